@@ -0,0 +1,291 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <bench_config.hxx>
+
+#include <fstream>
+#include <sstream>
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include "json_reporter.hxx"
+
+#include <http_parser.h>
+
+#include <io/http_parser.hxx>
+#include <io/mcbp_message.hxx>
+#include <io/mcbp_parser.hxx>
+#include <operations/document_query.hxx>
+#include <platform/uuid.h>
+#include <protocol/client_request.hxx>
+#include <protocol/client_response.hxx>
+#include <protocol/cmd_get.hxx>
+#include <protocol/cmd_get_cluster_config.hxx>
+#include <protocol/cmd_lookup_in.hxx>
+#include <protocol/cmd_mutate_in.hxx>
+#include <protocol/cmd_upsert.hxx>
+#include <utils/crc32.hxx>
+
+namespace
+{
+std::string
+load_test_data(const std::string& name)
+{
+    std::ifstream file(std::string(TEST_DATA_PATH) + "/" + name);
+    REQUIRE(file.is_open());
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+/**
+ * Builds response frame for given opcode as the server would send it.
+ */
+std::vector<std::uint8_t>
+make_response_frame(couchbase::protocol::client_opcode opcode, const std::string& extras, const std::string& value, std::uint8_t datatype = 0)
+{
+    std::vector<std::uint8_t> frame(couchbase::protocol::header_size + extras.size() + value.size());
+    frame[0] = static_cast<std::uint8_t>(couchbase::protocol::magic::client_response);
+    frame[1] = static_cast<std::uint8_t>(opcode);
+    frame[4] = static_cast<std::uint8_t>(extras.size());
+    frame[5] = datatype;
+    std::uint32_t body_size = htonl(static_cast<std::uint32_t>(extras.size() + value.size()));
+    std::memcpy(frame.data() + 8, &body_size, sizeof(body_size));
+    std::uint64_t cas = couchbase::utils::byte_swap_64(0x1600'0000'0000'0001ULL);
+    std::memcpy(frame.data() + 16, &cas, sizeof(cas));
+    std::copy(extras.begin(), extras.end(), frame.begin() + couchbase::protocol::header_size);
+    std::copy(value.begin(), value.end(), frame.begin() + static_cast<std::ptrdiff_t>(couchbase::protocol::header_size + extras.size()));
+    return frame;
+}
+
+couchbase::io::mcbp_message
+make_message(const std::vector<std::uint8_t>& frame)
+{
+    couchbase::io::mcbp_message msg{};
+    std::memcpy(&msg.header, frame.data(), couchbase::protocol::header_size);
+    msg.body.assign(frame.begin() + couchbase::protocol::header_size, frame.end());
+    return msg;
+}
+
+void
+append_uint16(std::string& out, std::uint16_t value)
+{
+    value = htons(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void
+append_uint32(std::string& out, std::uint32_t value)
+{
+    value = htonl(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::string
+make_document(std::size_t number_of_fields)
+{
+    tao::json::value doc = tao::json::empty_object;
+    for (std::size_t i = 0; i < number_of_fields; ++i) {
+        doc[fmt::format("field_{}", i)] = fmt::format("value of the field number {}", i);
+    }
+    return tao::json::to_string(doc);
+}
+} // namespace
+
+TEST_CASE("bench: mcbp_parser::next", "[benchmark]")
+{
+    auto frame = make_response_frame(couchbase::protocol::client_opcode::get, std::string(4, '\0'), make_document(20));
+    const std::size_t frames_per_feed = 64;
+    std::vector<std::uint8_t> stream;
+    for (std::size_t i = 0; i < frames_per_feed; ++i) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    BENCHMARK("64 get responses")
+    {
+        couchbase::io::mcbp_parser parser;
+        parser.feed(stream.begin(), stream.end());
+        couchbase::io::mcbp_message msg{};
+        std::size_t parsed = 0;
+        while (parser.next(msg) == couchbase::io::mcbp_parser::result::ok) {
+            ++parsed;
+        }
+        return parsed;
+    };
+}
+
+TEST_CASE("bench: client_request::data", "[benchmark]")
+{
+    couchbase::document_id id{ "default", "_default._default", "user::0123456789" };
+    auto value = make_document(50);
+
+    BENCHMARK("upsert without compression")
+    {
+        couchbase::protocol::client_request<couchbase::protocol::upsert_request_body> req;
+        req.opaque(42);
+        req.body().id(id);
+        req.body().content(value);
+        return req.data(false).size();
+    };
+
+    BENCHMARK("upsert with snappy")
+    {
+        couchbase::protocol::client_request<couchbase::protocol::upsert_request_body> req;
+        req.opaque(42);
+        req.body().id(id);
+        req.body().content(value);
+        return req.data(true).size();
+    };
+}
+
+TEST_CASE("bench: client_response construction", "[benchmark]")
+{
+    auto get_frame = make_response_frame(couchbase::protocol::client_opcode::get,
+                                         std::string(4, '\0'),
+                                         make_document(20),
+                                         static_cast<std::uint8_t>(couchbase::protocol::datatype::json));
+
+    std::string lookup_in_body;
+    for (std::size_t i = 0; i < 16; ++i) {
+        auto field = fmt::format(R"("value of the field number {}")", i);
+        append_uint16(lookup_in_body, static_cast<std::uint16_t>(couchbase::protocol::status::success));
+        append_uint32(lookup_in_body, static_cast<std::uint32_t>(field.size()));
+        lookup_in_body.append(field);
+    }
+    auto lookup_in_frame = make_response_frame(couchbase::protocol::client_opcode::subdoc_multi_lookup, {}, lookup_in_body);
+
+    std::string mutation_token(16, '\0');
+    std::string mutate_in_body;
+    for (std::size_t i = 0; i < 16; ++i) {
+        auto field = std::to_string(i * 1000);
+        mutate_in_body.push_back(static_cast<char>(i));
+        append_uint16(mutate_in_body, static_cast<std::uint16_t>(couchbase::protocol::status::success));
+        append_uint32(mutate_in_body, static_cast<std::uint32_t>(field.size()));
+        mutate_in_body.append(field);
+    }
+    auto mutate_in_frame = make_response_frame(couchbase::protocol::client_opcode::subdoc_multi_mutation, mutation_token, mutate_in_body);
+
+    BENCHMARK("get")
+    {
+        couchbase::protocol::client_response<couchbase::protocol::get_response_body> resp(make_message(get_frame));
+        return resp.body().value().size();
+    };
+
+    BENCHMARK("lookup_in with 16 specs")
+    {
+        couchbase::protocol::client_response<couchbase::protocol::lookup_in_response_body> resp(make_message(lookup_in_frame));
+        return resp.body().fields().size();
+    };
+
+    BENCHMARK("mutate_in with 16 specs")
+    {
+        couchbase::protocol::client_response<couchbase::protocol::mutate_in_response_body> resp(make_message(mutate_in_frame));
+        return resp.body().fields().size();
+    };
+}
+
+TEST_CASE("bench: protocol::parse_config", "[benchmark]")
+{
+    auto small = load_test_data("config_3_nodes.json");
+    auto large = load_test_data("config_50_nodes.json");
+
+    BENCHMARK("3 nodes, 1024 vbuckets")
+    {
+        return couchbase::protocol::parse_config(small.begin(), small.end());
+    };
+
+    BENCHMARK("50 nodes, 1024 vbuckets")
+    {
+        return couchbase::protocol::parse_config(large.begin(), large.end());
+    };
+}
+
+TEST_CASE("bench: utils::hash_crc32", "[benchmark]")
+{
+    std::string key{ "airline_10123" };
+
+    BENCHMARK("13 bytes key")
+    {
+        return couchbase::utils::hash_crc32(key.data(), key.size());
+    };
+}
+
+TEST_CASE("bench: uuid::random", "[benchmark]")
+{
+    BENCHMARK("random")
+    {
+        return couchbase::uuid::random();
+    };
+
+    BENCHMARK("random and to_string")
+    {
+        return couchbase::uuid::to_string(couchbase::uuid::random());
+    };
+}
+
+TEST_CASE("bench: http_parser::feed", "[benchmark]")
+{
+    auto body = make_document(100);
+    auto response = fmt::format("HTTP/1.1 200 OK\r\n"
+                                "Content-Type: application/json\r\n"
+                                "Date: Mon, 18 Oct 2021 12:00:00 GMT\r\n"
+                                "X-Content-Type-Options: nosniff\r\n"
+                                "Content-Length: {}\r\n"
+                                "\r\n"
+                                "{}",
+                                body.size(),
+                                body);
+
+    BENCHMARK("response with JSON body")
+    {
+        couchbase::io::http_parser parser;
+        parser.feed(response.data(), response.size());
+        return parser.complete;
+    };
+}
+
+TEST_CASE("bench: query_response_payload decoding", "[benchmark]")
+{
+    const std::size_t number_of_rows = 100;
+    tao::json::value rows = tao::json::empty_array;
+    for (std::size_t i = 0; i < number_of_rows; ++i) {
+        rows.get_array().emplace_back(tao::json::from_string(make_document(10)));
+    }
+    tao::json::value payload{
+        { "requestID", "a6b3b4a0-0e1f-4f4a-9a0e-8b9b3c9c7f2d" },
+        { "clientContextID", "2e8f1b2c-65a4-4b52-8c7d-4e6f3a9d1b0e" },
+        { "signature", { { "*", "*" } } },
+        { "results", std::move(rows) },
+        { "status", "success" },
+        { "metrics",
+          {
+            { "elapsedTime", "12.345ms" },
+            { "executionTime", "12.001ms" },
+            { "resultCount", number_of_rows },
+            { "resultSize", 65432 },
+            { "serviceLoad", 2 },
+          } },
+    };
+    auto encoded = tao::json::to_string(payload);
+
+    BENCHMARK("100 rows")
+    {
+        return tao::json::from_string(encoded).as<couchbase::operations::query_response_payload>();
+    };
+}
@@ -0,0 +1,535 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sys/resource.h>
+#endif
+
+#include <spdlog/cfg/env.h>
+#include <spdlog/spdlog.h>
+
+#include <cluster.hxx>
+#include <operations.hxx>
+#include <metrics/latency_histogram.hxx>
+#include <utils/connection_string.hxx>
+
+#include "mock/mock_cluster.hxx"
+
+namespace
+{
+const char* usage = R"(Usage: couchbase_bench [OPTIONS]
+
+Generates KV load (mix of get and upsert operations) and reports throughput and latency percentiles.
+
+Options:
+  --connection-string STRING  cluster to connect (default: couchbase://127.0.0.1)
+  --username STRING           (default: Administrator)
+  --password STRING           (default: password)
+  --bucket STRING             (default: default)
+  --mock                      start in-process mock cluster instead of connecting to the real one
+  --mock-nodes NUMBER         number of the nodes in the mock cluster (default: 1)
+  --mock-latency MS           latency of every mock response in milliseconds (default: 0)
+  --keys NUMBER               size of the key space (default: 10000)
+  --key-prefix STRING         (default: bench_)
+  --value-size MIN[:MAX]      size of the values in bytes, uniformly distributed (default: 256)
+  --set-ratio PERCENT         percentage of upsert operations (default: 33)
+  --concurrency NUMBER        number of independent request streams (default: 64)
+  --batch NUMBER              number of operations each stream sends before waiting for responses (default: 1)
+  --duration SECONDS          duration of the measurement (default: 10)
+  --io-threads NUMBER         number of IO threads, each with its own cluster connection (default: 1)
+  --no-populate               do not store the key space before measurement
+  --json                      print report as JSON
+  --help                      print this message
+
+On Linux the report includes read/write system calls (from /proc/self/io) and context switches per operation, to compare IO
+backends (configure with -DENABLE_IO_URING=ON to run sockets on io_uring). Submissions to io_uring are not counted as read/write
+calls, use "perf stat -e raw_syscalls:sys_enter" to count all system calls. With --mock the counters include the mock cluster.
+)";
+
+struct bench_options {
+    std::string connection_string{ "couchbase://127.0.0.1" };
+    std::string username{ "Administrator" };
+    std::string password{ "password" };
+    std::string bucket{ "default" };
+    bool use_mock{ false };
+    std::size_t mock_nodes{ 1 };
+    std::chrono::milliseconds mock_latency{ 0 };
+    std::size_t keys{ 10'000 };
+    std::string key_prefix{ "bench_" };
+    std::size_t min_value_size{ 256 };
+    std::size_t max_value_size{ 256 };
+    std::size_t set_ratio{ 33 };
+    std::size_t concurrency{ 64 };
+    std::size_t batch{ 1 };
+    std::chrono::seconds duration{ 10 };
+    std::size_t io_threads{ 1 };
+    bool populate{ true };
+    bool json{ false };
+    bool help{ false };
+};
+
+std::optional<std::string>
+parse_options(int argc, const char* argv[], bench_options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string name = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(fmt::format("option {} requires value", name));
+            }
+            return argv[++i];
+        };
+        try {
+            if (name == "--connection-string") {
+                options.connection_string = value();
+            } else if (name == "--username") {
+                options.username = value();
+            } else if (name == "--password") {
+                options.password = value();
+            } else if (name == "--bucket") {
+                options.bucket = value();
+            } else if (name == "--mock") {
+                options.use_mock = true;
+            } else if (name == "--mock-nodes") {
+                options.mock_nodes = std::stoul(value());
+            } else if (name == "--mock-latency") {
+                options.mock_latency = std::chrono::milliseconds(std::stoul(value()));
+            } else if (name == "--keys") {
+                options.keys = std::stoul(value());
+            } else if (name == "--key-prefix") {
+                options.key_prefix = value();
+            } else if (name == "--value-size") {
+                auto range = value();
+                auto colon = range.find(':');
+                options.min_value_size = std::stoul(range.substr(0, colon));
+                options.max_value_size = colon == std::string::npos ? options.min_value_size : std::stoul(range.substr(colon + 1));
+            } else if (name == "--set-ratio") {
+                options.set_ratio = std::stoul(value());
+            } else if (name == "--concurrency") {
+                options.concurrency = std::stoul(value());
+            } else if (name == "--batch") {
+                options.batch = std::stoul(value());
+            } else if (name == "--duration") {
+                options.duration = std::chrono::seconds(std::stoul(value()));
+            } else if (name == "--io-threads") {
+                options.io_threads = std::stoul(value());
+            } else if (name == "--no-populate") {
+                options.populate = false;
+            } else if (name == "--json") {
+                options.json = true;
+            } else if (name == "--help" || name == "-h") {
+                options.help = true;
+            } else {
+                return fmt::format("unknown option {}", name);
+            }
+        } catch (const std::invalid_argument& e) {
+            return fmt::format("unable to parse {}: {}", name, e.what());
+        } catch (const std::out_of_range& e) {
+            return fmt::format("unable to parse {}: {}", name, e.what());
+        }
+    }
+    if (options.keys == 0 || options.concurrency == 0 || options.batch == 0 || options.io_threads == 0) {
+        return "--keys, --concurrency, --batch and --io-threads must be positive";
+    }
+    if (options.set_ratio > 100) {
+        return "--set-ratio must be in range [0, 100]";
+    }
+    if (options.max_value_size < options.min_value_size) {
+        return "--value-size maximum must not be less than minimum";
+    }
+    return {};
+}
+
+/**
+ * @return reactor of the sockets, as selected by asio configuration (requested io_uring is used only if asio supports it)
+ */
+constexpr const char*
+io_backend_name()
+{
+#if defined(ASIO_HAS_IOCP)
+    return "iocp";
+#elif defined(ASIO_HAS_IO_URING_AS_DEFAULT)
+    return "io_uring";
+#elif defined(ASIO_HAS_EPOLL)
+    return "epoll";
+#elif defined(ASIO_HAS_KQUEUE)
+    return "kqueue";
+#elif defined(ASIO_HAS_DEV_POLL)
+    return "dev_poll";
+#else
+    return "select";
+#endif
+}
+
+/**
+ * Process counters, that show the cost of the IO backend. All zeros on platforms other than Linux.
+ */
+struct process_counters {
+    std::uint64_t read_syscalls{ 0 };
+    std::uint64_t write_syscalls{ 0 };
+    std::uint64_t voluntary_switches{ 0 };
+    std::uint64_t involuntary_switches{ 0 };
+
+    static process_counters capture()
+    {
+        process_counters res{};
+#if defined(__linux__)
+        std::ifstream io("/proc/self/io");
+        std::string name;
+        std::uint64_t value = 0;
+        while (io >> name >> value) {
+            if (name == "syscr:") {
+                res.read_syscalls = value;
+            } else if (name == "syscw:") {
+                res.write_syscalls = value;
+            }
+        }
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            res.voluntary_switches = static_cast<std::uint64_t>(usage.ru_nvcsw);
+            res.involuntary_switches = static_cast<std::uint64_t>(usage.ru_nivcsw);
+        }
+#endif
+        return res;
+    }
+
+    process_counters operator-(const process_counters& other) const
+    {
+        return { read_syscalls - other.read_syscalls,
+                 write_syscalls - other.write_syscalls,
+                 voluntary_switches - other.voluntary_switches,
+                 involuntary_switches - other.involuntary_switches };
+    }
+};
+
+struct operation_stats {
+    couchbase::metrics::latency_histogram latency{};
+    std::atomic_uint64_t errors{ 0 };
+};
+
+/**
+ * The cluster object expects all its handlers to run on a single thread, so every IO thread gets its own io_context and cluster.
+ */
+struct io_worker {
+    asio::io_context io{};
+    asio::executor_work_guard<asio::io_context::executor_type> guard{ asio::make_work_guard(io) };
+    couchbase::cluster cluster{ io };
+    std::thread thread{};
+};
+
+/**
+ * Runs fixed number of request streams. Every stream sends a batch of operations, and starts the next batch once all responses for
+ * the current one have been received. The streams are distributed over the clusters round-robin.
+ */
+class workload : public std::enable_shared_from_this<workload>
+{
+  public:
+    workload(std::vector<couchbase::cluster*> clusters, const bench_options& options)
+      : clusters_(std::move(clusters))
+      , options_(options)
+      , value_(options.max_value_size, 'x')
+    {
+    }
+
+    /**
+     * Stores every key of the key space once.
+     */
+    void populate()
+    {
+        next_key_ = 0;
+        active_streams_ = options_.concurrency;
+        done_ = std::make_shared<std::promise<void>>();
+        auto f = done_->get_future();
+        for (std::size_t i = 0; i < options_.concurrency; ++i) {
+            populate_next(*clusters_[i % clusters_.size()]);
+        }
+        f.get();
+    }
+
+    void run()
+    {
+        deadline_ = std::chrono::steady_clock::now() + options_.duration;
+        active_streams_ = options_.concurrency;
+        done_ = std::make_shared<std::promise<void>>();
+        auto f = done_->get_future();
+        auto counters_before = process_counters::capture();
+        started_at_ = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < options_.concurrency; ++i) {
+            auto stream = std::make_shared<request_stream>();
+            stream->cluster = clusters_[i % clusters_.size()];
+            stream->rng.seed(i + 1);
+            run_batch(stream);
+        }
+        f.get();
+        finished_at_ = std::chrono::steady_clock::now();
+        counters_ = process_counters::capture() - counters_before;
+    }
+
+    void report(std::ostream& out) const
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(finished_at_ - started_at_).count();
+        auto get = get_.latency.snapshot();
+        auto set = set_.latency.snapshot();
+        auto total = get.count + set.count;
+        auto throughput = elapsed > 0 ? static_cast<double>(total) / elapsed : 0.0;
+        auto per_operation = [total](std::uint64_t value) {
+            return total > 0 ? static_cast<double>(value) / static_cast<double>(total) : 0.0;
+        };
+        if (options_.json) {
+            auto entry = [](const couchbase::metrics::histogram_snapshot& s, std::uint64_t errors) {
+                return tao::json::value{
+                    { "count", s.count },
+                    { "errors", errors },
+                    { "mean_us", s.mean() },
+                    { "p50_us", s.value_at_percentile(50.0) },
+                    { "p99_us", s.value_at_percentile(99.0) },
+                    { "p999_us", s.value_at_percentile(99.9) },
+                    { "max_us", s.max },
+                };
+            };
+            tao::json::value result{
+                { "elapsed_seconds", elapsed },
+                { "operations", total },
+                { "throughput", throughput },
+                { "io_backend", io_backend_name() },
+                { "read_syscalls_per_operation", per_operation(counters_.read_syscalls) },
+                { "write_syscalls_per_operation", per_operation(counters_.write_syscalls) },
+                { "context_switches_per_operation", per_operation(counters_.voluntary_switches + counters_.involuntary_switches) },
+                { "get", entry(get, get_.errors) },
+                { "upsert", entry(set, set_.errors) },
+            };
+            out << tao::json::to_string(result, 2) << std::endl;
+            return;
+        }
+        out << fmt::format("elapsed: {:.2f}s, operations: {}, throughput: {:.0f} ops/s\n", elapsed, total, throughput);
+        out << fmt::format("io backend: {}, per operation: {:.2f} read calls, {:.2f} write calls, {:.2f} context switches\n",
+                           io_backend_name(),
+                           per_operation(counters_.read_syscalls),
+                           per_operation(counters_.write_syscalls),
+                           per_operation(counters_.voluntary_switches + counters_.involuntary_switches));
+        out << fmt::format(
+          "{:<8} {:>10} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "", "count", "errors", "mean", "p50", "p99", "p999", "max");
+        auto row = [&out](const char* name, const couchbase::metrics::histogram_snapshot& s, std::uint64_t errors) {
+            out << fmt::format("{:<8} {:>10} {:>8} {:>10.1f} {:>10} {:>10} {:>10} {:>10}\n",
+                               name,
+                               s.count,
+                               errors,
+                               s.mean(),
+                               s.value_at_percentile(50.0),
+                               s.value_at_percentile(99.0),
+                               s.value_at_percentile(99.9),
+                               s.max);
+        };
+        row("get", get, get_.errors);
+        row("upsert", set, set_.errors);
+        out << "(latencies in microseconds)" << std::endl;
+    }
+
+  private:
+    struct request_stream {
+        couchbase::cluster* cluster{ nullptr };
+        std::mt19937_64 rng{};
+        std::atomic_size_t pending{ 0 };
+    };
+
+    [[nodiscard]] couchbase::document_id make_id(std::size_t index) const
+    {
+        return { options_.bucket, "_default._default", fmt::format("{}{}", options_.key_prefix, index) };
+    }
+
+    void stream_finished()
+    {
+        if (--active_streams_ == 0) {
+            auto done = done_;
+            done->set_value();
+        }
+    }
+
+    void populate_next(couchbase::cluster& cluster)
+    {
+        auto index = next_key_.fetch_add(1);
+        if (index >= options_.keys) {
+            return stream_finished();
+        }
+        couchbase::operations::upsert_request req{ make_id(index), value_.substr(0, options_.min_value_size) };
+        cluster.execute(req, [self = shared_from_this(), &cluster](couchbase::operations::upsert_response&& resp) {
+            if (resp.ctx.ec) {
+                spdlog::warn("unable to populate {}: {}", resp.ctx.id, resp.ctx.ec.message());
+            }
+            self->populate_next(cluster);
+        });
+    }
+
+    void run_batch(std::shared_ptr<request_stream> stream)
+    {
+        if (std::chrono::steady_clock::now() >= deadline_) {
+            return stream_finished();
+        }
+        std::uniform_int_distribution<std::size_t> key_dist(0, options_.keys - 1);
+        std::uniform_int_distribution<std::size_t> size_dist(options_.min_value_size, options_.max_value_size);
+        std::uniform_int_distribution<std::size_t> ratio_dist(0, 99);
+
+        stream->pending = options_.batch;
+        auto on_complete = [self = shared_from_this(), stream]() {
+            if (--stream->pending == 0) {
+                self->run_batch(stream);
+            }
+        };
+        for (std::size_t i = 0; i < options_.batch; ++i) {
+            auto id = make_id(key_dist(stream->rng));
+            auto start = std::chrono::steady_clock::now();
+            if (ratio_dist(stream->rng) < options_.set_ratio) {
+                couchbase::operations::upsert_request req{ id, value_.substr(0, size_dist(stream->rng)) };
+                stream->cluster->execute(req, [this, start, on_complete](couchbase::operations::upsert_response&& resp) {
+                    set_.latency.record(std::chrono::steady_clock::now() - start);
+                    if (resp.ctx.ec) {
+                        ++set_.errors;
+                    }
+                    on_complete();
+                });
+            } else {
+                couchbase::operations::get_request req{ id };
+                stream->cluster->execute(req, [this, start, on_complete](couchbase::operations::get_response&& resp) {
+                    get_.latency.record(std::chrono::steady_clock::now() - start);
+                    if (resp.ctx.ec) {
+                        ++get_.errors;
+                    }
+                    on_complete();
+                });
+            }
+        }
+    }
+
+    std::vector<couchbase::cluster*> clusters_;
+    const bench_options& options_;
+    std::string value_;
+    operation_stats get_{};
+    operation_stats set_{};
+    std::chrono::steady_clock::time_point deadline_{};
+    std::chrono::steady_clock::time_point started_at_{};
+    std::chrono::steady_clock::time_point finished_at_{};
+    process_counters counters_{};
+    std::atomic_size_t next_key_{ 0 };
+    std::atomic_size_t active_streams_{ 0 };
+    std::shared_ptr<std::promise<void>> done_{};
+};
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+    bench_options options{};
+    if (auto error = parse_options(argc, argv, options); error) {
+        std::cerr << "ERROR: " << *error << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+    if (options.help) {
+        std::cout << usage;
+        return EXIT_SUCCESS;
+    }
+
+    spdlog::set_pattern("[%Y-%m-%d %T.%e] [%P,%t] [%^%l%$] %oms, %v");
+    auto env_val = spdlog::details::os::getenv("COUCHBASE_BACKEND_LOG_LEVEL");
+    if (env_val.empty()) {
+        spdlog::set_level(spdlog::level::warn);
+    } else {
+        spdlog::cfg::helpers::load_levels(env_val);
+    }
+
+    std::unique_ptr<mock::mock_cluster> mock_cluster{};
+    if (options.use_mock) {
+        mock_cluster = std::make_unique<mock::mock_cluster>(
+          mock::mock_options{ options.mock_nodes, 64, options.bucket, options.username, options.password });
+        mock_cluster->set_latency(options.mock_latency);
+        options.connection_string = mock_cluster->connection_string();
+    }
+
+    auto connstr = couchbase::utils::parse_connection_string(options.connection_string);
+    if (connstr.error) {
+        std::cerr << "ERROR: unable to parse connection string: " << *connstr.error << std::endl;
+        return EXIT_FAILURE;
+    }
+    couchbase::cluster_credentials auth{};
+    auth.username = options.username;
+    auth.password = options.password;
+    auth.allowed_sasl_mechanisms = { "SCRAM-SHA512", "SCRAM-SHA256", "SCRAM-SHA1" };
+
+    std::vector<std::unique_ptr<io_worker>> workers;
+    for (std::size_t i = 0; i < options.io_threads; ++i) {
+        auto& worker = workers.emplace_back(std::make_unique<io_worker>());
+        worker->thread = std::thread([&io = worker->io]() { io.run(); });
+    }
+
+    int rc = EXIT_SUCCESS;
+    for (auto& worker : workers) {
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        worker->cluster.open(couchbase::origin(auth, connstr), [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        if (auto ec = f.get(); ec) {
+            std::cerr << "ERROR: unable to connect: " << ec.message() << std::endl;
+            rc = EXIT_FAILURE;
+            break;
+        }
+    }
+    for (auto& worker : workers) {
+        if (rc != EXIT_SUCCESS) {
+            break;
+        }
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        worker->cluster.open_bucket(options.bucket, [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        if (auto ec = f.get(); ec) {
+            std::cerr << "ERROR: unable to open bucket: " << ec.message() << std::endl;
+            rc = EXIT_FAILURE;
+        }
+    }
+    if (rc == EXIT_SUCCESS) {
+        std::vector<couchbase::cluster*> clusters;
+        for (auto& worker : workers) {
+            clusters.push_back(&worker->cluster);
+        }
+        auto load = std::make_shared<workload>(std::move(clusters), options);
+        if (options.populate) {
+            load->populate();
+        }
+        load->run();
+        load->report(std::cout);
+    }
+    for (auto& worker : workers) {
+        auto barrier = std::make_shared<std::promise<void>>();
+        auto f = barrier->get_future();
+        worker->cluster.close([barrier]() { barrier->set_value(); });
+        f.get();
+        worker->guard.reset();
+    }
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+    return rc;
+}
@@ -0,0 +1,101 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <catch2/catch.hpp>
+
+#include <tao/json.hpp>
+
+namespace couchbase::bench
+{
+/**
+ * Catch2 reporter, that collects results of BENCHMARK sections and writes them as a single JSON document, suitable for trend
+ * tracking. All durations are in nanoseconds.
+ *
+ * Enabled with "--reporter json".
+ */
+class json_reporter : public Catch::StreamingReporterBase<json_reporter>
+{
+  public:
+    using StreamingReporterBase::StreamingReporterBase;
+
+    static std::string getDescription()
+    {
+        return "Reports benchmark results as JSON document";
+    }
+
+    void assertionStarting(const Catch::AssertionInfo& /* info */) override
+    {
+    }
+
+    bool assertionEnded(const Catch::AssertionStats& /* stats */) override
+    {
+        return true;
+    }
+
+    void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override
+    {
+        tao::json::value samples = tao::json::empty_array;
+        for (const auto& sample : stats.samples) {
+            samples.get_array().emplace_back(sample.count());
+        }
+        tao::json::value entry{
+            { "test_case", currentTestCaseInfo->name },
+            { "name", stats.info.name },
+            { "iterations", stats.info.iterations },
+            { "samples", std::move(samples) },
+            { "mean",
+              {
+                { "point", stats.mean.point.count() },
+                { "lower_bound", stats.mean.lower_bound.count() },
+                { "upper_bound", stats.mean.upper_bound.count() },
+              } },
+            { "standard_deviation",
+              {
+                { "point", stats.standardDeviation.point.count() },
+                { "lower_bound", stats.standardDeviation.lower_bound.count() },
+                { "upper_bound", stats.standardDeviation.upper_bound.count() },
+              } },
+            { "outlier_variance", stats.outlierVariance },
+        };
+        benchmarks_.get_array().emplace_back(std::move(entry));
+    }
+
+    void benchmarkFailed(const std::string& error) override
+    {
+        failures_.get_array().emplace_back(tao::json::value{ { "test_case", currentTestCaseInfo->name }, { "error", error } });
+    }
+
+    void testRunEnded(const Catch::TestRunStats& stats) override
+    {
+        tao::json::value report{
+            { "name", stats.runInfo.name },
+            { "benchmarks", std::move(benchmarks_) },
+            { "failures", std::move(failures_) },
+        };
+        stream << tao::json::to_string(report, 2) << std::endl;
+        StreamingReporterBase::testRunEnded(stats);
+    }
+
+  private:
+    tao::json::value benchmarks_{ tao::json::empty_array };
+    tao::json::value failures_{ tao::json::empty_array };
+};
+} // namespace couchbase::bench
+
+CATCH_REGISTER_REPORTER("json", couchbase::bench::json_reporter)
@@ -0,0 +1,52 @@
+option(ENABLE_BENCHMARKS "Build native load generator and microbenchmarks" FALSE)
+
+if(ENABLE_BENCHMARKS)
+  add_executable(couchbase_bench "${CMAKE_SOURCE_DIR}/bench/couchbase_bench.cxx")
+  target_include_directories(couchbase_bench PRIVATE ${CMAKE_SOURCE_DIR}/test)
+  target_link_libraries(
+    couchbase_bench
+    project_options
+    project_warnings
+    OpenSSL::SSL
+    OpenSSL::Crypto
+    platform
+    cbcrypto
+    cbsasl
+    http_parser
+    snappy
+    spdlog::spdlog_header_only)
+
+  file(
+    GENERATE
+    OUTPUT ${PROJECT_BINARY_DIR}/generated/bench_config.hxx
+    CONTENT
+      "
+#pragma once
+#define TEST_DATA_PATH \"${CMAKE_SOURCE_DIR}/test/test_data\"
+")
+
+  if(NOT TARGET Catch2::Catch2)
+    add_subdirectory(third_party/catch2)
+  endif()
+
+  # Catch2 microbenchmarks, use "--reporter json" to get results for trend tracking
+  macro(native_benchmark name)
+    add_executable(bench_${name} "${CMAKE_SOURCE_DIR}/bench/bench_${name}.cxx")
+    target_include_directories(bench_${name} PRIVATE ${PROJECT_BINARY_DIR}/generated)
+    target_link_libraries(
+      bench_${name}
+      project_options
+      project_warnings
+      Catch2::Catch2
+      OpenSSL::SSL
+      OpenSSL::Crypto
+      platform
+      cbcrypto
+      cbsasl
+      http_parser
+      snappy
+      spdlog::spdlog_header_only)
+  endmacro()
+
+  native_benchmark(codec)
+endif()
@@ -17,9 +17,13 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <queue>
 #include <utility>
 
+#include <io/parallel_bootstrap.hxx>
+#include <near_cache.hxx>
 #include <operations.hxx>
 #include <origin.hxx>
 
@@ -43,6 +47,10 @@ class bucket : public std::enable_shared_from_this<bucket>
       , known_features_(known_features)
     {
         log_prefix_ = fmt::format("[{}/{}]", client_id_, name_);
+        if (origin_.options().near_cache_capacity > 0) {
+            near_cache_ = std::make_shared<near_cache>(
+              origin_.options().near_cache_capacity, origin_.options().near_cache_max_staleness, origin_.telemetry().registry.near_cache());
+        }
     }
 
     ~bucket()
@@ -137,7 +145,7 @@ class bucket : public std::enable_shared_from_this<bucket>
                 if (port == 0) {
                     continue;
                 }
-                couchbase::origin origin(origin_.credentials(), hostname, port, origin_.options());
+                couchbase::origin origin(origin_, hostname, port);
                 std::shared_ptr<io::mcbp_session> session;
                 if (origin_.options().enable_tls) {
                     session = std::make_shared<io::mcbp_session>(client_id_, ctx_, tls_, origin, name_, known_features_);
@@ -176,7 +184,7 @@ class bucket : public std::enable_shared_from_this<bucket>
         auto hostname = old_session->bootstrap_hostname();
         auto port = old_session->bootstrap_port();
         auto old_id = old_session->id();
-        couchbase::origin origin(origin_.credentials(), hostname, port, origin_.options());
+        couchbase::origin origin(origin_, hostname, port);
         sessions_.erase(ptr);
         std::shared_ptr<io::mcbp_session> session;
         if (origin_.options().enable_tls) {
@@ -200,14 +208,15 @@ class bucket : public std::enable_shared_from_this<bucket>
     template<typename Handler>
     void bootstrap(Handler&& handler)
     {
-        std::shared_ptr<io::mcbp_session> new_session;
-        if (origin_.options().enable_tls) {
-            new_session = std::make_shared<io::mcbp_session>(client_id_, ctx_, tls_, origin_, name_, known_features_);
-        } else {
-            new_session = std::make_shared<io::mcbp_session>(client_id_, ctx_, origin_, name_, known_features_);
-        }
-        new_session->bootstrap([self = shared_from_this(), new_session, h = std::forward<Handler>(handler)](
-                                 std::error_code ec, const configuration& cfg) mutable {
+        bootstrap_ = std::make_shared<io::parallel_bootstrap>(origin_, [this](const couchbase::origin& origin) {
+            if (origin_.options().enable_tls) {
+                return std::make_shared<io::mcbp_session>(client_id_, ctx_, tls_, origin, name_, known_features_);
+            }
+            return std::make_shared<io::mcbp_session>(client_id_, ctx_, origin, name_, known_features_);
+        });
+        bootstrap_->start([self = shared_from_this(), h = std::forward<Handler>(handler)](
+                            std::error_code ec, std::shared_ptr<io::mcbp_session> new_session, const configuration& cfg) mutable {
+            self->bootstrap_.reset();
             if (!ec) {
                 size_t this_index = new_session->index();
                 new_session->on_configuration_update([self](const configuration& config) { self->update_config(config); });
@@ -235,11 +244,139 @@ class bucket : public std::enable_shared_from_this<bucket>
 
     template<typename Request, typename Handler>
     void execute(Request request, Handler&& handler)
+    {
+        if constexpr (std::is_same_v<Request, operations::get_request>) {
+            if (near_cache_) {
+                return execute_cached(std::move(request), std::forward<Handler>(handler));
+            }
+            if (origin_.options().enable_read_coalescing) {
+                return execute_coalesced(std::move(request), std::forward<Handler>(handler));
+            }
+        } else if constexpr (invalidates_near_cache<Request>::value) {
+            if (origin_.options().enable_read_coalescing) {
+                seal_coalesced(request.id);
+            }
+            if (near_cache_) {
+                /* invalidate before the mutation is sent, and once again after it has been applied */
+                auto key = near_cache::make_key(request.id);
+                near_cache_->invalidate(key);
+                return execute_command(std::move(request),
+                                       [cache = near_cache_, key, handler = std::forward<Handler>(handler)](
+                                         typename Request::response_type&& resp) mutable {
+                                           cache->invalidate(key);
+                                           handler(std::move(resp));
+                                       });
+            }
+        }
+        execute_command(std::move(request), std::forward<Handler>(handler));
+    }
+
+    /**
+     * Completes the read from the near cache without touching the sessions, or sends it and caches the successful response.
+     */
+    template<typename Handler>
+    void execute_cached(operations::get_request request, Handler&& handler)
+    {
+        if (closed_) {
+            return;
+        }
+        auto key = near_cache::make_key(request.id);
+        if (auto cached = near_cache_->find(key); cached) {
+            operations::get_response response{};
+            response.ctx.id = request.id;
+            response.value = std::move(cached->value);
+            response.cas = cached->cas;
+            response.flags = cached->flags;
+            return asio::post(asio::bind_executor(ctx_, [resp = std::move(response), handler = std::forward<Handler>(handler)]() mutable {
+                handler(std::move(resp));
+            }));
+        }
+        auto on_response = [cache = near_cache_, key, version = near_cache_->version(key), handler = std::forward<Handler>(handler)](
+                             operations::get_response&& resp) mutable {
+            if (!resp.ctx.ec) {
+                cache->store(key, version, { resp.value, resp.cas, resp.flags });
+            }
+            handler(std::move(resp));
+        };
+        if (origin_.options().enable_read_coalescing) {
+            return execute_coalesced(std::move(request), std::move(on_response));
+        }
+        execute_command(std::move(request), std::move(on_response));
+    }
+
+    /**
+     * Attaches the read to identical request in flight (same opcode, collection and key), or sends it as the leader of the flight.
+     * The response of the leader is copied to every request, that has been attached while it was in flight.
+     */
+    template<typename Handler>
+    void execute_coalesced(operations::get_request request, Handler&& handler)
+    {
+        if (closed_) {
+            return;
+        }
+        auto key = coalescing_key(request.id);
+        auto flight = std::make_shared<coalesced_flight>();
+        {
+            std::scoped_lock lock(coalescing_mutex_);
+            auto [it, inserted] = coalesced_gets_.try_emplace(key, flight);
+            it->second->waiters.emplace_back(std::forward<Handler>(handler));
+            if (!inserted) {
+                if (auto* metrics = origin_.telemetry().registry.coalescing(); metrics != nullptr) {
+                    metrics->coalesced.fetch_add(1, std::memory_order_relaxed);
+                }
+                return;
+            }
+        }
+        if (auto* metrics = origin_.telemetry().registry.coalescing(); metrics != nullptr) {
+            metrics->leaders.fetch_add(1, std::memory_order_relaxed);
+        }
+        execute_command(std::move(request), [self = shared_from_this(), key, flight](operations::get_response&& resp) {
+            std::vector<std::function<void(operations::get_response&&)>> waiters{};
+            {
+                std::scoped_lock lock(self->coalescing_mutex_);
+                if (auto it = self->coalesced_gets_.find(key); it != self->coalesced_gets_.end() && it->second == flight) {
+                    self->coalesced_gets_.erase(it);
+                }
+                std::swap(waiters, flight->waiters);
+            }
+            for (std::size_t i = 1; i < waiters.size(); ++i) {
+                auto copy = resp;
+                waiters[i](std::move(copy));
+            }
+            if (!waiters.empty()) {
+                waiters.front()(std::move(resp));
+            }
+        });
+    }
+
+    /**
+     * Closes the flight of the document for new reads, because they have to observe the mutation, that is being dispatched. The
+     * reads attached before still get the response of the leader.
+     */
+    void seal_coalesced(const document_id& id)
+    {
+        std::scoped_lock lock(coalescing_mutex_);
+        coalesced_gets_.erase(coalescing_key(id));
+    }
+
+    [[nodiscard]] static std::string coalescing_key(const document_id& id)
+    {
+        return fmt::format("{}/{}/{}", protocol::client_opcode::get, id.collection, id.key);
+    }
+
+    /**
+     * @param mapped_index node of the request, when the caller has mapped the key already (the partition is set in the request)
+     */
+    template<typename Request, typename Handler>
+    void execute_command(Request request, Handler&& handler, std::optional<std::int16_t> mapped_index = {})
     {
         if (closed_) {
             return;
         }
         auto cmd = std::make_shared<operations::mcbp_command<bucket, Request>>(ctx_, shared_from_this(), request);
+        if (auto& tracer = origin_.telemetry().tracer; tracer.enabled()) {
+            cmd->span_ = tracer.start_span(fmt::format("{}", Request::encoded_request_type::body_type::opcode), cmd->id_);
+        }
         cmd->start([cmd, handler = std::forward<Handler>(handler)](std::error_code ec, std::optional<io::mcbp_message> msg) mutable {
             using encoded_response_type = typename Request::encoded_response_type;
             auto resp = msg ? encoded_response_type(std::move(*msg)) : encoded_response_type{};
@@ -263,13 +400,82 @@ class bucket : public std::enable_shared_from_this<bucket>
                 }
             }
             ctx.enhanced_error_info = resp.error_info();
-            handler(make_response(std::move(ctx), cmd->request, std::move(resp)));
+            auto response = make_response(std::move(ctx), cmd->request, std::move(resp));
+            if (cmd->span_) {
+                cmd->span_->mark(tracing::span_phase::decoded);
+                cmd->manager_->origin_.telemetry().tracer.end_span(std::move(cmd->span_));
+            }
+            handler(std::move(response));
         });
-        if (config_) {
-            map_and_send(cmd);
-        } else {
+        if (!config_) {
             deferred_commands_.emplace([self = shared_from_this(), cmd]() { self->map_and_send(cmd); });
+        } else if (mapped_index) {
+            send_mapped(cmd, *mapped_index);
+        } else {
+            map_and_send(cmd);
+        }
+    }
+
+    /**
+     * Dispatches batch of get requests, grouping them by the node, which owns the key.
+     *
+     * Every node receives at most max_in_flight_per_node requests at a time, the next request for the node is being sent as soon as
+     * one of the previous requests completes. The handler is invoked for every request with its position in the batch.
+     */
+    template<typename Handler>
+    void execute_get_multi(std::vector<std::pair<std::size_t, operations::get_request>> requests,
+                           std::size_t max_in_flight_per_node,
+                           Handler&& handler)
+    {
+        if (closed_) {
+            for (auto& [position, request] : requests) {
+                handler(position, canceled_get_response(request));
+            }
+            return;
+        }
+        if (!config_) {
+            deferred_commands_.emplace([self = shared_from_this(),
+                                        requests = std::move(requests),
+                                        max_in_flight_per_node,
+                                        handler = std::forward<Handler>(handler)]() mutable {
+                self->execute_get_multi(std::move(requests), max_in_flight_per_node, std::move(handler));
+            });
+            return;
         }
+
+        struct node_lane {
+            std::int16_t index{ -1 };
+            std::vector<std::pair<std::size_t, operations::get_request>> requests{};
+            std::size_t next{ 0 };
+        };
+        std::map<std::int16_t, std::shared_ptr<node_lane>> lanes{};
+        for (auto& entry : requests) {
+            std::int16_t index = 0;
+            std::tie(entry.second.partition, index) = config_->map_key(entry.second.id.key);
+            auto& lane = lanes[index];
+            if (!lane) {
+                lane = std::make_shared<node_lane>();
+                lane->index = index;
+                lane->requests.reserve(requests.size() / std::max<std::size_t>(config_->nodes.size(), 1) + 1);
+            }
+            lane->requests.emplace_back(std::move(entry));
+        }
+        requests.clear();
+
+        auto on_response = std::make_shared<std::function<void(std::size_t, operations::get_response&&)>>(std::forward<Handler>(handler));
+        auto window = std::max<std::size_t>(max_in_flight_per_node, 1);
+        /*
+         * schedule the whole batch in a single handler, so that requests for the same node will be coalesced in the output buffer
+         * of the session and written to the socket using minimal number of system calls
+         */
+        asio::post(asio::bind_executor(ctx_, [self = shared_from_this(), lanes = std::move(lanes), on_response, window]() {
+            for (const auto& [index, lane] : lanes) {
+                auto initial = std::min(window, lane->requests.size());
+                for (std::size_t i = 0; i < initial; ++i) {
+                    self->dispatch_next_in_lane(lane, on_response);
+                }
+            }
+        }));
     }
 
     void close()
@@ -279,6 +485,9 @@ class bucket : public std::enable_shared_from_this<bucket>
         }
         closed_ = true;
 
+        if (bootstrap_) {
+            bootstrap_->cancel();
+        }
         drain_deferred_queue();
         for (auto& [index, session] : sessions_) {
             if (session) {
@@ -316,6 +525,23 @@ class bucket : public std::enable_shared_from_this<bucket>
         cmd->send_to(session);
     }
 
+    /**
+     * Sends the command to the node, that has been selected by the caller, and falls back to map_and_send() if the session of the
+     * node is gone. When the map has changed in the meantime, the node replies with NOT_MY_VBUCKET, and the command is retried.
+     */
+    template<typename Request>
+    void send_mapped(std::shared_ptr<operations::mcbp_command<bucket, Request>> cmd, std::int16_t index)
+    {
+        if (closed_) {
+            return cmd->cancel(io::retry_reason::do_not_retry);
+        }
+        auto session = index < 0 ? sessions_.end() : sessions_.find(static_cast<std::size_t>(index));
+        if (session == sessions_.end() || !session->second || session->second->is_stopped()) {
+            return map_and_send(cmd);
+        }
+        cmd->send_to(session->second);
+    }
+
     template<typename Request>
     void schedule_for_retry(std::shared_ptr<operations::mcbp_command<bucket, Request>> cmd, std::chrono::milliseconds duration)
     {
@@ -352,6 +578,40 @@ class bucket : public std::enable_shared_from_this<bucket>
     }
 
   private:
+    template<typename Lane, typename Handler>
+    void dispatch_next_in_lane(std::shared_ptr<Lane> lane, std::shared_ptr<Handler> on_response)
+    {
+        if (closed_) {
+            /* the bucket does not accept commands anymore, but every position of the batch must be completed */
+            while (lane->next < lane->requests.size()) {
+                auto& [position, request] = lane->requests[lane->next++];
+                (*on_response)(position, canceled_get_response(request));
+            }
+            return;
+        }
+        if (lane->next >= lane->requests.size()) {
+            return;
+        }
+        auto& [position, request] = lane->requests[lane->next++];
+        auto on_lane_response = [self = shared_from_this(), lane, on_response, position = position](operations::get_response&& resp) {
+            (*on_response)(position, std::move(resp));
+            self->dispatch_next_in_lane(lane, on_response);
+        };
+        if (near_cache_ || origin_.options().enable_read_coalescing) {
+            /* the near cache and the coalescing might complete the read without sending it */
+            return execute(std::move(request), std::move(on_lane_response));
+        }
+        execute_command(std::move(request), std::move(on_lane_response), lane->index);
+    }
+
+    [[nodiscard]] static operations::get_response canceled_get_response(const operations::get_request& request)
+    {
+        operations::get_response response{};
+        response.ctx.id = request.id;
+        response.ctx.ec = error::common_errc::request_canceled;
+        return response;
+    }
+
     std::string client_id_;
     asio::io_context& ctx_;
     asio::ssl::context& tls_;
@@ -363,7 +623,20 @@ class bucket : public std::enable_shared_from_this<bucket>
 
     std::queue<std::function<void()>> deferred_commands_{};
 
+    std::shared_ptr<near_cache> near_cache_{};
+
+    /**
+     * Reads of the same document, that wait for the response of the single request.
+     */
+    struct coalesced_flight {
+        std::vector<std::function<void(operations::get_response&&)>> waiters{};
+    };
+
+    std::mutex coalescing_mutex_{};
+    std::map<std::string, std::shared_ptr<coalesced_flight>> coalesced_gets_{};
+
     bool closed_{ false };
+    std::shared_ptr<io::parallel_bootstrap> bootstrap_{};
     std::map<size_t, std::shared_ptr<io::mcbp_session>> sessions_{};
     std::int16_t round_robin_next_{ 0 };
 
@@ -0,0 +1,78 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <cbsasl/scram-sha/salted_password_cache.h>
+
+namespace couchbase::sasl::mechanism::scram
+{
+
+SaltedPasswordCache&
+SaltedPasswordCache::instance()
+{
+    static SaltedPasswordCache cache;
+    return cache;
+}
+
+std::string
+SaltedPasswordCache::get(couchbase::crypto::Algorithm algorithm,
+                         const std::string& username,
+                         const std::string& password,
+                         const std::string& salt,
+                         unsigned int iterationCount)
+{
+    Key key{ algorithm, username, couchbase::crypto::digest(couchbase::crypto::Algorithm::SHA256, password), salt, iterationCount };
+    {
+        std::scoped_lock lock(mutex);
+        if (auto it = entries.find(key); it != entries.end()) {
+            ++counters.hits;
+            return it->second;
+        }
+        ++counters.misses;
+    }
+
+    // computed without the lock, so that connections of other users are not blocked
+    auto saltedPassword = couchbase::crypto::PBKDF2_HMAC(algorithm, password, salt, iterationCount);
+
+    std::scoped_lock lock(mutex);
+    if (entries.emplace(key, saltedPassword).second) {
+        insertionOrder.emplace_back(std::move(key));
+        if (insertionOrder.size() > maxEntries) {
+            entries.erase(insertionOrder.front());
+            insertionOrder.pop_front();
+        }
+    }
+    return saltedPassword;
+}
+
+SaltedPasswordCache::Stats
+SaltedPasswordCache::stats() const
+{
+    std::scoped_lock lock(mutex);
+    Stats result = counters;
+    result.size = entries.size();
+    return result;
+}
+
+void
+SaltedPasswordCache::clear()
+{
+    std::scoped_lock lock(mutex);
+    entries.clear();
+    insertionOrder.clear();
+}
+
+} // namespace couchbase::sasl::mechanism::scram
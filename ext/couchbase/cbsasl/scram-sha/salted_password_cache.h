@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include <cbcrypto/cbcrypto.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace couchbase::sasl::mechanism::scram
+{
+
+/**
+ * Process-wide cache of SCRAM salted passwords.
+ *
+ * SaltedPassword := Hi(Normalize(password), salt, i) costs i HMAC
+ * rounds, and every connection of the same user to the same cluster
+ * receives the same salt and iteration count, so the value is computed
+ * once per process instead of once per connection. The key includes a
+ * digest of the password, so a changed password never hits a stale entry.
+ */
+class SaltedPasswordCache
+{
+  public:
+    struct Stats {
+        std::uint64_t hits{ 0 };
+        std::uint64_t misses{ 0 };
+        std::size_t size{ 0 };
+    };
+
+    static SaltedPasswordCache& instance();
+
+    /**
+     * Return the salted password, computing it with PBKDF2 on cache miss.
+     */
+    std::string get(couchbase::crypto::Algorithm algorithm,
+                    const std::string& username,
+                    const std::string& password,
+                    const std::string& salt,
+                    unsigned int iterationCount);
+
+    [[nodiscard]] Stats stats() const;
+
+    void clear();
+
+  private:
+    using Key = std::tuple<couchbase::crypto::Algorithm, std::string, std::string, std::string, unsigned int>;
+
+    static constexpr std::size_t maxEntries = 64;
+
+    mutable std::mutex mutex;
+    std::map<Key, std::string> entries;
+    std::list<Key> insertionOrder;
+    Stats counters;
+};
+
+} // namespace couchbase::sasl::mechanism::scram
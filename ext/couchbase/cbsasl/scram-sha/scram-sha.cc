@@ -23,6 +23,7 @@
 
 #include <cbcrypto/cbcrypto.h>
 
+#include <cbsasl/scram-sha/salted_password_cache.h>
 #include <cbsasl/scram-sha/scram-sha.h>
 #include <cbsasl/scram-sha/stringutils.h>
 
@@ -374,7 +375,7 @@ bool
 ClientBackend::generateSaltedPassword(const std::string& secret)
 {
     try {
-        saltedPassword = couchbase::crypto::PBKDF2_HMAC(algorithm, secret, salt, iterationCount);
+        saltedPassword = SaltedPasswordCache::instance().get(algorithm, usernameCallback(), secret, salt, iterationCount);
         return true;
     } catch (...) {
         return false;
@@ -24,9 +24,10 @@
 #include <asio/ssl.hpp>
 
 #include <io/mcbp_session.hxx>
+#include <io/parallel_bootstrap.hxx>
 #include <io/http_session_manager.hxx>
 #include <io/http_command.hxx>
-#include <io/dns_client.hxx>
+#include <io/dns_cache.hxx>
 #include <origin.hxx>
 #include <bucket.hxx>
 #include <operations.hxx>
@@ -34,6 +35,11 @@
 
 #include <diagnostics.hxx>
 
+#include <dcp/consumer.hxx>
+
+#include <tracing/ring_buffer_tracer.hxx>
+#include <tracing/chrome_trace_exporter.hxx>
+
 namespace couchbase
 {
 namespace
@@ -90,8 +96,9 @@ class cluster
     explicit cluster(asio::io_context& ctx)
       : ctx_(ctx)
       , work_(asio::make_work_guard(ctx_))
-      , session_manager_(std::make_shared<io::http_session_manager>(id_, ctx_, tls_))
+      , session_manager_(std::make_shared<io::http_session_manager>(id_, ctx_, tls_, telemetry_))
       , dns_client_(ctx_)
+      , reporting_timer_(ctx_)
     {
     }
 
@@ -99,6 +106,9 @@ class cluster
     void open(const couchbase::origin& origin, Handler&& handler)
     {
         origin_ = origin;
+        origin_.set_telemetry(telemetry_);
+        telemetry_->registry.enabled(origin_.options().enable_metrics);
+        start_reporters();
         if (origin_.options().enable_dns_srv) {
             return asio::post(asio::bind_executor(
               ctx_, [this, handler = std::forward<Handler>(handler)]() mutable { return do_dns_srv(std::forward<Handler>(handler)); }));
@@ -110,6 +120,16 @@ class cluster
     void close(Handler&& handler)
     {
         asio::post(asio::bind_executor(ctx_, [this, handler = std::forward<Handler>(handler)]() {
+            reporting_timer_.cancel();
+            if (origin_.options().enable_tracing) {
+                telemetry_->threshold_reporter.maybe_emit(true);
+                telemetry_->orphan_reporter.maybe_emit(true);
+            }
+            export_spans();
+            telemetry_->tracer.set(nullptr);
+            if (bootstrap_) {
+                bootstrap_->cancel();
+            }
             if (session_) {
                 session_->stop(io::retry_reason::do_not_retry);
             }
@@ -117,6 +137,9 @@ class cluster
                 bucket.second->close();
             }
             session_manager_->close();
+            if (origin_.options().enable_tls) {
+                io::tls_session_cache::instance().forget(tls_);
+            }
             handler();
             work_.reset();
         }));
@@ -156,6 +179,121 @@ class cluster
         return bucket->second->execute(request, std::forward<Handler>(handler));
     }
 
+    template<class Handler>
+    void execute(operations::get_multi_request request, Handler&& handler)
+    {
+        struct multi_get_context {
+            operations::get_multi_response response{};
+            std::atomic_size_t expected{ 0 };
+            std::decay_t<Handler> handler;
+
+            explicit multi_get_context(Handler&& h)
+              : handler(std::forward<Handler>(h))
+            {
+            }
+        };
+        auto ctx = std::make_shared<multi_get_context>(std::forward<Handler>(handler));
+        auto num_of_ids = request.ids.size();
+        if (num_of_ids == 0) {
+            return ctx->handler(std::move(ctx->response));
+        }
+        ctx->response.entries.resize(num_of_ids);
+        ctx->expected = num_of_ids;
+
+        auto max_in_flight_per_node = request.max_in_flight_per_node.value_or(origin_.options().max_bulk_in_flight_per_node);
+        std::map<std::string, std::vector<std::pair<std::size_t, operations::get_request>>> requests_by_bucket{};
+        std::size_t not_found = 0;
+        for (std::size_t i = 0; i < num_of_ids; ++i) {
+            auto& id = request.ids[i];
+            if (buckets_.find(id.bucket) == buckets_.end()) {
+                error_context::key_value err{};
+                err.id = id;
+                err.ec = error::common_errc::bucket_not_found;
+                ctx->response.entries[i].ctx = std::move(err);
+                ++not_found;
+                continue;
+            }
+            operations::get_request req{ std::move(id) };
+            req.timeout = request.timeout;
+            requests_by_bucket[req.id.bucket].emplace_back(i, std::move(req));
+        }
+        if (not_found > 0 && (ctx->expected -= not_found) == 0) {
+            return ctx->handler(std::move(ctx->response));
+        }
+
+        for (auto& [bucket_name, requests] : requests_by_bucket) {
+            buckets_[bucket_name]->execute_get_multi(
+              std::move(requests), max_in_flight_per_node, [ctx](std::size_t position, operations::get_response&& resp) {
+                  ctx->response.entries[position] = std::move(resp);
+                  if (--ctx->expected == 0) {
+                      ctx->handler(std::move(ctx->response));
+                  }
+              });
+        }
+    }
+
+    template<class Handler>
+    void execute(operations::lookup_in_request request, Handler&& handler)
+    {
+        auto bucket = buckets_.find(request.id.bucket);
+        if (bucket == buckets_.end()) {
+            error_context::key_value ctx{};
+            ctx.id = request.id;
+            ctx.ec = error::common_errc::bucket_not_found;
+            return handler(operations::make_response(std::move(ctx), request, operations::lookup_in_request::encoded_response_type{}));
+        }
+        if (request.specs.entries.size() <= protocol::lookup_in_request_body::lookup_in_specs::max_number_of_specs) {
+            return bucket->second->execute(std::move(request), std::forward<Handler>(handler));
+        }
+
+        struct split_lookup_in_context {
+            operations::lookup_in_request request;
+            std::decay_t<Handler> handler;
+            std::vector<operations::lookup_in_response> chunks{};
+            std::atomic_size_t expected{ 0 };
+            std::size_t attempts_left{ max_split_lookup_in_attempts };
+
+            split_lookup_in_context(operations::lookup_in_request&& r, Handler&& h)
+              : request(std::move(r))
+              , handler(std::forward<Handler>(h))
+            {
+            }
+        };
+        auto ctx = std::make_shared<split_lookup_in_context>(std::move(request), std::forward<Handler>(handler));
+        dispatch_lookup_in_chunks(bucket->second, ctx);
+    }
+
+    template<class Handler>
+    void execute(operations::get_projected_request request, Handler&& handler)
+    {
+        std::size_t num_specs = request.projections.size() + (request.with_expiry ? 1 : 0);
+        if (num_specs <= protocol::lookup_in_request_body::lookup_in_specs::max_number_of_specs) {
+            auto bucket = buckets_.find(request.id.bucket);
+            if (bucket == buckets_.end()) {
+                error_context::key_value ctx{};
+                ctx.id = request.id;
+                ctx.ec = error::common_errc::bucket_not_found;
+                return handler(
+                  operations::make_response(std::move(ctx), request, operations::get_projected_request::encoded_response_type{}));
+            }
+            return bucket->second->execute(std::move(request), std::forward<Handler>(handler));
+        }
+
+        /* fetch projections with several sub-document requests instead of transferring the whole document */
+        operations::lookup_in_request lookup{ request.id };
+        lookup.timeout = request.timeout;
+        if (request.with_expiry) {
+            lookup.specs.add_spec(protocol::subdoc_opcode::get, true, "$document.exptime");
+        }
+        for (const auto& path : request.projections) {
+            lookup.specs.add_spec(protocol::subdoc_opcode::get, false, path);
+        }
+        execute(std::move(lookup),
+                [request = std::move(request), handler = std::forward<Handler>(handler)](operations::lookup_in_response&& resp) mutable {
+                    handler(operations::make_response(request, std::move(resp)));
+                });
+    }
+
     template<class Request, class Handler>
     void execute_http(Request request, Handler&& handler)
     {
@@ -187,6 +325,9 @@ class cluster
                 bucket->export_diag_info(res);
             }
             session_manager_->export_diag_info(res);
+            if (origin_.options().enable_tls) {
+                res.tls = io::tls_session_cache::instance().stats(tls_);
+            }
             handler(std::move(res));
         }));
     }
@@ -225,7 +366,142 @@ class cluster
         }));
     }
 
+    /**
+     * Creates DCP consumer for the bucket. It uses its own connections, and does not require the bucket to be opened.
+     */
+    [[nodiscard]] couchbase::telemetry& telemetry()
+    {
+        return *telemetry_;
+    }
+
+    [[nodiscard]] std::shared_ptr<dcp::consumer> dcp_consumer(const std::string& bucket_name, dcp::consumer_options options)
+    {
+        return std::make_shared<dcp::consumer>(id_, ctx_, tls_, origin_, bucket_name, std::move(options));
+    }
+
   private:
+    /**
+     * Number of times split lookup_in is re-read, when its chunks observe different versions of the document.
+     */
+    static const inline std::size_t max_split_lookup_in_attempts = 3;
+
+    /**
+     * Dispatches every chunk of the split lookup_in concurrently. All chunks share the key, so they go to the same vBucket.
+     */
+    template<class Context>
+    static void dispatch_lookup_in_chunks(std::shared_ptr<bucket> b, std::shared_ptr<Context> ctx)
+    {
+        constexpr auto chunk_size = protocol::lookup_in_request_body::lookup_in_specs::max_number_of_specs;
+        const auto& entries = ctx->request.specs.entries;
+        auto num_of_chunks = (entries.size() + chunk_size - 1) / chunk_size;
+        ctx->chunks.clear();
+        ctx->chunks.resize(num_of_chunks);
+        ctx->expected = num_of_chunks;
+        for (std::size_t chunk = 0; chunk < num_of_chunks; ++chunk) {
+            operations::lookup_in_request req{ ctx->request.id };
+            req.access_deleted = ctx->request.access_deleted;
+            req.timeout = ctx->request.timeout;
+            auto first = entries.begin() + static_cast<std::ptrdiff_t>(chunk * chunk_size);
+            req.specs.entries.assign(first, first + static_cast<std::ptrdiff_t>(std::min(chunk_size, entries.size() - chunk * chunk_size)));
+            b->execute(std::move(req), [b, ctx, chunk](operations::lookup_in_response&& resp) {
+                ctx->chunks[chunk] = std::move(resp);
+                if (--ctx->expected == 0) {
+                    merge_lookup_in_chunks(b, ctx);
+                }
+            });
+        }
+    }
+
+    /**
+     * Merges fields of the chunks back in the order of the original specs.
+     *
+     * The chunks are consistent only if they have been read at the same CAS, otherwise the document is read again.
+     */
+    template<class Context>
+    static void merge_lookup_in_chunks(std::shared_ptr<bucket> b, std::shared_ptr<Context> ctx)
+    {
+        constexpr auto chunk_size = protocol::lookup_in_request_body::lookup_in_specs::max_number_of_specs;
+        for (auto& chunk : ctx->chunks) {
+            if (chunk.ctx.ec) {
+                chunk.fields.clear();
+                return ctx->handler(std::move(chunk));
+            }
+        }
+        auto response = std::move(ctx->chunks.front());
+        for (std::size_t chunk = 1; chunk < ctx->chunks.size(); ++chunk) {
+            if (ctx->chunks[chunk].cas != response.cas) {
+                if (--ctx->attempts_left > 0) {
+                    return dispatch_lookup_in_chunks(b, ctx);
+                }
+                response.ctx.ec = error::common_errc::cas_mismatch;
+                response.fields.clear();
+                return ctx->handler(std::move(response));
+            }
+        }
+        response.fields.reserve(ctx->request.specs.entries.size());
+        for (std::size_t chunk = 1; chunk < ctx->chunks.size(); ++chunk) {
+            response.deleted = response.deleted || ctx->chunks[chunk].deleted;
+            for (auto& field : ctx->chunks[chunk].fields) {
+                field.original_index += chunk * chunk_size;
+                response.fields.emplace_back(std::move(field));
+            }
+        }
+        ctx->handler(std::move(response));
+    }
+
+    void start_reporters()
+    {
+        const auto& options = origin_.options();
+        telemetry_->threshold_reporter.configure(options.enable_tracing,
+                                                 {
+                                                   options.tracing_threshold_kv,
+                                                   options.tracing_threshold_query,
+                                                   options.tracing_threshold_analytics,
+                                                   options.tracing_threshold_search,
+                                                   options.tracing_threshold_view,
+                                                   options.tracing_threshold_management,
+                                                 },
+                                                 options.tracing_threshold_sample_size,
+                                                 options.tracing_threshold_emit_interval);
+        telemetry_->orphan_reporter.configure(
+          options.enable_tracing, options.tracing_orphaned_sample_size, options.tracing_orphaned_emit_interval);
+        if (options.enable_tracing) {
+            schedule_reporters(std::min(options.tracing_threshold_emit_interval, options.tracing_orphaned_emit_interval));
+        }
+        if (options.tracing_ring_buffer_capacity > 0) {
+            telemetry_->tracer.set(
+              std::make_shared<tracing::ring_buffer_tracer>(options.tracing_ring_buffer_capacity, options.tracing_sample_rate));
+        }
+    }
+
+    void export_spans()
+    {
+        const auto& path = origin_.options().tracing_chrome_trace_path;
+        if (path.empty()) {
+            return;
+        }
+        auto tracer = std::dynamic_pointer_cast<tracing::ring_buffer_tracer>(telemetry_->tracer.get());
+        if (!tracer) {
+            return;
+        }
+        if (auto ec = tracing::chrome_trace_exporter::write(path, tracer->snapshot()); ec) {
+            spdlog::warn("unable to write request spans to \"{}\": {}", path, ec.message());
+        }
+    }
+
+    void schedule_reporters(std::chrono::milliseconds interval)
+    {
+        reporting_timer_.expires_after(interval);
+        reporting_timer_.async_wait([this, interval](std::error_code ec) {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            telemetry_->threshold_reporter.maybe_emit();
+            telemetry_->orphan_reporter.maybe_emit();
+            schedule_reporters(interval);
+        });
+    }
+
     template<typename Handler>
     void do_dns_srv(Handler&& handler)
     {
@@ -233,9 +509,11 @@ class cluster
         std::string service;
         std::tie(hostname, service) = origin_.next_address();
         service = origin_.options().enable_tls ? "_couchbases" : "_couchbase";
-        dns_client_.query_srv(
+        io::dns::dns_cache::instance().query_srv(
+          dns_client_,
           hostname,
           service,
+          origin_.options().dns_negative_cache_ttl,
           [hostname, this, handler = std::forward<Handler>(handler)](couchbase::io::dns::dns_client::dns_srv_response&& resp) mutable {
               if (resp.ec) {
                   spdlog::warn("failed to fetch DNS SRV records for \"{}\" ({}), assuming that cluster is listening this address",
@@ -266,6 +544,7 @@ class cluster
     {
         if (origin_.options().enable_tls) {
             tls_.set_options(asio::ssl::context::default_workarounds | asio::ssl::context::no_sslv2 | asio::ssl::context::no_sslv3);
+            io::tls_session_cache::enable(tls_);
             if (!origin_.options().trust_certificate.empty()) {
                 std::error_code ec{};
                 spdlog::debug(R"([{}]: use TLS certificate chain: "{}")", id_, origin_.options().trust_certificate);
@@ -300,12 +579,18 @@ class cluster
                     return handler(ec);
                 }
             }
-            session_ = std::make_shared<io::mcbp_session>(id_, ctx_, tls_, origin_);
-        } else {
-            session_ = std::make_shared<io::mcbp_session>(id_, ctx_, origin_);
         }
-        session_->bootstrap([this, handler = std::forward<Handler>(handler)](std::error_code ec, const configuration& config) mutable {
+        bootstrap_ = std::make_shared<io::parallel_bootstrap>(origin_, [this](const couchbase::origin& origin) {
+            if (origin_.options().enable_tls) {
+                return std::make_shared<io::mcbp_session>(id_, ctx_, tls_, origin);
+            }
+            return std::make_shared<io::mcbp_session>(id_, ctx_, origin);
+        });
+        bootstrap_->start([this, handler = std::forward<Handler>(handler)](
+                            std::error_code ec, std::shared_ptr<io::mcbp_session> session, const configuration& config) mutable {
+            bootstrap_.reset();
             if (!ec) {
+                session_ = std::move(session);
                 if (origin_.options().network == "auto") {
                     origin_.options().network = config.select_network(session_->bootstrap_hostname());
                     if (origin_.options().network == "default") {
@@ -342,9 +627,12 @@ class cluster
     asio::io_context& ctx_;
     asio::executor_work_guard<asio::io_context::executor_type> work_;
     asio::ssl::context tls_{ asio::ssl::context::tls_client };
+    std::shared_ptr<couchbase::telemetry> telemetry_{ std::make_shared<couchbase::telemetry>() };
     std::shared_ptr<io::http_session_manager> session_manager_;
     io::dns::dns_config& dns_config_{ io::dns::dns_config::get() };
     couchbase::io::dns::dns_client dns_client_;
+    asio::steady_timer reporting_timer_;
+    std::shared_ptr<io::parallel_bootstrap> bootstrap_{};
     std::shared_ptr<io::mcbp_session> session_{};
     std::map<std::string, std::shared_ptr<bucket>> buckets_{};
     couchbase::origin origin_{};
@@ -24,6 +24,7 @@ namespace couchbase
 struct cluster_options {
     std::chrono::milliseconds bootstrap_timeout = timeout_defaults::bootstrap_timeout;
     std::chrono::milliseconds connect_timeout = timeout_defaults::connect_timeout;
+    std::chrono::milliseconds connection_attempt_delay = timeout_defaults::connection_attempt_delay;
     std::chrono::milliseconds key_value_timeout = timeout_defaults::key_value_timeout;
     std::chrono::milliseconds key_value_durable_timeout = timeout_defaults::key_value_durable_timeout;
     std::chrono::milliseconds view_timeout = timeout_defaults::view_timeout;
@@ -32,6 +33,8 @@ struct cluster_options {
     std::chrono::milliseconds search_timeout = timeout_defaults::search_timeout;
     std::chrono::milliseconds management_timeout = timeout_defaults::management_timeout;
     std::chrono::milliseconds dns_srv_timeout = timeout_defaults::dns_srv_timeout;
+    std::chrono::milliseconds dns_cache_ttl = timeout_defaults::dns_cache_ttl;
+    std::chrono::milliseconds dns_negative_cache_ttl = timeout_defaults::dns_negative_cache_ttl;
 
     bool enable_tls{ false };
     std::string trust_certificate{};
@@ -43,6 +46,11 @@ struct cluster_options {
     bool enable_unordered_execution{ true };
     bool enable_clustermap_notification{ true };
     bool enable_compression{ true };
+    bool enable_metrics{ true };
+    bool enable_pipelined_bootstrap{ true };
+    bool enable_read_coalescing{ false };
+    size_t near_cache_capacity{ 0 };
+    std::chrono::milliseconds near_cache_max_staleness = timeout_defaults::near_cache_max_staleness;
     std::string network{ "auto" };
 
     std::chrono::milliseconds tcp_keep_alive_interval = timeout_defaults::tcp_keep_alive_interval;
@@ -52,6 +60,26 @@ struct cluster_options {
 
     size_t max_http_connections{ 0 };
     std::chrono::milliseconds idle_http_connection_timeout = timeout_defaults::idle_http_connection_timeout;
+
+    bool enable_tracing{ true };
+    std::chrono::milliseconds tracing_threshold_kv = timeout_defaults::tracing_threshold_kv;
+    std::chrono::milliseconds tracing_threshold_query = timeout_defaults::tracing_threshold_query;
+    std::chrono::milliseconds tracing_threshold_view = timeout_defaults::tracing_threshold_view;
+    std::chrono::milliseconds tracing_threshold_search = timeout_defaults::tracing_threshold_search;
+    std::chrono::milliseconds tracing_threshold_analytics = timeout_defaults::tracing_threshold_analytics;
+    std::chrono::milliseconds tracing_threshold_management = timeout_defaults::tracing_threshold_management;
+    size_t tracing_threshold_sample_size{ 10 };
+    std::chrono::milliseconds tracing_threshold_emit_interval = timeout_defaults::tracing_threshold_emit_interval;
+    size_t tracing_orphaned_sample_size{ 64 };
+    std::chrono::milliseconds tracing_orphaned_emit_interval = timeout_defaults::tracing_orphaned_emit_interval;
+    size_t tracing_ring_buffer_capacity{ 0 };
+    size_t tracing_sample_rate{ 1 };
+    std::string tracing_chrome_trace_path{};
+
+    size_t max_bulk_in_flight_per_node{ 64 };
+    size_t max_kv_in_flight_requests{ 8192 };
+    size_t max_kv_queued_bytes{ 64 * 1024 * 1024 };
+    size_t max_parallel_bootstrap_nodes{ 1 };
 };
 
 } // namespace couchbase
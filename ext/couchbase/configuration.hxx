@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <set>
 
 #include <gsl/gsl_util>
@@ -25,6 +28,7 @@
 #include <spdlog/spdlog.h>
 #include <tao/json.hpp>
 #include <utils/crc32.hxx>
+#include <utils/md5.hxx>
 
 #include <capabilities.hxx>
 #include <service_type.hxx>
@@ -203,6 +207,11 @@ struct configuration {
     std::set<cluster_capability> cluster_capabilities{};
     node_locator_type node_locator{ node_locator_type::unknown };
 
+    /**
+     * Points of the ketama continuum (hash and node index) sorted by hash, used to map keys of memcached buckets.
+     */
+    std::vector<std::pair<std::uint32_t, std::int16_t>> ketama_continuum{};
+
     [[nodiscard]] std::string rev_str() const
     {
         return rev ? fmt::format("{}", *rev) : "(none)";
@@ -234,8 +243,41 @@ struct configuration {
         throw std::runtime_error("no nodes marked as this_node");
     }
 
+    /**
+     * Places every data node on the continuum at 160 points (40 MD5 digests of "host:port-N", four points per digest).
+     */
+    void build_ketama_continuum()
+    {
+        static constexpr std::size_t digests_per_node = 40;
+        ketama_continuum.clear();
+        for (const auto& n : nodes) {
+            if (!n.services_plain.key_value) {
+                continue;
+            }
+            for (std::size_t i = 0; i < digests_per_node; ++i) {
+                auto digest = utils::md5(fmt::format("{}:{}-{}", n.hostname, *n.services_plain.key_value, i));
+                for (std::size_t h = 0; h < 4; ++h) {
+                    ketama_continuum.emplace_back(ketama_point(digest, h), static_cast<std::int16_t>(n.index));
+                }
+            }
+        }
+        std::sort(ketama_continuum.begin(), ketama_continuum.end());
+    }
+
     std::pair<std::uint16_t, std::int16_t> map_key(const std::string& key)
     {
+        if (node_locator == node_locator_type::ketama) {
+            if (ketama_continuum.empty()) {
+                return { 0, -1 };
+            }
+            auto hash = ketama_point(utils::md5(key), 0);
+            auto point = std::lower_bound(
+              ketama_continuum.begin(), ketama_continuum.end(), std::make_pair(hash, std::numeric_limits<std::int16_t>::min()));
+            if (point == ketama_continuum.end()) {
+                point = ketama_continuum.begin();
+            }
+            return { 0, point->second };
+        }
         if (!vbmap.has_value()) {
             throw std::runtime_error("cannot map key: partition map is not available");
         }
@@ -243,6 +285,13 @@ struct configuration {
         auto vbucket = uint16_t(crc % vbmap->size());
         return { vbucket, vbmap->at(vbucket)[0] };
     }
+
+  private:
+    [[nodiscard]] static std::uint32_t ketama_point(const std::array<std::uint8_t, 16>& digest, std::size_t group)
+    {
+        return (static_cast<std::uint32_t>(digest[3 + group * 4]) << 24U) | (static_cast<std::uint32_t>(digest[2 + group * 4]) << 16U) |
+               (static_cast<std::uint32_t>(digest[1 + group * 4]) << 8U) | static_cast<std::uint32_t>(digest[group * 4]);
+    }
 };
 
 configuration
@@ -646,6 +695,9 @@ struct traits<couchbase::configuration> {
                 }
             }
         }
+        if (result.node_locator == couchbase::configuration::node_locator_type::ketama) {
+            result.build_ketama_continuum();
+        }
         return result;
     }
 };
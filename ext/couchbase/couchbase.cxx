@@ -15,6 +15,16 @@
  *   limitations under the License.
  */
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 #include <build_info.hxx>
 #include <version.hxx>
 
@@ -32,6 +42,7 @@
 #include <platform/terminate_handler.h>
 
 #include <cluster.hxx>
+#include <logger.hxx>
 #include <operations.hxx>
 
 #include <io/dns_client.hxx>
@@ -129,6 +140,9 @@ init_versions(VALUE mCouchbase)
     rb_hash_aset(cb_BuildInfo, rb_id2sym(rb_intern("openssl_include_dir")), rb_str_freeze(rb_str_new_cstr(OPENSSL_INCLUDE_DIR)));
 #if defined(STATIC_OPENSSL)
     rb_hash_aset(cb_BuildInfo, rb_id2sym(rb_intern("static_openssl")), Qtrue);
+#endif
+#if defined(ENABLE_IO_URING)
+    rb_hash_aset(cb_BuildInfo, rb_id2sym(rb_intern("io_uring")), Qtrue);
 #endif
     rb_hash_aset(cb_BuildInfo, rb_id2sym(rb_intern("ruby_library")), rb_str_freeze(rb_str_new_cstr(RUBY_LIBRARY)));
     rb_hash_aset(cb_BuildInfo, rb_id2sym(rb_intern("ruby_include_dir")), rb_str_freeze(rb_str_new_cstr(RUBY_INCLUDE_DIR)));
@@ -137,15 +151,94 @@ init_versions(VALUE mCouchbase)
                   std::string_view(RSTRING_PTR(build_info), static_cast<std::size_t>(RSTRING_LEN(build_info))));
 }
 
+/**
+ * Batches of DCP events, waiting for Backend#dcp_poll. The polled batch is kept until Backend#dcp_ack, and returned again by the next
+ * poll, if the application has not acknowledged it. It is shared, so that the poll could convert events without copying them, and
+ * without holding the mutex.
+ */
+struct cb_dcp_consumer_data {
+    std::shared_ptr<couchbase::dcp::consumer> consumer{};
+    std::mutex mutex{};
+    std::condition_variable cv{};
+    std::deque<couchbase::dcp::batch> batches{};
+    std::shared_ptr<const couchbase::dcp::batch> polled{};
+    std::optional<std::error_code> completed{};
+    bool interrupted{ false }; /* set by the unblocking function, when Ruby interrupts the thread waiting in Backend#dcp_poll */
+};
+
+/**
+ * Wakeup descriptor, shared by the futures of the backend. Every completion makes it readable, so that fibers could wait for their
+ * futures with IO#wait_readable. Only one waiter at a time drains it, and then lets the others check their futures (see
+ * Couchbase::Future).
+ */
+struct cb_completion_queue {
+    int read_fd{ -1 };
+    int write_fd{ -1 };
+
+    cb_completion_queue() = default;
+    cb_completion_queue(const cb_completion_queue&) = delete;
+    cb_completion_queue& operator=(const cb_completion_queue&) = delete;
+
+    ~cb_completion_queue()
+    {
+        if (write_fd >= 0 && write_fd != read_fd) {
+            close(write_fd);
+        }
+        if (read_fd >= 0) {
+            close(read_fd);
+        }
+    }
+
+    [[nodiscard]] bool open()
+    {
+#ifdef __linux__
+        read_fd = write_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        return read_fd >= 0;
+#else
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        read_fd = fds[0];
+        write_fd = fds[1];
+        for (int fd : fds) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+        return true;
+#endif
+    }
+
+    void notify() const
+    {
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto rc = write(write_fd, &one, sizeof(one));
+    }
+
+    void drain() const
+    {
+        std::uint64_t buffer[16];
+        while (read(read_fd, buffer, sizeof(buffer)) > 0) {
+        }
+    }
+};
+
 struct cb_backend_data {
     std::unique_ptr<asio::io_context> ctx;
     std::unique_ptr<couchbase::cluster> cluster;
     std::thread worker;
+    std::map<std::uint64_t, std::shared_ptr<cb_dcp_consumer_data>> dcp_consumers{};
+    std::uint64_t next_dcp_consumer_id{ 0 };
+    std::shared_ptr<cb_completion_queue> completions{}; /* opened by the first asynchronous operation */
 };
 
 static void
 cb_backend_close(cb_backend_data* backend)
 {
+    for (auto& [id, data] : backend->dcp_consumers) {
+        data->consumer->stop();
+    }
+    backend->dcp_consumers.clear();
     if (backend->cluster) {
         auto barrier = std::make_shared<std::promise<void>>();
         auto f = barrier->get_future();
@@ -427,6 +520,9 @@ cb_map_error_code(std::error_code ec, const std::string& message)
 
             case couchbase::error::common_errc::index_exists:
                 return rb_exc_new_cstr(eIndexExists, fmt::format("{}: {}", message, ec.message()).c_str());
+
+            case couchbase::error::common_errc::job_queue_full:
+                return rb_exc_new_cstr(eJobQueueFull, fmt::format("{}: {}", message, ec.message()).c_str());
         }
     } else if (ec.category() == couchbase::error::detail::get_key_value_category()) {
         switch (couchbase::error::key_value_errc(ec.value())) {
@@ -851,6 +947,232 @@ cb_wait_for_future(Future&& f) -> decltype(f.get())
     return std::move(arg.res);
 }
 
+/**
+ * Completion of the operation, started by one of the *_async methods of the Backend.
+ *
+ * The IO thread stores the response, wakes the threads waiting in Future#wait, and makes the descriptor of the backend readable, so
+ * that fibers could wait with IO#wait_readable, which cooperates with Fiber::Scheduler. The response is converted to Ruby objects
+ * only when the result is requested, because it needs the GVL.
+ */
+struct cb_future_state {
+    std::shared_ptr<cb_completion_queue> completions;
+    std::mutex mutex{};
+    std::condition_variable cv{};
+    std::function<VALUE(VALUE& exc)> result{};
+    bool interrupted{ false }; /* set by the unblocking function, when Ruby interrupts the thread waiting in Future#wait */
+
+    explicit cb_future_state(std::shared_ptr<cb_completion_queue> queue)
+      : completions(std::move(queue))
+    {
+    }
+
+    [[nodiscard]] bool completed()
+    {
+        std::scoped_lock lock(mutex);
+        return static_cast<bool>(result);
+    }
+
+    void complete(std::function<VALUE(VALUE& exc)>&& fun)
+    {
+        {
+            std::scoped_lock lock(mutex);
+            result = std::move(fun);
+        }
+        cv.notify_all();
+        completions->notify();
+    }
+};
+
+struct cb_future_data {
+    std::shared_ptr<cb_future_state> state{};
+};
+
+static void
+cb_Future_mark(void* /* ptr */)
+{
+}
+
+static void
+cb_Future_free(void* ptr)
+{
+    auto* future = static_cast<cb_future_data*>(ptr);
+    future->~cb_future_data();
+    ruby_xfree(future);
+}
+
+static size_t
+cb_Future_memsize(const void* /* ptr */)
+{
+    return sizeof(cb_future_data) + sizeof(cb_future_state);
+}
+
+static const rb_data_type_t cb_future_type{
+    "Couchbase/Backend/Future",
+    { cb_Future_mark,
+      cb_Future_free,
+      cb_Future_memsize,
+// only one reserved field when GC.compact implemented
+#ifdef T_MOVED
+      nullptr,
+#endif
+      {} },
+#ifdef RUBY_TYPED_FREE_IMMEDIATELY
+    nullptr,
+    nullptr,
+    RUBY_TYPED_FREE_IMMEDIATELY,
+#endif
+};
+
+static VALUE cFuture;
+
+/**
+ * @return descriptor, that becomes readable when any future of the backend completes
+ */
+static VALUE
+cb_Future_fileno(VALUE self)
+{
+    cb_future_data* future = nullptr;
+    TypedData_Get_Struct(self, cb_future_data, &cb_future_type, future);
+    return INT2FIX(future->state->completions->read_fd);
+}
+
+/**
+ * Resets the descriptor, returned by #fileno. It is called by the waiter, that has been woken up by the descriptor, before it lets
+ * other waiters check their futures.
+ */
+static VALUE
+cb_Future_drain(VALUE self)
+{
+    cb_future_data* future = nullptr;
+    TypedData_Get_Struct(self, cb_future_data, &cb_future_type, future);
+    future->state->completions->drain();
+    return Qnil;
+}
+
+/**
+ * Waits for the completion without the GVL. Returns early, when Ruby interrupts the thread, so that the caller should check
+ * #completed? again.
+ */
+static VALUE
+cb_Future_wait(VALUE self)
+{
+    cb_future_data* future = nullptr;
+    TypedData_Get_Struct(self, cb_future_data, &cb_future_type, future);
+
+    auto state = future->state;
+    /* the variant, that does not raise pending interrupts, so that the state is released before Ruby handles them */
+    rb_thread_call_without_gvl2(
+      [](void* param) -> void* {
+          auto* pack = static_cast<cb_future_state*>(param);
+          std::unique_lock lock(pack->mutex);
+          pack->cv.wait(lock, [pack]() { return pack->result || pack->interrupted; });
+          pack->interrupted = false;
+          return nullptr;
+      },
+      state.get(),
+      [](void* param) {
+          auto* pack = static_cast<cb_future_state*>(param);
+          std::scoped_lock lock(pack->mutex);
+          pack->interrupted = true;
+          pack->cv.notify_all();
+      },
+      state.get());
+    return state->completed() ? Qtrue : Qfalse;
+}
+
+static VALUE
+cb_Future_completed(VALUE self)
+{
+    cb_future_data* future = nullptr;
+    TypedData_Get_Struct(self, cb_future_data, &cb_future_type, future);
+    return future->state->completed() ? Qtrue : Qfalse;
+}
+
+/**
+ * Converts response of the completed operation, the method could be called only once.
+ */
+static VALUE
+cb_Future_result(VALUE self)
+{
+    cb_future_data* future = nullptr;
+    TypedData_Get_Struct(self, cb_future_data, &cb_future_type, future);
+
+    VALUE exc = Qnil;
+    VALUE res = Qnil;
+    {
+        std::function<VALUE(VALUE & exc)> result;
+        {
+            std::scoped_lock lock(future->state->mutex);
+            std::swap(result, future->state->result);
+        }
+        if (!result) {
+            rb_raise(rb_eArgError, "Operation has not been completed yet, or its result has been taken already");
+            return Qnil;
+        }
+        res = result(exc);
+    }
+    if (!NIL_P(exc)) {
+        rb_exc_raise(exc);
+    }
+    return res;
+}
+
+template<typename Request, typename = void>
+struct cb_is_http_request : std::false_type {
+};
+
+template<typename Request>
+struct cb_is_http_request<Request, std::void_t<decltype(Request::type)>> : std::true_type {
+};
+
+template<typename Request, typename Handler>
+static void
+cb_dispatch(cb_backend_data* backend, Request&& req, Handler&& handler)
+{
+    if constexpr (cb_is_http_request<std::decay_t<Request>>::value) {
+        backend->cluster->execute_http(std::forward<Request>(req), std::forward<Handler>(handler));
+    } else {
+        backend->cluster->execute(std::forward<Request>(req), std::forward<Handler>(handler));
+    }
+}
+
+/**
+ * Executes the request and converts its response with the converter, which has signature VALUE(Response&, VALUE& exc).
+ *
+ * In synchronous mode the calling thread waits for the response without the GVL, otherwise the function returns Backend::Future
+ * immediately, and the conversion is deferred until Future#result.
+ */
+template<typename Request, typename Converter>
+static VALUE
+cb_execute(cb_backend_data* backend, Request&& req, bool async, VALUE& exc, Converter&& convert)
+{
+    using response_type = typename std::decay_t<Request>::response_type;
+    if (async) {
+        if (!backend->completions) {
+            auto completions = std::make_shared<cb_completion_queue>();
+            if (!completions->open()) {
+                exc = rb_exc_new_cstr(rb_eRuntimeError,
+                                      fmt::format("unable to allocate descriptor for the futures: {}", std::strerror(errno)).c_str());
+                return Qnil;
+            }
+            backend->completions = std::move(completions);
+        }
+        auto state = std::make_shared<cb_future_state>(backend->completions);
+        cb_future_data* future = nullptr;
+        VALUE obj = TypedData_Make_Struct(cFuture, cb_future_data, &cb_future_type, future);
+        new (future) cb_future_data{ state };
+        cb_dispatch(backend, std::forward<Request>(req), [state, convert](response_type&& resp) mutable {
+            state->complete([resp = std::move(resp), convert](VALUE& e) mutable { return convert(resp, e); });
+        });
+        return obj;
+    }
+    auto barrier = std::make_shared<std::promise<response_type>>();
+    auto f = barrier->get_future();
+    cb_dispatch(backend, std::forward<Request>(req), [barrier](response_type&& resp) mutable { barrier->set_value(std::move(resp)); });
+    auto resp = cb_wait_for_future(f);
+    return convert(resp, exc);
+}
+
 static VALUE
 cb_Backend_open(VALUE self, VALUE connection_string, VALUE credentials, VALUE options)
 {
@@ -899,6 +1221,7 @@ cb_Backend_open(VALUE self, VALUE connection_string, VALUE credentials, VALUE op
             if (!NIL_P(allowed_mechanisms)) {
                 Check_Type(allowed_mechanisms, T_ARRAY);
                 auto allowed_mechanisms_size = static_cast<size_t>(RARRAY_LEN(allowed_mechanisms));
+                auth.allowed_sasl_mechanisms.clear();
                 auth.allowed_sasl_mechanisms.reserve(allowed_mechanisms_size);
                 for (size_t i = 0; i < allowed_mechanisms_size; ++i) {
                     VALUE mechanism = rb_ary_entry(allowed_mechanisms, static_cast<long>(i));
@@ -1032,12 +1355,97 @@ cb_Backend_diagnostics(VALUE self, VALUE report_id)
                 rb_ary_push(endpoints, service);
             }
         }
+        if (resp.tls) {
+            VALUE tls = rb_hash_new();
+            rb_hash_aset(tls, rb_id2sym(rb_intern("full_handshakes")), ULL2NUM(resp.tls->full_handshakes));
+            rb_hash_aset(tls, rb_id2sym(rb_intern("resumed_handshakes")), ULL2NUM(resp.tls->resumed_handshakes));
+            rb_hash_aset(tls, rb_id2sym(rb_intern("failed_handshakes")), ULL2NUM(resp.tls->failed_handshakes));
+            rb_hash_aset(tls, rb_id2sym(rb_intern("total_handshake_us")), ULL2NUM(resp.tls->total_handshake_us));
+            rb_hash_aset(tls, rb_id2sym(rb_intern("max_handshake_us")), ULL2NUM(resp.tls->max_handshake_us));
+            rb_hash_aset(res, rb_id2sym(rb_intern("tls")), tls);
+        }
         return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
+static VALUE
+cb_histogram_to_hash(const couchbase::metrics::histogram_snapshot& histogram)
+{
+    VALUE res = rb_hash_new();
+    rb_hash_aset(res, rb_id2sym(rb_intern("count")), ULL2NUM(histogram.count));
+    rb_hash_aset(res, rb_id2sym(rb_intern("mean")), DBL2NUM(histogram.mean()));
+    rb_hash_aset(res, rb_id2sym(rb_intern("max")), ULL2NUM(histogram.max));
+    VALUE percentiles = rb_hash_new();
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9, 99.99 }) {
+        rb_hash_aset(percentiles, DBL2NUM(percentile), ULL2NUM(histogram.value_at_percentile(percentile)));
+    }
+    rb_hash_aset(res, rb_id2sym(rb_intern("percentiles")), percentiles);
+    return res;
+}
+
+static VALUE
+cb_Backend_metrics(VALUE self)
+{
+    cb_backend_data* backend = nullptr;
+    TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
+    if (!backend->cluster) {
+        rb_raise(rb_eArgError, "Cluster has been closed already");
+        return Qnil;
+    }
+
+    const auto& registry = backend->cluster->telemetry().registry;
+    auto snapshot = registry.snapshot();
+
+    VALUE res = rb_hash_new();
+    rb_hash_aset(res, rb_id2sym(rb_intern("enabled")), registry.enabled() ? Qtrue : Qfalse);
+    VALUE kv = rb_ary_new_capa(static_cast<long>(snapshot.kv.size()));
+    for (const auto& entry : snapshot.kv) {
+        VALUE metrics = rb_hash_new();
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("opcode")), rb_id2sym(rb_intern(fmt::format("{}", entry.opcode).c_str())));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("node")), cb_str_new(entry.node));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("operations")), ULL2NUM(entry.operations));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("retries")), ULL2NUM(entry.retries));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("timeouts")), ULL2NUM(entry.timeouts));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("bytes_in")), ULL2NUM(entry.bytes_in));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("bytes_out")), ULL2NUM(entry.bytes_out));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("latency_us")), cb_histogram_to_hash(entry.latency));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("server_duration_us")), cb_histogram_to_hash(entry.server_duration));
+        rb_ary_push(kv, metrics);
+    }
+    rb_hash_aset(res, rb_id2sym(rb_intern("kv")), kv);
+    VALUE http = rb_ary_new_capa(static_cast<long>(snapshot.http.size()));
+    for (const auto& entry : snapshot.http) {
+        VALUE metrics = rb_hash_new();
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("service")), rb_id2sym(rb_intern(fmt::format("{}", entry.type).c_str())));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("node")), cb_str_new(entry.node));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("operations")), ULL2NUM(entry.operations));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("retries")), ULL2NUM(entry.retries));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("timeouts")), ULL2NUM(entry.timeouts));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("bytes_in")), ULL2NUM(entry.bytes_in));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("bytes_out")), ULL2NUM(entry.bytes_out));
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("latency_us")), cb_histogram_to_hash(entry.latency));
+        rb_ary_push(http, metrics);
+    }
+    rb_hash_aset(res, rb_id2sym(rb_intern("http")), http);
+    VALUE coalescing = rb_hash_new();
+    rb_hash_aset(coalescing, rb_id2sym(rb_intern("leaders")), ULL2NUM(snapshot.coalescing.leaders));
+    rb_hash_aset(coalescing, rb_id2sym(rb_intern("coalesced")), ULL2NUM(snapshot.coalescing.coalesced));
+    rb_hash_aset(res, rb_id2sym(rb_intern("coalescing")), coalescing);
+    VALUE near_cache = rb_hash_new();
+    rb_hash_aset(near_cache, rb_id2sym(rb_intern("hits")), ULL2NUM(snapshot.near_cache.hits));
+    rb_hash_aset(near_cache, rb_id2sym(rb_intern("misses")), ULL2NUM(snapshot.near_cache.misses));
+    rb_hash_aset(near_cache, rb_id2sym(rb_intern("evictions")), ULL2NUM(snapshot.near_cache.evictions));
+    rb_hash_aset(near_cache, rb_id2sym(rb_intern("invalidations")), ULL2NUM(snapshot.near_cache.invalidations));
+    rb_hash_aset(res, rb_id2sym(rb_intern("near_cache")), near_cache);
+    VALUE logger = rb_hash_new();
+    rb_hash_aset(logger, rb_id2sym(rb_intern("async")), couchbase::logger::is_async() ? Qtrue : Qfalse);
+    rb_hash_aset(logger, rb_id2sym(rb_intern("dropped")), ULL2NUM(couchbase::logger::dropped_messages()));
+    rb_hash_aset(res, rb_id2sym(rb_intern("logger")), logger);
+    return res;
+}
+
 static VALUE
 cb_Backend_open_bucket(VALUE self, VALUE bucket, VALUE wait_until_ready)
 {
@@ -1560,7 +1968,7 @@ cb_Backend_ping(VALUE self, VALUE bucket, VALUE options)
 }
 
 static VALUE
-cb_Backend_document_get(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options)
+cb_document_get(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options, bool async)
 {
     cb_backend_data* backend = nullptr;
     TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
@@ -1586,25 +1994,38 @@ cb_Backend_document_get(VALUE self, VALUE bucket, VALUE collection, VALUE id, VA
         if (!NIL_P(exc)) {
             break;
         }
-        auto barrier = std::make_shared<std::promise<couchbase::operations::get_response>>();
-        auto f = barrier->get_future();
-        backend->cluster->execute(req, [barrier](couchbase::operations::get_response&& resp) mutable { barrier->set_value(resp); });
-        auto resp = cb_wait_for_future(f);
-        if (resp.ctx.ec) {
-            exc = cb_map_error_code(resp.ctx, "unable to fetch document");
+        VALUE res = cb_execute(backend, std::move(req), async, exc, [](couchbase::operations::get_response& resp, VALUE& error) -> VALUE {
+            if (resp.ctx.ec) {
+                error = cb_map_error_code(resp.ctx, "unable to fetch document");
+                return Qnil;
+            }
+            VALUE entry = rb_hash_new();
+            rb_hash_aset(entry, rb_id2sym(rb_intern("content")), cb_str_new(resp.value));
+            rb_hash_aset(entry, rb_id2sym(rb_intern("cas")), ULL2NUM(resp.cas));
+            rb_hash_aset(entry, rb_id2sym(rb_intern("flags")), UINT2NUM(resp.flags));
+            return entry;
+        });
+        if (!NIL_P(exc)) {
             break;
         }
-
-        VALUE res = rb_hash_new();
-        rb_hash_aset(res, rb_id2sym(rb_intern("content")), cb_str_new(resp.value));
-        rb_hash_aset(res, rb_id2sym(rb_intern("cas")), ULL2NUM(resp.cas));
-        rb_hash_aset(res, rb_id2sym(rb_intern("flags")), UINT2NUM(resp.flags));
         return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
+static VALUE
+cb_Backend_document_get(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options)
+{
+    return cb_document_get(self, bucket, collection, id, options, false);
+}
+
+static VALUE
+cb_Backend_document_get_async(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options)
+{
+    return cb_document_get(self, bucket, collection, id, options, true);
+}
+
 static VALUE
 cb_Backend_document_get_multi(VALUE self, VALUE keys, VALUE options)
 {
@@ -1630,23 +2051,29 @@ cb_Backend_document_get_multi(VALUE self, VALUE keys, VALUE options)
             break;
         }
 
-        auto num_of_ids = ids.size();
-        std::vector<std::shared_ptr<std::promise<couchbase::operations::get_response>>> barriers;
-        barriers.reserve(num_of_ids);
+        VALUE max_in_flight_per_node = Qnil;
+        exc = cb_extract_option_fixnum(max_in_flight_per_node, options, "max_in_flight_per_node");
+        if (!NIL_P(exc)) {
+            break;
+        }
 
-        for (auto& id : ids) {
-            couchbase::operations::get_request req{ std::move(id) };
-            if (timeout.count() > 0) {
-                req.timeout = timeout;
-            }
-            auto barrier = std::make_shared<std::promise<couchbase::operations::get_response>>();
-            backend->cluster->execute(req, [barrier](couchbase::operations::get_response&& resp) mutable { barrier->set_value(resp); });
-            barriers.emplace_back(barrier);
+        auto num_of_ids = ids.size();
+        couchbase::operations::get_multi_request req{ std::move(ids) };
+        if (timeout.count() > 0) {
+            req.timeout = timeout;
+        }
+        if (!NIL_P(max_in_flight_per_node)) {
+            req.max_in_flight_per_node = FIX2ULONG(max_in_flight_per_node);
         }
+        auto barrier = std::make_shared<std::promise<couchbase::operations::get_multi_response>>();
+        auto f = barrier->get_future();
+        backend->cluster->execute(std::move(req), [barrier](couchbase::operations::get_multi_response&& resp) mutable {
+            barrier->set_value(std::move(resp));
+        });
+        auto multi_resp = cb_wait_for_future(f);
 
         VALUE res = rb_ary_new_capa(static_cast<long>(num_of_ids));
-        for (auto& barrier : barriers) {
-            auto resp = barrier->get_future().get();
+        for (auto& resp : multi_resp.entries) {
             VALUE entry = rb_hash_new();
             if (resp.ctx.ec) {
                 rb_hash_aset(entry, rb_id2sym(rb_intern("error")), cb_map_error_code(resp.ctx, "unable to (multi)fetch document"));
@@ -2039,7 +2466,7 @@ cb_Backend_document_unlock(VALUE self, VALUE bucket, VALUE collection, VALUE id,
 }
 
 static VALUE
-cb_Backend_document_upsert(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+cb_document_upsert(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options, bool async)
 {
     cb_backend_data* backend = nullptr;
     TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
@@ -2090,21 +2517,35 @@ cb_Backend_document_upsert(VALUE self, VALUE bucket, VALUE collection, VALUE id,
             break;
         }
 
-        auto barrier = std::make_shared<std::promise<couchbase::operations::upsert_response>>();
-        auto f = barrier->get_future();
-        backend->cluster->execute(req, [barrier](couchbase::operations::upsert_response&& resp) mutable { barrier->set_value(resp); });
-        auto resp = cb_wait_for_future(f);
-        if (resp.ctx.ec) {
-            exc = cb_map_error_code(resp.ctx, "unable to upsert");
+        VALUE res =
+          cb_execute(backend, std::move(req), async, exc, [](couchbase::operations::upsert_response& resp, VALUE& error) -> VALUE {
+              if (resp.ctx.ec) {
+                  error = cb_map_error_code(resp.ctx, "unable to upsert");
+                  return Qnil;
+              }
+              return cb_extract_mutation_result(resp);
+          });
+        if (!NIL_P(exc)) {
             break;
         }
-
-        return cb_extract_mutation_result(resp);
+        return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
+static VALUE
+cb_Backend_document_upsert(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+{
+    return cb_document_upsert(self, bucket, collection, id, content, flags, options, false);
+}
+
+static VALUE
+cb_Backend_document_upsert_async(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+{
+    return cb_document_upsert(self, bucket, collection, id, content, flags, options, true);
+}
+
 static VALUE
 cb_Backend_document_upsert_multi(VALUE self, VALUE id_content, VALUE options)
 {
@@ -2288,7 +2729,7 @@ cb_Backend_document_prepend(VALUE self, VALUE bucket, VALUE collection, VALUE id
 }
 
 static VALUE
-cb_Backend_document_replace(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+cb_document_replace(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options, bool async)
 {
     cb_backend_data* backend = nullptr;
     TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
@@ -2347,23 +2788,37 @@ cb_Backend_document_replace(VALUE self, VALUE bucket, VALUE collection, VALUE id
             req.cas = NUM2ULL(cas);
         }
 
-        auto barrier = std::make_shared<std::promise<couchbase::operations::replace_response>>();
-        auto f = barrier->get_future();
-        backend->cluster->execute(req, [barrier](couchbase::operations::replace_response&& resp) mutable { barrier->set_value(resp); });
-        auto resp = cb_wait_for_future(f);
-        if (resp.ctx.ec) {
-            exc = cb_map_error_code(resp.ctx, "unable to replace");
+        VALUE res =
+          cb_execute(backend, std::move(req), async, exc, [](couchbase::operations::replace_response& resp, VALUE& error) -> VALUE {
+              if (resp.ctx.ec) {
+                  error = cb_map_error_code(resp.ctx, "unable to replace");
+                  return Qnil;
+              }
+              return cb_extract_mutation_result(resp);
+          });
+        if (!NIL_P(exc)) {
             break;
         }
-
-        return cb_extract_mutation_result(resp);
+        return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
 static VALUE
-cb_Backend_document_insert(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+cb_Backend_document_replace(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+{
+    return cb_document_replace(self, bucket, collection, id, content, flags, options, false);
+}
+
+static VALUE
+cb_Backend_document_replace_async(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+{
+    return cb_document_replace(self, bucket, collection, id, content, flags, options, true);
+}
+
+static VALUE
+cb_document_insert(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options, bool async)
 {
     cb_backend_data* backend = nullptr;
     TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
@@ -2410,23 +2865,37 @@ cb_Backend_document_insert(VALUE self, VALUE bucket, VALUE collection, VALUE id,
             req.expiry = FIX2UINT(expiry);
         }
 
-        auto barrier = std::make_shared<std::promise<couchbase::operations::insert_response>>();
-        auto f = barrier->get_future();
-        backend->cluster->execute(req, [barrier](couchbase::operations::insert_response&& resp) mutable { barrier->set_value(resp); });
-        auto resp = cb_wait_for_future(f);
-        if (resp.ctx.ec) {
-            exc = cb_map_error_code(resp.ctx, "unable to insert");
+        VALUE res =
+          cb_execute(backend, std::move(req), async, exc, [](couchbase::operations::insert_response& resp, VALUE& error) -> VALUE {
+              if (resp.ctx.ec) {
+                  error = cb_map_error_code(resp.ctx, "unable to insert");
+                  return Qnil;
+              }
+              return cb_extract_mutation_result(resp);
+          });
+        if (!NIL_P(exc)) {
             break;
         }
-
-        return cb_extract_mutation_result(resp);
+        return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
 static VALUE
-cb_Backend_document_remove(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options)
+cb_Backend_document_insert(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+{
+    return cb_document_insert(self, bucket, collection, id, content, flags, options, false);
+}
+
+static VALUE
+cb_Backend_document_insert_async(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE content, VALUE flags, VALUE options)
+{
+    return cb_document_insert(self, bucket, collection, id, content, flags, options, true);
+}
+
+static VALUE
+cb_document_remove(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options, bool async)
 {
     cb_backend_data* backend = nullptr;
     TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
@@ -2468,20 +2937,35 @@ cb_Backend_document_remove(VALUE self, VALUE bucket, VALUE collection, VALUE id,
             req.cas = NUM2ULL(cas);
         }
 
-        auto barrier = std::make_shared<std::promise<couchbase::operations::remove_response>>();
-        auto f = barrier->get_future();
-        backend->cluster->execute(req, [barrier](couchbase::operations::remove_response&& resp) mutable { barrier->set_value(resp); });
-        auto resp = cb_wait_for_future(f);
-        if (resp.ctx.ec) {
-            exc = cb_map_error_code(resp.ctx, "unable to remove");
+        VALUE res =
+          cb_execute(backend, std::move(req), async, exc, [](couchbase::operations::remove_response& resp, VALUE& error) -> VALUE {
+              if (resp.ctx.ec) {
+                  error = cb_map_error_code(resp.ctx, "unable to remove");
+                  return Qnil;
+              }
+              return cb_extract_mutation_result(resp);
+          });
+        if (!NIL_P(exc)) {
             break;
         }
-        return cb_extract_mutation_result(resp);
+        return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
+static VALUE
+cb_Backend_document_remove(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options)
+{
+    return cb_document_remove(self, bucket, collection, id, options, false);
+}
+
+static VALUE
+cb_Backend_document_remove_async(VALUE self, VALUE bucket, VALUE collection, VALUE id, VALUE options)
+{
+    return cb_document_remove(self, bucket, collection, id, options, true);
+}
+
 static VALUE
 cb_Backend_document_remove_multi(VALUE self, VALUE id_cas, VALUE options)
 {
@@ -3192,7 +3676,64 @@ cb_for_each_named_param(VALUE key, VALUE value, VALUE arg)
 }
 
 static VALUE
-cb_Backend_document_query(VALUE self, VALUE statement, VALUE options)
+cb_extract_query_result(couchbase::operations::query_response& resp, VALUE& exc)
+{
+    if (resp.ctx.ec) {
+        if (resp.payload.meta_data.errors && !resp.payload.meta_data.errors->empty()) {
+            const auto& first_error = resp.payload.meta_data.errors->front();
+            exc = cb_map_error_code(resp.ctx, fmt::format(R"(unable to query ({}: {}))", first_error.code, first_error.message));
+        } else {
+            exc = cb_map_error_code(resp.ctx, "unable to query");
+        }
+        return Qnil;
+    }
+    VALUE res = rb_hash_new();
+    VALUE rows = rb_ary_new_capa(static_cast<long>(resp.payload.rows.size()));
+    rb_hash_aset(res, rb_id2sym(rb_intern("rows")), rows);
+    for (auto& row : resp.payload.rows) {
+        rb_ary_push(rows, cb_str_new(row));
+    }
+    VALUE meta = rb_hash_new();
+    rb_hash_aset(res, rb_id2sym(rb_intern("meta")), meta);
+    rb_hash_aset(meta,
+                 rb_id2sym(rb_intern("status")),
+                 rb_id2sym(rb_intern2(resp.payload.meta_data.status.data(), static_cast<long>(resp.payload.meta_data.status.size()))));
+    rb_hash_aset(meta, rb_id2sym(rb_intern("request_id")), cb_str_new(resp.payload.meta_data.request_id));
+    rb_hash_aset(meta, rb_id2sym(rb_intern("client_context_id")), cb_str_new(resp.payload.meta_data.client_context_id));
+    if (resp.payload.meta_data.signature) {
+        rb_hash_aset(meta, rb_id2sym(rb_intern("signature")), cb_str_new(resp.payload.meta_data.signature.value()));
+    }
+    if (resp.payload.meta_data.profile) {
+        rb_hash_aset(meta, rb_id2sym(rb_intern("profile")), cb_str_new(resp.payload.meta_data.profile.value()));
+    }
+    VALUE metrics = rb_hash_new();
+    rb_hash_aset(meta, rb_id2sym(rb_intern("metrics")), metrics);
+    if (!resp.payload.meta_data.metrics.elapsed_time.empty()) {
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("elapsed_time")), cb_str_new(resp.payload.meta_data.metrics.elapsed_time));
+    }
+    if (!resp.payload.meta_data.metrics.execution_time.empty()) {
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("execution_time")), cb_str_new(resp.payload.meta_data.metrics.execution_time));
+    }
+    rb_hash_aset(metrics, rb_id2sym(rb_intern("result_count")), ULL2NUM(resp.payload.meta_data.metrics.result_count));
+    rb_hash_aset(metrics, rb_id2sym(rb_intern("result_size")), ULL2NUM(resp.payload.meta_data.metrics.result_size));
+    if (resp.payload.meta_data.metrics.sort_count) {
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("sort_count")), ULL2NUM(*resp.payload.meta_data.metrics.sort_count));
+    }
+    if (resp.payload.meta_data.metrics.mutation_count) {
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("mutation_count")), ULL2NUM(*resp.payload.meta_data.metrics.mutation_count));
+    }
+    if (resp.payload.meta_data.metrics.error_count) {
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("error_count")), ULL2NUM(*resp.payload.meta_data.metrics.error_count));
+    }
+    if (resp.payload.meta_data.metrics.warning_count) {
+        rb_hash_aset(metrics, rb_id2sym(rb_intern("warning_count")), ULL2NUM(*resp.payload.meta_data.metrics.warning_count));
+    }
+
+    return res;
+}
+
+static VALUE
+cb_document_query(VALUE self, VALUE statement, VALUE options, bool async)
 {
     cb_backend_data* backend = nullptr;
     TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
@@ -3351,67 +3892,28 @@ cb_Backend_document_query(VALUE self, VALUE statement, VALUE options)
             rb_hash_foreach(raw_params, INT_FUNC(cb_for_each_named_param), reinterpret_cast<VALUE>(&req));
         }
 
-        auto barrier = std::make_shared<std::promise<couchbase::operations::query_response>>();
-        auto f = barrier->get_future();
-        backend->cluster->execute_http(req, [barrier](couchbase::operations::query_response&& resp) mutable { barrier->set_value(resp); });
-        auto resp = cb_wait_for_future(f);
-        if (resp.ctx.ec) {
-            if (resp.payload.meta_data.errors && !resp.payload.meta_data.errors->empty()) {
-                const auto& first_error = resp.payload.meta_data.errors->front();
-                exc = cb_map_error_code(resp.ctx, fmt::format(R"(unable to query ({}: {}))", first_error.code, first_error.message));
-            } else {
-                exc = cb_map_error_code(resp.ctx, "unable to query");
-            }
+        VALUE res = cb_execute(backend, std::move(req), async, exc, &cb_extract_query_result);
+        if (!NIL_P(exc)) {
             break;
         }
-        VALUE res = rb_hash_new();
-        VALUE rows = rb_ary_new_capa(static_cast<long>(resp.payload.rows.size()));
-        rb_hash_aset(res, rb_id2sym(rb_intern("rows")), rows);
-        for (auto& row : resp.payload.rows) {
-            rb_ary_push(rows, cb_str_new(row));
-        }
-        VALUE meta = rb_hash_new();
-        rb_hash_aset(res, rb_id2sym(rb_intern("meta")), meta);
-        rb_hash_aset(meta,
-                     rb_id2sym(rb_intern("status")),
-                     rb_id2sym(rb_intern2(resp.payload.meta_data.status.data(), static_cast<long>(resp.payload.meta_data.status.size()))));
-        rb_hash_aset(meta, rb_id2sym(rb_intern("request_id")), cb_str_new(resp.payload.meta_data.request_id));
-        rb_hash_aset(meta, rb_id2sym(rb_intern("client_context_id")), cb_str_new(resp.payload.meta_data.client_context_id));
-        if (resp.payload.meta_data.signature) {
-            rb_hash_aset(meta, rb_id2sym(rb_intern("signature")), cb_str_new(resp.payload.meta_data.signature.value()));
-        }
-        if (resp.payload.meta_data.profile) {
-            rb_hash_aset(meta, rb_id2sym(rb_intern("profile")), cb_str_new(resp.payload.meta_data.profile.value()));
-        }
-        metrics = rb_hash_new();
-        rb_hash_aset(meta, rb_id2sym(rb_intern("metrics")), metrics);
-        if (!resp.payload.meta_data.metrics.elapsed_time.empty()) {
-            rb_hash_aset(metrics, rb_id2sym(rb_intern("elapsed_time")), cb_str_new(resp.payload.meta_data.metrics.elapsed_time));
-        }
-        if (!resp.payload.meta_data.metrics.execution_time.empty()) {
-            rb_hash_aset(metrics, rb_id2sym(rb_intern("execution_time")), cb_str_new(resp.payload.meta_data.metrics.execution_time));
-        }
-        rb_hash_aset(metrics, rb_id2sym(rb_intern("result_count")), ULL2NUM(resp.payload.meta_data.metrics.result_count));
-        rb_hash_aset(metrics, rb_id2sym(rb_intern("result_size")), ULL2NUM(resp.payload.meta_data.metrics.result_size));
-        if (resp.payload.meta_data.metrics.sort_count) {
-            rb_hash_aset(metrics, rb_id2sym(rb_intern("sort_count")), ULL2NUM(*resp.payload.meta_data.metrics.sort_count));
-        }
-        if (resp.payload.meta_data.metrics.mutation_count) {
-            rb_hash_aset(metrics, rb_id2sym(rb_intern("mutation_count")), ULL2NUM(*resp.payload.meta_data.metrics.mutation_count));
-        }
-        if (resp.payload.meta_data.metrics.error_count) {
-            rb_hash_aset(metrics, rb_id2sym(rb_intern("error_count")), ULL2NUM(*resp.payload.meta_data.metrics.error_count));
-        }
-        if (resp.payload.meta_data.metrics.warning_count) {
-            rb_hash_aset(metrics, rb_id2sym(rb_intern("warning_count")), ULL2NUM(*resp.payload.meta_data.metrics.warning_count));
-        }
-
         return res;
     } while (false);
     rb_exc_raise(exc);
     return Qnil;
 }
 
+static VALUE
+cb_Backend_document_query(VALUE self, VALUE statement, VALUE options)
+{
+    return cb_document_query(self, statement, options, false);
+}
+
+static VALUE
+cb_Backend_document_query_async(VALUE self, VALUE statement, VALUE options)
+{
+    return cb_document_query(self, statement, options, true);
+}
+
 static VALUE
 cb_generate_bucket_settings(VALUE bucket, couchbase::operations::bucket_settings& entry, bool is_create)
 {
@@ -8256,29 +8758,50 @@ cb_Backend_document_view(VALUE self, VALUE bucket_name, VALUE design_document_na
 }
 
 static VALUE
-cb_Backend_set_log_level(VALUE self, VALUE log_level)
+cb_Backend_set_log_level(int argc, VALUE* argv, VALUE self)
 {
     (void)self;
+    VALUE log_level = Qnil;
+    VALUE options = Qnil;
+    rb_scan_args(argc, argv, "11", &log_level, &options);
     Check_Type(log_level, T_SYMBOL);
+    spdlog::level::level_enum level{};
     ID type = rb_sym2id(log_level);
     if (type == rb_intern("trace")) {
-        spdlog::set_level(spdlog::level::trace);
+        level = spdlog::level::trace;
     } else if (type == rb_intern("debug")) {
-        spdlog::set_level(spdlog::level::debug);
+        level = spdlog::level::debug;
     } else if (type == rb_intern("info")) {
-        spdlog::set_level(spdlog::level::info);
+        level = spdlog::level::info;
     } else if (type == rb_intern("warn")) {
-        spdlog::set_level(spdlog::level::warn);
+        level = spdlog::level::warn;
     } else if (type == rb_intern("error")) {
-        spdlog::set_level(spdlog::level::err);
+        level = spdlog::level::err;
     } else if (type == rb_intern("critical")) {
-        spdlog::set_level(spdlog::level::critical);
+        level = spdlog::level::critical;
     } else if (type == rb_intern("off")) {
-        spdlog::set_level(spdlog::level::off);
+        level = spdlog::level::off;
     } else {
         rb_raise(rb_eArgError, "Unsupported log level type: %+" PRIsVALUE, log_level);
         return Qnil;
     }
+    if (!NIL_P(options)) {
+        Check_Type(options, T_HASH);
+        VALUE async = rb_hash_aref(options, rb_id2sym(rb_intern("async")));
+        VALUE queue_size = rb_hash_aref(options, rb_id2sym(rb_intern("queue_size")));
+        if (!NIL_P(queue_size)) {
+            Check_Type(queue_size, T_FIXNUM);
+            if (FIX2LONG(queue_size) <= 0) {
+                rb_raise(rb_eArgError, "Queue size of the logger must be positive: %+" PRIsVALUE, queue_size);
+                return Qnil;
+            }
+        }
+        if (!NIL_P(async)) {
+            couchbase::logger::configure(RTEST(async),
+                                         NIL_P(queue_size) ? couchbase::logger::async_sink::default_queue_size : FIX2ULONG(queue_size));
+        }
+    }
+    spdlog::set_level(level);
     return Qnil;
 }
 
@@ -8307,6 +8830,404 @@ cb_Backend_get_log_level(VALUE self)
     return Qnil;
 }
 
+/**
+ * Maximum depth of arrays and objects, that JSON generator and parser accept. The parser is recursive, so the limit also protects the
+ * stack of the thread, that runs it.
+ */
+static constexpr std::size_t cb_json_max_nesting = 100;
+
+/**
+ * Flat sequence of JSON events, so that parsing could run without the GVL, and Ruby objects could be created afterwards in document
+ * order. Strings and keys are stored in the single arena.
+ */
+struct cb_json_tape {
+    enum class kind : std::uint8_t {
+        null,
+        boolean_true,
+        boolean_false,
+        signed_number,
+        unsigned_number,
+        double_number,
+        string,
+        key,
+        begin_array,
+        end_array,
+        begin_object,
+        end_object,
+    };
+
+    struct event {
+        kind type;
+        std::uint64_t bits{ 0 }; /* number, or offset of the string in the arena */
+        std::size_t size{ 0 };
+    };
+
+    std::vector<event> events{};
+    std::string arena{};
+    std::size_t depth{ 0 };
+
+    /* consumer interface for tao::json::events */
+
+    void enter()
+    {
+        if (++depth > cb_json_max_nesting) {
+            throw std::runtime_error(fmt::format("nesting of {} is too deep", depth));
+        }
+    }
+
+    void null()
+    {
+        events.push_back({ kind::null });
+    }
+
+    void boolean(bool value)
+    {
+        events.push_back({ value ? kind::boolean_true : kind::boolean_false });
+    }
+
+    void number(std::int64_t value)
+    {
+        events.push_back({ kind::signed_number, static_cast<std::uint64_t>(value) });
+    }
+
+    void number(std::uint64_t value)
+    {
+        events.push_back({ kind::unsigned_number, value });
+    }
+
+    void number(double value)
+    {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        events.push_back({ kind::double_number, bits });
+    }
+
+    void string(std::string_view value)
+    {
+        events.push_back({ kind::string, arena.size(), value.size() });
+        arena.append(value);
+    }
+
+    void key(std::string_view value)
+    {
+        events.push_back({ kind::key, arena.size(), value.size() });
+        arena.append(value);
+    }
+
+    void begin_array(std::size_t /* size */ = 0)
+    {
+        enter();
+        events.push_back({ kind::begin_array });
+    }
+
+    void element()
+    {
+    }
+
+    void end_array(std::size_t /* size */ = 0)
+    {
+        --depth;
+        events.push_back({ kind::end_array });
+    }
+
+    void begin_object(std::size_t /* size */ = 0)
+    {
+        enter();
+        events.push_back({ kind::begin_object });
+    }
+
+    void member()
+    {
+    }
+
+    void end_object(std::size_t /* size */ = 0)
+    {
+        --depth;
+        events.push_back({ kind::end_object });
+    }
+
+    [[nodiscard]] VALUE to_ruby() const
+    {
+        VALUE result = Qnil;
+        std::vector<VALUE> containers{}; /* every container is referenced by its parent or by result, so it is visible to GC */
+        std::vector<const event*> keys{};
+        auto append = [&](VALUE value) {
+            if (containers.empty()) {
+                result = value;
+            } else if (RB_TYPE_P(containers.back(), T_ARRAY)) {
+                rb_ary_push(containers.back(), value);
+            } else {
+                const event* key = keys.back();
+                keys.pop_back();
+                rb_hash_aset(containers.back(), rb_utf8_str_new(arena.data() + key->bits, static_cast<long>(key->size)), value);
+            }
+            RB_GC_GUARD(value);
+        };
+        for (const auto& e : events) {
+            switch (e.type) {
+                case kind::null:
+                    append(Qnil);
+                    break;
+                case kind::boolean_true:
+                    append(Qtrue);
+                    break;
+                case kind::boolean_false:
+                    append(Qfalse);
+                    break;
+                case kind::signed_number:
+                    append(LL2NUM(static_cast<std::int64_t>(e.bits)));
+                    break;
+                case kind::unsigned_number:
+                    append(ULL2NUM(e.bits));
+                    break;
+                case kind::double_number: {
+                    double value = 0;
+                    std::memcpy(&value, &e.bits, sizeof(value));
+                    append(DBL2NUM(value));
+                } break;
+                case kind::string:
+                    append(rb_utf8_str_new(arena.data() + e.bits, static_cast<long>(e.size)));
+                    break;
+                case kind::key:
+                    keys.push_back(&e);
+                    break;
+                case kind::begin_array: {
+                    VALUE array = rb_ary_new();
+                    append(array);
+                    containers.push_back(array);
+                } break;
+                case kind::begin_object: {
+                    VALUE hash = rb_hash_new();
+                    append(hash);
+                    containers.push_back(hash);
+                } break;
+                case kind::end_array:
+                case kind::end_object:
+                    containers.pop_back();
+                    break;
+            }
+        }
+        RB_GC_GUARD(result);
+        return result;
+    }
+};
+
+static constexpr std::size_t cb_json_parse_without_gvl_threshold = 16 * 1024;
+
+static VALUE
+cb_Backend_json_parse(VALUE self, VALUE blob)
+{
+    (void)self;
+    Check_Type(blob, T_STRING);
+
+    VALUE exc = Qnil;
+    VALUE res = Qnil;
+    {
+        struct parse_context {
+            std::string_view input;
+            cb_json_tape tape{};
+            std::string error{};
+        } ctx{ { RSTRING_PTR(blob), static_cast<std::size_t>(RSTRING_LEN(blob)) } };
+        auto parse = [](void* param) -> void* {
+            auto* pack = static_cast<parse_context*>(param);
+            try {
+                pack->tape.events.reserve(pack->input.size() / 8);
+                tao::json::events::from_string(pack->tape, pack->input);
+            } catch (const std::exception& e) {
+                pack->error = e.what();
+            }
+            return nullptr;
+        };
+        if (ctx.input.size() >= cb_json_parse_without_gvl_threshold) {
+            rb_str_locktmp(blob);
+            rb_thread_call_without_gvl(parse, &ctx, nullptr, nullptr);
+            rb_str_unlocktmp(blob);
+        } else {
+            parse(&ctx);
+        }
+        if (ctx.error.empty()) {
+            res = ctx.tape.to_ruby();
+        } else {
+            exc = rb_exc_new_cstr(eDecodingFailure, fmt::format("unable to parse JSON: {}", ctx.error).c_str());
+        }
+    }
+    if (!NIL_P(exc)) {
+        rb_exc_raise(exc);
+    }
+    return res;
+}
+
+static void
+cb_json_escape(std::string& out, const char* data, std::size_t size)
+{
+    static const char* hex = "0123456789abcdef";
+    out.push_back('"');
+    for (std::size_t i = 0; i < size; ++i) {
+        auto c = static_cast<unsigned char>(data[i]);
+        switch (c) {
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '\b':
+                out.append("\\b");
+                break;
+            case '\f':
+                out.append("\\f");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            case '\r':
+                out.append("\\r");
+                break;
+            case '\t':
+                out.append("\\t");
+                break;
+            default:
+                if (c < 0x20) {
+                    out.append("\\u00");
+                    out.push_back(hex[c >> 4U]);
+                    out.push_back(hex[c & 0xfU]);
+                } else {
+                    out.push_back(static_cast<char>(c));
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+struct cb_json_hash_context {
+    std::string& out;
+    std::size_t depth;
+    bool first{ true };
+    VALUE exc{ Qnil };
+};
+
+static VALUE
+cb_json_generate(std::string& out, VALUE value, std::size_t depth);
+
+static int
+cb_json_generate_member(VALUE key, VALUE entry, VALUE arg)
+{
+    auto* ctx = reinterpret_cast<cb_json_hash_context*>(arg);
+    if (!ctx->first) {
+        ctx->out.push_back(',');
+    }
+    ctx->first = false;
+    if (TYPE(key) == T_SYMBOL) {
+        key = rb_sym2str(key);
+    }
+    if (TYPE(key) != T_STRING) {
+        ctx->exc = rb_exc_new_str(eEncodingFailure, rb_sprintf("JSON object keys must be String or Symbol, given %+" PRIsVALUE, key));
+        return ST_STOP;
+    }
+    cb_json_escape(ctx->out, RSTRING_PTR(key), static_cast<std::size_t>(RSTRING_LEN(key)));
+    ctx->out.push_back(':');
+    ctx->exc = cb_json_generate(ctx->out, entry, ctx->depth);
+    return NIL_P(ctx->exc) ? ST_CONTINUE : ST_STOP;
+}
+
+/**
+ * Serializes Ruby value to JSON. Only String, Symbol, Integer, Float, true, false, nil, Array and Hash (with String or Symbol keys) are
+ * supported, so that conversion never calls into Ruby code, and could not raise while C++ objects are alive.
+ *
+ * @return exception object or nil
+ */
+static VALUE
+cb_json_generate(std::string& out, VALUE value, std::size_t depth)
+{
+    if (depth > cb_json_max_nesting) {
+        return rb_exc_new_cstr(eEncodingFailure, fmt::format("nesting of {} is too deep", depth).c_str());
+    }
+    switch (TYPE(value)) {
+        case T_NIL:
+            out.append("null");
+            break;
+        case T_TRUE:
+            out.append("true");
+            break;
+        case T_FALSE:
+            out.append("false");
+            break;
+        case T_FIXNUM:
+            out.append(std::to_string(FIX2LONG(value)));
+            break;
+        case T_BIGNUM: {
+            VALUE str = rb_big2str(value, 10);
+            out.append(RSTRING_PTR(str), static_cast<std::size_t>(RSTRING_LEN(str)));
+        } break;
+        case T_FLOAT: {
+            double number = RFLOAT_VALUE(value);
+            if (number != number || number == std::numeric_limits<double>::infinity() ||
+                number == -std::numeric_limits<double>::infinity()) {
+                return rb_exc_new_cstr(eEncodingFailure, fmt::format("{} is not allowed in JSON", number).c_str());
+            }
+            auto start = out.size();
+            out.append(fmt::format("{}", number));
+            if (out.find_first_of(".e", start) == std::string::npos) {
+                out.append(".0");
+            }
+        } break;
+        case T_STRING:
+            cb_json_escape(out, RSTRING_PTR(value), static_cast<std::size_t>(RSTRING_LEN(value)));
+            break;
+        case T_SYMBOL: {
+            VALUE str = rb_sym2str(value);
+            cb_json_escape(out, RSTRING_PTR(str), static_cast<std::size_t>(RSTRING_LEN(str)));
+        } break;
+        case T_ARRAY: {
+            out.push_back('[');
+            for (long i = 0; i < RARRAY_LEN(value); ++i) {
+                if (i > 0) {
+                    out.push_back(',');
+                }
+                VALUE exc = cb_json_generate(out, rb_ary_entry(value, i), depth + 1);
+                if (!NIL_P(exc)) {
+                    return exc;
+                }
+            }
+            out.push_back(']');
+        } break;
+        case T_HASH: {
+            cb_json_hash_context ctx{ out, depth + 1 };
+            out.push_back('{');
+            rb_hash_foreach(value, INT_FUNC(cb_json_generate_member), reinterpret_cast<VALUE>(&ctx));
+            if (!NIL_P(ctx.exc)) {
+                return ctx.exc;
+            }
+            out.push_back('}');
+        } break;
+        default:
+            return rb_exc_new_str(
+              eEncodingFailure,
+              rb_sprintf("unable to encode %" PRIsVALUE " as JSON, use Couchbase::JsonTranscoder for custom types", rb_obj_class(value)));
+    }
+    return Qnil;
+}
+
+static VALUE
+cb_Backend_json_generate(VALUE self, VALUE document)
+{
+    (void)self;
+
+    VALUE exc = Qnil;
+    VALUE res = Qnil;
+    {
+        std::string out;
+        exc = cb_json_generate(out, document, 0);
+        if (NIL_P(exc)) {
+            res = rb_utf8_str_new(out.data(), static_cast<long>(out.size()));
+        }
+    }
+    if (!NIL_P(exc)) {
+        rb_exc_raise(exc);
+    }
+    return res;
+}
+
 static VALUE
 cb_Backend_snappy_compress(VALUE self, VALUE data)
 {
@@ -8408,33 +9329,399 @@ cb_Backend_form_encode(VALUE self, VALUE data)
     return cb_str_new(encoded);
 }
 
+[[nodiscard]] static std::shared_ptr<cb_dcp_consumer_data>
+cb_find_dcp_consumer(cb_backend_data* backend, VALUE consumer_id)
+{
+    Check_Type(consumer_id, T_FIXNUM);
+    auto consumer = backend->dcp_consumers.find(NUM2ULL(consumer_id));
+    if (consumer == backend->dcp_consumers.end()) {
+        rb_raise(rb_eArgError, "DCP consumer %" PRIsVALUE " does not exist or has been closed already", consumer_id);
+    }
+    return consumer->second;
+}
+
+static VALUE
+cb_Backend_dcp_open(VALUE self, VALUE bucket, VALUE options)
+{
+    cb_backend_data* backend = nullptr;
+    TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
+
+    if (!backend->cluster) {
+        rb_raise(rb_eArgError, "Cluster has been closed already");
+        return Qnil;
+    }
+
+    Check_Type(bucket, T_STRING);
+    if (!NIL_P(options)) {
+        Check_Type(options, T_HASH);
+    }
+
+    VALUE exc = Qnil;
+    do {
+        couchbase::dcp::consumer_options consumer_options{};
+        exc = cb_extract_option_string(consumer_options.connection_name, options, "connection_name");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        exc = cb_extract_option_bool(consumer_options.include_xattrs, options, "include_xattrs");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        exc = cb_extract_option_bool(consumer_options.no_value, options, "no_value");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        VALUE val = Qnil;
+        exc = cb_extract_option_fixnum(val, options, "stream_flags");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            consumer_options.stream_flags = NUM2UINT(val);
+        }
+        exc = cb_extract_option_bignum(val, options, "end_seqno");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            consumer_options.end_seqno = NUM2ULL(val);
+        }
+        exc = cb_extract_option_fixnum(val, options, "buffer_size");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            consumer_options.buffer_size = NUM2UINT(val);
+        }
+        exc = cb_extract_option_fixnum(val, options, "batch_size");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            consumer_options.batch_size = NUM2ULL(val);
+        }
+        exc = cb_extract_option_fixnum(val, options, "flush_interval");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            consumer_options.flush_interval = std::chrono::milliseconds(NUM2ULL(val));
+        }
+        exc = cb_extract_option_array(val, options, "partitions");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            auto size = static_cast<std::size_t>(RARRAY_LEN(val));
+            consumer_options.partitions.reserve(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                VALUE entry = rb_ary_entry(val, static_cast<long>(i));
+                Check_Type(entry, T_FIXNUM);
+                consumer_options.partitions.emplace_back(static_cast<std::uint16_t>(NUM2UINT(entry)));
+            }
+        }
+        exc = cb_extract_option_array(val, options, "collections");
+        if (!NIL_P(exc)) {
+            break;
+        }
+        if (!NIL_P(val)) {
+            auto size = static_cast<std::size_t>(RARRAY_LEN(val));
+            consumer_options.collections.reserve(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                VALUE entry = rb_ary_entry(val, static_cast<long>(i));
+                Check_Type(entry, T_FIXNUM);
+                consumer_options.collections.emplace_back(NUM2UINT(entry));
+            }
+        }
+        if (!NIL_P(options)) {
+            VALUE start_state = rb_hash_aref(options, rb_id2sym(rb_intern("start_state")));
+            if (!NIL_P(start_state)) {
+                Check_Type(start_state, T_HASH);
+                VALUE partitions = rb_funcall(start_state, rb_intern("keys"), 0);
+                auto size = static_cast<std::size_t>(RARRAY_LEN(partitions));
+                for (std::size_t i = 0; i < size; ++i) {
+                    VALUE partition = rb_ary_entry(partitions, static_cast<long>(i));
+                    Check_Type(partition, T_FIXNUM);
+                    VALUE entry = rb_hash_aref(start_state, partition);
+                    Check_Type(entry, T_HASH);
+                    couchbase::dcp::partition_state state{};
+                    if (VALUE field = rb_hash_aref(entry, rb_id2sym(rb_intern("partition_uuid"))); !NIL_P(field)) {
+                        state.partition_uuid = NUM2ULL(field);
+                    }
+                    if (VALUE field = rb_hash_aref(entry, rb_id2sym(rb_intern("seqno"))); !NIL_P(field)) {
+                        state.seqno = NUM2ULL(field);
+                    }
+                    if (VALUE field = rb_hash_aref(entry, rb_id2sym(rb_intern("snapshot_start"))); !NIL_P(field)) {
+                        state.snapshot_start = NUM2ULL(field);
+                    }
+                    if (VALUE field = rb_hash_aref(entry, rb_id2sym(rb_intern("snapshot_end"))); !NIL_P(field)) {
+                        state.snapshot_end = NUM2ULL(field);
+                    }
+                    consumer_options.start_state.emplace(static_cast<std::uint16_t>(NUM2UINT(partition)), state);
+                }
+            }
+        }
+
+        std::string name(RSTRING_PTR(bucket), static_cast<size_t>(RSTRING_LEN(bucket)));
+        auto data = std::make_shared<cb_dcp_consumer_data>();
+        data->consumer = backend->cluster->dcp_consumer(name, std::move(consumer_options));
+        data->consumer->start(
+          [data](couchbase::dcp::batch&& batch) {
+              std::scoped_lock lock(data->mutex);
+              data->batches.emplace_back(std::move(batch));
+              data->cv.notify_all();
+          },
+          [data](std::error_code ec) {
+              std::scoped_lock lock(data->mutex);
+              data->completed = ec;
+              data->cv.notify_all();
+          });
+        auto id = ++backend->next_dcp_consumer_id;
+        backend->dcp_consumers.emplace(id, data);
+        return ULL2NUM(id);
+    } while (false);
+    rb_exc_raise(exc);
+    return Qnil;
+}
+
+[[nodiscard]] static VALUE
+cb_dcp_event_to_hash(const couchbase::dcp::event& e)
+{
+    VALUE res = rb_hash_new();
+    switch (e.type) {
+        case couchbase::dcp::event_type::mutation:
+            rb_hash_aset(res, rb_id2sym(rb_intern("type")), rb_id2sym(rb_intern("mutation")));
+            break;
+        case couchbase::dcp::event_type::deletion:
+            rb_hash_aset(res, rb_id2sym(rb_intern("type")), rb_id2sym(rb_intern("deletion")));
+            break;
+        case couchbase::dcp::event_type::expiration:
+            rb_hash_aset(res, rb_id2sym(rb_intern("type")), rb_id2sym(rb_intern("expiration")));
+            break;
+        case couchbase::dcp::event_type::rollback:
+            rb_hash_aset(res, rb_id2sym(rb_intern("type")), rb_id2sym(rb_intern("rollback")));
+            break;
+        case couchbase::dcp::event_type::stream_end:
+            rb_hash_aset(res, rb_id2sym(rb_intern("type")), rb_id2sym(rb_intern("stream_end")));
+            switch (e.reason) {
+                case couchbase::dcp::stream_end_reason::ok:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("ok")));
+                    break;
+                case couchbase::dcp::stream_end_reason::closed:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("closed")));
+                    break;
+                case couchbase::dcp::stream_end_reason::state_changed:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("state_changed")));
+                    break;
+                case couchbase::dcp::stream_end_reason::disconnected:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("disconnected")));
+                    break;
+                case couchbase::dcp::stream_end_reason::too_slow:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("too_slow")));
+                    break;
+                case couchbase::dcp::stream_end_reason::backfill_failed:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("backfill_failed")));
+                    break;
+                case couchbase::dcp::stream_end_reason::rollback:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("rollback")));
+                    break;
+                case couchbase::dcp::stream_end_reason::filter_empty:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("filter_empty")));
+                    break;
+                case couchbase::dcp::stream_end_reason::lost_privileges:
+                    rb_hash_aset(res, rb_id2sym(rb_intern("reason")), rb_id2sym(rb_intern("lost_privileges")));
+                    break;
+            }
+            break;
+    }
+    rb_hash_aset(res, rb_id2sym(rb_intern("partition")), UINT2NUM(e.partition));
+    rb_hash_aset(res, rb_id2sym(rb_intern("partition_uuid")), ULL2NUM(e.partition_uuid));
+    rb_hash_aset(res, rb_id2sym(rb_intern("seqno")), ULL2NUM(e.by_seqno));
+    if (e.type == couchbase::dcp::event_type::mutation || e.type == couchbase::dcp::event_type::deletion ||
+        e.type == couchbase::dcp::event_type::expiration) {
+        rb_hash_aset(res, rb_id2sym(rb_intern("rev_seqno")), ULL2NUM(e.rev_seqno));
+        rb_hash_aset(res, rb_id2sym(rb_intern("cas")), ULL2NUM(e.cas));
+        rb_hash_aset(res, rb_id2sym(rb_intern("id")), cb_str_new(e.key));
+        rb_hash_aset(res, rb_id2sym(rb_intern("collection_id")), UINT2NUM(e.collection_id));
+        rb_hash_aset(res, rb_id2sym(rb_intern("datatype")), UINT2NUM(e.datatype));
+    }
+    if (e.type == couchbase::dcp::event_type::mutation) {
+        rb_hash_aset(res, rb_id2sym(rb_intern("flags")), UINT2NUM(e.flags));
+        rb_hash_aset(res, rb_id2sym(rb_intern("expiry")), UINT2NUM(e.expiry));
+        rb_hash_aset(res, rb_id2sym(rb_intern("content")), cb_str_new(e.value));
+    }
+    return res;
+}
+
+static VALUE
+cb_Backend_dcp_poll(VALUE self, VALUE consumer_id, VALUE timeout)
+{
+    cb_backend_data* backend = nullptr;
+    TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
+
+    auto data = cb_find_dcp_consumer(backend, consumer_id);
+    std::chrono::milliseconds wait_for{ 1'000 };
+    if (!NIL_P(timeout)) {
+        Check_Type(timeout, T_FIXNUM);
+        wait_for = std::chrono::milliseconds(NUM2ULL(timeout));
+    }
+
+    struct arg_pack {
+        cb_dcp_consumer_data* data;
+        std::chrono::milliseconds timeout;
+        std::shared_ptr<const couchbase::dcp::batch> polled{};
+        std::optional<std::error_code> completed{};
+    } arg{ data.get(), wait_for };
+    /* the variant, that does not raise pending interrupts, so that C++ objects above are destroyed before Ruby handles them */
+    rb_thread_call_without_gvl2(
+      [](void* param) -> void* {
+          auto* pack = static_cast<arg_pack*>(param);
+          std::unique_lock lock(pack->data->mutex);
+          if (!pack->data->polled) {
+              pack->data->cv.wait_for(lock, pack->timeout, [pack]() {
+                  return !pack->data->batches.empty() || pack->data->completed || pack->data->interrupted;
+              });
+              pack->data->interrupted = false;
+              if (!pack->data->batches.empty()) {
+                  pack->data->polled = std::make_shared<const couchbase::dcp::batch>(std::move(pack->data->batches.front()));
+                  pack->data->batches.pop_front();
+              }
+          }
+          if (pack->data->polled) {
+              pack->polled = pack->data->polled;
+          } else {
+              pack->completed = pack->data->completed;
+          }
+          return nullptr;
+      },
+      &arg,
+      [](void* param) {
+          auto* consumer = static_cast<cb_dcp_consumer_data*>(param);
+          std::scoped_lock lock(consumer->mutex);
+          consumer->interrupted = true;
+          consumer->cv.notify_all();
+      },
+      data.get());
+
+    if (arg.polled) {
+        VALUE res = rb_ary_new_capa(static_cast<long>(arg.polled->events.size()));
+        for (const auto& e : arg.polled->events) {
+            rb_ary_push(res, cb_dcp_event_to_hash(e));
+        }
+        return res;
+    }
+    if (arg.completed) {
+        if (auto ec = arg.completed.value(); ec && ec != couchbase::error::common_errc::request_canceled) {
+            rb_exc_raise(cb_map_error_code(ec, "DCP consumer has failed"));
+        }
+        return Qnil;
+    }
+    return rb_ary_new();
+}
+
+static VALUE
+cb_Backend_dcp_ack(VALUE self, VALUE consumer_id)
+{
+    cb_backend_data* backend = nullptr;
+    TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
+
+    auto data = cb_find_dcp_consumer(backend, consumer_id);
+    std::shared_ptr<const couchbase::dcp::batch> processed{};
+    {
+        std::scoped_lock lock(data->mutex);
+        std::swap(processed, data->polled);
+    }
+    if (processed) {
+        data->consumer->acknowledge(*processed);
+    }
+    return Qnil;
+}
+
+static VALUE
+cb_Backend_dcp_state(VALUE self, VALUE consumer_id)
+{
+    cb_backend_data* backend = nullptr;
+    TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
+
+    auto data = cb_find_dcp_consumer(backend, consumer_id);
+    VALUE res = rb_hash_new();
+    for (const auto& [partition, state] : data->consumer->state()) {
+        VALUE entry = rb_hash_new();
+        rb_hash_aset(entry, rb_id2sym(rb_intern("partition_uuid")), ULL2NUM(state.partition_uuid));
+        rb_hash_aset(entry, rb_id2sym(rb_intern("seqno")), ULL2NUM(state.seqno));
+        rb_hash_aset(entry, rb_id2sym(rb_intern("snapshot_start")), ULL2NUM(state.snapshot_start));
+        rb_hash_aset(entry, rb_id2sym(rb_intern("snapshot_end")), ULL2NUM(state.snapshot_end));
+        VALUE failover_log = rb_ary_new_capa(static_cast<long>(state.failover_entries.size()));
+        for (const auto& [uuid, seqno] : state.failover_entries) {
+            rb_ary_push(failover_log, rb_ary_new_from_args(2, ULL2NUM(uuid), ULL2NUM(seqno)));
+        }
+        rb_hash_aset(entry, rb_id2sym(rb_intern("failover_log")), failover_log);
+        rb_hash_aset(res, UINT2NUM(partition), entry);
+    }
+    return res;
+}
+
+static VALUE
+cb_Backend_dcp_close(VALUE self, VALUE consumer_id)
+{
+    cb_backend_data* backend = nullptr;
+    TypedData_Get_Struct(self, cb_backend_data, &cb_backend_type, backend);
+
+    auto data = cb_find_dcp_consumer(backend, consumer_id);
+    data->consumer->stop();
+    backend->dcp_consumers.erase(NUM2ULL(consumer_id));
+    return Qnil;
+}
+
 static void
 init_backend(VALUE mCouchbase)
 {
     VALUE cBackend = rb_define_class_under(mCouchbase, "Backend", rb_cBasicObject);
     rb_define_alloc_func(cBackend, cb_Backend_allocate);
+
+    cFuture = rb_define_class_under(cBackend, "Future", rb_cObject);
+    rb_undef_alloc_func(cFuture);
+    rb_define_method(cFuture, "fileno", VALUE_FUNC(cb_Future_fileno), 0);
+    rb_define_method(cFuture, "drain", VALUE_FUNC(cb_Future_drain), 0);
+    rb_define_method(cFuture, "wait", VALUE_FUNC(cb_Future_wait), 0);
+    rb_define_method(cFuture, "completed?", VALUE_FUNC(cb_Future_completed), 0);
+    rb_define_method(cFuture, "result", VALUE_FUNC(cb_Future_result), 0);
+
     rb_define_method(cBackend, "open", VALUE_FUNC(cb_Backend_open), 3);
     rb_define_method(cBackend, "close", VALUE_FUNC(cb_Backend_close), 0);
     rb_define_method(cBackend, "open_bucket", VALUE_FUNC(cb_Backend_open_bucket), 2);
     rb_define_method(cBackend, "diagnostics", VALUE_FUNC(cb_Backend_diagnostics), 1);
+    rb_define_method(cBackend, "metrics", VALUE_FUNC(cb_Backend_metrics), 0);
     rb_define_method(cBackend, "ping", VALUE_FUNC(cb_Backend_ping), 2);
 
+    rb_define_method(cBackend, "dcp_open", VALUE_FUNC(cb_Backend_dcp_open), 2);
+    rb_define_method(cBackend, "dcp_poll", VALUE_FUNC(cb_Backend_dcp_poll), 2);
+    rb_define_method(cBackend, "dcp_ack", VALUE_FUNC(cb_Backend_dcp_ack), 1);
+    rb_define_method(cBackend, "dcp_state", VALUE_FUNC(cb_Backend_dcp_state), 1);
+    rb_define_method(cBackend, "dcp_close", VALUE_FUNC(cb_Backend_dcp_close), 1);
+
     rb_define_method(cBackend, "document_get", VALUE_FUNC(cb_Backend_document_get), 4);
+    rb_define_method(cBackend, "document_get_async", VALUE_FUNC(cb_Backend_document_get_async), 4);
     rb_define_method(cBackend, "document_get_multi", VALUE_FUNC(cb_Backend_document_get_multi), 2);
     rb_define_method(cBackend, "document_get_projected", VALUE_FUNC(cb_Backend_document_get_projected), 4);
     rb_define_method(cBackend, "document_get_and_lock", VALUE_FUNC(cb_Backend_document_get_and_lock), 5);
     rb_define_method(cBackend, "document_get_and_touch", VALUE_FUNC(cb_Backend_document_get_and_touch), 5);
     rb_define_method(cBackend, "document_insert", VALUE_FUNC(cb_Backend_document_insert), 6);
+    rb_define_method(cBackend, "document_insert_async", VALUE_FUNC(cb_Backend_document_insert_async), 6);
     rb_define_method(cBackend, "document_replace", VALUE_FUNC(cb_Backend_document_replace), 6);
+    rb_define_method(cBackend, "document_replace_async", VALUE_FUNC(cb_Backend_document_replace_async), 6);
     rb_define_method(cBackend, "document_upsert", VALUE_FUNC(cb_Backend_document_upsert), 6);
+    rb_define_method(cBackend, "document_upsert_async", VALUE_FUNC(cb_Backend_document_upsert_async), 6);
     rb_define_method(cBackend, "document_upsert_multi", VALUE_FUNC(cb_Backend_document_upsert_multi), 2);
     rb_define_method(cBackend, "document_append", VALUE_FUNC(cb_Backend_document_append), 5);
     rb_define_method(cBackend, "document_prepend", VALUE_FUNC(cb_Backend_document_prepend), 5);
     rb_define_method(cBackend, "document_remove", VALUE_FUNC(cb_Backend_document_remove), 4);
+    rb_define_method(cBackend, "document_remove_async", VALUE_FUNC(cb_Backend_document_remove_async), 4);
     rb_define_method(cBackend, "document_remove_multi", VALUE_FUNC(cb_Backend_document_remove_multi), 2);
     rb_define_method(cBackend, "document_lookup_in", VALUE_FUNC(cb_Backend_document_lookup_in), 5);
     rb_define_method(cBackend, "document_mutate_in", VALUE_FUNC(cb_Backend_document_mutate_in), 5);
     rb_define_method(cBackend, "document_query", VALUE_FUNC(cb_Backend_document_query), 2);
+    rb_define_method(cBackend, "document_query_async", VALUE_FUNC(cb_Backend_document_query_async), 2);
     rb_define_method(cBackend, "document_touch", VALUE_FUNC(cb_Backend_document_touch), 5);
     rb_define_method(cBackend, "document_exists", VALUE_FUNC(cb_Backend_document_exists), 4);
     rb_define_method(cBackend, "document_unlock", VALUE_FUNC(cb_Backend_document_unlock), 5);
@@ -8517,8 +9804,10 @@ init_backend(VALUE mCouchbase)
     rb_define_method(cBackend, "collections_manifest_get", VALUE_FUNC(cb_Backend_collections_manifest_get), 2);
     rb_define_singleton_method(cBackend, "dns_srv", VALUE_FUNC(cb_Backend_dns_srv), 2);
     rb_define_singleton_method(cBackend, "parse_connection_string", VALUE_FUNC(cb_Backend_parse_connection_string), 1);
-    rb_define_singleton_method(cBackend, "set_log_level", VALUE_FUNC(cb_Backend_set_log_level), 1);
+    rb_define_singleton_method(cBackend, "set_log_level", VALUE_FUNC(cb_Backend_set_log_level), -1);
     rb_define_singleton_method(cBackend, "get_log_level", VALUE_FUNC(cb_Backend_get_log_level), 0);
+    rb_define_singleton_method(cBackend, "json_generate", VALUE_FUNC(cb_Backend_json_generate), 1);
+    rb_define_singleton_method(cBackend, "json_parse", VALUE_FUNC(cb_Backend_json_parse), 1);
     rb_define_singleton_method(cBackend, "snappy_compress", VALUE_FUNC(cb_Backend_snappy_compress), 1);
     rb_define_singleton_method(cBackend, "snappy_uncompress", VALUE_FUNC(cb_Backend_snappy_uncompress), 1);
     rb_define_singleton_method(cBackend, "leb128_encode", VALUE_FUNC(cb_Backend_leb128_encode), 1);
@@ -0,0 +1,802 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <asio/ssl.hpp>
+
+#include <io/mcbp_session.hxx>
+#include <origin.hxx>
+#include <protocol/cmd_dcp_buffer_acknowledgement.hxx>
+#include <protocol/cmd_dcp_control.hxx>
+#include <protocol/cmd_dcp_open.hxx>
+#include <protocol/cmd_dcp_stream_request.hxx>
+#include <protocol/cmd_get_cluster_config.hxx>
+
+#include <dcp/event.hxx>
+#include <dcp/message_decoder.hxx>
+
+namespace couchbase::dcp
+{
+struct consumer_options {
+    /**
+     * Name of the DCP connection, visible in the server stats. Generated when empty.
+     */
+    std::string connection_name{};
+
+    /**
+     * Partitions to stream, all partitions of the bucket when empty.
+     */
+    std::vector<std::uint16_t> partitions{};
+
+    /**
+     * Where to resume the partitions from, missing partitions are streamed from the beginning.
+     */
+    std::map<std::uint16_t, partition_state> start_state{};
+
+    /**
+     * The stream ends when it reaches this sequence number, by default streams never end.
+     */
+    std::uint64_t end_seqno{ std::numeric_limits<std::uint64_t>::max() };
+
+    bool include_xattrs{ false };
+    bool no_value{ false };
+
+    /**
+     * Flags of every stream request, see protocol::dcp_stream_request_request_body.
+     */
+    std::uint32_t stream_flags{ 0 };
+
+    /**
+     * Collection IDs to stream, all collections of the bucket when empty. Every partition has one stream, multiple streams per
+     * partition (stream IDs) are not supported.
+     */
+    std::vector<std::uint32_t> collections{};
+
+    /**
+     * Flow control window, the server stops sending when this number of bytes has not been acknowledged.
+     */
+    std::uint32_t buffer_size{ 20 * 1024 * 1024 };
+
+    /**
+     * Fraction of the flow control window, after which the consumer sends buffer acknowledgement.
+     */
+    double buffer_ack_threshold{ 0.5 };
+
+    std::size_t batch_size{ 1'000 };
+    std::chrono::milliseconds flush_interval{ 100 };
+    std::chrono::seconds noop_interval{ 20 };
+    std::chrono::milliseconds retry_interval{ 500 };
+};
+
+/**
+ * Change data capture over DCP.
+ *
+ * Opens one DCP connection per node and requests a stream for every partition, owned by the node in the vBucket map. Follows
+ * changes of the map, reconnects to failed nodes, and restarts the streams from the last received position. Received events are
+ * delivered in batches. The application gives every batch back with acknowledge(), which advances the state returned by state()
+ * and acknowledges the bytes to the server, so the server never sends more than buffer_size unprocessed bytes per connection.
+ */
+class consumer : public std::enable_shared_from_this<consumer>
+{
+  public:
+    using batch_handler = std::function<void(batch&&)>;
+    using completion_handler = std::function<void(std::error_code)>;
+
+    consumer(std::string client_id,
+             asio::io_context& ctx,
+             asio::ssl::context& tls,
+             const couchbase::origin& origin,
+             std::string bucket_name,
+             consumer_options options)
+      : client_id_(std::move(client_id))
+      , ctx_(ctx)
+      , tls_(tls)
+      , origin_(origin)
+      , bucket_name_(std::move(bucket_name))
+      , options_(std::move(options))
+      , flush_timer_(ctx_)
+    {
+        /* the server does not allow out of order execution on DCP connections, and flow control counts bytes as they were sent */
+        origin_.options().enable_unordered_execution = false;
+        origin_.options().enable_compression = false;
+        if (options_.connection_name.empty()) {
+            options_.connection_name = fmt::format("{}/{}", client_id_, uuid::to_string(uuid::random()));
+        }
+        log_prefix_ = fmt::format("[{}/dcp/{}]", client_id_, bucket_name_);
+        if (!options_.collections.empty()) {
+            std::vector<std::string> ids;
+            ids.reserve(options_.collections.size());
+            for (auto id : options_.collections) {
+                ids.emplace_back(fmt::format("\"{:x}\"", id));
+            }
+            collections_filter_ = fmt::format(R"({{"collections":[{}]}})", fmt::join(ids, ","));
+        }
+    }
+
+    void start(batch_handler on_batch, completion_handler on_complete)
+    {
+        on_batch_ = std::move(on_batch);
+        on_complete_ = std::move(on_complete);
+        asio::post(asio::bind_executor(ctx_, [self = shared_from_this()]() { self->do_bootstrap(); }));
+    }
+
+    void stop()
+    {
+        asio::post(asio::bind_executor(ctx_, [self = shared_from_this()]() { self->complete(error::common_errc::request_canceled); }));
+    }
+
+    /**
+     * Marks the batch as processed by the application. The batch is only read, so the application could keep it until the call returns.
+     */
+    void acknowledge(const batch& processed)
+    {
+        std::vector<std::pair<std::shared_ptr<io::mcbp_session>, std::uint32_t>> acks;
+        {
+            std::scoped_lock lock(mutex_);
+            for (const auto& e : processed.events) {
+                auto& delivered = partitions_[e.partition].delivered;
+                switch (e.type) {
+                    case event_type::mutation:
+                    case event_type::deletion:
+                    case event_type::expiration:
+                        delivered.partition_uuid = e.partition_uuid;
+                        delivered.seqno = e.by_seqno;
+                        delivered.snapshot_start = e.snapshot_start;
+                        delivered.snapshot_end = e.snapshot_end;
+                        break;
+                    case event_type::rollback:
+                        delivered.partition_uuid = e.partition_uuid;
+                        delivered.seqno = e.by_seqno;
+                        delivered.snapshot_start = e.by_seqno;
+                        delivered.snapshot_end = e.by_seqno;
+                        break;
+                    case event_type::stream_end:
+                        break;
+                }
+            }
+            auto threshold = static_cast<std::size_t>(options_.buffer_size * options_.buffer_ack_threshold);
+            for (const auto& [session_id, bytes] : processed.bytes) {
+                for (auto& [index, node] : nodes_) {
+                    if (!node.session || node.session->id() != session_id) {
+                        continue;
+                    }
+                    node.unacked_bytes += bytes;
+                    if (node.unacked_bytes >= threshold) {
+                        acks.emplace_back(node.session, static_cast<std::uint32_t>(node.unacked_bytes));
+                        node.unacked_bytes = 0;
+                    }
+                }
+            }
+        }
+        for (const auto& [session, bytes] : acks) {
+            protocol::client_request<protocol::dcp_buffer_acknowledgement_request_body> req;
+            req.opaque(session->next_opaque());
+            req.body().bytes(bytes);
+            session->write_and_flush(req.data());
+        }
+    }
+
+    /**
+     * @return state of the partitions after the last acknowledged batch
+     */
+    [[nodiscard]] std::map<std::uint16_t, partition_state> state() const
+    {
+        std::scoped_lock lock(mutex_);
+        std::map<std::uint16_t, partition_state> result;
+        for (const auto& [partition, stream] : partitions_) {
+            result.emplace(partition, stream.delivered);
+        }
+        return result;
+    }
+
+  private:
+    struct node_entry {
+        std::shared_ptr<io::mcbp_session> session{};
+        bool ready{ false };
+        std::size_t unacked_bytes{ 0 };
+    };
+
+    struct partition_stream {
+        partition_state received{};
+        partition_state delivered{};
+        std::string session_id{};
+        std::uint32_t opaque{ 0 };
+        bool requested{ false };
+        bool finished{ false };
+    };
+
+    [[nodiscard]] std::shared_ptr<io::mcbp_session> make_session(const couchbase::origin& origin)
+    {
+        if (origin_.options().enable_tls) {
+            return std::make_shared<io::mcbp_session>(client_id_, ctx_, tls_, origin, bucket_name_);
+        }
+        return std::make_shared<io::mcbp_session>(client_id_, ctx_, origin, bucket_name_);
+    }
+
+    void do_bootstrap()
+    {
+        auto session = make_session(origin_);
+        session->bootstrap(
+          [self = shared_from_this(), session](std::error_code ec, const configuration& config) {
+              if (ec) {
+                  spdlog::error("{} unable to bootstrap DCP consumer: {}", self->log_prefix_, ec.message());
+                  return self->complete(ec);
+              }
+              if (!config.vbmap.has_value() || config.vbmap->empty()) {
+                  spdlog::error("{} DCP requires bucket with vBucket map", self->log_prefix_);
+                  return self->complete(error::common_errc::unsupported_operation);
+              }
+              {
+                  std::scoped_lock lock(self->mutex_);
+                  self->config_ = config;
+                  std::vector<std::uint16_t> partitions = self->options_.partitions;
+                  if (partitions.empty()) {
+                      for (std::size_t vbid = 0; vbid < config.vbmap->size(); ++vbid) {
+                          partitions.emplace_back(static_cast<std::uint16_t>(vbid));
+                      }
+                  }
+                  for (auto vbid : partitions) {
+                      partition_stream stream{};
+                      if (auto state = self->options_.start_state.find(vbid); state != self->options_.start_state.end()) {
+                          stream.received = state->second;
+                          stream.delivered = state->second;
+                      }
+                      self->partitions_.emplace(vbid, std::move(stream));
+                  }
+                  self->nodes_[session->index()].session = session;
+              }
+              self->schedule_flush();
+              for (const auto& node : config.nodes) {
+                  if (node.index == session->index()) {
+                      self->on_node_ready(node.index, session);
+                  } else {
+                      self->open_node(node.index);
+                  }
+              }
+          },
+          true);
+    }
+
+    void open_node(std::size_t index)
+    {
+        std::shared_ptr<io::mcbp_session> session;
+        {
+            std::scoped_lock lock(mutex_);
+            if (stopped_ || index >= config_.nodes.size()) {
+                return;
+            }
+            const auto& node = config_.nodes[index];
+            const auto& hostname = node.hostname_for(origin_.options().network);
+            auto port = node.port_or(origin_.options().network, service_type::kv, origin_.options().enable_tls, 0);
+            if (port == 0) {
+                return;
+            }
+            session = make_session(couchbase::origin(origin_, hostname, port));
+            nodes_[index] = node_entry{ session };
+        }
+        session->bootstrap(
+          [self = shared_from_this(), session, index](std::error_code ec, const configuration& /* config */) {
+              if (ec) {
+                  spdlog::warn("{} unable to connect to node idx={}: {}", self->log_prefix_, index, ec.message());
+                  return self->schedule_restart(index, session->id());
+              }
+              self->on_node_ready(index, session);
+          },
+          true);
+    }
+
+    void schedule_restart(std::size_t index, const std::string& session_id)
+    {
+        auto timer = std::make_shared<asio::steady_timer>(ctx_, options_.retry_interval);
+        timer->async_wait([self = shared_from_this(), timer, index, session_id](std::error_code ec) {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            {
+                std::scoped_lock lock(self->mutex_);
+                auto node = self->nodes_.find(index);
+                if (self->stopped_ || (node != self->nodes_.end() && node->second.session && node->second.session->id() != session_id)) {
+                    return; /* already restarted */
+                }
+            }
+            self->open_node(index);
+        });
+    }
+
+    void on_node_ready(std::size_t index, std::shared_ptr<io::mcbp_session> session)
+    {
+        session->on_configuration_update([self = shared_from_this()](const configuration& config) { self->update_config(config); });
+        session->on_stop([self = shared_from_this(), index, session_id = session->id()](io::retry_reason /* reason */) {
+            self->on_node_stopped(index, session_id);
+        });
+        session->on_dcp_message([self = shared_from_this(),
+                                 session_id = session->id(),
+                                 collections = session->supports_feature(protocol::hello_feature::collections)](io::mcbp_message&& msg) {
+            self->handle_message(session_id, collections, std::move(msg));
+        });
+
+        protocol::client_request<protocol::dcp_open_request_body> open_req;
+        open_req.opaque(session->next_opaque());
+        open_req.body().connection_name(options_.connection_name);
+        std::uint32_t flags = protocol::dcp_open_request_body::flag_producer | protocol::dcp_open_request_body::flag_include_delete_times;
+        if (options_.include_xattrs) {
+            flags |= protocol::dcp_open_request_body::flag_include_xattrs;
+        }
+        if (options_.no_value) {
+            flags |= protocol::dcp_open_request_body::flag_no_value;
+        }
+        open_req.body().flags(flags);
+        session->write_and_subscribe(
+          open_req.opaque(),
+          open_req.data(),
+          [self = shared_from_this(), session, index](std::error_code ec, io::retry_reason /* reason */, io::mcbp_message&& msg) {
+              if (ec || ntohs(msg.header.specific) != static_cast<std::uint16_t>(protocol::status::success)) {
+                  spdlog::error("{} unable to open DCP connection on node idx={}: {}, status={}",
+                                self->log_prefix_,
+                                index,
+                                ec.message(),
+                                protocol::status_to_string(ntohs(msg.header.specific)));
+                  return self->complete(ec ? ec : error::common_errc::authentication_failure);
+              }
+              self->send_controls(index, session);
+          });
+    }
+
+    void send_controls(std::size_t index, std::shared_ptr<io::mcbp_session> session)
+    {
+        std::vector<std::pair<std::string, std::string>> controls{
+            { "connection_buffer_size", std::to_string(options_.buffer_size) },
+            { "enable_noop", "true" },
+            { "set_noop_interval", std::to_string(options_.noop_interval.count()) },
+            { "enable_expiry_opcode", "true" },
+        };
+        auto pending = std::make_shared<std::atomic_size_t>(controls.size());
+        for (const auto& [key, value] : controls) {
+            protocol::client_request<protocol::dcp_control_request_body> req;
+            req.opaque(session->next_opaque());
+            req.body().control(key, value);
+            session->write_and_subscribe(
+              req.opaque(),
+              req.data(),
+              [self = shared_from_this(), session, index, pending, key = key](
+                std::error_code ec, io::retry_reason /* reason */, io::mcbp_message&& msg) {
+                  if (ec || ntohs(msg.header.specific) != static_cast<std::uint16_t>(protocol::status::success)) {
+                      spdlog::warn("{} DCP control \"{}\" rejected by node idx={}: {}, status={}",
+                                   self->log_prefix_,
+                                   key,
+                                   index,
+                                   ec.message(),
+                                   protocol::status_to_string(ntohs(msg.header.specific)));
+                  }
+                  if (--(*pending) == 0) {
+                      {
+                          std::scoped_lock lock(self->mutex_);
+                          if (auto node = self->nodes_.find(index); node != self->nodes_.end() && node->second.session == session) {
+                              node->second.ready = true;
+                          }
+                      }
+                      self->request_streams(index);
+                  }
+              });
+        }
+    }
+
+    void on_node_stopped(std::size_t index, const std::string& session_id)
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            if (stopped_) {
+                return;
+            }
+            if (auto node = nodes_.find(index); node != nodes_.end() && node->second.session && node->second.session->id() == session_id) {
+                node->second.ready = false;
+            }
+            for (auto& [vbid, stream] : partitions_) {
+                if (stream.session_id == session_id) {
+                    stream.requested = false;
+                }
+            }
+        }
+        spdlog::debug("{} DCP session to node idx={} has been closed, reconnecting", log_prefix_, index);
+        schedule_restart(index, session_id);
+    }
+
+    void update_config(const configuration& config)
+    {
+        std::vector<std::size_t> new_nodes;
+        {
+            std::scoped_lock lock(mutex_);
+            if (stopped_ || !config.vbmap.has_value() || config.rev <= config_.rev) {
+                return;
+            }
+            spdlog::debug("{} DCP consumer received new configuration: {}", log_prefix_, config);
+            config_ = config;
+            for (const auto& node : config_.nodes) {
+                if (nodes_.find(node.index) == nodes_.end()) {
+                    new_nodes.emplace_back(node.index);
+                }
+            }
+        }
+        for (auto index : new_nodes) {
+            open_node(index);
+        }
+    }
+
+    /**
+     * Requests streams for all partitions owned by the node, that are not streaming yet.
+     */
+    void request_streams(std::size_t index)
+    {
+        std::vector<std::uint16_t> partitions;
+        {
+            std::scoped_lock lock(mutex_);
+            for (const auto& [vbid, stream] : partitions_) {
+                if (!stream.finished && !stream.requested && owner(vbid) == static_cast<std::int16_t>(index)) {
+                    partitions.emplace_back(vbid);
+                }
+            }
+        }
+        for (auto vbid : partitions) {
+            request_stream(vbid);
+        }
+    }
+
+    [[nodiscard]] std::int16_t owner(std::uint16_t vbid) const
+    {
+        if (!config_.vbmap.has_value() || vbid >= config_.vbmap->size() || config_.vbmap->at(vbid).empty()) {
+            return -1;
+        }
+        return config_.vbmap->at(vbid)[0];
+    }
+
+    void request_stream(std::uint16_t vbid)
+    {
+        std::shared_ptr<io::mcbp_session> session;
+        protocol::client_request<protocol::dcp_stream_request_request_body> req;
+        {
+            std::scoped_lock lock(mutex_);
+            auto& stream = partitions_[vbid];
+            if (stopped_ || stream.finished || stream.requested) {
+                return;
+            }
+            auto index = owner(vbid);
+            auto node = nodes_.find(static_cast<std::size_t>(index));
+            if (index < 0 || node == nodes_.end() || !node->second.ready) {
+                /* the stream will be requested when the node will be ready */
+                return;
+            }
+            session = node->second.session;
+            req.opaque(session->next_opaque());
+            req.partition(vbid);
+            req.body().start_seqno(stream.received.seqno);
+            req.body().end_seqno(options_.end_seqno);
+            req.body().partition_uuid(stream.received.partition_uuid);
+            req.body().snapshot(stream.received.snapshot_start, stream.received.snapshot_end);
+            req.body().flags(options_.stream_flags);
+            if (!collections_filter_.empty()) {
+                req.body().filter(collections_filter_);
+            }
+            stream.requested = true;
+            stream.opaque = req.opaque();
+            stream.session_id = session->id();
+        }
+        session->write_and_subscribe(
+          req.opaque(),
+          req.data(),
+          [self = shared_from_this(), vbid, opaque = req.opaque()](
+            std::error_code ec, io::retry_reason /* reason */, io::mcbp_message&& msg) {
+              self->on_stream_response(vbid, opaque, ec, std::move(msg));
+          });
+    }
+
+    void on_stream_response(std::uint16_t vbid, std::uint32_t opaque, std::error_code ec, io::mcbp_message&& msg)
+    {
+        if (ec) {
+            spdlog::debug("{} DCP stream request failed for vb={}: {}", log_prefix_, vbid, ec.message());
+            return retry_stream(vbid, opaque);
+        }
+        protocol::client_response<protocol::dcp_stream_request_request_body::response_body_type> resp(std::move(msg));
+        switch (resp.status()) {
+            case protocol::status::success: {
+                std::scoped_lock lock(mutex_);
+                auto& stream = partitions_[vbid];
+                if (stream.opaque != opaque) {
+                    return;
+                }
+                stream.received.failover_entries = resp.body().failover_log_entries();
+                stream.delivered.failover_entries = stream.received.failover_entries;
+                if (!stream.received.failover_entries.empty()) {
+                    stream.received.partition_uuid = stream.received.failover_entries.front().first;
+                }
+                spdlog::trace("{} DCP stream opened for vb={}, start_seqno={}", log_prefix_, vbid, stream.received.seqno);
+            } break;
+
+            case protocol::status::rollback: {
+                event e{};
+                e.type = event_type::rollback;
+                e.partition = vbid;
+                e.by_seqno = resp.body().rollback_seqno();
+                {
+                    std::scoped_lock lock(mutex_);
+                    auto& stream = partitions_[vbid];
+                    if (stream.opaque != opaque) {
+                        return;
+                    }
+                    for (const auto& [uuid, seqno] : stream.received.failover_entries) {
+                        if (seqno <= e.by_seqno) {
+                            e.partition_uuid = uuid;
+                            break;
+                        }
+                    }
+                    spdlog::debug("{} DCP stream for vb={} rolls back from seqno={} to seqno={}",
+                                  log_prefix_,
+                                  vbid,
+                                  stream.received.seqno,
+                                  e.by_seqno);
+                    stream.received.partition_uuid = e.partition_uuid;
+                    stream.received.seqno = e.by_seqno;
+                    stream.received.snapshot_start = e.by_seqno;
+                    stream.received.snapshot_end = e.by_seqno;
+                    stream.requested = false;
+                    batch_.events.emplace_back(std::move(e));
+                }
+                request_stream(vbid);
+            } break;
+
+            case protocol::status::not_my_vbucket: {
+                auto& body = resp.data();
+                if (!body.empty()) {
+                    try {
+                        update_config(protocol::parse_config(body.begin(), body.end()));
+                    } catch (const std::exception& e) {
+                        spdlog::debug("{} unable to parse configuration from NOT_MY_VBUCKET: {}", log_prefix_, e.what());
+                    }
+                }
+                retry_stream(vbid, opaque);
+            } break;
+
+            default: {
+                spdlog::error("{} DCP stream request for vb={} failed: {}", log_prefix_, vbid, resp.error_message());
+                {
+                    std::scoped_lock lock(mutex_);
+                    auto& stream = partitions_[vbid];
+                    if (stream.opaque != opaque) {
+                        return;
+                    }
+                    stream.finished = true;
+                }
+                maybe_complete();
+            } break;
+        }
+    }
+
+    void retry_stream(std::uint16_t vbid, std::uint32_t opaque)
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            auto& stream = partitions_[vbid];
+            if (stopped_ || stream.opaque != opaque) {
+                return;
+            }
+            stream.requested = false;
+        }
+        auto timer = std::make_shared<asio::steady_timer>(ctx_, options_.retry_interval);
+        timer->async_wait([self = shared_from_this(), timer, vbid](std::error_code ec) {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            self->request_stream(vbid);
+        });
+    }
+
+    void handle_message(const std::string& session_id, bool collections, io::mcbp_message&& msg)
+    {
+        auto opcode = protocol::client_opcode(msg.header.opcode);
+        if (opcode == protocol::client_opcode::dcp_noop) {
+            return reply_noop(session_id, msg);
+        }
+        std::uint16_t vbid = ntohs(msg.header.specific);
+        std::size_t bytes = protocol::header_size + msg.body.size();
+
+        bool restart_stream = false;
+        bool stream_finished = false;
+        bool flush_now = false;
+        {
+            std::scoped_lock lock(mutex_);
+            batch_.bytes[session_id] += bytes;
+            auto stream = partitions_.find(vbid);
+            if (stream == partitions_.end() || stream->second.session_id != session_id || stream->second.opaque != msg.header.opaque) {
+                return;
+            }
+            auto& received = stream->second.received;
+            switch (opcode) {
+                case protocol::client_opcode::dcp_snapshot_marker:
+                    if (auto marker = message_decoder::snapshot(msg); marker) {
+                        received.snapshot_start = marker->start;
+                        received.snapshot_end = marker->end;
+                    }
+                    break;
+
+                case protocol::client_opcode::dcp_mutation:
+                case protocol::client_opcode::dcp_deletion:
+                case protocol::client_opcode::dcp_expiration: {
+                    auto e = message_decoder::document(msg, collections);
+                    if (!e) {
+                        spdlog::warn("{} unable to decode DCP {} for vb={}, opaque={}", log_prefix_, opcode, vbid, msg.header.opaque);
+                        break;
+                    }
+                    e->partition_uuid = received.partition_uuid;
+                    e->snapshot_start = received.snapshot_start;
+                    e->snapshot_end = received.snapshot_end;
+                    received.seqno = e->by_seqno;
+                    batch_.events.emplace_back(std::move(*e));
+                    flush_now = batch_.events.size() >= options_.batch_size;
+                } break;
+
+                case protocol::client_opcode::dcp_stream_end: {
+                    event e{};
+                    e.type = event_type::stream_end;
+                    e.partition = vbid;
+                    e.reason = message_decoder::stream_end(msg).value_or(stream_end_reason::ok);
+                    switch (e.reason) {
+                        case stream_end_reason::state_changed:
+                        case stream_end_reason::disconnected:
+                        case stream_end_reason::too_slow:
+                        case stream_end_reason::backfill_failed:
+                        case stream_end_reason::rollback:
+                            stream->second.requested = false;
+                            restart_stream = true;
+                            break;
+                        case stream_end_reason::ok:
+                        case stream_end_reason::closed:
+                        case stream_end_reason::filter_empty:
+                        case stream_end_reason::lost_privileges:
+                            stream->second.finished = true;
+                            stream_finished = true;
+                            break;
+                    }
+                    spdlog::debug("{} DCP stream for vb={} has ended, reason={}", log_prefix_, vbid, static_cast<std::uint32_t>(e.reason));
+                    batch_.events.emplace_back(std::move(e));
+                } break;
+
+                default:
+                    /* system events, seqno advanced and vBucket state changes are only counted for flow control */
+                    break;
+            }
+        }
+        if (flush_now) {
+            flush();
+        }
+        if (restart_stream) {
+            retry_stream(vbid, msg.header.opaque);
+        }
+        if (stream_finished) {
+            maybe_complete();
+        }
+    }
+
+    void reply_noop(const std::string& session_id, const io::mcbp_message& msg)
+    {
+        std::shared_ptr<io::mcbp_session> session;
+        {
+            std::scoped_lock lock(mutex_);
+            for (const auto& [index, node] : nodes_) {
+                if (node.session && node.session->id() == session_id) {
+                    session = node.session;
+                }
+            }
+        }
+        if (!session) {
+            return;
+        }
+        std::vector<std::uint8_t> reply(protocol::header_size, 0);
+        reply[0] = static_cast<std::uint8_t>(protocol::magic::client_response);
+        reply[1] = static_cast<std::uint8_t>(protocol::client_opcode::dcp_noop);
+        std::memcpy(reply.data() + 12, &msg.header.opaque, sizeof(msg.header.opaque));
+        session->write_and_flush(reply);
+    }
+
+    void schedule_flush()
+    {
+        flush_timer_.expires_after(options_.flush_interval);
+        flush_timer_.async_wait([self = shared_from_this()](std::error_code ec) {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            self->flush();
+            if (!self->stopped_) {
+                self->schedule_flush();
+            }
+        });
+    }
+
+    void flush()
+    {
+        std::scoped_lock delivery_lock(delivery_mutex_);
+        batch ready{};
+        {
+            std::scoped_lock lock(mutex_);
+            if (batch_.events.empty() && batch_.bytes.empty()) {
+                return;
+            }
+            std::swap(ready, batch_);
+        }
+        if (ready.events.empty() || !on_batch_) {
+            /* nothing to show to the application, but the bytes still have to be acknowledged */
+            return acknowledge(ready);
+        }
+        on_batch_(std::move(ready));
+    }
+
+    void maybe_complete()
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            for (const auto& [vbid, stream] : partitions_) {
+                if (!stream.finished) {
+                    return;
+                }
+            }
+        }
+        complete({});
+    }
+
+    void complete(std::error_code ec)
+    {
+        std::map<std::size_t, node_entry> nodes;
+        {
+            std::scoped_lock lock(mutex_);
+            if (stopped_) {
+                return;
+            }
+            stopped_ = true;
+            std::swap(nodes, nodes_);
+        }
+        flush_timer_.cancel();
+        flush();
+        for (auto& [index, node] : nodes) {
+            if (node.session) {
+                node.session->stop(io::retry_reason::do_not_retry);
+            }
+        }
+        if (on_complete_) {
+            on_complete_(ec);
+        }
+    }
+
+    std::string client_id_;
+    asio::io_context& ctx_;
+    asio::ssl::context& tls_;
+    couchbase::origin origin_;
+    std::string bucket_name_;
+    consumer_options options_;
+    std::string log_prefix_{};
+    std::string collections_filter_{};
+    asio::steady_timer flush_timer_;
+    batch_handler on_batch_{};
+    completion_handler on_complete_{};
+
+    mutable std::mutex mutex_{};
+    std::mutex delivery_mutex_{};
+    std::atomic_bool stopped_{ false };
+    configuration config_{};
+    std::map<std::size_t, node_entry> nodes_{};
+    std::map<std::uint16_t, partition_stream> partitions_{};
+    batch batch_{};
+};
+} // namespace couchbase::dcp
@@ -0,0 +1,105 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace couchbase::dcp
+{
+enum class event_type {
+    mutation,
+    deletion,
+    expiration,
+
+    /**
+     * The server has closed the stream, see stream_end_reason.
+     */
+    stream_end,
+
+    /**
+     * The server asked to roll back the partition, all changes after by_seqno have to be discarded by the application.
+     */
+    rollback,
+};
+
+enum class stream_end_reason : std::uint32_t {
+    ok = 0x00,
+    closed = 0x01,
+    state_changed = 0x02,
+    disconnected = 0x03,
+    too_slow = 0x04,
+    backfill_failed = 0x05,
+    rollback = 0x06,
+    filter_empty = 0x07,
+    lost_privileges = 0x08,
+};
+
+/**
+ * Partition UUID and the sequence number, at which it has been created. Newest entry goes first.
+ */
+using failover_log = std::vector<std::pair<std::uint64_t, std::uint64_t>>;
+
+/**
+ * Position in the partition history. Enough to resume the stream after restart of the application.
+ */
+struct partition_state {
+    std::uint64_t partition_uuid{ 0 };
+    std::uint64_t seqno{ 0 };
+    std::uint64_t snapshot_start{ 0 };
+    std::uint64_t snapshot_end{ 0 };
+    failover_log failover_entries{};
+};
+
+struct event {
+    event_type type{ event_type::mutation };
+    std::uint16_t partition{ 0 };
+    std::uint64_t partition_uuid{ 0 };
+    std::uint64_t by_seqno{ 0 };
+    std::uint64_t rev_seqno{ 0 };
+    std::uint64_t snapshot_start{ 0 };
+    std::uint64_t snapshot_end{ 0 };
+    std::uint64_t cas{ 0 };
+    std::uint32_t flags{ 0 };
+    std::uint32_t expiry{ 0 };
+    std::uint8_t datatype{ 0 };
+
+    /**
+     * Collection of the document, zero (default collection) when the connection does not use collections.
+     */
+    std::uint32_t collection_id{ 0 };
+    stream_end_reason reason{ stream_end_reason::ok };
+    std::string key{};
+    std::string value{};
+};
+
+/**
+ * Events delivered together. The consumer acknowledges the bytes to the server (flow control) and advances partition states only
+ * when the batch is given back to consumer::acknowledge.
+ */
+struct batch {
+    std::vector<event> events{};
+
+    /**
+     * Number of bytes received for this batch, by session ID.
+     */
+    std::map<std::string, std::size_t> bytes{};
+};
+} // namespace couchbase::dcp
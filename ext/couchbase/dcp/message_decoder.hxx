@@ -0,0 +1,167 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+#include <io/mcbp_message.hxx>
+#include <protocol/client_opcode.hxx>
+#include <protocol/magic.hxx>
+#include <protocol/unsigned_leb128.h>
+#include <utils/byteswap.hxx>
+
+#include <dcp/event.hxx>
+
+namespace couchbase::dcp
+{
+/**
+ * Boundaries of the snapshot, which contains the following mutations of the partition.
+ */
+struct snapshot_marker {
+    std::uint64_t start{ 0 };
+    std::uint64_t end{ 0 };
+};
+
+/**
+ * Decodes the messages, that the server sends on the DCP stream. The decoder does not know the state of the stream, so partition UUID
+ * and snapshot boundaries of the document events are left for the consumer.
+ */
+class message_decoder
+{
+  public:
+    [[nodiscard]] static std::optional<snapshot_marker> snapshot(const io::mcbp_message& msg)
+    {
+        auto layout = layout_of(msg);
+        if (!layout || layout->extras_size < 2 * sizeof(std::uint64_t)) {
+            return {};
+        }
+        const auto* extras = msg.body.data() + layout->framing_extras_size;
+        return snapshot_marker{ read_uint64(extras, 0), read_uint64(extras, sizeof(std::uint64_t)) };
+    }
+
+    /**
+     * Decodes mutation, deletion or expiration.
+     *
+     * @param collections whether the connection has negotiated collections, in this case every key starts with LEB128-encoded
+     * collection ID, which is moved into event::collection_id
+     */
+    [[nodiscard]] static std::optional<event> document(const io::mcbp_message& msg, bool collections)
+    {
+        auto layout = layout_of(msg);
+        if (!layout || layout->extras_size < 2 * sizeof(std::uint64_t)) {
+            return {};
+        }
+        auto opcode = protocol::client_opcode(msg.header.opcode);
+        event e{};
+        switch (opcode) {
+            case protocol::client_opcode::dcp_mutation:
+                e.type = event_type::mutation;
+                break;
+            case protocol::client_opcode::dcp_deletion:
+                e.type = event_type::deletion;
+                break;
+            case protocol::client_opcode::dcp_expiration:
+                e.type = event_type::expiration;
+                break;
+            default:
+                return {};
+        }
+        const auto* extras = msg.body.data() + layout->framing_extras_size;
+        e.partition = ntohs(msg.header.specific);
+        e.by_seqno = read_uint64(extras, 0);
+        e.rev_seqno = read_uint64(extras, sizeof(std::uint64_t));
+        e.cas = utils::byte_swap_64(msg.header.cas);
+        e.datatype = msg.header.datatype;
+        if (opcode == protocol::client_opcode::dcp_mutation &&
+            layout->extras_size >= 2 * sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t)) {
+            e.flags = read_uint32(extras, 2 * sizeof(std::uint64_t));
+            e.expiry = read_uint32(extras, 2 * sizeof(std::uint64_t) + sizeof(std::uint32_t));
+        }
+        std::string_view key(reinterpret_cast<const char*>(extras + layout->extras_size), layout->key_size);
+        if (collections) {
+            if (key.empty()) {
+                return {};
+            }
+            auto [collection_id, stripped] = protocol::decode_unsigned_leb128<std::uint32_t>(key, protocol::Leb128NoThrow{});
+            if (stripped.data() == nullptr) {
+                return {};
+            }
+            e.collection_id = collection_id;
+            key = stripped;
+        }
+        e.key.assign(key);
+        const auto* value = extras + layout->extras_size + layout->key_size;
+        e.value.assign(reinterpret_cast<const char*>(value), msg.body.size() - static_cast<std::size_t>(value - msg.body.data()));
+        return e;
+    }
+
+    [[nodiscard]] static std::optional<stream_end_reason> stream_end(const io::mcbp_message& msg)
+    {
+        auto layout = layout_of(msg);
+        if (!layout || layout->extras_size < sizeof(std::uint32_t)) {
+            return {};
+        }
+        return stream_end_reason(read_uint32(msg.body.data() + layout->framing_extras_size, 0));
+    }
+
+  private:
+    struct layout {
+        std::size_t framing_extras_size{ 0 };
+        std::size_t extras_size{ 0 };
+        std::size_t key_size{ 0 };
+    };
+
+    /**
+     * @return sizes of the body parts, or empty if they do not fit into the body
+     */
+    [[nodiscard]] static std::optional<layout> layout_of(const io::mcbp_message& msg)
+    {
+        layout res{};
+        res.extras_size = msg.header.extlen;
+        if (msg.header.magic == static_cast<std::uint8_t>(protocol::magic::alt_client_request)) {
+            /* alternative encoding splits key length into framing extras length and one byte key length */
+            std::uint8_t sizes[sizeof(msg.header.keylen)];
+            std::memcpy(sizes, &msg.header.keylen, sizeof(sizes));
+            res.framing_extras_size = sizes[0];
+            res.key_size = sizes[1];
+        } else {
+            res.key_size = ntohs(msg.header.keylen);
+        }
+        if (res.framing_extras_size + res.extras_size + res.key_size > msg.body.size()) {
+            return {};
+        }
+        return res;
+    }
+
+    [[nodiscard]] static std::uint64_t read_uint64(const std::uint8_t* data, std::size_t offset)
+    {
+        std::uint64_t value = 0;
+        std::memcpy(&value, data + offset, sizeof(value));
+        return utils::byte_swap_64(value);
+    }
+
+    [[nodiscard]] static std::uint32_t read_uint32(const std::uint8_t* data, std::size_t offset)
+    {
+        std::uint32_t value = 0;
+        std::memcpy(&value, data + offset, sizeof(value));
+        return ntohl(value);
+    }
+};
+} // namespace couchbase::dcp
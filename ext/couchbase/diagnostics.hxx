@@ -21,6 +21,8 @@
 #include <map>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <optional>
 
 #include <spdlog/fmt/fmt.h>
 
@@ -60,10 +62,20 @@ struct endpoint_diag_info {
     std::optional<std::string> details{};
 };
 
+struct tls_handshake_info {
+    std::uint64_t full_handshakes{ 0 };
+    std::uint64_t resumed_handshakes{ 0 };
+    std::uint64_t failed_handshakes{ 0 };
+    std::uint64_t total_handshake_us{ 0 };
+    std::uint64_t max_handshake_us{ 0 };
+};
+
 struct diagnostics_result {
     std::string id;
     std::string sdk;
     std::map<service_type, std::vector<endpoint_diag_info>> services{};
+    /** TLS handshakes of the cluster since it has been opened, empty for plain connections */
+    std::optional<tls_handshake_info> tls{};
 
     int version{ 2 };
 };
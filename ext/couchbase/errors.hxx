@@ -102,6 +102,10 @@ enum class common_errc {
 
     /// Raised when decoding of the data into the user object failed
     decoding_failure,
+
+    /// The request cannot be queued, because the node has reached its limit of requests in flight (or bytes waiting to be written).
+    /// Raised immediately instead of waiting for the timeout.
+    job_queue_full,
 };
 
 /// Errors for related to KeyValue service (kv_engine)
@@ -360,6 +364,8 @@ struct common_error_category : std::error_category {
                 return "index_not_found";
             case common_errc::index_exists:
                 return "index_exists";
+            case common_errc::job_queue_full:
+                return "job_queue_full";
         }
         return "FIXME: unknown error code common (recompile with newer library)";
     }
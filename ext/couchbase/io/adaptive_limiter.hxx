@@ -0,0 +1,150 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace couchbase::io
+{
+/**
+ * Limits number of requests in flight and number of bytes waiting to be written for a single session.
+ *
+ * The limit of requests in flight adapts using AIMD: it grows by one per "window" of responses while latency stays close to the
+ * lowest observed one, and shrinks by a fixed factor (at most once per round trip) when latency degrades or requests time out.
+ */
+class adaptive_limiter
+{
+  public:
+    struct snapshot {
+        std::size_t in_flight;
+        std::size_t limit;
+        std::size_t queued_bytes;
+        std::size_t max_queued_bytes;
+        std::size_t rejected;
+    };
+
+    adaptive_limiter(std::size_t max_in_flight, std::size_t max_queued_bytes)
+      : max_limit_(std::max(max_in_flight, min_limit))
+      , max_queued_bytes_(max_queued_bytes)
+      , limit_(static_cast<double>(std::max(max_limit_ / 4, min_limit)))
+    {
+    }
+
+    /**
+     * @return false if the request has to be rejected
+     */
+    [[nodiscard]] bool try_acquire(std::size_t bytes)
+    {
+        std::scoped_lock lock(mutex_);
+        if (in_flight_ >= static_cast<std::size_t>(limit_) || (max_queued_bytes_ > 0 && queued_bytes_ + bytes > max_queued_bytes_)) {
+            ++rejected_;
+            return false;
+        }
+        ++in_flight_;
+        return true;
+    }
+
+    void on_queued(std::size_t bytes)
+    {
+        std::scoped_lock lock(mutex_);
+        queued_bytes_ += bytes;
+    }
+
+    void on_written(std::size_t bytes)
+    {
+        std::scoped_lock lock(mutex_);
+        queued_bytes_ -= std::min(bytes, queued_bytes_);
+    }
+
+    /**
+     * releases the slot without updating the limit (e.g. when the session is being closed)
+     */
+    void release()
+    {
+        std::scoped_lock lock(mutex_);
+        if (in_flight_ > 0) {
+            --in_flight_;
+        }
+    }
+
+    /**
+     * @param latency time between dispatch and completion of the request
+     * @param congested true if the request has not been completed normally (e.g. timed out)
+     */
+    void release(std::chrono::steady_clock::duration latency, bool congested)
+    {
+        release(latency, congested, std::chrono::steady_clock::now());
+    }
+
+    /**
+     * @param now time of the completion
+     */
+    void release(std::chrono::steady_clock::duration latency, bool congested, std::chrono::steady_clock::time_point now)
+    {
+        std::scoped_lock lock(mutex_);
+        if (in_flight_ > 0) {
+            --in_flight_;
+        }
+        if (!congested) {
+            if (min_latency_.count() == 0 || latency < min_latency_) {
+                min_latency_ = latency;
+            }
+            if (latency <= min_latency_ * latency_tolerance) {
+                /* increase only if the current limit is actually utilized */
+                if (static_cast<double>(in_flight_ + 1) * 2 >= limit_) {
+                    limit_ = std::min(limit_ + 1.0 / limit_, static_cast<double>(max_limit_));
+                }
+                return;
+            }
+        }
+        /* decrease at most once per round trip, otherwise single burst of slow responses collapses the limit */
+        if (now - last_decrease_ < std::max(latency, min_latency_)) {
+            return;
+        }
+        last_decrease_ = now;
+        limit_ = std::max(limit_ * backoff_ratio, static_cast<double>(min_limit));
+        /* let the baseline follow the node, if it became slower permanently */
+        min_latency_ += (latency - min_latency_) / 8;
+    }
+
+    [[nodiscard]] snapshot stats() const
+    {
+        std::scoped_lock lock(mutex_);
+        return { in_flight_, static_cast<std::size_t>(limit_), queued_bytes_, max_queued_bytes_, rejected_ };
+    }
+
+  private:
+    static constexpr std::size_t min_limit = 16;
+    static constexpr double backoff_ratio = 0.9;
+    static constexpr int latency_tolerance = 2;
+
+    const std::size_t max_limit_;
+    const std::size_t max_queued_bytes_;
+
+    mutable std::mutex mutex_{};
+    double limit_;
+    std::size_t in_flight_{ 0 };
+    std::size_t queued_bytes_{ 0 };
+    std::size_t rejected_{ 0 };
+    std::chrono::steady_clock::duration min_latency_{};
+    std::chrono::steady_clock::time_point last_decrease_{};
+};
+} // namespace couchbase::io
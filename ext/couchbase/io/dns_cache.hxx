@@ -0,0 +1,280 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include <asio.hpp>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <io/dns_client.hxx>
+
+namespace couchbase::io::dns
+{
+/**
+ * Orders SRV targets as described by RFC 2782: ascending priority, and weighted random order inside every priority group, so that
+ * targets with larger weight are more likely to be tried first.
+ */
+inline std::vector<dns_client::dns_srv_response::address>
+order_srv_targets(std::vector<dns_client::dns_srv_response::address> targets)
+{
+    static thread_local std::mt19937_64 gen{ std::random_device{}() };
+
+    std::stable_sort(targets.begin(), targets.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.priority < rhs.priority || (lhs.priority == rhs.priority && lhs.weight == 0 && rhs.weight != 0);
+    });
+    std::vector<dns_client::dns_srv_response::address> result;
+    result.reserve(targets.size());
+    auto group_begin = targets.begin();
+    while (group_begin != targets.end()) {
+        auto group_end = std::find_if(group_begin, targets.end(), [priority = group_begin->priority](const auto& target) {
+            return target.priority != priority;
+        });
+        std::vector<dns_client::dns_srv_response::address> group(group_begin, group_end);
+        while (!group.empty()) {
+            std::uint64_t sum = 0;
+            for (const auto& target : group) {
+                sum += target.weight;
+            }
+            auto selected = std::uniform_int_distribution<std::uint64_t>(0, sum)(gen);
+            std::uint64_t running_sum = 0;
+            auto it = group.begin();
+            for (; it != group.end(); ++it) {
+                running_sum += it->weight;
+                if (running_sum >= selected) {
+                    break;
+                }
+            }
+            result.emplace_back(std::move(*it));
+            group.erase(it);
+        }
+        group_begin = group_end;
+    }
+    return result;
+}
+
+/**
+ * Process-wide cache of DNS answers, shared by all sessions and clusters.
+ *
+ * Hostname resolution (getaddrinfo does not expose TTL) is cached for the configured TTL, and SRV answers for the smallest TTL of the
+ * records. Failed and empty answers are cached for the negative TTL. An entry that is past three quarters of its TTL is served from the
+ * cache and refreshed in the background, so sessions never wait for the resolver while the name keeps resolving.
+ *
+ * The cache does not own resolvers: misses and refreshes use the resolver or DNS client of the caller, and handlers are invoked on its
+ * executor.
+ */
+class dns_cache
+{
+  public:
+    struct stats {
+        std::uint64_t hits{ 0 };
+        std::uint64_t misses{ 0 };
+        std::uint64_t refreshes{ 0 };
+    };
+
+    static dns_cache& instance()
+    {
+        static dns_cache cache;
+        return cache;
+    }
+
+    template<typename Handler>
+    void async_resolve(asio::ip::tcp::resolver& resolver,
+                       const std::string& hostname,
+                       const std::string& service,
+                       std::chrono::milliseconds ttl,
+                       std::chrono::milliseconds negative_ttl,
+                       Handler&& handler)
+    {
+        if (ttl.count() == 0) {
+            return resolver.async_resolve(hostname, service, std::forward<Handler>(handler));
+        }
+        auto key = fmt::format("{}:{}", hostname, service);
+        {
+            std::scoped_lock lock(mutex_);
+            if (auto it = hosts_.find(key); it != hosts_.end() && it->second.expires_at > std::chrono::steady_clock::now()) {
+                ++stats_.hits;
+                asio::post(resolver.get_executor(),
+                           [handler = std::forward<Handler>(handler), ec = it->second.ec, results = it->second.results]() mutable {
+                               handler(ec, results);
+                           });
+                if (!start_refresh(it->second)) {
+                    return;
+                }
+                return resolver.async_resolve(hostname,
+                                              service,
+                                              [this, key, ttl, negative_ttl](std::error_code ec,
+                                                                             const asio::ip::tcp::resolver::results_type& results) {
+                                                  store_host(key, ec, results, ttl, negative_ttl);
+                                              });
+            }
+            ++stats_.misses;
+        }
+        resolver.async_resolve(hostname,
+                               service,
+                               [this, key, ttl, negative_ttl, handler = std::forward<Handler>(handler)](
+                                 std::error_code ec, const asio::ip::tcp::resolver::results_type& results) mutable {
+                                   store_host(key, ec, results, ttl, negative_ttl);
+                                   handler(ec, results);
+                               });
+    }
+
+    template<typename Handler>
+    void query_srv(dns_client& client,
+                   const std::string& name,
+                   const std::string& service,
+                   std::chrono::milliseconds negative_ttl,
+                   Handler&& handler)
+    {
+        auto key = fmt::format("{}.{}", service, name);
+        {
+            std::scoped_lock lock(mutex_);
+            if (auto it = srv_.find(key); it != srv_.end() && it->second.expires_at > std::chrono::steady_clock::now()) {
+                ++stats_.hits;
+                dns_client::dns_srv_response resp{};
+                resp.targets = order_srv_targets(it->second.targets);
+                asio::post(client.ctx_, [handler = std::forward<Handler>(handler), resp = std::move(resp)]() mutable {
+                    handler(std::move(resp));
+                });
+                if (!start_refresh(it->second)) {
+                    return;
+                }
+                return client.query_srv(
+                  name, service, [this, key, negative_ttl](dns_client::dns_srv_response&& fresh) { store_srv(key, fresh, negative_ttl); });
+            }
+            ++stats_.misses;
+        }
+        client.query_srv(
+          name, service, [this, key, negative_ttl, handler = std::forward<Handler>(handler)](dns_client::dns_srv_response&& resp) mutable {
+              store_srv(key, resp, negative_ttl);
+              resp.targets = order_srv_targets(std::move(resp.targets));
+              handler(std::move(resp));
+          });
+    }
+
+    [[nodiscard]] stats get_stats() const
+    {
+        std::scoped_lock lock(mutex_);
+        return stats_;
+    }
+
+    void clear()
+    {
+        std::scoped_lock lock(mutex_);
+        hosts_.clear();
+        srv_.clear();
+    }
+
+  private:
+    struct entry {
+        std::chrono::steady_clock::time_point refresh_at{};
+        std::chrono::steady_clock::time_point expires_at{};
+        bool refreshing{ false };
+    };
+
+    struct host_entry : entry {
+        std::error_code ec{};
+        asio::ip::tcp::resolver::results_type results{};
+    };
+
+    struct srv_entry : entry {
+        std::vector<dns_client::dns_srv_response::address> targets{};
+    };
+
+    dns_cache() = default;
+
+    /**
+     * Marks entry as refreshing if it is old enough, must be called under the lock.
+     *
+     * @return true if the caller should start background refresh
+     */
+    bool start_refresh(entry& e)
+    {
+        if (e.refreshing || std::chrono::steady_clock::now() < e.refresh_at) {
+            return false;
+        }
+        ++stats_.refreshes;
+        e.refreshing = true;
+        return true;
+    }
+
+    static void set_expiry(entry& e, std::chrono::milliseconds ttl)
+    {
+        auto now = std::chrono::steady_clock::now();
+        e.expires_at = now + ttl;
+        e.refresh_at = now + ttl * 3 / 4;
+        e.refreshing = false;
+    }
+
+    void store_host(const std::string& key,
+                    std::error_code ec,
+                    const asio::ip::tcp::resolver::results_type& results,
+                    std::chrono::milliseconds ttl,
+                    std::chrono::milliseconds negative_ttl)
+    {
+        std::scoped_lock lock(mutex_);
+        if (ec == asio::error::operation_aborted) {
+            if (auto it = hosts_.find(key); it != hosts_.end()) {
+                it->second.refreshing = false;
+            }
+            return;
+        }
+        auto& e = hosts_[key];
+        if (ec && e.expires_at > std::chrono::steady_clock::now() && !e.ec) {
+            /* keep serving the last good answer, while the refresh fails */
+            e.refreshing = false;
+            return;
+        }
+        e.ec = ec;
+        e.results = results;
+        set_expiry(e, ec ? negative_ttl : ttl);
+    }
+
+    void store_srv(const std::string& key, const dns_client::dns_srv_response& resp, std::chrono::milliseconds negative_ttl)
+    {
+        std::scoped_lock lock(mutex_);
+        if (resp.ec) {
+            /* network errors and timeouts say nothing about the name, they are not cached */
+            if (auto it = srv_.find(key); it != srv_.end()) {
+                it->second.refreshing = false;
+            }
+            return;
+        }
+        auto& e = srv_[key];
+        e.targets = resp.targets;
+        if (resp.targets.empty()) {
+            return set_expiry(e, negative_ttl);
+        }
+        auto min_ttl = std::min_element(resp.targets.begin(), resp.targets.end(), [](const auto& lhs, const auto& rhs) {
+                           return lhs.ttl < rhs.ttl;
+                       })->ttl;
+        set_expiry(e, std::chrono::seconds(min_ttl));
+    }
+
+    mutable std::mutex mutex_{};
+    std::map<std::string, host_entry> hosts_{};
+    std::map<std::string, srv_entry> srv_{};
+    stats stats_{};
+};
+} // namespace couchbase::io::dns
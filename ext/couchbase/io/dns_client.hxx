@@ -34,9 +34,23 @@ class dns_client
         struct address {
             std::string hostname;
             std::uint16_t port;
+            std::uint16_t priority{ 0 };
+            std::uint16_t weight{ 0 };
+            std::uint32_t ttl{ 0 };
         };
         std::error_code ec;
         std::vector<address> targets{};
+
+        static dns_srv_response from_message(const dns_message& message)
+        {
+            dns_srv_response resp{};
+            resp.targets.reserve(message.answers.size());
+            for (const auto& answer : message.answers) {
+                resp.targets.emplace_back(address{
+                  fmt::format("{}", fmt::join(answer.target.labels, ".")), answer.port, answer.priority, answer.weight, answer.ttl });
+            }
+            return resp;
+        }
     };
 
     class dns_srv_command : public std::enable_shared_from_this<dns_srv_command>
@@ -103,13 +117,7 @@ class dns_client
                             self->udp_.close();
                             return self->retry_with_tcp(std::forward<Handler>(handler));
                         }
-                        dns_srv_response resp{ ec2 };
-                        resp.targets.reserve(message.answers.size());
-                        for (const auto& answer : message.answers) {
-                            resp.targets.emplace_back(
-                              dns_srv_response::address{ fmt::format("{}", fmt::join(answer.target.labels, ".")), answer.port });
-                        }
-                        return handler(std::move(resp));
+                        return handler(dns_srv_response::from_message(message));
                     });
               });
             deadline_.expires_after(timeout);
@@ -173,13 +181,7 @@ class dns_client
                                                    }
                                                    self->recv_buf_.resize(bytes_transferred);
                                                    dns_message message = dns_codec::decode(self->recv_buf_);
-                                                   dns_srv_response resp{ ec4 };
-                                                   resp.targets.reserve(message.answers.size());
-                                                   for (const auto& answer : message.answers) {
-                                                       resp.targets.emplace_back(dns_srv_response::address{
-                                                         fmt::format("{}", fmt::join(answer.target.labels, ".")), answer.port });
-                                                   }
-                                                   return handler(std::move(resp));
+                                                   return handler(dns_srv_response::from_message(message));
                                                });
                                          });
                     });
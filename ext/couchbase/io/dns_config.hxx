@@ -50,6 +50,17 @@ class dns_config
         return timeout_;
     }
 
+    /**
+     * Overrides the nameserver from resolv.conf (e.g. to point the client to an in-process DNS server in tests).
+     */
+    void set_nameserver(const asio::ip::address& address, std::uint16_t port)
+    {
+        initialize();
+        host_ = address.to_string();
+        address_ = address;
+        port_ = port;
+    }
+
     static dns_config& get()
     {
         static dns_config instance{};
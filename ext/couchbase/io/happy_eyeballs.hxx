@@ -0,0 +1,184 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <asio.hpp>
+#include <spdlog/spdlog.h>
+
+namespace couchbase::io
+{
+/**
+ * Races TCP connections to the resolved endpoints of a single host as described by RFC 8305 ("Happy Eyeballs Version 2").
+ *
+ * Endpoints are interleaved by address family starting with IPv6. A new attempt starts every attempt_delay, or immediately when the
+ * previous attempt fails, while the earlier attempts are still in flight. The first socket to connect wins, and the rest are closed.
+ *
+ * All handlers run on the given strand, so the connector does not need its own locking.
+ */
+class happy_eyeballs_connector : public std::enable_shared_from_this<happy_eyeballs_connector>
+{
+  public:
+    using handler_type = std::function<void(std::error_code, asio::ip::tcp::socket&&, const asio::ip::tcp::endpoint&)>;
+
+    happy_eyeballs_connector(asio::strand<asio::io_context::executor_type> strand,
+                             const asio::ip::tcp::resolver::results_type& endpoints,
+                             std::chrono::milliseconds attempt_delay,
+                             std::chrono::milliseconds connect_timeout,
+                             bool ipv4_only = false)
+      : strand_(std::move(strand))
+      , attempt_delay_(attempt_delay)
+      , connect_timeout_(connect_timeout)
+      , attempt_timer_(strand_)
+      , deadline_(strand_)
+    {
+        std::vector<asio::ip::tcp::endpoint> v6;
+        std::vector<asio::ip::tcp::endpoint> v4;
+        for (const auto& entry : endpoints) {
+            if (entry.endpoint().protocol() == asio::ip::tcp::v6()) {
+                if (!ipv4_only) {
+                    v6.emplace_back(entry.endpoint());
+                }
+            } else {
+                v4.emplace_back(entry.endpoint());
+            }
+        }
+        endpoints_.reserve(v6.size() + v4.size());
+        for (std::size_t i = 0; i < v6.size() || i < v4.size(); ++i) {
+            if (i < v6.size()) {
+                endpoints_.emplace_back(v6[i]);
+            }
+            if (i < v4.size()) {
+                endpoints_.emplace_back(v4[i]);
+            }
+        }
+    }
+
+    void start(handler_type&& handler)
+    {
+        handler_ = std::move(handler);
+        asio::post(strand_, [self = shared_from_this()]() {
+            if (self->endpoints_.empty()) {
+                return self->finish(asio::error::host_not_found, {});
+            }
+            self->deadline_.expires_after(self->connect_timeout_);
+            self->deadline_.async_wait([self](std::error_code ec) {
+                if (ec == asio::error::operation_aborted) {
+                    return;
+                }
+                self->finish(asio::error::timed_out, {});
+            });
+            self->start_next_attempt();
+        });
+    }
+
+    void cancel()
+    {
+        asio::post(strand_, [self = shared_from_this()]() { self->finish(asio::error::operation_aborted, {}); });
+    }
+
+  private:
+    struct attempt {
+        asio::ip::tcp::socket socket;
+        asio::ip::tcp::endpoint endpoint;
+    };
+
+    void start_next_attempt()
+    {
+        if (finished_ || next_endpoint_ >= endpoints_.size()) {
+            return;
+        }
+        auto index = attempts_.size();
+        const auto& endpoint = endpoints_[next_endpoint_++];
+        attempts_.emplace_back(std::make_unique<attempt>(attempt{ asio::ip::tcp::socket(strand_), endpoint }));
+        ++in_flight_;
+        spdlog::trace("happy eyeballs: connecting to {}:{}, attempt={}", endpoint.address().to_string(), endpoint.port(), index);
+        attempts_[index]->socket.async_connect(
+          endpoint, [self = shared_from_this(), index](std::error_code ec) { self->on_attempt_completed(index, ec); });
+
+        attempt_timer_.expires_after(attempt_delay_);
+        attempt_timer_.async_wait([self = shared_from_this()](std::error_code ec) {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            self->start_next_attempt();
+        });
+    }
+
+    void on_attempt_completed(std::size_t index, std::error_code ec)
+    {
+        --in_flight_;
+        if (finished_) {
+            return;
+        }
+        auto& current = attempts_[index];
+        if (!ec) {
+            auto socket = std::move(current->socket);
+            return finish({}, std::move(socket), current->endpoint);
+        }
+        spdlog::debug("happy eyeballs: unable to connect to {}:{}: {} ({})",
+                      current->endpoint.address().to_string(),
+                      current->endpoint.port(),
+                      ec.value(),
+                      ec.message());
+        last_error_ = ec;
+        if (next_endpoint_ < endpoints_.size()) {
+            attempt_timer_.cancel();
+            return start_next_attempt();
+        }
+        if (in_flight_ == 0) {
+            finish(last_error_, {});
+        }
+    }
+
+    void finish(std::error_code ec, std::optional<asio::ip::tcp::socket> socket, const asio::ip::tcp::endpoint& endpoint = {})
+    {
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        attempt_timer_.cancel();
+        deadline_.cancel();
+        for (auto& pending : attempts_) {
+            std::error_code ignored{};
+            pending->socket.close(ignored);
+        }
+        if (auto handler = std::move(handler_); handler) {
+            handler(ec, socket ? std::move(*socket) : asio::ip::tcp::socket(strand_), endpoint);
+        }
+    }
+
+    asio::strand<asio::io_context::executor_type> strand_;
+    std::chrono::milliseconds attempt_delay_;
+    std::chrono::milliseconds connect_timeout_;
+    asio::steady_timer attempt_timer_;
+    asio::steady_timer deadline_;
+    std::vector<asio::ip::tcp::endpoint> endpoints_{};
+    std::vector<std::unique_ptr<attempt>> attempts_{};
+    std::size_t next_endpoint_{ 0 };
+    std::size_t in_flight_{ 0 };
+    std::error_code last_error_{};
+    handler_type handler_{};
+    bool finished_{ false };
+};
+} // namespace couchbase::io
@@ -19,6 +19,11 @@
 
 #include <io/http_session.hxx>
 
+#include <metrics/registry.hxx>
+#include <metrics/threshold_reporter.hxx>
+
+#include <tracing/request_tracer.hxx>
+
 namespace couchbase::operations
 {
 
@@ -31,6 +36,7 @@ struct http_command : public std::enable_shared_from_this<http_command<Request>>
     asio::steady_timer retry_backoff;
     Request request;
     encoded_request_type encoded;
+    std::shared_ptr<tracing::request_span> span_{};
 
     http_command(asio::io_context& ctx, Request req)
       : deadline(ctx)
@@ -42,6 +48,12 @@ struct http_command : public std::enable_shared_from_this<http_command<Request>>
     template<typename Handler>
     void send_to(std::shared_ptr<io::http_session> session, Handler&& handler)
     {
+        if (auto& tracer = session->telemetry().tracer; !span_ && tracer.enabled()) {
+            span_ = tracer.start_span(fmt::format("{}", request.type), request.client_context_id);
+        }
+        if (span_) {
+            span_->mark(tracing::span_phase::encode_start);
+        }
         encoded.type = request.type;
         if (auto ec = request.encode_to(encoded, session->http_context()); ec) {
             error_context_type ctx{};
@@ -49,6 +61,11 @@ struct http_command : public std::enable_shared_from_this<http_command<Request>>
             ctx.client_context_id = request.client_context_id;
             return handler(make_response(std::move(ctx), request, {}));
         }
+        if (span_) {
+            span_->mark(tracing::span_phase::encode_end);
+            span_->set_remote(fmt::format("{}:{}", session->hostname(), session->port()));
+            span_->mark(tracing::span_phase::dispatched);
+        }
         encoded.headers["client-context-id"] = request.client_context_id;
         auto log_prefix = session->log_prefix();
         spdlog::trace(R"({} HTTP request: {}, method={}, path="{}", client_context_id="{}", timeout={}ms)",
@@ -66,10 +83,44 @@ struct http_command : public std::enable_shared_from_this<http_command<Request>>
                      request.client_context_id,
                      request.timeout.count(),
                      spdlog::to_hex(encoded.body));
+        auto* metrics = session->metrics();
+        if (metrics != nullptr) {
+            metrics->bytes_out += encoded.body.size();
+        }
         session->write_and_subscribe(encoded,
-                                     [self = this->shared_from_this(), log_prefix, session, handler = std::forward<Handler>(handler)](
-                                       std::error_code ec, io::http_response&& msg) mutable {
+                                     [self = this->shared_from_this(),
+                                      log_prefix,
+                                      session,
+                                      metrics,
+                                      threshold_reporter = &session->telemetry().threshold_reporter,
+                                      start = std::chrono::steady_clock::now(),
+                                      handler = std::forward<Handler>(handler)](std::error_code ec, io::http_response&& msg) mutable {
                                          self->deadline.cancel();
+                                         auto now = std::chrono::steady_clock::now();
+                                         auto latency = now - start;
+                                         if (self->span_) {
+                                             self->span_->mark(tracing::span_phase::received, now);
+                                         }
+                                         if (metrics != nullptr) {
+                                             ++metrics->operations;
+                                             if (ec == error::common_errc::ambiguous_timeout) {
+                                                 ++metrics->timeouts;
+                                             } else {
+                                                 metrics->latency.record(latency);
+                                                 metrics->bytes_in += msg.body.size();
+                                             }
+                                         }
+                                         if (!ec && threshold_reporter->over_threshold(Request::type, latency)) {
+                                             metrics::report_entry entry{};
+                                             entry.operation_name = fmt::format("{} {}", self->encoded.method, self->encoded.path);
+                                             entry.total_duration_us = static_cast<std::uint64_t>(
+                                               std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+                                             entry.last_remote_socket = session->remote_address();
+                                             entry.last_local_socket = session->local_address();
+                                             entry.last_local_id = session->id();
+                                             entry.operation_id = self->request.client_context_id;
+                                             threshold_reporter->report(Request::type, std::move(entry));
+                                         }
                                          encoded_response_type resp(msg);
                                          spdlog::trace(R"({} HTTP response: {}, client_context_id="{}", status={})",
                                                        log_prefix,
@@ -92,8 +143,19 @@ struct http_command : public std::enable_shared_from_this<http_command<Request>>
                                              ctx.last_dispatched_to = session->remote_address();
                                              ctx.http_status = msg.status_code;
                                              ctx.http_body = msg.body;
-                                             handler(make_response(std::move(ctx), self->request, std::move(msg)));
+                                             auto response = make_response(std::move(ctx), self->request, std::move(msg));
+                                             if (self->span_) {
+                                                 self->span_->mark(tracing::span_phase::decoded);
+                                                 session->telemetry().tracer.end_span(std::move(self->span_));
+                                             }
+                                             handler(std::move(response));
                                          } catch (const priv::retry_http_request&) {
+                                             if (metrics != nullptr) {
+                                                 ++metrics->retries;
+                                             }
+                                             if (self->span_) {
+                                                 self->span_->mark(tracing::span_phase::retry_scheduled);
+                                             }
                                              self->send_to(session, std::forward<Handler>(handler));
                                          }
                                      });
@@ -19,6 +19,7 @@
 
 #include <configuration.hxx>
 #include <io/query_cache.hxx>
+#include <telemetry.hxx>
 
 namespace couchbase
 {
@@ -26,6 +27,7 @@ struct http_context {
     const configuration& config;
     const cluster_options& options;
     query_cache& cache;
+    couchbase::telemetry& telemetry;
 };
 
 namespace priv
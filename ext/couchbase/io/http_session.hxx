@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <array>
+#include <charconv>
 #include <memory>
 #include <utility>
 
@@ -30,6 +32,7 @@
 #include <errors.hxx>
 #include <version.hxx>
 
+#include <io/dns_cache.hxx>
 #include <io/http_context.hxx>
 #include <io/http_message.hxx>
 #include <io/http_parser.hxx>
@@ -61,8 +64,10 @@ class http_session : public std::enable_shared_from_this<http_session>
       , hostname_(hostname)
       , service_(service)
       , user_agent_(fmt::format("{}; client/{}; session/{}; {}", couchbase::sdk_id(), client_id_, id_, BACKEND_SYSTEM))
+      , static_headers_(encode_static_headers())
       , log_prefix_(fmt::format("[{}/{}]", client_id_, id_))
       , http_ctx_(std::move(http_ctx))
+      , metrics_(http_ctx_.telemetry.registry.http(type_, fmt::format("{}:{}", hostname_, service_)))
     {
     }
 
@@ -86,8 +91,10 @@ class http_session : public std::enable_shared_from_this<http_session>
       , hostname_(hostname)
       , service_(service)
       , user_agent_(fmt::format("{}; client/{}; session/{}; {}", couchbase::sdk_id(), client_id_, id_, BACKEND_SYSTEM))
+      , static_headers_(encode_static_headers())
       , log_prefix_(fmt::format("[{}/{}]", client_id_, id_))
       , http_ctx_(std::move(http_ctx))
+      , metrics_(http_ctx_.telemetry.registry.http(type_, fmt::format("{}:{}", hostname_, service_)))
     {
     }
 
@@ -126,14 +133,21 @@ class http_session : public std::enable_shared_from_this<http_session>
                                                                   std::chrono::steady_clock::now() - last_active_)),
                  remote_address(),
                  local_address(),
-                 state_ };
+                 state_,
+                 std::nullopt,
+                 stream_->handshake_info() };
     }
 
     void start()
     {
         state_ = diag::endpoint_state::connecting;
-        resolver_.async_resolve(
-          hostname_, service_, std::bind(&http_session::on_resolve, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+        dns::dns_cache::instance().async_resolve(
+          resolver_,
+          hostname_,
+          service_,
+          http_ctx_.options.dns_cache_ttl,
+          http_ctx_.options.dns_negative_cache_ttl,
+          std::bind(&http_session::on_resolve, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
     }
 
     [[nodiscard]] const std::string& log_prefix() const
@@ -146,6 +160,29 @@ class http_session : public std::enable_shared_from_this<http_session>
         return id_;
     }
 
+    [[nodiscard]] const std::string& hostname() const
+    {
+        return hostname_;
+    }
+
+    [[nodiscard]] const std::string& port() const
+    {
+        return service_;
+    }
+
+    [[nodiscard]] couchbase::telemetry& telemetry() const
+    {
+        return http_ctx_.telemetry;
+    }
+
+    /**
+     * @return metrics of the service for the node of this session (nullptr if metrics are disabled)
+     */
+    [[nodiscard]] metrics::http_metrics* metrics() const
+    {
+        return metrics_;
+    }
+
     [[nodiscard]] const asio::ip::tcp::endpoint& endpoint() const
     {
         return endpoint_;
@@ -227,21 +264,52 @@ class http_session : public std::enable_shared_from_this<http_session>
         if (stopped_) {
             return;
         }
-        if (request.headers["connection"] == "keep-alive") {
+        if (auto it = request.headers.find("connection"); it != request.headers.end() && it->second == "keep-alive") {
             keep_alive_ = true;
         }
-        request.headers["user-agent"] = user_agent_;
-        request.headers["authorization"] =
-          fmt::format("Basic {}", base64::encode(fmt::format("{}:{}", credentials_.username, credentials_.password)));
-        write(fmt::format("{} {} HTTP/1.1\r\nhost: {}:{}\r\n", request.method, request.path, hostname_, service_));
+
+        std::array<char, 20> content_length{};
+        std::size_t content_length_size = 0;
         if (!request.body.empty()) {
-            request.headers["content-length"] = std::to_string(request.body.size());
+            content_length_size = static_cast<std::size_t>(
+              std::to_chars(content_length.data(), content_length.data() + content_length.size(), request.body.size()).ptr -
+              content_length.data());
         }
-        for (auto& header : request.headers) {
-            write(fmt::format("{}: {}\r\n", header.first, header.second));
+
+        std::size_t size = request.method.size() + 1 + request.path.size() + 11 + static_headers_.size() + 2 + request.body.size();
+        for (const auto& [name, value] : request.headers) {
+            if (!is_static_header(name)) {
+                size += name.size() + 2 + value.size() + 2;
+            }
         }
-        write("\r\n");
-        write(request.body);
+        if (content_length_size > 0) {
+            size += 16 + content_length_size + 2;
+        }
+
+        std::vector<std::uint8_t> buf;
+        buf.reserve(size);
+        auto append = [&buf](std::string_view data) { buf.insert(buf.end(), data.begin(), data.end()); };
+        append(request.method);
+        append(" ");
+        append(request.path);
+        append(" HTTP/1.1\r\n");
+        append(static_headers_);
+        for (const auto& [name, value] : request.headers) {
+            if (!is_static_header(name)) {
+                append(name);
+                append(": ");
+                append(value);
+                append("\r\n");
+            }
+        }
+        if (content_length_size > 0) {
+            append("content-length: ");
+            append({ content_length.data(), content_length_size });
+            append("\r\n");
+        }
+        append("\r\n");
+        append(request.body);
+        output_buffer_.emplace_back(std::move(buf));
         {
             std::scoped_lock lock(command_handlers_mutex_);
             command_handlers_.push_back(std::move(handler));
@@ -266,8 +334,29 @@ class http_session : public std::enable_shared_from_this<http_session>
     }
 
   private:
+    /**
+     * Serializes headers, that do not change during the lifetime of the session, so that requests do not have to format them and
+     * encode credentials every time.
+     */
+    [[nodiscard]] std::string encode_static_headers() const
+    {
+        return fmt::format("host: {}:{}\r\nuser-agent: {}\r\nauthorization: Basic {}\r\n",
+                           hostname_,
+                           service_,
+                           user_agent_,
+                           base64::encode(fmt::format("{}:{}", credentials_.username, credentials_.password)));
+    }
+
+    [[nodiscard]] static bool is_static_header(const std::string& name)
+    {
+        return name == "host" || name == "user-agent" || name == "authorization";
+    }
+
     void on_resolve(std::error_code ec, const asio::ip::tcp::resolver::results_type& endpoints)
     {
+        if (stopped_) {
+            return;
+        }
         if (ec) {
             spdlog::error("{} error on resolve: {}", log_prefix_, ec.message());
             return;
@@ -416,6 +505,7 @@ class http_session : public std::enable_shared_from_this<http_session>
     std::string hostname_;
     std::string service_;
     std::string user_agent_;
+    std::string static_headers_;
 
     bool stopped_{ false };
     bool connected_{ false };
@@ -438,6 +528,7 @@ class http_session : public std::enable_shared_from_this<http_session>
 
     std::string log_prefix_{};
     couchbase::http_context http_ctx_;
+    metrics::http_metrics* metrics_;
 
     std::chrono::time_point<std::chrono::steady_clock> last_active_{};
     diag::endpoint_state state_{ diag::endpoint_state::disconnected };
@@ -31,10 +31,14 @@ namespace couchbase::io
 class http_session_manager : public std::enable_shared_from_this<http_session_manager>
 {
   public:
-    http_session_manager(const std::string& client_id, asio::io_context& ctx, asio::ssl::context& tls)
+    http_session_manager(const std::string& client_id,
+                         asio::io_context& ctx,
+                         asio::ssl::context& tls,
+                         std::shared_ptr<couchbase::telemetry> telemetry)
       : client_id_(client_id)
       , ctx_(ctx)
       , tls_(tls)
+      , telemetry_(std::move(telemetry))
     {
     }
 
@@ -85,6 +89,7 @@ class http_session_manager : public std::enable_shared_from_this<http_session_ma
                 if (port != 0) {
                     std::scoped_lock lock(sessions_mutex_);
                     std::shared_ptr<http_session> session;
+                    http_context http_ctx{ config_, options_, query_cache_, *telemetry_ };
                     session = options_.enable_tls ? std::make_shared<http_session>(type,
                                                                                    client_id_,
                                                                                    ctx_,
@@ -92,14 +97,14 @@ class http_session_manager : public std::enable_shared_from_this<http_session_ma
                                                                                    credentials,
                                                                                    node.hostname_for(options_.network),
                                                                                    std::to_string(port),
-                                                                                   http_context{ config_, options_, query_cache_ })
+                                                                                   http_ctx)
                                                   : std::make_shared<http_session>(type,
                                                                                    client_id_,
                                                                                    ctx_,
                                                                                    credentials,
                                                                                    node.hostname_for(options_.network),
                                                                                    std::to_string(port),
-                                                                                   http_context{ config_, options_, query_cache_ });
+                                                                                   http_ctx);
                     session->start();
                     session->on_stop([type, id = session->id(), self = this->shared_from_this()]() {
                         for (auto& s : self->busy_sessions_[type]) {
@@ -159,6 +164,7 @@ class http_session_manager : public std::enable_shared_from_this<http_session_ma
             }
             config_.nodes.size();
             std::shared_ptr<http_session> session;
+            http_context http_ctx{ config_, options_, query_cache_, *telemetry_ };
             if (options_.enable_tls) {
                 session = std::make_shared<http_session>(type,
                                                          client_id_,
@@ -167,10 +173,9 @@ class http_session_manager : public std::enable_shared_from_this<http_session_ma
                                                          credentials,
                                                          hostname,
                                                          std::to_string(port),
-                                                         http_context{ config_, options_, query_cache_ });
+                                                         http_ctx);
             } else {
-                session = std::make_shared<http_session>(
-                  type, client_id_, ctx_, credentials, hostname, std::to_string(port), http_context{ config_, options_, query_cache_ });
+                session = std::make_shared<http_session>(type, client_id_, ctx_, credentials, hostname, std::to_string(port), http_ctx);
             }
             session->start();
 
@@ -246,6 +251,7 @@ class http_session_manager : public std::enable_shared_from_this<http_session_ma
     std::string client_id_;
     asio::io_context& ctx_;
     asio::ssl::context& tls_;
+    std::shared_ptr<couchbase::telemetry> telemetry_;
     cluster_options options_;
 
     configuration config_{};
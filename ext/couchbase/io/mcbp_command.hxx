@@ -23,6 +23,7 @@
 #include <io/retry_orchestrator.hxx>
 
 #include <protocol/cmd_get_collection_id.hxx>
+#include <tracing/request_tracer.hxx>
 #include <functional>
 #include <utility>
 
@@ -44,6 +45,7 @@ struct mcbp_command : public std::enable_shared_from_this<mcbp_command<Manager,
     mcbp_command_handler handler_{};
     std::shared_ptr<Manager> manager_{};
     std::string id_;
+    std::shared_ptr<tracing::request_span> span_{};
 
     mcbp_command(asio::io_context& ctx, std::shared_ptr<Manager> manager, Request req)
       : deadline(ctx)
@@ -81,6 +83,11 @@ struct mcbp_command : public std::enable_shared_from_this<mcbp_command<Manager,
     void invoke_handler(std::error_code ec, std::optional<io::mcbp_message> msg = {})
     {
         if (handler_) {
+            if (request.retries.retry_attempts > 0 && session_) {
+                if (auto* metrics = session_->kv_metrics(encoded_request_type::body_type::opcode); metrics != nullptr) {
+                    metrics->retries += static_cast<std::uint64_t>(request.retries.retry_attempts);
+                }
+            }
             handler_(ec, std::move(msg));
         }
         handler_ = nullptr;
@@ -167,9 +174,17 @@ struct mcbp_command : public std::enable_shared_from_this<mcbp_command<Manager,
             }
         }
 
+        if (span_) {
+            span_->mark(tracing::span_phase::encode_start);
+        }
         if (auto ec = request.encode_to(encoded, session_->context()); ec) {
             return invoke_handler(ec);
         }
+        if (span_) {
+            span_->mark(tracing::span_phase::encode_end);
+            span_->set_remote(session_->bootstrap_address());
+            span_->mark(tracing::span_phase::dispatched);
+        }
 
         session_->write_and_subscribe(
           request.opaque,
@@ -180,6 +195,10 @@ struct mcbp_command : public std::enable_shared_from_this<mcbp_command<Manager,
                   return self->invoke_handler(make_error_code(self->request.retries.idempotent ? error::common_errc::unambiguous_timeout
                                                                                                : error::common_errc::ambiguous_timeout));
               }
+              if (ec == error::common_errc::job_queue_full) {
+                  self->deadline.cancel();
+                  return self->invoke_handler(ec);
+              }
               if (ec == error::common_errc::request_canceled) {
                   if (reason == io::retry_reason::do_not_retry) {
                       return self->invoke_handler(ec);
@@ -232,7 +251,8 @@ struct mcbp_command : public std::enable_shared_from_this<mcbp_command<Manager,
               } else {
                   io::retry_orchestrator::maybe_retry(self->manager_, self, reason, ec);
               }
-          });
+          },
+          span_);
     }
 
     void send_to(std::shared_ptr<io::mcbp_session> session)
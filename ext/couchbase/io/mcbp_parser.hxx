@@ -17,9 +17,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
 #include <snappy.h>
 
 #include <gsl/gsl_assert>
+#include <io/mcbp_message.hxx>
 #include <protocol/magic.hxx>
 #include <protocol/datatype.hxx>
 
@@ -27,32 +33,153 @@
 
 namespace couchbase::io
 {
+/**
+ * Incremental parser of the KV stream.
+ *
+ * The socket reads land directly in the parser storage: prepare() returns the space for the next read, and commit() accounts the
+ * bytes received into it. Frames with bodies larger than default_read_size are received straight into their own body storage, so
+ * a large document takes one read per socket buffer instead of one per default_read_size, and its bytes are never copied between
+ * buffers. Once everything is parsed, the regular storage is trimmed back to default_read_size.
+ */
 struct mcbp_parser {
     enum class result { ok, need_data, failure };
 
+    /**
+     * Size of the regular read buffer, also the largest body that is assembled in it.
+     */
+    static constexpr std::size_t default_read_size = 16 * 1024;
+
+    /**
+     * The regular buffer is compacted (and grown if necessary) once the free space at its end drops below this value.
+     */
+    static constexpr std::size_t min_read_size = 4 * 1024;
+
     template<typename Iterator>
     void feed(Iterator begin, Iterator end)
     {
-        buf.reserve(buf.size() + static_cast<size_t>(std::distance(begin, end)));
-        std::copy(begin, end, std::back_inserter(buf));
+        auto remaining = static_cast<std::size_t>(std::distance(begin, end));
+        while (remaining > 0) {
+            auto [data, size] = prepare();
+            std::size_t chunk = std::min(size, remaining);
+            std::copy_n(begin, chunk, data);
+            std::advance(begin, chunk);
+            commit(chunk);
+            remaining -= chunk;
+        }
+    }
+
+    /**
+     * @return writable space for the next socket read
+     */
+    [[nodiscard]] std::pair<std::uint8_t*, std::size_t> prepare()
+    {
+        if (!pending_body_.empty()) {
+            return { pending_body_.data() + pending_size_, pending_body_.size() - pending_size_ };
+        }
+        if (buf_.size() - end_ < min_read_size) {
+            if (begin_ > 0) {
+                std::memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+                end_ -= begin_;
+                begin_ = 0;
+            }
+            if (buf_.size() - end_ < min_read_size) {
+                buf_.resize(std::max(default_read_size, end_ + min_read_size));
+            }
+        }
+        return { buf_.data() + end_, buf_.size() - end_ };
+    }
+
+    /**
+     * Accounts bytes written into the space returned by the last prepare().
+     */
+    void commit(std::size_t bytes_transferred)
+    {
+        if (!pending_body_.empty()) {
+            pending_size_ += bytes_transferred;
+        } else {
+            end_ += bytes_transferred;
+        }
     }
 
     void reset()
     {
-        buf.clear();
+        begin_ = 0;
+        end_ = 0;
+        pending_size_ = 0;
+        pending_body_ = {};
+        if (buf_.size() > default_read_size) {
+            buf_ = {};
+        }
+    }
+
+    /**
+     * @return number of bytes received, but not parsed yet
+     */
+    [[nodiscard]] std::size_t buffered() const
+    {
+        return end_ - begin_ + pending_size_;
+    }
+
+    /**
+     * @return number of bytes allocated for the regular read buffer
+     */
+    [[nodiscard]] std::size_t capacity() const
+    {
+        return buf_.size();
     }
 
     result next(mcbp_message& msg)
     {
-        static const size_t header_size = 24;
-        if (buf.size() < header_size) {
+        if (!pending_body_.empty()) {
+            if (pending_size_ < pending_body_.size()) {
+                return result::need_data;
+            }
+            msg.header = pending_header_;
+            std::uint32_t body_size = ntohl(msg.header.bodylen);
+            if (is_compressed(msg.header)) {
+                decode_body(msg, pending_body_.data(), body_size);
+            } else {
+                msg.body = std::move(pending_body_);
+            }
+            pending_body_ = {};
+            pending_size_ = 0;
+            return check_next_frame(msg, body_size);
+        }
+
+        std::size_t available = end_ - begin_;
+        if (available < protocol::header_size) {
             return result::need_data;
         }
-        std::memcpy(&msg.header, buf.data(), header_size);
-        uint32_t body_size = ntohl(msg.header.bodylen);
-        if (body_size > 0 && buf.size() - header_size < body_size) {
+        std::memcpy(&msg.header, buf_.data() + begin_, protocol::header_size);
+        std::uint32_t body_size = ntohl(msg.header.bodylen);
+        if (available - protocol::header_size < body_size) {
+            if (body_size > default_read_size) {
+                // the rest of the buffer belongs to this frame, move it to the body storage and receive the remainder there
+                pending_header_ = msg.header;
+                pending_body_.resize(body_size);
+                pending_size_ = available - protocol::header_size;
+                std::memcpy(pending_body_.data(), buf_.data() + begin_ + protocol::header_size, pending_size_);
+                begin_ = end_;
+                trim();
+            }
             return result::need_data;
         }
+        decode_body(msg, buf_.data() + begin_ + protocol::header_size, body_size);
+        begin_ += protocol::header_size + body_size;
+        if (begin_ == end_) {
+            trim();
+        }
+        return check_next_frame(msg, body_size);
+    }
+
+  private:
+    [[nodiscard]] static bool is_compressed(const binary_header& header)
+    {
+        return (header.datatype & static_cast<uint8_t>(protocol::datatype::snappy)) != 0;
+    }
+
+    static void decode_body(mcbp_message& msg, const std::uint8_t* body, std::uint32_t body_size)
+    {
         msg.body.clear();
         msg.body.reserve(body_size);
         uint32_t key_size = ntohs(msg.header.keylen);
@@ -62,14 +189,12 @@ struct mcbp_parser {
             key_size = (msg.header.keylen & 0xf0U) >> 8U;
             prefix_size = uint32_t(framing_extras_size) + uint32_t(msg.header.extlen) + key_size;
         }
-        std::copy(buf.begin() + header_size, buf.begin() + header_size + prefix_size, std::back_inserter(msg.body));
+        msg.body.insert(msg.body.end(), body, body + prefix_size);
 
-        bool is_compressed = (msg.header.datatype & static_cast<uint8_t>(protocol::datatype::snappy)) != 0;
         bool use_raw_value = true;
-        if (is_compressed) {
+        if (is_compressed(msg.header)) {
             std::string uncompressed;
-            size_t offset = header_size + prefix_size;
-            bool success = snappy::Uncompress(reinterpret_cast<const char*>(buf.data() + offset), body_size - prefix_size, &uncompressed);
+            bool success = snappy::Uncompress(reinterpret_cast<const char*>(body + prefix_size), body_size - prefix_size, &uncompressed);
             if (success) {
                 std::copy(uncompressed.begin(), uncompressed.end(), std::back_inserter(msg.body));
                 use_raw_value = false;
@@ -78,24 +203,46 @@ struct mcbp_parser {
             }
         }
         if (use_raw_value) {
-            std::copy(buf.begin() + header_size + prefix_size, buf.begin() + header_size + body_size, std::back_inserter(msg.body));
+            msg.body.insert(msg.body.end(), body + prefix_size, body + body_size);
         }
-        buf.erase(buf.begin(), buf.begin() + header_size + body_size);
-        if (!protocol::is_valid_magic(buf[0])) {
+    }
+
+    result check_next_frame(const mcbp_message& msg, std::uint32_t body_size)
+    {
+        if (begin_ < end_ && !protocol::is_valid_magic(buf_[begin_])) {
             spdlog::warn("parsed frame for magic={:x}, opcode={:x}, opaque={}, body_len={}. Invalid magic of the next frame: {:x}, {} "
                          "bytes to parse{}",
                          msg.header.magic,
                          msg.header.opcode,
                          msg.header.opaque,
                          body_size,
-                         buf[0],
-                         buf.size(),
-                         spdlog::to_hex(buf));
+                         buf_[begin_],
+                         end_ - begin_,
+                         spdlog::to_hex(buf_.begin() + static_cast<std::ptrdiff_t>(begin_),
+                                        buf_.begin() + static_cast<std::ptrdiff_t>(end_)));
             reset();
         }
         return result::ok;
     }
 
-    std::vector<std::uint8_t> buf;
+    /**
+     * Rewinds the regular buffer once it has been parsed completely, and releases the space grown above default_read_size.
+     */
+    void trim()
+    {
+        begin_ = 0;
+        end_ = 0;
+        if (buf_.size() > default_read_size) {
+            buf_.resize(default_read_size);
+            buf_.shrink_to_fit();
+        }
+    }
+
+    std::vector<std::uint8_t> buf_{};
+    std::size_t begin_{ 0 };
+    std::size_t end_{ 0 };
+    binary_header pending_header_{};
+    std::vector<std::uint8_t> pending_body_{};
+    std::size_t pending_size_{ 0 };
 };
 } // namespace couchbase::io
@@ -28,8 +28,17 @@
 #include <io/mcbp_message.hxx>
 #include <io/mcbp_parser.hxx>
 #include <io/streams.hxx>
+#include <io/happy_eyeballs.hxx>
+#include <io/dns_cache.hxx>
 #include <io/retry_orchestrator.hxx>
 #include <io/mcbp_context.hxx>
+#include <io/adaptive_limiter.hxx>
+
+#include <metrics/registry.hxx>
+#include <metrics/threshold_reporter.hxx>
+#include <metrics/orphan_reporter.hxx>
+
+#include <tracing/request_tracer.hxx>
 
 #include <timeout_defaults.hxx>
 
@@ -56,6 +65,7 @@
 #include <errors.hxx>
 #include <version.hxx>
 #include <diagnostics.hxx>
+#include <logger.hxx>
 
 namespace couchbase::io
 {
@@ -106,8 +116,18 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
     {
       private:
         std::shared_ptr<mcbp_session> session_;
-        sasl::ClientContext sasl_;
+        std::shared_ptr<sasl::ClientContext> sasl_;
         std::atomic_bool stopped_{ false };
+        bool pipelined_{ false };
+
+        /**
+         * Runs SCRAM key derivation, that might take milliseconds on salted password cache miss, away from the IO threads.
+         */
+        static asio::thread_pool& sasl_worker()
+        {
+            static asio::thread_pool pool(1);
+            return pool;
+        }
 
       public:
         ~bootstrap_handler() override = default;
@@ -123,9 +143,9 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
 
         explicit bootstrap_handler(std::shared_ptr<mcbp_session> session)
           : session_(session)
-          , sasl_([origin = session_->origin_]() { return origin.username(); },
-                  [origin = session_->origin_]() { return origin.password(); },
-                  session_->origin_.credentials().allowed_sasl_mechanisms)
+          , sasl_(std::make_shared<sasl::ClientContext>([origin = session_->origin_]() { return origin.username(); },
+                                                        [origin = session_->origin_]() { return origin.password(); },
+                                                        session_->origin_.credentials().allowed_sasl_mechanisms))
         {
             tao::json::value user_agent{
                 { "a", couchbase::sdk_id() },
@@ -155,13 +175,23 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                 session_->write(list_req.data());
 
                 protocol::client_request<protocol::sasl_auth_request_body> auth_req;
-                auto [sasl_code, sasl_payload] = sasl_.start();
+                auto [sasl_code, sasl_payload] = sasl_->start();
                 auth_req.opaque(session_->next_opaque());
-                auth_req.body().mechanism(sasl_.get_name());
+                auth_req.body().mechanism(sasl_->get_name());
                 auth_req.body().sasl_data(sasl_payload);
                 session_->write(auth_req.data());
             }
 
+            /*
+             * Certificate and PLAIN authentication need no extra round trips, so the rest of the handshake is sent optimistically in the
+             * same flight. The server executes the commands in order, and the responses are validated in order.
+             */
+            pipelined_ = session->origin_.options().enable_pipelined_bootstrap &&
+                         (session->origin_.credentials().uses_certificate() || sasl_->get_name() == "PLAIN");
+            if (pipelined_) {
+                write_post_auth_requests(true);
+            }
+
             session_->flush();
         }
 
@@ -171,10 +201,39 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             session_->invoke_bootstrap_handler(ec);
         }
 
+        void on_sasl_step(sasl::error sasl_code, const std::string& sasl_payload, std::uint32_t opaque)
+        {
+            if (stopped_ || !session_) {
+                return;
+            }
+            if (sasl_code == sasl::error::OK) {
+                return auth_success();
+            }
+            if (sasl_code == sasl::error::CONTINUE) {
+                protocol::client_request<protocol::sasl_step_request_body> req;
+                req.opaque(session_->next_opaque());
+                req.body().mechanism(sasl_->get_name());
+                req.body().sasl_data(sasl_payload);
+                session_->write_and_flush(req.data());
+            } else {
+                spdlog::error("{} unable to authenticate: (sasl_code={}, opaque={})", session_->log_prefix_, sasl_code, opaque);
+                complete(error::common_errc::authentication_failure);
+            }
+        }
+
         void auth_success()
         {
             session_->authenticated_ = true;
-            if (session_->supports_feature(protocol::hello_feature::xerror)) {
+            if (pipelined_) {
+                return;
+            }
+            write_post_auth_requests(session_->supports_feature(protocol::hello_feature::xerror));
+            session_->flush();
+        }
+
+        void write_post_auth_requests(bool with_error_map)
+        {
+            if (with_error_map) {
                 protocol::client_request<protocol::get_error_map_request_body> errmap_req;
                 errmap_req.opaque(session_->next_opaque());
                 session_->write(errmap_req.data());
@@ -188,7 +247,6 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             protocol::client_request<protocol::get_cluster_config_request_body> cfg_req;
             cfg_req.opaque(session_->next_opaque());
             session_->write(cfg_req.data());
-            session_->flush();
         }
 
         void handle(mcbp_message&& msg) override
@@ -231,21 +289,16 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                         return auth_success();
                     }
                     if (resp.status() == protocol::status::auth_continue) {
-                        auto [sasl_code, sasl_payload] = sasl_.step(resp.body().value());
-                        if (sasl_code == sasl::error::OK) {
-                            return auth_success();
-                        }
-                        if (sasl_code == sasl::error::CONTINUE) {
-                            protocol::client_request<protocol::sasl_step_request_body> req;
-                            req.opaque(session_->next_opaque());
-                            req.body().mechanism(sasl_.get_name());
-                            req.body().sasl_data(sasl_payload);
-                            session_->write_and_flush(req.data());
-                        } else {
-                            spdlog::error(
-                              "{} unable to authenticate: (sasl_code={}, opaque={})", session_->log_prefix_, sasl_code, resp.opaque());
-                            return complete(error::common_errc::authentication_failure);
-                        }
+                        std::string challenge(resp.body().value());
+                        asio::post(sasl_worker(), [session = session_, sasl = sasl_, challenge, opaque = resp.opaque()]() {
+                            auto [sasl_code, sasl_payload] = sasl->step(challenge);
+                            asio::post(session->ctx_, [session, sasl, code = sasl_code, payload = std::string(sasl_payload), opaque]() {
+                                auto* handler = dynamic_cast<bootstrap_handler*>(session->handler_.get());
+                                if (handler != nullptr && handler->sasl_ == sasl) {
+                                    handler->on_sasl_step(code, payload, opaque);
+                                }
+                            });
+                        });
                     } else {
                         spdlog::warn("{} unexpected message status during bootstrap: {} (opaque={})",
                                      session_->log_prefix_,
@@ -265,6 +318,12 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                     protocol::client_response<protocol::get_error_map_response_body> resp(std::move(msg));
                     if (resp.status() == protocol::status::success) {
                         session_->error_map_.emplace(resp.body().errmap());
+                    } else if (pipelined_ && !session_->supports_feature(protocol::hello_feature::xerror)) {
+                        /* the request was sent before HELLO has been answered, and the node turned out to not support error maps */
+                        spdlog::debug("{} node does not support error map: {} (opaque={})",
+                                      session_->log_prefix_,
+                                      resp.error_message(),
+                                      resp.opaque());
                     } else {
                         spdlog::warn("{} unexpected message status during bootstrap: {} (opaque={}, {:n})",
                                      session_->log_prefix_,
@@ -408,13 +467,18 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                         case protocol::client_opcode::increment:
                         case protocol::client_opcode::decrement:
                         case protocol::client_opcode::subdoc_multi_lookup:
-                        case protocol::client_opcode::subdoc_multi_mutation: {
+                        case protocol::client_opcode::subdoc_multi_mutation:
+                        case protocol::client_opcode::dcp_open:
+                        case protocol::client_opcode::dcp_control:
+                        case protocol::client_opcode::dcp_stream_request:
+                        case protocol::client_opcode::dcp_close_stream: {
                             std::uint32_t opaque = msg.header.opaque;
                             std::uint16_t status = ntohs(msg.header.specific);
                             session_->command_handlers_mutex_.lock();
                             auto handler = session_->command_handlers_.find(opaque);
                             if (handler != session_->command_handlers_.end() && handler->second) {
-                                auto ec = session_->map_status_code(opcode, status);
+                                /* DCP consumer inspects the status itself, because rollback and NOT_MY_VBUCKET are part of the protocol */
+                                auto ec = is_dcp_opcode(opcode) ? std::error_code{} : session_->map_status_code(opcode, status);
                                 spdlog::trace("{} MCBP invoke operation handler: opcode={}, opaque={}, status={}, ec={}",
                                               session_->log_prefix_,
                                               opcode,
@@ -432,6 +496,18 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                                               opcode,
                                               msg.header.opaque,
                                               protocol::status_to_string(status));
+                                if (auto& reporter = session_->origin_.telemetry().orphan_reporter; reporter.enabled()) {
+                                    metrics::report_entry entry{};
+                                    entry.operation_name = fmt::format("{}", opcode);
+                                    entry.server_duration_us = extract_server_duration(msg);
+                                    /* the client does not know when the request has been sent, so the entries sorted by server duration */
+                                    entry.total_duration_us = entry.server_duration_us.value_or(0);
+                                    entry.last_remote_socket = session_->remote_address();
+                                    entry.last_local_socket = session_->local_address();
+                                    entry.last_local_id = session_->id_;
+                                    entry.operation_id = fmt::format("0x{:x}", msg.header.opaque);
+                                    reporter.report(std::move(entry));
+                                }
                             }
                         } break;
                         default:
@@ -468,6 +544,11 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                     break;
                 case protocol::magic::client_request:
                 case protocol::magic::alt_client_request:
+                    if (session_->dcp_message_handler_) {
+                        session_->dcp_message_handler_(std::move(msg));
+                        break;
+                    }
+                    [[fallthrough]];
                 case protocol::magic::server_response:
                     spdlog::warn("{} unexpected magic: {} (opcode={:x}, opaque={}){:a}{:a}",
                                  session_->log_prefix_,
@@ -480,6 +561,12 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             }
         }
 
+        [[nodiscard]] static bool is_dcp_opcode(protocol::client_opcode opcode)
+        {
+            return opcode == protocol::client_opcode::dcp_open || opcode == protocol::client_opcode::dcp_control ||
+                   opcode == protocol::client_opcode::dcp_stream_request || opcode == protocol::client_opcode::dcp_close_stream;
+        }
+
         void fetch_config(std::error_code ec)
         {
             if (ec == asio::error::operation_aborted || stopped_ || !session_) {
@@ -511,6 +598,7 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
       , origin_(origin)
       , bucket_name_(std::move(bucket_name))
       , supported_features_(known_features)
+      , limiter_(std::make_shared<adaptive_limiter>(origin_.options().max_kv_in_flight_requests, origin_.options().max_kv_queued_bytes))
     {
         log_prefix_ = fmt::format("[{}/{}/{}/{}]", client_id_, id_, stream_->log_prefix(), bucket_name_.value_or("-"));
     }
@@ -532,6 +620,7 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
       , origin_(origin)
       , bucket_name_(std::move(bucket_name))
       , supported_features_(known_features)
+      , limiter_(std::make_shared<adaptive_limiter>(origin_.options().max_kv_in_flight_requests, origin_.options().max_kv_queued_bytes))
     {
         log_prefix_ = fmt::format("[{}/{}/{}/{}]", client_id_, id_, stream_->log_prefix(), bucket_name_.value_or("-"));
     }
@@ -564,6 +653,7 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
 
     [[nodiscard]] diag::endpoint_diag_info diag_info() const
     {
+        auto limits = limiter_->stats();
         return { service_type::kv,
                  id_,
                  last_active_.time_since_epoch().count() == 0 ? std::nullopt
@@ -572,7 +662,14 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                  remote_address(),
                  local_address(),
                  state_,
-                 bucket_name_ };
+                 bucket_name_,
+                 fmt::format("in_flight={}/{}, queued_bytes={}/{}, rejected={}{}",
+                             limits.in_flight,
+                             limits.limit,
+                             limits.queued_bytes,
+                             limits.max_queued_bytes,
+                             limits.rejected,
+                             stream_->handshake_info() ? ", " + stream_->handshake_info().value() : "") };
     }
 
     template<typename Handler>
@@ -654,6 +751,10 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             return;
         }
         std::tie(bootstrap_hostname_, bootstrap_port_) = origin_.next_address();
+        bootstrap_address_ = fmt::format("{}:{}", bootstrap_hostname_, bootstrap_port_);
+        for (auto& entry : kv_metrics_) {
+            entry.store(nullptr, std::memory_order_relaxed);
+        }
         log_prefix_ = fmt::format("[{}/{}/{}/{}] <{}:{}>",
                                   client_id_,
                                   id_,
@@ -662,9 +763,13 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                                   bootstrap_hostname_,
                                   bootstrap_port_);
         spdlog::debug("{} attempt to establish MCBP connection", log_prefix_);
-        resolver_.async_resolve(bootstrap_hostname_,
-                                bootstrap_port_,
-                                std::bind(&mcbp_session::on_resolve, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+        dns::dns_cache::instance().async_resolve(
+          resolver_,
+          bootstrap_hostname_,
+          bootstrap_port_,
+          origin_.options().dns_cache_ttl,
+          origin_.options().dns_negative_cache_ttl,
+          std::bind(&mcbp_session::on_resolve, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
     }
 
     [[nodiscard]] const std::string& id() const
@@ -694,6 +799,10 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
         connection_deadline_.cancel();
         retry_backoff_.cancel();
         resolver_.cancel();
+        if (connector_) {
+            connector_->cancel();
+            connector_.reset();
+        }
         if (stream_->is_open()) {
             stream_->close();
         }
@@ -717,6 +826,7 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             command_handlers_.clear();
         }
         config_listeners_.clear();
+        dcp_message_handler_ = nullptr;
         if (on_stop_handler_) {
             on_stop_handler_(reason);
         }
@@ -724,17 +834,22 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
         state_ = diag::endpoint_state::disconnected;
     }
 
-    void write(const std::vector<uint8_t>& buf)
+    void write(const std::vector<uint8_t>& buf, std::shared_ptr<std::chrono::steady_clock::time_point> written_at = nullptr)
     {
         if (stopped_) {
             return;
         }
         std::uint32_t opaque{ 0 };
         std::memcpy(&opaque, buf.data() + 12, sizeof(opaque));
-        spdlog::trace("{} MCBP send, opaque={}, {:n}", log_prefix_, opaque, spdlog::to_hex(buf.begin(), buf.begin() + 24));
+        logger::log_deferred(
+          spdlog::level::trace, "{} MCBP send, opaque={}, {:n}", log_prefix_, opaque, logger::hex(buf.begin(), buf.begin() + 24));
         SPDLOG_TRACE("{} MCBP send, opaque={}{:a}", log_prefix_, opaque, spdlog::to_hex(data));
+        limiter_->on_queued(buf.size());
         std::scoped_lock lock(output_buffer_mutex_);
         output_buffer_.push_back(buf);
+        if (written_at) {
+            output_timestamps_.emplace_back(std::move(written_at));
+        }
     }
 
     void flush()
@@ -756,19 +871,74 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
 
     void write_and_subscribe(uint32_t opaque,
                              std::vector<std::uint8_t>& data,
-                             std::function<void(std::error_code, retry_reason, io::mcbp_message&&)> handler)
+                             std::function<void(std::error_code, retry_reason, io::mcbp_message&&)> handler,
+                             std::shared_ptr<tracing::request_span> span = nullptr)
     {
         if (stopped_) {
             spdlog::warn("{} MCBP cancel operation, while trying to write to closed session, opaque={}", log_prefix_, opaque);
             handler(error::common_errc::request_canceled, retry_reason::socket_closed_while_in_flight, {});
             return;
         }
+        if (!limiter_->try_acquire(data.size())) {
+            spdlog::debug("{} MCBP reject operation, the session has reached limit of requests in flight, opaque={}", log_prefix_, opaque);
+            handler(error::common_errc::job_queue_full, retry_reason::do_not_retry, {});
+            return;
+        }
+        std::uint8_t opcode = data[1];
+        auto* metrics = kv_metrics(protocol::client_opcode(opcode));
+        if (metrics != nullptr) {
+            metrics->bytes_out += data.size();
+        }
+        /* the handlers are owned and invoked by the session, so the reporter of its telemetry outlives them */
+        auto* threshold_reporter = &origin_.telemetry().threshold_reporter;
+        std::shared_ptr<std::chrono::steady_clock::time_point> written_at{};
+        if (span) {
+            written_at = tracing::request_span::slot(span, tracing::span_phase::written);
+        } else if (threshold_reporter->enabled()) {
+            written_at = std::make_shared<std::chrono::steady_clock::time_point>();
+        }
         {
             std::scoped_lock lock(command_handlers_mutex_);
-            command_handlers_.try_emplace(opaque, std::move(handler));
+            command_handlers_.try_emplace(
+              opaque,
+              [self = weak_from_this(),
+               limiter = limiter_,
+               metrics,
+               threshold_reporter,
+               opaque,
+               opcode,
+               written_at,
+               span = std::move(span),
+               start = std::chrono::steady_clock::now(),
+               handler = std::move(handler)](std::error_code ec, retry_reason reason, io::mcbp_message&& msg) mutable {
+                  auto now = std::chrono::steady_clock::now();
+                  auto latency = now - start;
+                  if (span) {
+                      span->mark(tracing::span_phase::received, now);
+                  }
+                  if (ec == error::common_errc::request_canceled) {
+                      limiter->release();
+                  } else {
+                      limiter->release(latency, ec == asio::error::operation_aborted);
+                  }
+                  if (metrics != nullptr) {
+                      record_metrics(*metrics, ec, latency, msg);
+                  }
+                  if (!ec && threshold_reporter->over_threshold(service_type::kv, latency)) {
+                      if (auto session = self.lock(); session) {
+                          std::optional<std::chrono::steady_clock::time_point> written{};
+                          if (written_at && written_at->time_since_epoch().count() != 0) {
+                              written = *written_at;
+                          }
+                          session->report_over_threshold(opaque, opcode, start, written, msg);
+                      }
+                  }
+                  handler(ec, reason, std::move(msg));
+              });
         }
         if (bootstrapped_ && stream_->is_open()) {
-            write_and_flush(data);
+            write(data, std::move(written_at));
+            flush();
         } else {
             spdlog::debug("{} the stream is not ready yet, put the message into pending buffer, opaque={}", log_prefix_, opaque);
             std::scoped_lock lock(pending_buffer_mutex_);
@@ -837,6 +1007,25 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
         return bootstrap_port_;
     }
 
+    [[nodiscard]] const std::string& bootstrap_address() const
+    {
+        return bootstrap_address_;
+    }
+
+    /**
+     * @return metrics of the opcode for the node of this session (nullptr if metrics are disabled)
+     */
+    [[nodiscard]] metrics::kv_metrics* kv_metrics(protocol::client_opcode opcode)
+    {
+        auto& entry = kv_metrics_[static_cast<std::uint8_t>(opcode)];
+        auto* metrics = entry.load(std::memory_order_acquire);
+        if (metrics == nullptr) {
+            metrics = origin_.telemetry().registry.kv(opcode, bootstrap_address_);
+            entry.store(metrics, std::memory_order_release);
+        }
+        return metrics;
+    }
+
     [[nodiscard]] uint32_t next_opaque()
     {
         return ++opaque_;
@@ -991,6 +1180,14 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
         return {};
     }
 
+    /**
+     * Sets receiver of the messages, that DCP producer sends to this connection.
+     */
+    void on_dcp_message(std::function<void(io::mcbp_message&&)> handler)
+    {
+        dcp_message_handler_ = std::move(handler);
+    }
+
     void on_configuration_update(std::function<void(const configuration&)> handler)
     {
         config_listeners_.emplace_back(std::move(handler));
@@ -1128,62 +1325,75 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             spdlog::error("{} error on resolve: {} ({})", log_prefix_, ec.value(), ec.message());
             return initiate_bootstrap();
         }
-        endpoints_ = endpoints;
-        do_connect(endpoints_.begin());
-        connection_deadline_.expires_after(timeout_defaults::connect_timeout);
+        if (connector_) {
+            connector_->cancel();
+        }
+        connector_ = std::make_shared<happy_eyeballs_connector>(stream_->get_executor(),
+                                                                endpoints,
+                                                                origin_.options().connection_attempt_delay,
+                                                                origin_.options().connect_timeout,
+                                                                origin_.options().force_ipv4);
+        connector_->start([self = shared_from_this(), connector = connector_](
+                            std::error_code ec, asio::ip::tcp::socket&& socket, const asio::ip::tcp::endpoint& endpoint) {
+            self->on_connect(ec, std::move(socket), endpoint, connector);
+        });
+        connection_deadline_.expires_after(origin_.options().connect_timeout);
         connection_deadline_.async_wait(std::bind(&mcbp_session::check_deadline, shared_from_this(), std::placeholders::_1));
     }
 
-    void do_connect(asio::ip::tcp::resolver::results_type::iterator it)
+    void on_connect(std::error_code ec,
+                    asio::ip::tcp::socket&& socket,
+                    const asio::ip::tcp::endpoint& endpoint,
+                    const std::shared_ptr<happy_eyeballs_connector>& connector)
     {
-        if (stopped_) {
+        if (stopped_ || ec == asio::error::operation_aborted || connector != connector_) {
             return;
         }
+        connector_.reset();
         last_active_ = std::chrono::steady_clock::now();
-        if (it != endpoints_.end()) {
-            spdlog::debug("{} connecting to {}:{}", log_prefix_, it->endpoint().address().to_string(), it->endpoint().port());
-            connection_deadline_.expires_after(timeout_defaults::connect_timeout);
-            stream_->async_connect(it->endpoint(), std::bind(&mcbp_session::on_connect, shared_from_this(), std::placeholders::_1, it));
-        } else {
-            spdlog::error("{} no more endpoints left to connect, will try another address", log_prefix_);
+        if (ec) {
+            spdlog::error("{} unable to connect to any endpoint: {} ({}), will try another address", log_prefix_, ec.value(), ec.message());
             return initiate_bootstrap();
         }
+        spdlog::debug("{} TCP connection established to {}:{}", log_prefix_, endpoint.address().to_string(), endpoint.port());
+        stream_->async_adopt(std::move(socket), [self = shared_from_this(), endpoint, stream_id = stream_->id()](std::error_code ec_adopt) {
+            if (self->stopped_ || stream_id != self->stream_->id()) {
+                return;
+            }
+            self->on_stream_ready(ec_adopt, endpoint);
+        });
     }
 
-    void on_connect(const std::error_code& ec, asio::ip::tcp::resolver::results_type::iterator it)
+    void on_stream_ready(std::error_code ec, const asio::ip::tcp::endpoint& endpoint)
     {
-        if (stopped_) {
-            return;
-        }
         last_active_ = std::chrono::steady_clock::now();
         if (!stream_->is_open() || ec) {
             spdlog::warn("{} unable to connect to {}:{}: {} ({}), is_open={}",
                          log_prefix_,
-                         it->endpoint().address().to_string(),
-                         it->endpoint().port(),
+                         endpoint.address().to_string(),
+                         endpoint.port(),
                          ec.value(),
                          ec.message(),
                          stream_->is_open());
-            do_connect(++it);
-        } else {
-            stream_->set_options();
-            local_endpoint_ = stream_->local_endpoint();
-            local_endpoint_address_ = local_endpoint_.address().to_string();
-            endpoint_ = it->endpoint();
-            endpoint_address_ = endpoint_.address().to_string();
-            spdlog::debug("{} connected to {}:{}", log_prefix_, endpoint_address_, it->endpoint().port());
-            log_prefix_ = fmt::format("[{}/{}/{}/{}] <{}/{}:{}>",
-                                      client_id_,
-                                      id_,
-                                      stream_->log_prefix(),
-                                      bucket_name_.value_or("-"),
-                                      bootstrap_hostname_,
-                                      endpoint_address_,
-                                      endpoint_.port());
-            handler_ = std::make_unique<bootstrap_handler>(shared_from_this());
-            connection_deadline_.expires_at(asio::steady_timer::time_point::max());
-            connection_deadline_.cancel();
+            return initiate_bootstrap();
         }
+        stream_->set_options();
+        local_endpoint_ = stream_->local_endpoint();
+        local_endpoint_address_ = local_endpoint_.address().to_string();
+        endpoint_ = endpoint;
+        endpoint_address_ = endpoint_.address().to_string();
+        spdlog::debug("{} connected to {}:{}", log_prefix_, endpoint_address_, endpoint_.port());
+        log_prefix_ = fmt::format("[{}/{}/{}/{}] <{}/{}:{}>",
+                                  client_id_,
+                                  id_,
+                                  stream_->log_prefix(),
+                                  bucket_name_.value_or("-"),
+                                  bootstrap_hostname_,
+                                  endpoint_address_,
+                                  endpoint_.port());
+        handler_ = std::make_unique<bootstrap_handler>(shared_from_this());
+        connection_deadline_.expires_at(asio::steady_timer::time_point::max());
+        connection_deadline_.cancel();
     }
 
     void check_deadline(std::error_code ec)
@@ -1204,8 +1414,9 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             return;
         }
         reading_ = true;
+        auto [data, size] = parser_.prepare();
         stream_->async_read_some(
-          asio::buffer(input_buffer_),
+          asio::buffer(data, size),
           [self = shared_from_this(), stream_id = stream_->id()](std::error_code ec, std::size_t bytes_transferred) {
               if (ec == asio::error::operation_aborted || self->stopped_) {
                   return;
@@ -1228,14 +1439,17 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
                                 ec.message());
                   return self->stop(retry_reason::socket_closed_while_in_flight);
               }
-              self->parser_.feed(self->input_buffer_.data(), self->input_buffer_.data() + ssize_t(bytes_transferred));
+              self->parser_.commit(bytes_transferred);
 
               for (;;) {
                   mcbp_message msg{};
                   switch (self->parser_.next(msg)) {
                       case mcbp_parser::result::ok:
-                          spdlog::trace(
-                            "{} MCBP recv, opaque={}, {:n}", self->log_prefix_, msg.header.opaque, spdlog::to_hex(msg.header_data()));
+                          logger::log_deferred(spdlog::level::trace,
+                                               "{} MCBP recv, opaque={}, {:n}",
+                                               self->log_prefix_,
+                                               msg.header.opaque,
+                                               logger::hex(msg.header_data()));
                           SPDLOG_TRACE("{} MCBP recv, opaque={}{:a}{:a}",
                                        self->log_prefix_,
                                        msg.header.opaque,
@@ -1259,6 +1473,75 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
           });
     }
 
+    static void record_metrics(metrics::kv_metrics& metrics,
+                               std::error_code ec,
+                               std::chrono::steady_clock::duration latency,
+                               const io::mcbp_message& msg)
+    {
+        ++metrics.operations;
+        if (ec == asio::error::operation_aborted) {
+            ++metrics.timeouts;
+            return;
+        }
+        if (ec == error::common_errc::request_canceled) {
+            return;
+        }
+        metrics.latency.record(latency);
+        metrics.bytes_in += protocol::header_size + msg.body.size();
+        if (auto server_duration = extract_server_duration(msg); server_duration) {
+            metrics.server_duration.record(server_duration.value());
+        }
+    }
+
+    static std::optional<std::uint64_t> extract_server_duration(const io::mcbp_message& msg)
+    {
+        if (msg.header.magic != static_cast<std::uint8_t>(protocol::magic::alt_client_response)) {
+            return {};
+        }
+        /* in alternative response the first byte of the key length is the size of framing extras */
+        auto framing_extras_size = static_cast<std::size_t>(reinterpret_cast<const std::uint8_t*>(&msg.header)[2]);
+        std::size_t offset = 0;
+        while (offset < framing_extras_size && offset < msg.body.size()) {
+            std::uint8_t frame_size = msg.body[offset] & 0xfU;
+            std::uint8_t frame_id = (static_cast<std::uint32_t>(msg.body[offset]) >> 4U) & 0xfU;
+            ++offset;
+            if (frame_id == static_cast<std::uint8_t>(protocol::response_frame_info_id::server_duration) && frame_size == 2 &&
+                offset + frame_size <= msg.body.size()) {
+                std::uint16_t encoded_duration{};
+                std::memcpy(&encoded_duration, msg.body.data() + offset, sizeof(encoded_duration));
+                encoded_duration = ntohs(encoded_duration);
+                return static_cast<std::uint64_t>(std::pow(encoded_duration, 1.74) / 2);
+            }
+            offset += frame_size;
+        }
+        return {};
+    }
+
+    void report_over_threshold(std::uint32_t opaque,
+                               std::uint8_t opcode,
+                               std::chrono::steady_clock::time_point dispatched_at,
+                               std::optional<std::chrono::steady_clock::time_point> written_at,
+                               const io::mcbp_message& msg) const
+    {
+        auto now = std::chrono::steady_clock::now();
+        metrics::report_entry entry{};
+        entry.operation_name = fmt::format("{}", protocol::client_opcode(opcode));
+        entry.total_duration_us =
+          static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - dispatched_at).count());
+        if (written_at) {
+            entry.dispatch_to_write_us =
+              static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(*written_at - dispatched_at).count());
+            entry.write_to_response_us =
+              static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - *written_at).count());
+        }
+        entry.server_duration_us = extract_server_duration(msg);
+        entry.last_remote_socket = remote_address();
+        entry.last_local_socket = local_address();
+        entry.last_local_id = id_;
+        entry.operation_id = fmt::format("0x{:x}", opaque);
+        origin_.telemetry().threshold_reporter.report(service_type::kv, std::move(entry));
+    }
+
     void do_write()
     {
         if (stopped_ || !stream_->is_open()) {
@@ -1269,12 +1552,14 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             return;
         }
         std::swap(writing_buffer_, output_buffer_);
+        std::swap(writing_timestamps_, output_timestamps_);
         std::vector<asio::const_buffer> buffers;
         buffers.reserve(writing_buffer_.size());
         for (auto& buf : writing_buffer_) {
             buffers.emplace_back(asio::buffer(buf));
         }
-        stream_->async_write(buffers, [self = shared_from_this()](std::error_code ec, std::size_t /*unused*/) {
+        stream_->async_write(buffers, [self = shared_from_this()](std::error_code ec, std::size_t bytes_transferred) {
+            self->limiter_->on_written(bytes_transferred);
             if (ec == asio::error::operation_aborted || self->stopped_) {
                 return;
             }
@@ -1290,6 +1575,10 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
             {
                 std::scoped_lock inner_lock(self->writing_buffer_mutex_);
                 self->writing_buffer_.clear();
+                for (auto& written_at : self->writing_timestamps_) {
+                    *written_at = self->last_active_;
+                }
+                self->writing_timestamps_.clear();
             }
             self->do_write();
             self->do_read();
@@ -1313,6 +1602,7 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
     std::map<uint32_t, std::function<void(std::error_code, retry_reason, io::mcbp_message&&)>> command_handlers_{};
     std::vector<std::function<void(const configuration&)>> config_listeners_{};
     std::function<void(io::retry_reason)> on_stop_handler_{};
+    std::function<void(io::mcbp_message&&)> dcp_message_handler_{};
 
     bool bootstrapped_{ false };
     std::atomic_bool stopped_{ false };
@@ -1323,24 +1613,28 @@ class mcbp_session : public std::enable_shared_from_this<mcbp_session>
 
     std::atomic<std::uint32_t> opaque_{ 0 };
 
-    std::array<std::uint8_t, 16384> input_buffer_{};
     std::vector<std::vector<std::uint8_t>> output_buffer_{};
     std::vector<std::vector<std::uint8_t>> pending_buffer_{};
     std::vector<std::vector<std::uint8_t>> writing_buffer_{};
+    std::vector<std::shared_ptr<std::chrono::steady_clock::time_point>> output_timestamps_{};
+    std::vector<std::shared_ptr<std::chrono::steady_clock::time_point>> writing_timestamps_{};
     std::mutex output_buffer_mutex_{};
     std::mutex pending_buffer_mutex_{};
     std::mutex writing_buffer_mutex_{};
     std::string bootstrap_hostname_{};
     std::string bootstrap_port_{};
+    std::string bootstrap_address_{};
+    std::array<std::atomic<metrics::kv_metrics*>, 256> kv_metrics_{};
     asio::ip::tcp::endpoint endpoint_{}; // connected endpoint
     std::string endpoint_address_{};     // cached string with endpoint address
     asio::ip::tcp::endpoint local_endpoint_{};
     std::string local_endpoint_address_{};
-    asio::ip::tcp::resolver::results_type endpoints_;
+    std::shared_ptr<happy_eyeballs_connector> connector_{};
     std::vector<protocol::hello_feature> supported_features_;
     std::optional<configuration> config_;
     std::optional<error_map> error_map_;
     collection_cache collection_cache_;
+    std::shared_ptr<adaptive_limiter> limiter_;
 
     std::atomic_bool reading_{ false };
 
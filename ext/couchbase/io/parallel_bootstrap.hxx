@@ -0,0 +1,138 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <io/mcbp_session.hxx>
+#include <origin.hxx>
+
+namespace couchbase::io
+{
+/**
+ * Bootstraps sessions against several seed nodes at once and keeps the first one that returns the configuration.
+ *
+ * Seed nodes are split into origin_.options().max_parallel_bootstrap_nodes groups, and every session starts from its own group, so
+ * an unreachable seed delays only one session. Every session keeps the full seed list for later reconnects. The sessions that lost
+ * the race are stopped.
+ */
+class parallel_bootstrap : public std::enable_shared_from_this<parallel_bootstrap>
+{
+  public:
+    using session_factory = std::function<std::shared_ptr<mcbp_session>(const couchbase::origin&)>;
+    using handler_type = std::function<void(std::error_code, std::shared_ptr<mcbp_session>, const configuration&)>;
+
+    parallel_bootstrap(const couchbase::origin& origin, session_factory&& factory)
+      : origin_(origin)
+      , factory_(std::move(factory))
+    {
+    }
+
+    void start(handler_type&& handler, bool retry_on_bucket_not_found = false)
+    {
+        handler_ = std::move(handler);
+        auto origins = origin_.split(origin_.options().max_parallel_bootstrap_nodes);
+        std::vector<std::shared_ptr<mcbp_session>> candidates;
+        candidates.reserve(origins.size());
+        for (const auto& part : origins) {
+            candidates.emplace_back(factory_(part));
+        }
+        {
+            std::scoped_lock lock(mutex_);
+            candidates_ = candidates;
+            pending_ = candidates_.size();
+        }
+        for (const auto& session : candidates) {
+            if (candidates.size() > 1) {
+                spdlog::debug("{} racing bootstrap against {} groups of seed nodes", session->log_prefix(), candidates.size());
+            }
+            session->bootstrap(
+              [self = shared_from_this(), session](std::error_code ec, const configuration& config) {
+                  self->on_bootstrap(session, ec, config);
+              },
+              retry_on_bucket_not_found);
+        }
+    }
+
+    /**
+     * Stops all candidates, the handler receives request_canceled unless a winner has been selected already.
+     */
+    void cancel()
+    {
+        std::vector<std::shared_ptr<mcbp_session>> candidates;
+        {
+            std::scoped_lock lock(mutex_);
+            candidates = candidates_;
+        }
+        for (const auto& session : candidates) {
+            session->stop(retry_reason::do_not_retry);
+        }
+    }
+
+  private:
+    void on_bootstrap(const std::shared_ptr<mcbp_session>& session, std::error_code ec, const configuration& config)
+    {
+        std::vector<std::shared_ptr<mcbp_session>> losers;
+        handler_type handler;
+        {
+            std::scoped_lock lock(mutex_);
+            if (finished_) {
+                return;
+            }
+            --pending_;
+            if (ec) {
+                if (!error_ || error_ == error::common_errc::unambiguous_timeout || error_ == error::common_errc::request_canceled) {
+                    error_ = ec;
+                }
+                if (pending_ > 0) {
+                    return;
+                }
+            } else {
+                for (const auto& candidate : candidates_) {
+                    if (candidate != session) {
+                        losers.emplace_back(candidate);
+                    }
+                }
+            }
+            finished_ = true;
+            candidates_.clear();
+            handler = std::move(handler_);
+        }
+        for (const auto& loser : losers) {
+            spdlog::debug("{} stop bootstrap candidate, {} has won", loser->log_prefix(), session->log_prefix());
+            loser->stop(retry_reason::do_not_retry);
+        }
+        if (ec) {
+            return handler(error_, nullptr, config);
+        }
+        handler({}, session, config);
+    }
+
+    couchbase::origin origin_;
+    session_factory factory_;
+    handler_type handler_{};
+    std::mutex mutex_{};
+    std::vector<std::shared_ptr<mcbp_session>> candidates_{};
+    std::size_t pending_{ 0 };
+    std::error_code error_{};
+    bool finished_{ false };
+};
+} // namespace couchbase::io
@@ -21,6 +21,7 @@
 
 #include <io/retry_reason.hxx>
 #include <io/retry_action.hxx>
+#include <tracing/request_tracer.hxx>
 
 namespace couchbase::io::retry_orchestrator
 {
@@ -72,6 +73,9 @@ retry_with_duration(std::shared_ptr<Manager> manager,
     ++command->request.retries.retry_attempts;
     command->request.retries.reasons.insert(reason);
     command->request.retries.last_duration = duration;
+    if (command->span_) {
+        command->span_->mark(tracing::span_phase::retry_scheduled);
+    }
     spdlog::trace(R"({} retrying operation {} (duration={}ms, id="{}", reason={}, attempts={}))",
                   manager->log_prefix(),
                   decltype(command->request)::encoded_request_type::body_type::opcode,
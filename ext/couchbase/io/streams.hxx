@@ -17,11 +17,15 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <optional>
 
 #include <asio.hpp>
 #include <asio/ssl.hpp>
 
+#include <io/tls_session_cache.hxx>
+
 namespace couchbase::io
 {
 
@@ -42,6 +46,11 @@ class stream_impl
 
     virtual ~stream_impl() = default;
 
+    [[nodiscard]] asio::strand<asio::io_context::executor_type> get_executor() const
+    {
+        return strand_;
+    }
+
     [[nodiscard]] std::string_view log_prefix() const
     {
         return tls_ ? "tls" : "plain";
@@ -65,9 +74,23 @@ class stream_impl
     virtual void async_connect(const asio::ip::tcp::resolver::results_type::endpoint_type& endpoint,
                                std::function<void(std::error_code)>&& handler) = 0;
 
+    /**
+     * Takes ownership of the socket, that has been connected elsewhere (e.g. by happy_eyeballs_connector), and completes the
+     * handshake if the stream needs one.
+     */
+    virtual void async_adopt(asio::ip::tcp::socket&& socket, std::function<void(std::error_code)>&& handler) = 0;
+
     virtual void async_write(std::vector<asio::const_buffer>& buffers, std::function<void(std::error_code, std::size_t)>&& handler) = 0;
 
     virtual void async_read_some(asio::mutable_buffer buffer, std::function<void(std::error_code, std::size_t)>&& handler) = 0;
+
+    /**
+     * @return description of the last TLS handshake for diagnostics, empty for plain streams
+     */
+    [[nodiscard]] virtual std::optional<std::string> handshake_info() const
+    {
+        return {};
+    }
 };
 
 class plain_stream_impl : public stream_impl
@@ -123,6 +146,12 @@ class plain_stream_impl : public stream_impl
         return stream_.async_connect(endpoint, std::move(handler));
     }
 
+    void async_adopt(asio::ip::tcp::socket&& socket, std::function<void(std::error_code)>&& handler) override
+    {
+        stream_ = std::move(socket);
+        asio::post(strand_, [handler = std::move(handler)]() { handler({}); });
+    }
+
     void async_write(std::vector<asio::const_buffer>& buffers, std::function<void(std::error_code, std::size_t)>&& handler) override
     {
         return asio::async_write(stream_, buffers, std::move(handler));
@@ -139,6 +168,8 @@ class tls_stream_impl : public stream_impl
   private:
     std::unique_ptr<asio::ssl::stream<asio::ip::tcp::socket>> stream_;
     asio::ssl::context& tls_;
+    std::string session_key_{};
+    std::optional<std::string> handshake_info_{};
 
   public:
     tls_stream_impl(asio::io_context& ctx, asio::ssl::context& tls)
@@ -186,22 +217,25 @@ class tls_stream_impl : public stream_impl
     void async_connect(const asio::ip::tcp::resolver::results_type::endpoint_type& endpoint,
                        std::function<void(std::error_code)>&& handler) override
     {
-        return stream_->lowest_layer().async_connect(endpoint, [this, handler](std::error_code ec_connect) mutable {
+        return stream_->lowest_layer().async_connect(endpoint, [this, endpoint, handler](std::error_code ec_connect) mutable {
             if (ec_connect == asio::error::operation_aborted) {
                 return;
             }
             if (ec_connect) {
                 return handler(ec_connect);
             }
-            stream_->async_handshake(asio::ssl::stream_base::client, [handler](std::error_code ec_handshake) mutable {
-                if (ec_handshake == asio::error::operation_aborted) {
-                    return;
-                }
-                return handler(ec_handshake);
-            });
+            do_handshake(endpoint, std::move(handler));
         });
     }
 
+    void async_adopt(asio::ip::tcp::socket&& socket, std::function<void(std::error_code)>&& handler) override
+    {
+        std::error_code ec{};
+        auto endpoint = socket.remote_endpoint(ec);
+        stream_ = std::make_unique<asio::ssl::stream<asio::ip::tcp::socket>>(std::move(socket), tls_);
+        do_handshake(endpoint, std::move(handler));
+    }
+
     void async_write(std::vector<asio::const_buffer>& buffers, std::function<void(std::error_code, std::size_t)>&& handler) override
     {
         return asio::async_write(*stream_, buffers, std::move(handler));
@@ -211,6 +245,31 @@ class tls_stream_impl : public stream_impl
     {
         return stream_->async_read_some(buffer, std::move(handler));
     }
+
+    [[nodiscard]] std::optional<std::string> handshake_info() const override
+    {
+        return handshake_info_;
+    }
+
+  private:
+    void do_handshake(const asio::ip::tcp::endpoint& endpoint, std::function<void(std::error_code)>&& handler)
+    {
+        auto& cache = tls_session_cache::instance();
+        cache.prepare(stream_->native_handle(), session_key_, endpoint);
+        stream_->async_handshake(asio::ssl::stream_base::client,
+                                 [this, &cache, handler, start = std::chrono::steady_clock::now()](std::error_code ec_handshake) mutable {
+                                     if (ec_handshake == asio::error::operation_aborted) {
+                                         return;
+                                     }
+                                     auto latency =
+                                       std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                                     bool resumed = cache.record_handshake(stream_->native_handle(), session_key_, ec_handshake, latency);
+                                     handshake_info_ = fmt::format("tls_handshake={}, tls_handshake_us={}",
+                                                                   ec_handshake ? "failed" : (resumed ? "resumed" : "full"),
+                                                                   latency.count());
+                                     return handler(ec_handshake);
+                                 });
+    }
 };
 
 } // namespace couchbase::io
@@ -0,0 +1,178 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include <asio/ssl.hpp>
+#include <openssl/ssl.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <diagnostics.hxx>
+
+namespace couchbase::io
+{
+/**
+ * Client-side cache of TLS sessions (session IDs and tickets) keyed by SSL context and remote endpoint.
+ *
+ * Reconnecting KV and HTTP sessions offer the cached session to the server, so the handshake is abbreviated to one round trip and skips
+ * certificate verification and key exchange. The cache also counts full and resumed handshakes per SSL context for diagnostics.
+ */
+class tls_session_cache
+{
+  public:
+    static tls_session_cache& instance()
+    {
+        static tls_session_cache cache;
+        return cache;
+    }
+
+    /**
+     * Turns on client session caching for the context. OpenSSL reports new sessions (including TLS 1.3 tickets, that arrive after the
+     * handshake) through the callback.
+     */
+    static void enable(asio::ssl::context& tls)
+    {
+        SSL_CTX_set_session_cache_mode(tls.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(tls.native_handle(), &tls_session_cache::on_new_session);
+    }
+
+    /**
+     * Associates the connection with the endpoint and offers the cached session, if any.
+     *
+     * @param key must outlive the SSL object
+     */
+    void prepare(SSL* ssl, std::string& key, const asio::ip::tcp::endpoint& endpoint)
+    {
+        key = fmt::format("{}/{}:{}", static_cast<const void*>(SSL_get_SSL_CTX(ssl)), endpoint.address().to_string(), endpoint.port());
+        SSL_set_ex_data(ssl, key_index(), &key);
+        std::scoped_lock lock(mutex_);
+        if (auto it = sessions_.find(key); it != sessions_.end()) {
+            /* the connection gets its own copy, because OpenSSL marks the session as not resumable when the connection is closed
+             * without shutdown */
+            SSL_SESSION* copy = SSL_SESSION_dup(it->second);
+            if (copy != nullptr) {
+                SSL_set_session(ssl, copy);
+                SSL_SESSION_free(copy);
+            }
+        }
+    }
+
+    /**
+     * @return true if the session has been resumed
+     */
+    bool record_handshake(SSL* ssl, const std::string& key, std::error_code ec, std::chrono::microseconds latency)
+    {
+        bool resumed = !ec && SSL_session_reused(ssl) == 1;
+        std::scoped_lock lock(mutex_);
+        auto& stats = stats_[SSL_get_SSL_CTX(ssl)];
+        if (ec) {
+            ++stats.failed_handshakes;
+            if (auto it = sessions_.find(key); it != sessions_.end()) {
+                SSL_SESSION_free(it->second);
+                sessions_.erase(it);
+            }
+            return false;
+        }
+        if (resumed) {
+            ++stats.resumed_handshakes;
+        } else {
+            ++stats.full_handshakes;
+        }
+        auto latency_us = static_cast<std::uint64_t>(latency.count());
+        stats.total_handshake_us += latency_us;
+        stats.max_handshake_us = std::max(stats.max_handshake_us, latency_us);
+        return resumed;
+    }
+
+    [[nodiscard]] std::optional<diag::tls_handshake_info> stats(asio::ssl::context& tls) const
+    {
+        std::scoped_lock lock(mutex_);
+        if (auto it = stats_.find(tls.native_handle()); it != stats_.end()) {
+            return it->second;
+        }
+        return {};
+    }
+
+    /**
+     * Drops sessions and statistics of the context, because its address might be reused by another context with different
+     * verification settings.
+     */
+    void forget(asio::ssl::context& tls)
+    {
+        auto prefix = fmt::format("{}/", static_cast<const void*>(tls.native_handle()));
+        std::scoped_lock lock(mutex_);
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                SSL_SESSION_free(it->second);
+                it = sessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        stats_.erase(tls.native_handle());
+    }
+
+  private:
+    tls_session_cache() = default;
+
+    ~tls_session_cache()
+    {
+        for (auto& [key, session] : sessions_) {
+            SSL_SESSION_free(session);
+        }
+    }
+
+    static int key_index()
+    {
+        static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+
+    static int on_new_session(SSL* ssl, SSL_SESSION* session)
+    {
+        const auto* key = static_cast<const std::string*>(SSL_get_ex_data(ssl, key_index()));
+        if (key == nullptr || SSL_SESSION_is_resumable(session) != 1) {
+            return 0;
+        }
+        SSL_SESSION* copy = SSL_SESSION_dup(session);
+        if (copy == nullptr) {
+            return 0;
+        }
+        auto& cache = instance();
+        std::scoped_lock lock(cache.mutex_);
+        auto [it, inserted] = cache.sessions_.try_emplace(*key, copy);
+        if (!inserted) {
+            SSL_SESSION_free(it->second);
+            it->second = copy;
+        }
+        return 0; /* the connection keeps its reference, the cache owns the copy */
+    }
+
+    mutable std::mutex mutex_{};
+    std::map<std::string, SSL_SESSION*> sessions_{};
+    std::map<const SSL_CTX*, diag::tls_handshake_info> stats_{};
+};
+} // namespace couchbase::io
@@ -0,0 +1,529 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+
+#include <spdlog/details/os.h>
+#include <spdlog/fmt/bin_to_hex.h>
+#include <spdlog/sinks/sink.h>
+#include <spdlog/spdlog.h>
+
+#include <utils/mpsc_queue.hxx>
+
+namespace couchbase::logger
+{
+/**
+ * Copy of the bytes to be rendered as hex dump, so that the rendering could be deferred to the logging thread.
+ */
+struct hex_dump {
+    std::vector<std::uint8_t> bytes{};
+};
+
+template<typename Container>
+[[nodiscard]] hex_dump
+hex(const Container& container)
+{
+    return { { std::begin(container), std::end(container) } };
+}
+
+template<typename Iterator>
+[[nodiscard]] hex_dump
+hex(Iterator begin, Iterator end)
+{
+    return { { begin, end } };
+}
+
+namespace priv
+{
+template<typename T>
+[[nodiscard]] const T&
+formattable(const T& value)
+{
+    return value;
+}
+
+[[nodiscard]] inline auto
+formattable(const hex_dump& value)
+{
+    return spdlog::to_hex(value.bytes);
+}
+
+template<typename... Args>
+[[nodiscard]] std::string
+format(std::string_view format, const Args&... args)
+{
+    auto render = [format](const auto&... values) { return fmt::vformat(format, fmt::make_format_args(values...)); };
+    return render(formattable(args)...);
+}
+
+struct deferred_message {
+    virtual ~deferred_message() = default;
+    [[nodiscard]] virtual std::string render() const = 0;
+};
+
+template<typename... Args>
+struct deferred_message_with_args : deferred_message {
+    template<typename... Params>
+    explicit deferred_message_with_args(std::string_view format, Params&&... args)
+      : format_(format)
+      , args_(std::forward<Params>(args)...)
+    {
+    }
+
+    [[nodiscard]] std::string render() const override
+    {
+        return std::apply([this](const auto&... args) { return priv::format(format_, args...); }, args_);
+    }
+
+    std::string_view format_;
+    std::tuple<Args...> args_;
+};
+
+struct record {
+    spdlog::level::level_enum level{ spdlog::level::off };
+    spdlog::log_clock::time_point time{};
+    std::size_t thread_id{ 0 };
+    std::string_view logger_name{};
+    std::string payload{};
+    std::unique_ptr<deferred_message> deferred{};
+};
+
+[[nodiscard]] inline std::atomic<std::uint64_t>&
+dropped_counter()
+{
+    static std::atomic<std::uint64_t> counter{ 0 };
+    return counter;
+}
+} // namespace priv
+
+class async_sink;
+
+namespace priv
+{
+/**
+ * Sink of the default logger, that accepts deferred messages, or nullptr when the default logger is synchronous.
+ */
+[[nodiscard]] inline std::atomic<async_sink*>&
+active_sink()
+{
+    static std::atomic<async_sink*> sink{ nullptr };
+    return sink;
+}
+
+/**
+ * Number of fork() calls, that created the current process. The background threads of the sinks created before the last fork() do
+ * not exist in the child.
+ */
+[[nodiscard]] inline std::atomic<std::uint64_t>&
+fork_generation()
+{
+    static std::atomic<std::uint64_t> generation{ 0 };
+    return generation;
+}
+} // namespace priv
+
+/**
+ * Sink, that moves the output of the messages to the background thread.
+ *
+ * The logging threads only copy the message into the lock-free queue. The background thread renders deferred messages, and passes
+ * everything to the wrapped sinks, so that the pattern formatting and writes to the console or file never block the IO threads.
+ * When the queue is full, the message is dropped and counted, and the background thread reports the number of dropped messages
+ * with the next warning.
+ *
+ * In the child process after fork() the sink writes synchronously. The fork handlers keep the background thread of the active sink
+ * out of the wrapped sinks while the process is forked, so that the child does not inherit their locks in the locked state.
+ */
+class async_sink : public spdlog::sinks::sink
+{
+  public:
+    static constexpr std::size_t default_queue_size = 8192;
+
+    async_sink(std::vector<spdlog::sink_ptr> sinks, std::size_t queue_size)
+      : sinks_(std::move(sinks))
+      , queue_(queue_size)
+      , fork_generation_(priv::fork_generation().load())
+      , reported_dropped_(priv::dropped_counter().load())
+    {
+        register_fork_handlers();
+        worker_ = std::thread([this]() { run(); });
+    }
+
+    async_sink(const async_sink&) = delete;
+    async_sink& operator=(const async_sink&) = delete;
+
+    ~async_sink() override
+    {
+        shutdown();
+    }
+
+    [[nodiscard]] const std::vector<spdlog::sink_ptr>& sinks() const
+    {
+        return sinks_;
+    }
+
+    void log(const spdlog::details::log_msg& msg) override
+    {
+        priv::record rec{
+            msg.level,
+            msg.time,
+            msg.thread_id,
+            { msg.logger_name.data(), msg.logger_name.size() },
+            { msg.payload.data(), msg.payload.size() },
+            {},
+        };
+        push(rec);
+    }
+
+    void push_deferred(spdlog::level::level_enum level, std::string_view logger_name, std::unique_ptr<priv::deferred_message> message)
+    {
+        priv::record rec{
+            level, spdlog::log_clock::now(), spdlog::details::os::thread_id(), logger_name, {}, std::move(message),
+        };
+        push(rec);
+    }
+
+    void flush() override
+    {
+        if (stopped_.load() || forked()) {
+            flush_sinks();
+            return;
+        }
+        flush_requested_ = true;
+        wakeup();
+    }
+
+    void set_pattern(const std::string& pattern) override
+    {
+        for (const auto& sink : sinks_) {
+            sink->set_pattern(pattern);
+        }
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override
+    {
+        for (const auto& sink : sinks_) {
+            sink->set_formatter(sink_formatter->clone());
+        }
+    }
+
+    /**
+     * Stops the background thread after it has written everything queued. The messages logged after that are written synchronously.
+     */
+    void shutdown()
+    {
+        async_sink* self = this;
+        priv::active_sink().compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+        if (stopped_.exchange(true)) {
+            return;
+        }
+        if (forked()) {
+            /* the background thread and the pushing threads have not survived fork(), and the queue is written by the parent */
+            if (worker_.joinable()) {
+                worker_.detach();
+            }
+            flush_sinks();
+            return;
+        }
+        /* the threads, that have seen the sink running, might still be pushing, and their records must not stay in the queue */
+        while (pushing_.load() > 0) {
+            std::this_thread::yield();
+        }
+        wakeup();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        drain();
+        flush_sinks();
+    }
+
+  private:
+    [[nodiscard]] bool forked() const
+    {
+        return priv::fork_generation().load(std::memory_order_relaxed) != fork_generation_;
+    }
+
+    static void register_fork_handlers()
+    {
+        static std::once_flag registered{};
+        std::call_once(registered, []() { pthread_atfork(prepare_fork, resume_after_fork_in_parent, resume_after_fork_in_child); });
+    }
+
+    [[nodiscard]] static async_sink*& forking_sink()
+    {
+        static async_sink* sink{ nullptr };
+        return sink;
+    }
+
+    static void prepare_fork()
+    {
+        auto* sink = priv::active_sink().load(std::memory_order_acquire);
+        if (sink != nullptr) {
+            /* waits until the background thread has finished writing the current records */
+            sink->write_mutex_.lock();
+            sink->mutex_.lock();
+        }
+        forking_sink() = sink;
+    }
+
+    static void resume_after_fork_in_parent()
+    {
+        if (auto* sink = std::exchange(forking_sink(), nullptr); sink != nullptr) {
+            sink->mutex_.unlock();
+            sink->write_mutex_.unlock();
+        }
+    }
+
+    static void resume_after_fork_in_child()
+    {
+        ++priv::fork_generation();
+        resume_after_fork_in_parent();
+    }
+
+    void push(priv::record& rec)
+    {
+        ++pushing_;
+        if (stopped_.load() || forked()) {
+            --pushing_;
+            std::scoped_lock lock(write_mutex_);
+            write(rec);
+            return;
+        }
+        bool pushed = queue_.try_push(rec);
+        --pushing_;
+        if (!pushed) {
+            ++priv::dropped_counter();
+            return;
+        }
+        if (idle_.load(std::memory_order_acquire)) {
+            wakeup();
+        }
+    }
+
+    void wakeup()
+    {
+        std::scoped_lock lock(mutex_);
+        cv_.notify_one();
+    }
+
+    void run()
+    {
+        while (!stopped_.load(std::memory_order_acquire)) {
+            if (drain() == 0) {
+                std::unique_lock lock(mutex_);
+                idle_ = true;
+                cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() { return stopped_ || flush_requested_ || !queue_.empty(); });
+                idle_ = false;
+            }
+            if (flush_requested_.exchange(false)) {
+                drain();
+                flush_sinks();
+            }
+        }
+        drain();
+    }
+
+    std::size_t drain()
+    {
+        std::scoped_lock lock(write_mutex_);
+        std::size_t processed = 0;
+        priv::record rec{};
+        while (queue_.try_pop(rec)) {
+            write(rec);
+            ++processed;
+        }
+        if (auto dropped = priv::dropped_counter().load(); dropped != reported_dropped_) {
+            priv::record warning{
+                spdlog::level::warn,
+                spdlog::log_clock::now(),
+                spdlog::details::os::thread_id(),
+                {},
+                fmt::format("{} log messages have been dropped, because the queue of the asynchronous logger was full",
+                            dropped - reported_dropped_),
+                {},
+            };
+            reported_dropped_ = dropped;
+            write(warning);
+        }
+        return processed;
+    }
+
+    /**
+     * Exceptions of the formatting or the sinks are reported to stderr, because they must not terminate the background thread.
+     */
+    void write(priv::record& rec)
+    {
+        if (rec.deferred) {
+            try {
+                rec.payload = rec.deferred->render();
+            } catch (const std::exception& e) {
+                rec.payload = fmt::format("unable to format log message: {}", e.what());
+            }
+        }
+        spdlog::details::log_msg msg(rec.time, {}, rec.logger_name, rec.level, rec.payload);
+        msg.thread_id = rec.thread_id;
+        for (const auto& sink : sinks_) {
+            if (!sink->should_log(msg.level)) {
+                continue;
+            }
+            try {
+                sink->log(msg);
+            } catch (const std::exception& e) {
+                report_error(e.what());
+            } catch (...) {
+                report_error("unknown exception");
+            }
+        }
+    }
+
+    static void report_error(std::string_view message)
+    {
+        try {
+            fmt::print(stderr, "[*** LOG ERROR ***] [async_sink] {}\n", message);
+        } catch (...) {
+        }
+    }
+
+    void flush_sinks()
+    {
+        std::scoped_lock lock(write_mutex_);
+        for (const auto& sink : sinks_) {
+            try {
+                sink->flush();
+            } catch (const std::exception& e) {
+                report_error(e.what());
+            } catch (...) {
+                report_error("unknown exception");
+            }
+        }
+    }
+
+    std::vector<spdlog::sink_ptr> sinks_;
+    utils::mpsc_queue<priv::record> queue_;
+    std::uint64_t fork_generation_;
+    std::uint64_t reported_dropped_;
+    std::thread worker_{};
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    /** serializes the writes of the background thread with the synchronous writes after shutdown */
+    std::mutex write_mutex_{};
+    std::atomic_size_t pushing_{ 0 };
+    std::atomic_bool idle_{ false };
+    std::atomic_bool stopped_{ false };
+    std::atomic_bool flush_requested_{ false };
+};
+
+/**
+ * Switches the default logger between synchronous and asynchronous output, keeping its sinks, level and pattern.
+ *
+ * The replaced loggers are never destroyed, because other threads might still be logging through them.
+ *
+ * @param queue_size number of messages the background thread might lag behind (only for asynchronous mode)
+ */
+inline void
+configure(bool async, std::size_t queue_size = async_sink::default_queue_size)
+{
+    static std::mutex mutex{};
+    static std::vector<std::shared_ptr<spdlog::logger>> retired_loggers{};
+
+    std::scoped_lock lock(mutex);
+    auto current = spdlog::default_logger();
+    std::vector<spdlog::sink_ptr> sinks;
+    std::vector<std::shared_ptr<async_sink>> retired_sinks;
+    for (const auto& sink : current->sinks()) {
+        if (auto wrapper = std::dynamic_pointer_cast<async_sink>(sink); wrapper) {
+            sinks.insert(sinks.end(), wrapper->sinks().begin(), wrapper->sinks().end());
+            retired_sinks.emplace_back(wrapper);
+        } else {
+            sinks.emplace_back(sink);
+        }
+    }
+
+    std::shared_ptr<spdlog::logger> logger;
+    async_sink* active = nullptr;
+    if (async) {
+        auto wrapper = std::make_shared<async_sink>(std::move(sinks), queue_size);
+        active = wrapper.get();
+        logger = std::make_shared<spdlog::logger>(current->name(), std::move(wrapper));
+    } else {
+        logger = std::make_shared<spdlog::logger>(current->name(), sinks.begin(), sinks.end());
+    }
+    logger->set_level(current->level());
+    logger->flush_on(current->flush_level());
+
+    retired_loggers.emplace_back(current);
+    spdlog::set_default_logger(logger);
+    priv::active_sink().store(active, std::memory_order_release);
+    for (const auto& sink : retired_sinks) {
+        sink->shutdown();
+    }
+}
+
+/**
+ * @return true if the default logger writes messages from the background thread
+ */
+[[nodiscard]] inline bool
+is_async()
+{
+    return priv::active_sink().load(std::memory_order_acquire) != nullptr;
+}
+
+/**
+ * @return number of messages dropped by asynchronous loggers since the start of the process
+ */
+[[nodiscard]] inline std::uint64_t
+dropped_messages()
+{
+    return priv::dropped_counter().load();
+}
+
+/**
+ * Logs the message with the default logger, but when it is asynchronous, the arguments are copied and formatted by the
+ * background thread. Use it for expensive arguments on hot paths, like hex dumps of the packets (see hex()).
+ *
+ * @param format format string, it must outlive the logger (e.g. string literal)
+ */
+template<typename... Args>
+void
+log_deferred(spdlog::level::level_enum level, std::string_view format, Args&&... args)
+{
+    auto* logger = spdlog::default_logger_raw();
+    if (!logger->should_log(level)) {
+        return;
+    }
+    if (auto* sink = priv::active_sink().load(std::memory_order_acquire); sink != nullptr) {
+        using message_type = priv::deferred_message_with_args<std::decay_t<Args>...>;
+        sink->push_deferred(level, logger->name(), std::make_unique<message_type>(format, std::forward<Args>(args)...));
+        return;
+    }
+    logger->log(level, "{}", priv::format(format, args...));
+}
+} // namespace couchbase::logger
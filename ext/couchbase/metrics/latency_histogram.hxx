@@ -0,0 +1,139 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace couchbase::metrics
+{
+struct histogram_snapshot {
+    std::uint64_t count{ 0 };
+    std::uint64_t sum{ 0 };
+    std::uint64_t max{ 0 };
+    /** pairs of (upper bound of the bucket, number of values in the bucket), only non-empty buckets */
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> buckets{};
+
+    [[nodiscard]] double mean() const
+    {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+
+    /**
+     * @param percentile value in range [0, 100]
+     * @return upper bound of the bucket, which contains requested percentile
+     */
+    [[nodiscard]] std::uint64_t value_at_percentile(double percentile) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+        auto threshold = static_cast<std::uint64_t>(static_cast<double>(count) * percentile / 100.0 + 0.5);
+        if (threshold == 0) {
+            threshold = 1;
+        }
+        std::uint64_t seen = 0;
+        for (const auto& [bound, bucket_count] : buckets) {
+            seen += bucket_count;
+            if (seen >= threshold) {
+                return std::min(bound, max);
+            }
+        }
+        return max;
+    }
+};
+
+/**
+ * Lock-free histogram with log-linear buckets (similar to HdrHistogram).
+ *
+ * Every power of two is split into 32 linear sub-buckets, so the relative error of the reported values does not exceed 3.2%. Values
+ * are recorded in microseconds (or bytes) and anything above 2^37 goes into the last bucket.
+ */
+class latency_histogram
+{
+  public:
+    static constexpr std::uint32_t sub_bucket_bits = 5;
+    static constexpr std::uint64_t sub_bucket_count = 1ULL << sub_bucket_bits;
+    static constexpr std::uint32_t max_magnitude = 37;
+    static constexpr std::size_t bucket_count = sub_bucket_count + (max_magnitude - sub_bucket_bits + 1) * sub_bucket_count;
+
+    void record(std::uint64_t value)
+    {
+        counts_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        auto current_max = max_.load(std::memory_order_relaxed);
+        while (value > current_max && !max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void record(std::chrono::steady_clock::duration duration)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        record(static_cast<std::uint64_t>(us < 0 ? 0 : us));
+    }
+
+    [[nodiscard]] histogram_snapshot snapshot() const
+    {
+        histogram_snapshot res{};
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            if (auto n = counts_[i].load(std::memory_order_relaxed); n > 0) {
+                res.buckets.emplace_back(bucket_upper_bound(i), n);
+                res.count += n;
+            }
+        }
+        res.sum = sum_.load(std::memory_order_relaxed);
+        res.max = max_.load(std::memory_order_relaxed);
+        return res;
+    }
+
+    [[nodiscard]] static std::size_t bucket_index(std::uint64_t value)
+    {
+        if (value < sub_bucket_count) {
+            return static_cast<std::size_t>(value);
+        }
+        std::uint32_t magnitude = 63;
+        while ((value & (1ULL << magnitude)) == 0) {
+            --magnitude;
+        }
+        if (magnitude > max_magnitude) {
+            return bucket_count - 1;
+        }
+        auto sub_bucket = (value >> (magnitude - sub_bucket_bits)) & (sub_bucket_count - 1);
+        return static_cast<std::size_t>(sub_bucket_count + (magnitude - sub_bucket_bits) * sub_bucket_count + sub_bucket);
+    }
+
+    [[nodiscard]] static std::uint64_t bucket_upper_bound(std::size_t index)
+    {
+        if (index < sub_bucket_count) {
+            return index;
+        }
+        auto magnitude = static_cast<std::uint32_t>((index - sub_bucket_count) / sub_bucket_count) + sub_bucket_bits;
+        auto sub_bucket = static_cast<std::uint64_t>((index - sub_bucket_count) % sub_bucket_count);
+        auto lower = (1ULL << magnitude) | (sub_bucket << (magnitude - sub_bucket_bits));
+        return lower + (1ULL << (magnitude - sub_bucket_bits)) - 1;
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> counts_{};
+    std::atomic<std::uint64_t> sum_{ 0 };
+    std::atomic<std::uint64_t> max_{ 0 };
+};
+} // namespace couchbase::metrics
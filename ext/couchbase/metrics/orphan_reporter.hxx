@@ -0,0 +1,81 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <metrics/threshold_reporter.hxx>
+
+namespace couchbase::metrics
+{
+/**
+ * Collects responses, which arrived after the request has been cancelled (timed out) or otherwise forgotten by the client, and
+ * periodically writes the slowest of them to the log.
+ */
+class orphan_reporter
+{
+  public:
+    void configure(bool enabled, std::size_t sample_size, std::chrono::milliseconds emit_interval)
+    {
+        std::scoped_lock lock(mutex_);
+        enabled_ = enabled;
+        sample_size_ = sample_size;
+        emit_interval_ = emit_interval;
+        queue_.capacity(sample_size);
+    }
+
+    [[nodiscard]] bool enabled() const
+    {
+        return enabled_;
+    }
+
+    void report(report_entry&& entry)
+    {
+        std::scoped_lock lock(mutex_);
+        queue_.add(std::move(entry));
+    }
+
+    void maybe_emit(bool force = false)
+    {
+        auto now = std::chrono::steady_clock::now();
+        sampled_queue queue{};
+        {
+            std::scoped_lock lock(mutex_);
+            if (!force && now - last_emit_ < emit_interval_) {
+                return;
+            }
+            last_emit_ = now;
+            if (queue_.empty()) {
+                return;
+            }
+            queue = std::move(queue_);
+            queue_ = sampled_queue(sample_size_);
+        }
+        tao::json::value report = {
+            { "kv", queue.to_json() },
+        };
+        spdlog::warn("Orphan responses observed: {}", tao::json::to_string(report));
+    }
+
+  private:
+    std::atomic_bool enabled_{ true };
+    std::mutex mutex_{};
+    std::size_t sample_size_{ 64 };
+    std::chrono::milliseconds emit_interval_{ timeout_defaults::tracing_orphaned_emit_interval };
+    std::chrono::steady_clock::time_point last_emit_{ std::chrono::steady_clock::now() };
+    sampled_queue queue_{ 64 };
+};
+} // namespace couchbase::metrics
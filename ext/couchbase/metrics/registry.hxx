@@ -0,0 +1,223 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+
+#include <metrics/latency_histogram.hxx>
+#include <protocol/client_opcode.hxx>
+#include <service_type.hxx>
+
+namespace couchbase::metrics
+{
+struct kv_metrics {
+    latency_histogram latency{};
+    latency_histogram server_duration{};
+    std::atomic<std::uint64_t> operations{ 0 };
+    std::atomic<std::uint64_t> retries{ 0 };
+    std::atomic<std::uint64_t> timeouts{ 0 };
+    std::atomic<std::uint64_t> bytes_in{ 0 };
+    std::atomic<std::uint64_t> bytes_out{ 0 };
+};
+
+struct http_metrics {
+    latency_histogram latency{};
+    std::atomic<std::uint64_t> operations{ 0 };
+    std::atomic<std::uint64_t> retries{ 0 };
+    std::atomic<std::uint64_t> timeouts{ 0 };
+    std::atomic<std::uint64_t> bytes_in{ 0 };
+    std::atomic<std::uint64_t> bytes_out{ 0 };
+};
+
+/**
+ * Counters of the single-flight reads: leaders are sent to the server, coalesced requests wait for the response of the leader.
+ */
+struct coalescing_metrics {
+    std::atomic<std::uint64_t> leaders{ 0 };
+    std::atomic<std::uint64_t> coalesced{ 0 };
+};
+
+struct near_cache_metrics {
+    std::atomic<std::uint64_t> hits{ 0 };
+    std::atomic<std::uint64_t> misses{ 0 };
+    std::atomic<std::uint64_t> evictions{ 0 };
+    std::atomic<std::uint64_t> invalidations{ 0 };
+};
+
+struct kv_metrics_snapshot {
+    protocol::client_opcode opcode;
+    std::string node;
+    histogram_snapshot latency;
+    histogram_snapshot server_duration;
+    std::uint64_t operations;
+    std::uint64_t retries;
+    std::uint64_t timeouts;
+    std::uint64_t bytes_in;
+    std::uint64_t bytes_out;
+};
+
+struct http_metrics_snapshot {
+    service_type type;
+    std::string node;
+    histogram_snapshot latency;
+    std::uint64_t operations;
+    std::uint64_t retries;
+    std::uint64_t timeouts;
+    std::uint64_t bytes_in;
+    std::uint64_t bytes_out;
+};
+
+struct coalescing_metrics_snapshot {
+    std::uint64_t leaders{ 0 };
+    std::uint64_t coalesced{ 0 };
+};
+
+struct near_cache_metrics_snapshot {
+    std::uint64_t hits{ 0 };
+    std::uint64_t misses{ 0 };
+    std::uint64_t evictions{ 0 };
+    std::uint64_t invalidations{ 0 };
+};
+
+struct registry_snapshot {
+    std::vector<kv_metrics_snapshot> kv{};
+    std::vector<http_metrics_snapshot> http{};
+    coalescing_metrics_snapshot coalescing{};
+    near_cache_metrics_snapshot near_cache{};
+};
+
+/**
+ * Storage of the operation metrics of the cluster, grouped by KV opcode or HTTP service, and by the node.
+ *
+ * Lookup of the entry takes shared lock only, the entries are never removed, so the sessions resolve their entries once and cache the
+ * pointers. Recording of the values does not involve any locks.
+ */
+class registry
+{
+  public:
+    [[nodiscard]] bool enabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void enabled(bool value)
+    {
+        enabled_.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return nullptr if metrics collection is disabled
+     */
+    [[nodiscard]] kv_metrics* kv(protocol::client_opcode opcode, const std::string& node)
+    {
+        return lookup(kv_, opcode, node);
+    }
+
+    /**
+     * @return nullptr if metrics collection is disabled
+     */
+    [[nodiscard]] http_metrics* http(service_type type, const std::string& node)
+    {
+        return lookup(http_, type, node);
+    }
+
+    /**
+     * @return nullptr if metrics collection is disabled
+     */
+    [[nodiscard]] coalescing_metrics* coalescing()
+    {
+        return enabled() ? &coalescing_ : nullptr;
+    }
+
+    /**
+     * @return nullptr if metrics collection is disabled
+     */
+    [[nodiscard]] near_cache_metrics* near_cache()
+    {
+        return enabled() ? &near_cache_ : nullptr;
+    }
+
+    [[nodiscard]] registry_snapshot snapshot() const
+    {
+        registry_snapshot res{};
+        res.coalescing = { coalescing_.leaders.load(), coalescing_.coalesced.load() };
+        res.near_cache = {
+            near_cache_.hits.load(), near_cache_.misses.load(), near_cache_.evictions.load(), near_cache_.invalidations.load()
+        };
+        std::shared_lock lock(mutex_);
+        res.kv.reserve(kv_.size());
+        for (const auto& [key, m] : kv_) {
+            res.kv.emplace_back(kv_metrics_snapshot{ std::get<0>(key),
+                                                     std::get<1>(key),
+                                                     m->latency.snapshot(),
+                                                     m->server_duration.snapshot(),
+                                                     m->operations.load(),
+                                                     m->retries.load(),
+                                                     m->timeouts.load(),
+                                                     m->bytes_in.load(),
+                                                     m->bytes_out.load() });
+        }
+        res.http.reserve(http_.size());
+        for (const auto& [key, m] : http_) {
+            res.http.emplace_back(http_metrics_snapshot{ std::get<0>(key),
+                                                         std::get<1>(key),
+                                                         m->latency.snapshot(),
+                                                         m->operations.load(),
+                                                         m->retries.load(),
+                                                         m->timeouts.load(),
+                                                         m->bytes_in.load(),
+                                                         m->bytes_out.load() });
+        }
+        return res;
+    }
+
+  private:
+    template<typename Key, typename Metrics>
+    Metrics* lookup(std::map<std::tuple<Key, std::string>, std::unique_ptr<Metrics>>& storage, Key key, const std::string& node)
+    {
+        if (!enabled()) {
+            return nullptr;
+        }
+        auto full_key = std::make_tuple(key, node);
+        {
+            std::shared_lock lock(mutex_);
+            if (auto it = storage.find(full_key); it != storage.end()) {
+                return it->second.get();
+            }
+        }
+        std::unique_lock lock(mutex_);
+        auto& entry = storage[full_key];
+        if (!entry) {
+            entry = std::make_unique<Metrics>();
+        }
+        return entry.get();
+    }
+
+    std::atomic_bool enabled_{ true };
+    mutable std::shared_mutex mutex_{};
+    std::map<std::tuple<protocol::client_opcode, std::string>, std::unique_ptr<kv_metrics>> kv_{};
+    std::map<std::tuple<service_type, std::string>, std::unique_ptr<http_metrics>> http_{};
+    coalescing_metrics coalescing_{};
+    near_cache_metrics near_cache_{};
+};
+} // namespace couchbase::metrics
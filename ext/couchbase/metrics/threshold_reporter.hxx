@@ -0,0 +1,223 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <tao/json.hpp>
+
+#include <service_type.hxx>
+#include <timeout_defaults.hxx>
+
+namespace couchbase::metrics
+{
+struct report_entry {
+    std::string operation_name{};
+    std::uint64_t total_duration_us{ 0 };
+    std::optional<std::uint64_t> dispatch_to_write_us{};
+    std::optional<std::uint64_t> write_to_response_us{};
+    std::optional<std::uint64_t> server_duration_us{};
+    std::string last_remote_socket{};
+    std::string last_local_socket{};
+    std::string last_local_id{};
+    std::string operation_id{};
+};
+
+/**
+ * Keeps N entries with the largest duration, and counts all entries offered
+ */
+class sampled_queue
+{
+  public:
+    sampled_queue() = default;
+
+    explicit sampled_queue(std::size_t capacity)
+      : capacity_(capacity)
+    {
+    }
+
+    void capacity(std::size_t capacity)
+    {
+        capacity_ = capacity;
+    }
+
+    void add(report_entry&& entry)
+    {
+        ++total_count_;
+        if (capacity_ == 0) {
+            return;
+        }
+        if (entries_.size() < capacity_) {
+            entries_.emplace_back(std::move(entry));
+            std::push_heap(entries_.begin(), entries_.end(), compare);
+        } else if (entry.total_duration_us > entries_.front().total_duration_us) {
+            std::pop_heap(entries_.begin(), entries_.end(), compare);
+            entries_.back() = std::move(entry);
+            std::push_heap(entries_.begin(), entries_.end(), compare);
+        }
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return total_count_ == 0;
+    }
+
+    [[nodiscard]] tao::json::value to_json() const
+    {
+        auto sorted = entries_;
+        std::sort(sorted.begin(), sorted.end(), [](const report_entry& lhs, const report_entry& rhs) {
+            return lhs.total_duration_us > rhs.total_duration_us;
+        });
+        tao::json::value top = tao::json::empty_array;
+        for (const auto& entry : sorted) {
+            tao::json::value e = {
+                { "operation_name", entry.operation_name },
+                { "total_duration_us", entry.total_duration_us },
+                { "last_remote_socket", entry.last_remote_socket },
+                { "last_local_socket", entry.last_local_socket },
+            };
+            if (entry.dispatch_to_write_us) {
+                e["last_dispatch_to_write_us"] = entry.dispatch_to_write_us.value();
+            }
+            if (entry.write_to_response_us) {
+                e["last_write_to_response_us"] = entry.write_to_response_us.value();
+            }
+            if (entry.server_duration_us) {
+                e["last_server_duration_us"] = entry.server_duration_us.value();
+            }
+            if (!entry.last_local_id.empty()) {
+                e["last_local_id"] = entry.last_local_id;
+            }
+            if (!entry.operation_id.empty()) {
+                e["operation_id"] = entry.operation_id;
+            }
+            top.push_back(e);
+        }
+        return {
+            { "total_count", total_count_ },
+            { "top_requests", top },
+        };
+    }
+
+  private:
+    static bool compare(const report_entry& lhs, const report_entry& rhs)
+    {
+        /* min-heap: the fastest of the kept entries is on the top */
+        return lhs.total_duration_us > rhs.total_duration_us;
+    }
+
+    std::size_t capacity_{ 10 };
+    std::uint64_t total_count_{ 0 };
+    std::vector<report_entry> entries_{};
+};
+
+/**
+ * Collects operations, that took longer than the threshold of their service, and periodically writes top N slowest of them to the log.
+ */
+class threshold_reporter
+{
+  public:
+    void configure(bool enabled,
+                   const std::array<std::chrono::milliseconds, 6>& thresholds,
+                   std::size_t sample_size,
+                   std::chrono::milliseconds emit_interval)
+    {
+        std::scoped_lock lock(mutex_);
+        for (std::size_t i = 0; i < thresholds.size(); ++i) {
+            thresholds_us_[i] = std::chrono::duration_cast<std::chrono::microseconds>(thresholds[i]).count();
+            queues_[i].capacity(sample_size);
+        }
+        sample_size_ = sample_size;
+        emit_interval_ = emit_interval;
+        enabled_ = enabled;
+    }
+
+    [[nodiscard]] bool enabled() const
+    {
+        return enabled_;
+    }
+
+    /**
+     * Cheap check, that does not require locking, so that the caller can skip building the entry.
+     */
+    [[nodiscard]] bool over_threshold(service_type type, std::chrono::steady_clock::duration duration) const
+    {
+        return enabled_ && std::chrono::duration_cast<std::chrono::microseconds>(duration).count() >=
+                             thresholds_us_[static_cast<std::size_t>(type)].load(std::memory_order_relaxed);
+    }
+
+    void report(service_type type, report_entry&& entry)
+    {
+        std::scoped_lock lock(mutex_);
+        queues_[static_cast<std::size_t>(type)].add(std::move(entry));
+    }
+
+    /**
+     * Writes the report if the emit interval has passed since the previous one (or if forced), and resets collected samples.
+     */
+    void maybe_emit(bool force = false)
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::array<sampled_queue, 6> queues{};
+        {
+            std::scoped_lock lock(mutex_);
+            if (!force && now - last_emit_ < emit_interval_) {
+                return;
+            }
+            last_emit_ = now;
+            for (std::size_t i = 0; i < queues_.size(); ++i) {
+                queues[i] = std::move(queues_[i]);
+                queues_[i] = sampled_queue(sample_size_);
+            }
+        }
+        tao::json::value report = tao::json::empty_object;
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            if (!queues[i].empty()) {
+                report[fmt::format("{}", service_type(i))] = queues[i].to_json();
+            }
+        }
+        if (!report.get_object().empty()) {
+            spdlog::warn("Operations over threshold: {}", tao::json::to_string(report));
+        }
+    }
+
+  private:
+    std::atomic_bool enabled_{ true };
+    std::array<std::atomic<std::int64_t>, 6> thresholds_us_{ {
+      { std::chrono::duration_cast<std::chrono::microseconds>(timeout_defaults::tracing_threshold_kv).count() },
+      { std::chrono::duration_cast<std::chrono::microseconds>(timeout_defaults::tracing_threshold_query).count() },
+      { std::chrono::duration_cast<std::chrono::microseconds>(timeout_defaults::tracing_threshold_analytics).count() },
+      { std::chrono::duration_cast<std::chrono::microseconds>(timeout_defaults::tracing_threshold_search).count() },
+      { std::chrono::duration_cast<std::chrono::microseconds>(timeout_defaults::tracing_threshold_view).count() },
+      { std::chrono::duration_cast<std::chrono::microseconds>(timeout_defaults::tracing_threshold_management).count() },
+    } };
+    std::mutex mutex_{};
+    std::size_t sample_size_{ 10 };
+    std::chrono::milliseconds emit_interval_{ timeout_defaults::tracing_threshold_emit_interval };
+    std::chrono::steady_clock::time_point last_emit_{ std::chrono::steady_clock::now() };
+    std::array<sampled_queue, 6> queues_{};
+};
+} // namespace couchbase::metrics
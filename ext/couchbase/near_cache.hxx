@@ -0,0 +1,183 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <document_id.hxx>
+#include <metrics/registry.hxx>
+#include <operations.hxx>
+
+namespace couchbase
+{
+/**
+ * Requests, that change the document, and therefore invalidate its cached copy.
+ */
+template<typename Request>
+struct invalidates_near_cache
+  : std::disjunction<std::is_same<Request, operations::upsert_request>,
+                     std::is_same<Request, operations::insert_request>,
+                     std::is_same<Request, operations::replace_request>,
+                     std::is_same<Request, operations::remove_request>,
+                     std::is_same<Request, operations::append_request>,
+                     std::is_same<Request, operations::prepend_request>,
+                     std::is_same<Request, operations::increment_request>,
+                     std::is_same<Request, operations::decrement_request>,
+                     std::is_same<Request, operations::mutate_in_request>,
+                     std::is_same<Request, operations::touch_request>,
+                     std::is_same<Request, operations::get_and_touch_request>,
+                     std::is_same<Request, operations::get_and_lock_request>,
+                     std::is_same<Request, operations::unlock_request>> {
+};
+
+/**
+ * Bounded in-process cache of the documents fetched with get, split into shards with their own lock and LRU list.
+ *
+ * An entry lives at most max_staleness, and is removed as soon as the document is mutated through the same bucket. Every
+ * invalidation bumps version of the shard, and the response of the read is stored only if the version has not changed since the read
+ * has been sent, so that the read, which raced with the mutation, cannot bring the old value back.
+ */
+class near_cache
+{
+  public:
+    struct entry {
+        std::string value{};
+        std::uint64_t cas{};
+        std::uint32_t flags{};
+    };
+
+    /**
+     * @param metrics counters of the cluster, or nullptr if metrics collection is disabled
+     */
+    near_cache(std::size_t capacity, std::chrono::milliseconds max_staleness, metrics::near_cache_metrics* metrics = nullptr)
+      : shard_capacity_((capacity + number_of_shards - 1) / number_of_shards)
+      , max_staleness_(max_staleness)
+      , metrics_(metrics)
+      , shards_(number_of_shards)
+    {
+    }
+
+    [[nodiscard]] static std::string make_key(const document_id& id)
+    {
+        return fmt::format("{}/{}", id.collection, id.key);
+    }
+
+    [[nodiscard]] std::optional<entry> find(const std::string& key)
+    {
+        auto& s = shard_for(key);
+        std::scoped_lock lock(s.mutex);
+        auto it = s.index.find(key);
+        if (it == s.index.end() || it->second->stored_at + max_staleness_ < std::chrono::steady_clock::now()) {
+            if (it != s.index.end()) {
+                s.lru.erase(it->second);
+                s.index.erase(it);
+            }
+            if (metrics_ != nullptr) {
+                metrics_->misses.fetch_add(1, std::memory_order_relaxed);
+            }
+            return {};
+        }
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        if (metrics_ != nullptr) {
+            metrics_->hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        return it->second->document;
+    }
+
+    /**
+     * @return version of the shard, which has to be passed to store() with the response
+     */
+    [[nodiscard]] std::uint64_t version(const std::string& key)
+    {
+        auto& s = shard_for(key);
+        std::scoped_lock lock(s.mutex);
+        return s.version;
+    }
+
+    void store(const std::string& key, std::uint64_t version, entry document)
+    {
+        auto& s = shard_for(key);
+        std::scoped_lock lock(s.mutex);
+        if (s.version != version) {
+            return;
+        }
+        if (auto it = s.index.find(key); it != s.index.end()) {
+            s.lru.erase(it->second);
+            s.index.erase(it);
+        }
+        s.lru.push_front({ key, std::move(document), std::chrono::steady_clock::now() });
+        s.index.emplace(key, s.lru.begin());
+        if (s.lru.size() > shard_capacity_) {
+            s.index.erase(s.lru.back().key);
+            s.lru.pop_back();
+            if (metrics_ != nullptr) {
+                metrics_->evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void invalidate(const std::string& key)
+    {
+        auto& s = shard_for(key);
+        std::scoped_lock lock(s.mutex);
+        ++s.version;
+        if (auto it = s.index.find(key); it != s.index.end()) {
+            s.lru.erase(it->second);
+            s.index.erase(it);
+            if (metrics_ != nullptr) {
+                metrics_->invalidations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+  private:
+    static constexpr std::size_t number_of_shards = 16;
+
+    struct node {
+        std::string key;
+        entry document;
+        std::chrono::steady_clock::time_point stored_at;
+    };
+
+    struct shard {
+        std::mutex mutex{};
+        std::list<node> lru{};
+        std::unordered_map<std::string, std::list<node>::iterator> index{};
+        std::uint64_t version{ 0 };
+    };
+
+    shard& shard_for(const std::string& key)
+    {
+        return shards_[std::hash<std::string>{}(key) % shards_.size()];
+    }
+
+    std::size_t shard_capacity_;
+    std::chrono::milliseconds max_staleness_;
+    metrics::near_cache_metrics* metrics_;
+    std::vector<shard> shards_;
+};
+} // namespace couchbase
@@ -21,6 +21,7 @@
 #include <timeout_defaults.hxx>
 
 #include <operations/document_get.hxx>
+#include <operations/document_get_multi.hxx>
 #include <operations/document_get_and_lock.hxx>
 #include <operations/document_get_and_touch.hxx>
 #include <operations/document_insert.hxx>
@@ -33,6 +33,7 @@ struct get_response {
 };
 
 struct get_request {
+    using response_type = get_response;
     using encoded_request_type = protocol::client_request<protocol::get_request_body>;
     using encoded_response_type = protocol::client_response<protocol::get_response_body>;
 
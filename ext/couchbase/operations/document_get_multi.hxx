@@ -0,0 +1,43 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <document_id.hxx>
+#include <operations/document_get.hxx>
+
+namespace couchbase::operations
+{
+
+struct get_multi_response {
+    /**
+     * entries are stored in the same order as identifiers in the request
+     */
+    std::vector<get_response> entries{};
+};
+
+struct get_multi_request {
+    std::vector<document_id> ids{};
+    std::chrono::milliseconds timeout{ timeout_defaults::key_value_timeout };
+
+    /**
+     * maximum number of requests dispatched to a single node at any given moment, when not set, the value from cluster options used
+     */
+    std::optional<std::size_t> max_in_flight_per_node{};
+};
+
+} // namespace couchbase::operations
@@ -19,7 +19,9 @@
 
 #include <document_id.hxx>
 #include <protocol/cmd_lookup_in.hxx>
+#include <operations/document_lookup_in.hxx>
 #include <io/retry_context.hxx>
+#include <utils/json_projector.hxx>
 
 namespace couchbase::operations
 {
@@ -33,6 +35,7 @@ struct get_projected_response {
 };
 
 struct get_projected_request {
+    using response_type = get_projected_response;
     using encoded_request_type = protocol::client_request<protocol::lookup_in_request_body>;
     using encoded_response_type = protocol::client_response<protocol::lookup_in_response_body>;
 
@@ -57,8 +60,8 @@ struct get_projected_request {
         if (with_expiry) {
             num_projections++;
         }
-        if (num_projections > 16) {
-            // too many subdoc operations, better fetch full document
+        if (num_projections > protocol::lookup_in_request_body::lookup_in_specs::max_number_of_specs) {
+            // too many subdoc operations for single request (cluster splits them before dispatching), fetch full document
             effective_projections.clear();
         }
 
@@ -78,122 +81,6 @@ struct get_projected_request {
     }
 };
 
-namespace priv
-{
-
-std::optional<tao::json::value>
-subdoc_lookup(tao::json::value& root, const std::string& path)
-{
-    std::string::size_type offset = 0;
-    tao::json::value* cur = &root;
-
-    while (offset < path.size()) {
-        std::string::size_type idx = path.find_first_of(".[]", offset);
-
-        if (idx == std::string::npos) {
-            std::string key = path.substr(offset);
-            auto* val = cur->find(key);
-            if (val != nullptr) {
-                return *val;
-            }
-            break;
-        }
-
-        if (path[idx] == '.' || path[idx] == '[') {
-            std::string key = path.substr(offset, idx - offset);
-            auto* val = cur->find(key);
-            if (val == nullptr) {
-                break;
-            }
-            cur = val;
-        } else if (path[idx] == ']') {
-            if (!cur->is_array()) {
-                break;
-            }
-            std::string key = path.substr(offset, idx - offset);
-            if (int array_index = std::stoi(key); array_index == -1) {
-                cur = &cur->get_array().back();
-            } else if (static_cast<std::size_t>(array_index) < cur->get_array().size()) {
-                cur = &cur->get_array().back();
-            } else {
-                break;
-            }
-            if (idx < path.size() - 1) {
-                return *cur;
-            }
-            idx += 1;
-        }
-        offset = idx + 1;
-    }
-
-    return {};
-}
-
-void
-subdoc_apply_projection(tao::json::value& root, const std::string& path, tao::json::value& value, bool preserve_array_indexes)
-{
-    std::string::size_type offset = 0;
-    tao::json::value* cur = &root;
-
-    while (offset < path.size()) {
-        std::string::size_type idx = path.find_first_of(".[]", offset);
-
-        if (idx == std::string::npos) {
-            cur->operator[](path.substr(offset)) = value;
-            break;
-        }
-
-        if (path[idx] == '.') {
-            std::string key = path.substr(offset, idx - offset);
-            tao::json::value* child = cur->find(key);
-            if (child == nullptr) {
-                cur->operator[](key) = tao::json::empty_object;
-                child = cur->find(key);
-            }
-            cur = child;
-        } else if (path[idx] == '[') {
-            std::string key = path.substr(offset, idx - offset);
-            tao::json::value* child = cur->find(key);
-            if (child == nullptr) {
-                cur->operator[](key) = tao::json::empty_array;
-                child = cur->find(key);
-            }
-            cur = child;
-        } else if (path[idx] == ']') {
-            tao::json::value child;
-            if (idx == path.size() - 1) {
-                child = value;
-            } else if (path[idx + 1] == '.') {
-                child = tao::json::empty_object;
-            } else if (path[idx + 1] == '[') {
-                child = tao::json::empty_array;
-            } else {
-                Expects(false);
-            }
-            if (preserve_array_indexes) {
-                int array_index = std::stoi(path.substr(offset, idx - offset));
-                if (array_index >= 0) {
-                    if (static_cast<std::size_t>(array_index) >= cur->get_array().size()) {
-                        cur->get_array().resize(static_cast<std::size_t>(array_index + 1), tao::json::null);
-                    }
-                    cur->at(static_cast<std::size_t>(array_index)) = child;
-                    cur = &cur->at(static_cast<std::size_t>(array_index));
-                } else {
-                    // index is negative, just append and let user decide what it means
-                    cur->get_array().push_back(child);
-                    cur = &cur->get_array().back();
-                }
-            } else {
-                cur->get_array().push_back(child);
-                cur = &cur->get_array().back();
-            }
-            ++idx;
-        }
-        offset = idx + 1;
-    }
-}
-} // namespace priv
-
 get_projected_response
 make_response(error_context::key_value&& ctx, const get_projected_request& request, get_projected_request::encoded_response_type&& encoded)
 {
@@ -209,46 +96,54 @@ make_response(error_context::key_value&& ctx, const get_projected_request& reque
                 // special case when user only wanted full+expiration
                 response.value = encoded.body().fields()[1].value;
             } else {
-                tao::json::value full_doc{};
-                try {
-                    full_doc = tao::json::from_string(encoded.body().fields()[request.with_expiry ? 1 : 0].value);
-                } catch (const tao::json::pegtl::parse_error& e) {
-                    response.ctx.ec = error::common_errc::parsing_failure;
+                utils::json::projector projector(request.projections, request.preserve_array_indexes);
+                if (auto ec = projector.extract(encoded.body().fields()[request.with_expiry ? 1 : 0].value); ec) {
+                    response.ctx.ec = ec;
                     return response;
                 }
-                tao::json::value new_doc;
-                for (const auto& projection : request.projections) {
-                    auto value_to_apply = priv::subdoc_lookup(full_doc, projection);
-                    if (value_to_apply) {
-                        priv::subdoc_apply_projection(new_doc, projection, *value_to_apply, request.preserve_array_indexes);
-                    } else {
-                        response.ctx.ec = error::key_value_errc::path_not_found;
-                        return response;
-                    }
-                }
-                response.value = tao::json::to_string(new_doc);
+                response.ctx.ec = projector.write(response.value);
             }
         } else {
-            tao::json::value new_doc = tao::json::empty_object;
+            utils::json::projector projector(request.projections, request.preserve_array_indexes);
             std::size_t offset = request.with_expiry ? 1 : 0;
-            for (const auto& projection : request.projections) {
-                auto& field = encoded.body().fields()[offset++];
+            for (std::size_t path_index = 0; path_index < request.projections.size(); ++path_index) {
+                const auto& field = encoded.body().fields()[offset++];
                 if (field.status == protocol::status::success && !field.value.empty()) {
-                    tao::json::value value_to_apply{};
-                    try {
-                        value_to_apply = tao::json::from_string(field.value);
-                    } catch (const tao::json::pegtl::parse_error& e) {
-                        response.ctx.ec = error::common_errc::parsing_failure;
-                        return response;
-                    }
-                    priv::subdoc_apply_projection(new_doc, projection, value_to_apply, request.preserve_array_indexes);
-                } else {
-                    response.ctx.ec = error::key_value_errc::path_not_found;
-                    return response;
+                    projector.assign(path_index, field.value);
                 }
             }
-            response.value = tao::json::to_string(new_doc);
+            response.ctx.ec = projector.write(response.value);
+        }
+    }
+    return response;
+}
+
+/**
+ * Builds projected document from the response of lookup_in request, which has been split by the cluster into several requests.
+ *
+ * The lookup contains optional expiry spec followed by one get spec for every projection.
+ */
+get_projected_response
+make_response(const get_projected_request& request, lookup_in_response&& lookup)
+{
+    get_projected_response response{ std::move(lookup.ctx) };
+    if (!response.ctx.ec) {
+        response.cas = lookup.cas;
+        std::size_t offset = 0;
+        if (request.with_expiry) {
+            if (!lookup.fields[0].value.empty()) {
+                response.expiry = gsl::narrow_cast<std::uint32_t>(std::stoul(lookup.fields[0].value));
+            }
+            offset = 1;
+        }
+        utils::json::projector projector(request.projections, request.preserve_array_indexes);
+        for (std::size_t path_index = 0; path_index < request.projections.size(); ++path_index) {
+            const auto& field = lookup.fields[offset + path_index];
+            if (field.status == protocol::status::success && !field.value.empty()) {
+                projector.assign(path_index, field.value);
+            }
         }
+        response.ctx.ec = projector.write(response.value);
     }
     return response;
 }
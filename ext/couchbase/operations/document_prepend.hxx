@@ -31,6 +31,7 @@ struct prepend_response {
 };
 
 struct prepend_request {
+    using response_type = prepend_response;
     using encoded_request_type = protocol::client_request<protocol::prepend_request_body>;
     using encoded_response_type = protocol::client_response<protocol::prepend_response_body>;
 
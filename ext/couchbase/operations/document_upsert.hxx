@@ -32,6 +32,7 @@ struct upsert_response {
 };
 
 struct upsert_request {
+    using response_type = upsert_response;
     using encoded_request_type = protocol::client_request<protocol::upsert_request_body>;
     using encoded_response_type = protocol::client_response<protocol::upsert_response_body>;
 
@@ -17,9 +17,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <string>
 
 #include <utility>
+
+#include <telemetry.hxx>
 #include <utils/connection_string.hxx>
 
 namespace couchbase
@@ -52,6 +56,24 @@ struct origin {
       , credentials_(other.credentials_)
       , nodes_(other.nodes_)
       , next_node_(nodes_.begin())
+      , telemetry_(other.telemetry_)
+    {
+    }
+
+    /**
+     * Copies credentials, options and telemetry of the other origin, but points to the single node.
+     */
+    origin(const origin& other, const std::string& hostname, const std::string& port)
+      : options_(other.options_)
+      , credentials_(other.credentials_)
+      , nodes_{ { hostname, port } }
+      , next_node_(nodes_.begin())
+      , telemetry_(other.telemetry_)
+    {
+    }
+
+    origin(const origin& other, const std::string& hostname, std::uint16_t port)
+      : origin(other, hostname, std::to_string(port))
     {
     }
 
@@ -92,6 +114,7 @@ struct origin {
             nodes_ = other.nodes_;
             next_node_ = nodes_.begin();
             exhausted_ = false;
+            telemetry_ = other.telemetry_;
         }
         return *this;
     }
@@ -133,6 +156,33 @@ struct origin {
         exhausted_ = false;
     }
 
+    /**
+     * Creates at most max_parts origins, that could be bootstrapped concurrently. Bootstrap nodes are distributed round-robin into
+     * groups, and every origin walks its own group first and the other groups after it, so it keeps the full list of seed nodes.
+     */
+    [[nodiscard]] std::vector<origin> split(std::size_t max_parts) const
+    {
+        std::size_t parts = std::max(std::size_t{ 1 }, std::min(max_parts, nodes_.size()));
+        std::vector<node_list> groups(parts);
+        for (std::size_t i = 0; i < nodes_.size(); ++i) {
+            groups[i % parts].emplace_back(nodes_[i]);
+        }
+        std::vector<origin> result;
+        result.reserve(parts);
+        for (std::size_t part = 0; part < parts; ++part) {
+            node_list nodes;
+            nodes.reserve(nodes_.size());
+            for (std::size_t offset = 0; offset < parts; ++offset) {
+                const auto& group = groups[(part + offset) % parts];
+                nodes.insert(nodes.end(), group.begin(), group.end());
+            }
+            origin candidate(*this);
+            candidate.set_nodes(std::move(nodes));
+            result.emplace_back(std::move(candidate));
+        }
+        return result;
+    }
+
     [[nodiscard]] std::pair<std::string, std::string> next_address()
     {
         if (exhausted_) {
@@ -172,12 +222,23 @@ struct origin {
         return credentials_;
     }
 
+    [[nodiscard]] couchbase::telemetry& telemetry() const
+    {
+        return *telemetry_;
+    }
+
+    void set_telemetry(std::shared_ptr<couchbase::telemetry> telemetry)
+    {
+        telemetry_ = std::move(telemetry);
+    }
+
   private:
     couchbase::cluster_options options_{};
     cluster_credentials credentials_{};
     node_list nodes_{};
     node_list::iterator next_node_{};
     bool exhausted_{ false };
+    std::shared_ptr<couchbase::telemetry> telemetry_{ std::make_shared<couchbase::telemetry>() };
 };
 
 } // namespace couchbase
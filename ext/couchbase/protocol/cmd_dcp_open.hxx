@@ -0,0 +1,98 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <protocol/client_opcode.hxx>
+
+namespace couchbase::protocol
+{
+class dcp_open_response_body
+{
+  public:
+    static const inline client_opcode opcode = client_opcode::dcp_open;
+
+    bool parse(protocol::status /* status */,
+               const header_buffer& header,
+               std::uint8_t /* framing_extras_size */,
+               std::uint16_t /* key_size */,
+               std::uint8_t /* extras_size */,
+               const std::vector<uint8_t>& /* body */,
+               const cmd_info& /* info */)
+    {
+        Expects(header[1] == static_cast<uint8_t>(opcode));
+        return false;
+    }
+};
+
+class dcp_open_request_body
+{
+  public:
+    using response_body_type = dcp_open_response_body;
+    static const inline client_opcode opcode = client_opcode::dcp_open;
+
+    static const inline std::uint32_t flag_producer = 0x01;
+    static const inline std::uint32_t flag_include_xattrs = 0x04;
+    static const inline std::uint32_t flag_no_value = 0x08;
+    static const inline std::uint32_t flag_include_delete_times = 0x20;
+
+  private:
+    std::string key_;
+    std::vector<std::uint8_t> extras_{};
+
+  public:
+    void connection_name(std::string_view name)
+    {
+        key_ = name;
+    }
+
+    void flags(std::uint32_t flags)
+    {
+        extras_.resize(2 * sizeof(std::uint32_t));
+        std::uint32_t field = 0; /* sequence number, reserved */
+        memcpy(extras_.data(), &field, sizeof(field));
+        field = htonl(flags);
+        memcpy(extras_.data() + sizeof(field), &field, sizeof(field));
+    }
+
+    [[nodiscard]] const std::string& key() const
+    {
+        return key_;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& framing_extras() const
+    {
+        return empty_buffer;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& extras() const
+    {
+        return extras_;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& value() const
+    {
+        return empty_buffer;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return key_.size() + extras_.size();
+    }
+};
+
+} // namespace couchbase::protocol
@@ -0,0 +1,196 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <limits>
+#include <string>
+
+#include <protocol/client_opcode.hxx>
+#include <utils/byteswap.hxx>
+
+namespace couchbase::protocol
+{
+class dcp_stream_request_response_body
+{
+  public:
+    static const inline client_opcode opcode = client_opcode::dcp_stream_request;
+
+    /**
+     * Partition UUID and the sequence number, at which it has been created. Newest entry goes first.
+     */
+    using failover_log = std::vector<std::pair<std::uint64_t, std::uint64_t>>;
+
+  private:
+    failover_log failover_log_{};
+    std::uint64_t rollback_seqno_{ 0 };
+
+  public:
+    [[nodiscard]] const failover_log& failover_log_entries() const
+    {
+        return failover_log_;
+    }
+
+    /**
+     * @return sequence number to roll back to, when the response has status rollback
+     */
+    [[nodiscard]] std::uint64_t rollback_seqno() const
+    {
+        return rollback_seqno_;
+    }
+
+    bool parse(protocol::status status,
+               const header_buffer& header,
+               std::uint8_t framing_extras_size,
+               std::uint16_t key_size,
+               std::uint8_t extras_size,
+               const std::vector<uint8_t>& body,
+               const cmd_info& /* info */)
+    {
+        Expects(header[1] == static_cast<uint8_t>(opcode));
+        std::size_t offset = std::size_t{ framing_extras_size } + extras_size + key_size;
+        if (status == protocol::status::success) {
+            while (offset + 2 * sizeof(std::uint64_t) <= body.size()) {
+                std::uint64_t uuid = 0;
+                memcpy(&uuid, body.data() + offset, sizeof(uuid));
+                offset += sizeof(uuid);
+                std::uint64_t seqno = 0;
+                memcpy(&seqno, body.data() + offset, sizeof(seqno));
+                offset += sizeof(seqno);
+                failover_log_.emplace_back(utils::byte_swap_64(uuid), utils::byte_swap_64(seqno));
+            }
+            return true;
+        }
+        if (status == protocol::status::rollback && offset + sizeof(rollback_seqno_) <= body.size()) {
+            memcpy(&rollback_seqno_, body.data() + offset, sizeof(rollback_seqno_));
+            rollback_seqno_ = utils::byte_swap_64(rollback_seqno_);
+            return true;
+        }
+        return false;
+    }
+};
+
+class dcp_stream_request_request_body
+{
+  public:
+    using response_body_type = dcp_stream_request_response_body;
+    static const inline client_opcode opcode = client_opcode::dcp_stream_request;
+
+    /** the stream ends as soon as the partition is not active on the node anymore */
+    static const inline std::uint32_t flag_active_vb_only = 0x10;
+    /** the stream is rejected, if the partition UUID does not match, even when the start seqno is zero */
+    static const inline std::uint32_t flag_strict_vbuuid = 0x20;
+
+  private:
+    std::uint32_t flags_{ 0 };
+    std::uint64_t start_seqno_{ 0 };
+    std::uint64_t end_seqno_{ std::numeric_limits<std::uint64_t>::max() };
+    std::uint64_t partition_uuid_{ 0 };
+    std::uint64_t snapshot_start_seqno_{ 0 };
+    std::uint64_t snapshot_end_seqno_{ 0 };
+    std::vector<std::uint8_t> extras_{};
+    std::vector<std::uint8_t> value_{};
+
+  public:
+    void flags(std::uint32_t flags)
+    {
+        flags_ = flags;
+    }
+
+    /**
+     * Restricts the stream to the collections or scope (requires collections on the connection), for example
+     * {"collections":["8","9"]} or {"scope":"0"}, where the IDs are hexadecimal.
+     */
+    void filter(const std::string& filter)
+    {
+        value_.assign(filter.begin(), filter.end());
+    }
+
+    void start_seqno(std::uint64_t seqno)
+    {
+        start_seqno_ = seqno;
+    }
+
+    void end_seqno(std::uint64_t seqno)
+    {
+        end_seqno_ = seqno;
+    }
+
+    void partition_uuid(std::uint64_t uuid)
+    {
+        partition_uuid_ = uuid;
+    }
+
+    void snapshot(std::uint64_t start_seqno, std::uint64_t end_seqno)
+    {
+        snapshot_start_seqno_ = start_seqno;
+        snapshot_end_seqno_ = end_seqno;
+    }
+
+    [[nodiscard]] const std::string& key() const
+    {
+        return empty_string;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& framing_extras() const
+    {
+        return empty_buffer;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& extras()
+    {
+        if (extras_.empty()) {
+            fill_extras();
+        }
+        return extras_;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& value() const
+    {
+        return value_;
+    }
+
+    [[nodiscard]] std::size_t size()
+    {
+        if (extras_.empty()) {
+            fill_extras();
+        }
+        return extras_.size() + value_.size();
+    }
+
+  private:
+    void fill_extras()
+    {
+        extras_.resize(2 * sizeof(std::uint32_t) + 5 * sizeof(std::uint64_t));
+        std::size_t offset = 0;
+
+        std::uint32_t field = htonl(flags_);
+        memcpy(extras_.data() + offset, &field, sizeof(field));
+        offset += sizeof(field);
+        field = 0; /* reserved */
+        memcpy(extras_.data() + offset, &field, sizeof(field));
+        offset += sizeof(field);
+
+        for (auto seqno : { start_seqno_, end_seqno_, partition_uuid_, snapshot_start_seqno_, snapshot_end_seqno_ }) {
+            seqno = utils::byte_swap_64(seqno);
+            memcpy(extras_.data() + offset, &seqno, sizeof(seqno));
+            offset += sizeof(seqno);
+        }
+    }
+};
+
+} // namespace couchbase::protocol
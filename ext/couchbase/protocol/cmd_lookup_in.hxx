@@ -104,6 +104,11 @@ class lookup_in_request_body
          */
         static const inline uint8_t path_flag_xattr = 0b0000'0100;
 
+        /**
+         * Maximum number of specs the server accepts in single request.
+         */
+        static const inline std::size_t max_number_of_specs = 16;
+
         struct entry {
             std::uint8_t opcode;
             std::uint8_t flags;
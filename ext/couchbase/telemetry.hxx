@@ -0,0 +1,39 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <metrics/orphan_reporter.hxx>
+#include <metrics/registry.hxx>
+#include <metrics/threshold_reporter.hxx>
+#include <tracing/request_tracer.hxx>
+
+namespace couchbase
+{
+/**
+ * Metrics, reporters and tracer of a single cluster object.
+ *
+ * The cluster creates it, and the sessions reach it through the origin (KV) or the http_context (HTTP), so that the settings and the
+ * data of one cluster never leak into another cluster opened in the same process.
+ */
+struct telemetry {
+    metrics::registry registry{};
+    metrics::threshold_reporter threshold_reporter{};
+    metrics::orphan_reporter orphan_reporter{};
+    tracing::tracer_holder tracer{};
+};
+} // namespace couchbase
@@ -24,6 +24,7 @@ namespace couchbase::timeout_defaults
 constexpr std::chrono::milliseconds bootstrap_timeout{ 10'000 };
 
 constexpr std::chrono::milliseconds connect_timeout{ 10'000 };
+constexpr std::chrono::milliseconds connection_attempt_delay{ 250 };
 constexpr std::chrono::milliseconds key_value_timeout{ 2'500 };
 constexpr std::chrono::milliseconds key_value_durable_timeout{ 10'000 };
 constexpr std::chrono::milliseconds view_timeout{ 75'000 };
@@ -33,9 +34,21 @@ constexpr std::chrono::milliseconds search_timeout{ 75'000 };
 constexpr std::chrono::milliseconds management_timeout{ 75'000 };
 
 constexpr std::chrono::milliseconds dns_srv_timeout{ 500 };
+constexpr std::chrono::milliseconds dns_cache_ttl{ 60'000 };
+constexpr std::chrono::milliseconds dns_negative_cache_ttl{ 5'000 };
+constexpr std::chrono::milliseconds near_cache_max_staleness{ 1'000 };
 constexpr std::chrono::milliseconds tcp_keep_alive_interval{ 60'000 };
 constexpr std::chrono::milliseconds config_poll_interval{ 2'500 };
 constexpr std::chrono::milliseconds config_poll_floor{ 50'000 };
 constexpr std::chrono::milliseconds config_idle_redial_timeout{ 5 * 60'000 };
 constexpr std::chrono::milliseconds idle_http_connection_timeout{ 4'500 };
+
+constexpr std::chrono::milliseconds tracing_threshold_kv{ 500 };
+constexpr std::chrono::milliseconds tracing_threshold_query{ 1'000 };
+constexpr std::chrono::milliseconds tracing_threshold_view{ 1'000 };
+constexpr std::chrono::milliseconds tracing_threshold_search{ 1'000 };
+constexpr std::chrono::milliseconds tracing_threshold_analytics{ 1'000 };
+constexpr std::chrono::milliseconds tracing_threshold_management{ 1'000 };
+constexpr std::chrono::milliseconds tracing_threshold_emit_interval{ 10'000 };
+constexpr std::chrono::milliseconds tracing_orphaned_emit_interval{ 10'000 };
 } // namespace couchbase::timeout_defaults
@@ -0,0 +1,142 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+#include <tao/json.hpp>
+
+#include <tracing/request_tracer.hxx>
+
+namespace couchbase::tracing
+{
+/**
+ * Converts spans into Chrome trace event format (https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU),
+ * which can be loaded into Perfetto UI or chrome://tracing.
+ *
+ * Every span gets its own track, which contains complete event for the whole request and nested events for every phase.
+ */
+class chrome_trace_exporter
+{
+  public:
+    [[nodiscard]] static tao::json::value to_json(const std::vector<std::shared_ptr<request_span>>& spans)
+    {
+        std::optional<std::chrono::steady_clock::time_point> origin{};
+        for (const auto& span : spans) {
+            if (span && span->has(span_phase::queued) && (!origin || span->at(span_phase::queued) < *origin)) {
+                origin = span->at(span_phase::queued);
+            }
+        }
+
+        tao::json::value events = tao::json::empty_array;
+        std::size_t track = 0;
+        for (const auto& span : spans) {
+            if (!span || !span->has(span_phase::queued)) {
+                continue;
+            }
+            ++track;
+            auto end = last_timestamp(*span);
+            tao::json::value args = {
+                { "retries", span->retries() },
+            };
+            if (!span->id().empty()) {
+                args["id"] = span->id();
+            }
+            if (!span->remote().empty()) {
+                args["remote"] = span->remote();
+            }
+            events.push_back(complete_event(span->name(), *origin, span->at(span_phase::queued), end, track, args));
+            add_interval(events, "queue", *span, span_phase::queued, span_phase::encode_start, *origin, track);
+            add_interval(events, "encode", *span, span_phase::encode_start, span_phase::encode_end, *origin, track);
+            add_interval(events, "write", *span, span_phase::dispatched, span_phase::written, *origin, track);
+            add_interval(events,
+                         "wire",
+                         *span,
+                         span->has(span_phase::written) ? span_phase::written : span_phase::dispatched,
+                         span_phase::received,
+                         *origin,
+                         track);
+            add_interval(events, "decode", *span, span_phase::received, span_phase::decoded, *origin, track);
+        }
+        return {
+            { "traceEvents", events },
+            { "displayTimeUnit", "ns" },
+        };
+    }
+
+    static std::error_code write(const std::string& path, const std::vector<std::shared_ptr<request_span>>& spans)
+    {
+        std::ofstream output(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!output) {
+            return std::make_error_code(std::errc::io_error);
+        }
+        output << tao::json::to_string(to_json(spans));
+        return output ? std::error_code{} : std::make_error_code(std::errc::io_error);
+    }
+
+  private:
+    static std::chrono::steady_clock::time_point last_timestamp(const request_span& span)
+    {
+        auto last = span.at(span_phase::queued);
+        for (std::size_t i = 0; i < span_phase_count; ++i) {
+            auto ts = span.at(span_phase(i));
+            if (ts > last) {
+                last = ts;
+            }
+        }
+        return last;
+    }
+
+    static void add_interval(tao::json::value& events,
+                             const char* name,
+                             const request_span& span,
+                             span_phase from,
+                             span_phase to,
+                             std::chrono::steady_clock::time_point origin,
+                             std::size_t track)
+    {
+        if (!span.has(from) || !span.has(to) || span.at(to) < span.at(from)) {
+            return;
+        }
+        events.push_back(complete_event(name, origin, span.at(from), span.at(to), track, tao::json::empty_object));
+    }
+
+    static tao::json::value complete_event(const std::string& name,
+                                           std::chrono::steady_clock::time_point origin,
+                                           std::chrono::steady_clock::time_point start,
+                                           std::chrono::steady_clock::time_point end,
+                                           std::size_t track,
+                                           const tao::json::value& args)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::nanoseconds;
+        return {
+            { "name", name },
+            { "ph", "X" },
+            { "pid", 1 },
+            { "tid", track },
+            { "ts", static_cast<double>(duration_cast<nanoseconds>(start - origin).count()) / 1000.0 },
+            { "dur", static_cast<double>(duration_cast<nanoseconds>(end - start).count()) / 1000.0 },
+            { "args", args },
+        };
+    }
+};
+} // namespace couchbase::tracing
@@ -0,0 +1,198 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace couchbase::tracing
+{
+/**
+ * Points in the lifetime of the request, recorded by the span
+ */
+enum class span_phase : std::size_t {
+    /** the request has been accepted by the cluster/bucket object */
+    queued,
+    /** the request is being encoded into the wire format */
+    encode_start,
+    /** encoding has been finished */
+    encode_end,
+    /** the request has been handed over to the session (last attempt) */
+    dispatched,
+    /** the bytes of the request have been written to the socket (last attempt) */
+    written,
+    /** the response has been read from the socket and matched with the request */
+    received,
+    /** the response has been decoded and passed to the caller */
+    decoded,
+    /** the last time, when the request has been scheduled for retry */
+    retry_scheduled,
+};
+
+constexpr std::size_t span_phase_count = static_cast<std::size_t>(span_phase::retry_scheduled) + 1;
+
+/**
+ * Monotonic timestamps of the request phases. All methods are expected to be called from the IO thread, or before the request
+ * has been submitted.
+ */
+class request_span
+{
+  public:
+    request_span(std::string name, std::string id = {})
+      : name_(std::move(name))
+      , id_(std::move(id))
+    {
+    }
+
+    void mark(span_phase phase, std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now())
+    {
+        timestamps_[static_cast<std::size_t>(phase)] = timestamp;
+        if (phase == span_phase::retry_scheduled) {
+            ++retries_;
+        }
+    }
+
+    [[nodiscard]] bool has(span_phase phase) const
+    {
+        return timestamps_[static_cast<std::size_t>(phase)].time_since_epoch().count() != 0;
+    }
+
+    [[nodiscard]] std::chrono::steady_clock::time_point at(span_phase phase) const
+    {
+        return timestamps_[static_cast<std::size_t>(phase)];
+    }
+
+    /**
+     * @return pointer to the timestamp slot, that shares ownership with the span, so that the IO layer might fill it later
+     */
+    static std::shared_ptr<std::chrono::steady_clock::time_point> slot(const std::shared_ptr<request_span>& span, span_phase phase)
+    {
+        return { span, &span->timestamps_[static_cast<std::size_t>(phase)] };
+    }
+
+    void set_remote(std::string remote)
+    {
+        remote_ = std::move(remote);
+    }
+
+    [[nodiscard]] const std::string& name() const
+    {
+        return name_;
+    }
+
+    [[nodiscard]] const std::string& id() const
+    {
+        return id_;
+    }
+
+    [[nodiscard]] const std::string& remote() const
+    {
+        return remote_;
+    }
+
+    [[nodiscard]] std::size_t retries() const
+    {
+        return retries_;
+    }
+
+  private:
+    std::string name_;
+    std::string id_;
+    std::string remote_{};
+    std::size_t retries_{ 0 };
+    std::array<std::chrono::steady_clock::time_point, span_phase_count> timestamps_{};
+};
+
+/**
+ * Tracer decides which requests should be traced (by returning non-empty span) and receives the spans back when the requests complete.
+ */
+class request_tracer
+{
+  public:
+    virtual ~request_tracer() = default;
+
+    /**
+     * @return nullptr if the request should not be traced
+     */
+    virtual std::shared_ptr<request_span> start_span(const std::string& name, const std::string& id) = 0;
+
+    virtual void end_span(std::shared_ptr<request_span> span) = 0;
+};
+
+class noop_tracer : public request_tracer
+{
+  public:
+    std::shared_ptr<request_span> start_span(const std::string& /* name */, const std::string& /* id */) override
+    {
+        return nullptr;
+    }
+
+    void end_span(std::shared_ptr<request_span> /* span */) override
+    {
+    }
+};
+
+/**
+ * Tracer of the cluster. By default the no-op tracer is installed, and the IO code does not touch the tracer at all.
+ */
+class tracer_holder
+{
+  public:
+    void set(std::shared_ptr<request_tracer> tracer)
+    {
+        enabled_ = tracer != nullptr && dynamic_cast<noop_tracer*>(tracer.get()) == nullptr;
+        std::atomic_store(&tracer_, tracer ? std::move(tracer) : std::make_shared<noop_tracer>());
+    }
+
+    [[nodiscard]] bool enabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::shared_ptr<request_tracer> get() const
+    {
+        return std::atomic_load(&tracer_);
+    }
+
+    std::shared_ptr<request_span> start_span(const std::string& name, const std::string& id = {})
+    {
+        if (!enabled()) {
+            return nullptr;
+        }
+        auto span = get()->start_span(name, id);
+        if (span) {
+            span->mark(span_phase::queued);
+        }
+        return span;
+    }
+
+    void end_span(std::shared_ptr<request_span> span)
+    {
+        if (span) {
+            get()->end_span(std::move(span));
+        }
+    }
+
+  private:
+    std::atomic_bool enabled_{ false };
+    std::shared_ptr<request_tracer> tracer_{ std::make_shared<noop_tracer>() };
+};
+} // namespace couchbase::tracing
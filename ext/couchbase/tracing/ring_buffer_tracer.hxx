@@ -0,0 +1,85 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <tracing/request_tracer.hxx>
+
+namespace couchbase::tracing
+{
+/**
+ * Keeps the last N completed spans in memory.
+ *
+ * Every sample_rate-th request is traced, so that with the sample rate 1 all requests are traced.
+ */
+class ring_buffer_tracer : public request_tracer
+{
+  public:
+    ring_buffer_tracer(std::size_t capacity, std::size_t sample_rate = 1)
+      : capacity_(std::max<std::size_t>(capacity, 1))
+      , sample_rate_(std::max<std::size_t>(sample_rate, 1))
+    {
+        spans_.reserve(capacity_);
+    }
+
+    std::shared_ptr<request_span> start_span(const std::string& name, const std::string& id) override
+    {
+        if (counter_.fetch_add(1, std::memory_order_relaxed) % sample_rate_ != 0) {
+            return nullptr;
+        }
+        return std::make_shared<request_span>(name, id);
+    }
+
+    void end_span(std::shared_ptr<request_span> span) override
+    {
+        std::scoped_lock lock(mutex_);
+        if (spans_.size() < capacity_) {
+            spans_.emplace_back(std::move(span));
+        } else {
+            spans_[next_] = std::move(span);
+        }
+        next_ = (next_ + 1) % capacity_;
+    }
+
+    /**
+     * @return completed spans, starting from the oldest one
+     */
+    [[nodiscard]] std::vector<std::shared_ptr<request_span>> snapshot() const
+    {
+        std::scoped_lock lock(mutex_);
+        if (spans_.size() < capacity_) {
+            return spans_;
+        }
+        std::vector<std::shared_ptr<request_span>> res;
+        res.reserve(capacity_);
+        res.insert(res.end(), spans_.begin() + static_cast<std::ptrdiff_t>(next_), spans_.end());
+        res.insert(res.end(), spans_.begin(), spans_.begin() + static_cast<std::ptrdiff_t>(next_));
+        return res;
+    }
+
+  private:
+    const std::size_t capacity_;
+    const std::size_t sample_rate_;
+    std::atomic<std::size_t> counter_{ 0 };
+    mutable std::mutex mutex_{};
+    std::vector<std::shared_ptr<request_span>> spans_{};
+    std::size_t next_{ 0 };
+};
+} // namespace couchbase::tracing
@@ -219,6 +219,12 @@ extract_options(connection_string& connstr)
                  * connection, reconnecting, node added, etc.
                  */
                 connstr.options.connect_timeout = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "connection_attempt_delay") {
+                /**
+                 * Number of milliseconds to wait before starting connection to the next resolved address of the node, while the previous
+                 * attempts are still in progress (RFC 8305).
+                 */
+                connstr.options.connection_attempt_delay = std::chrono::milliseconds(std::stoull(param.second));
             } else if (param.first == "kv_timeout") {
                 /**
                  * Number of milliseconds to wait before timing out a KV operation by the client.
@@ -306,6 +312,29 @@ extract_options(connection_string& connstr)
                  * The period of time an HTTP connection can be idle before it is forcefully disconnected.
                  */
                 connstr.options.idle_http_connection_timeout = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "max_bulk_in_flight_per_node") {
+                /**
+                 * The maximum number of requests of the bulk operation, that could be dispatched to a single node without waiting for
+                 * responses.
+                 */
+                connstr.options.max_bulk_in_flight_per_node = std::stoul(param.second);
+            } else if (param.first == "max_kv_in_flight_requests") {
+                /**
+                 * The upper bound for the number of KV requests in flight per node. The effective limit adapts to the observed latency
+                 * and never exceeds this value. Requests above the limit are rejected with job_queue_full error.
+                 */
+                connstr.options.max_kv_in_flight_requests = std::stoul(param.second);
+            } else if (param.first == "max_kv_queued_bytes") {
+                /**
+                 * The maximum number of bytes waiting to be written to the KV socket of a single node. 0 disables the limit.
+                 */
+                connstr.options.max_kv_queued_bytes = std::stoul(param.second);
+            } else if (param.first == "max_parallel_bootstrap_nodes") {
+                /**
+                 * The number of seed nodes to bootstrap from concurrently. The first node to return the configuration wins, and the
+                 * other connections are closed. The default 1 tries seed nodes one after another.
+                 */
+                connstr.options.max_parallel_bootstrap_nodes = std::stoul(param.second);
             } else if (param.first == "enable_dns_srv") {
                 if (connstr.bootstrap_nodes.size() == 1) {
                     if (param.second == "true" || param.second == "yes" || param.second == "on") {
@@ -319,6 +348,17 @@ extract_options(connection_string& connstr)
                       param.first,
                       param.second);
                 }
+            } else if (param.first == "dns_cache_ttl") {
+                /**
+                 * Number of milliseconds to reuse resolved addresses of the nodes. SRV records use TTL from the DNS answer instead. 0
+                 * disables caching of the addresses.
+                 */
+                connstr.options.dns_cache_ttl = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "dns_negative_cache_ttl") {
+                /**
+                 * Number of milliseconds to remember that the name could not be resolved, or has no SRV records.
+                 */
+                connstr.options.dns_negative_cache_ttl = std::chrono::milliseconds(std::stoull(param.second));
             } else if (param.first == "network") {
                 connstr.options.network = param.second; /* current known values are "auto", "default" and "external" */
             } else if (param.first == "show_queries") {
@@ -330,6 +370,16 @@ extract_options(connection_string& connstr)
                 } else if (param.second == "false" || param.second == "no" || param.second == "off") {
                     connstr.options.show_queries = false;
                 }
+            } else if (param.first == "enable_pipelined_bootstrap") {
+                /**
+                 * Send the whole KV handshake in a single flight when authentication needs no extra round trips (TLS certificate or
+                 * PLAIN mechanism).
+                 */
+                if (param.second == "true" || param.second == "yes" || param.second == "on") {
+                    connstr.options.enable_pipelined_bootstrap = true;
+                } else if (param.second == "false" || param.second == "no" || param.second == "off") {
+                    connstr.options.enable_pipelined_bootstrap = false;
+                }
             } else if (param.first == "enable_clustermap_notification") {
                 /**
                  * Allow the server to push configuration updates asynchronously.
@@ -348,6 +398,84 @@ extract_options(connection_string& connstr)
                 } else if (param.second == "false" || param.second == "no" || param.second == "off") {
                     connstr.options.enable_unordered_execution = false;
                 }
+            } else if (param.first == "enable_metrics") {
+                /**
+                 * Collect latency histograms and counters for KV and HTTP operations (see metrics::registry)
+                 */
+                if (param.second == "true" || param.second == "yes" || param.second == "on") {
+                    connstr.options.enable_metrics = true;
+                } else if (param.second == "false" || param.second == "no" || param.second == "off") {
+                    connstr.options.enable_metrics = false;
+                }
+            } else if (param.first == "enable_read_coalescing") {
+                /**
+                 * Attach concurrent identical reads of the same document to single request in flight
+                 */
+                if (param.second == "true" || param.second == "yes" || param.second == "on") {
+                    connstr.options.enable_read_coalescing = true;
+                } else if (param.second == "false" || param.second == "no" || param.second == "off") {
+                    connstr.options.enable_read_coalescing = false;
+                }
+            } else if (param.first == "near_cache_capacity") {
+                /**
+                 * Number of documents to keep in the in-process cache of get results for every bucket. 0 disables the cache.
+                 */
+                connstr.options.near_cache_capacity = std::stoul(param.second);
+            } else if (param.first == "near_cache_max_staleness") {
+                /**
+                 * Number of milliseconds to serve cached document, unless it has been mutated through the same bucket.
+                 */
+                connstr.options.near_cache_max_staleness = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "enable_tracing") {
+                /**
+                 * Log operations over threshold and orphaned responses
+                 */
+                if (param.second == "true" || param.second == "yes" || param.second == "on") {
+                    connstr.options.enable_tracing = true;
+                } else if (param.second == "false" || param.second == "no" || param.second == "off") {
+                    connstr.options.enable_tracing = false;
+                }
+            } else if (param.first == "tracing_threshold_kv") {
+                /**
+                 * Operations which take longer than the threshold (in milliseconds) will be included into threshold report
+                 */
+                connstr.options.tracing_threshold_kv = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_threshold_query") {
+                connstr.options.tracing_threshold_query = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_threshold_view") {
+                connstr.options.tracing_threshold_view = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_threshold_search") {
+                connstr.options.tracing_threshold_search = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_threshold_analytics") {
+                connstr.options.tracing_threshold_analytics = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_threshold_management") {
+                connstr.options.tracing_threshold_management = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_threshold_sample_size") {
+                /**
+                 * Number of the slowest operations per service, kept for the single threshold report
+                 */
+                connstr.options.tracing_threshold_sample_size = std::stoul(param.second);
+            } else if (param.first == "tracing_threshold_emit_interval") {
+                connstr.options.tracing_threshold_emit_interval = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_orphaned_sample_size") {
+                connstr.options.tracing_orphaned_sample_size = std::stoul(param.second);
+            } else if (param.first == "tracing_orphaned_emit_interval") {
+                connstr.options.tracing_orphaned_emit_interval = std::chrono::milliseconds(std::stoull(param.second));
+            } else if (param.first == "tracing_ring_buffer_capacity") {
+                /**
+                 * Number of the most recent request spans to keep in memory (zero disables span tracing)
+                 */
+                connstr.options.tracing_ring_buffer_capacity = std::stoul(param.second);
+            } else if (param.first == "tracing_sample_rate") {
+                /**
+                 * Trace every Nth request
+                 */
+                connstr.options.tracing_sample_rate = std::stoul(param.second);
+            } else if (param.first == "tracing_chrome_trace_path") {
+                /**
+                 * Write collected spans in Chrome Trace Event format to this file when the cluster is closed
+                 */
+                connstr.options.tracing_chrome_trace_path = param.second;
             } else if (param.first == "enable_compression") {
                 /**
                  * Announce support of compression (snappy) to server
@@ -0,0 +1,471 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <errors.hxx>
+
+namespace couchbase::utils::json
+{
+/**
+ * Extracts projections (sub-document paths like "name", "addresses.billing" or "tags[0]") from JSON document in a single pass.
+ *
+ * Paths are compiled into a trie once. The scanner descends only into members and elements, that lead to requested paths, skips
+ * everything else without decoding, and remembers raw spans of the matched values. The output document is then written directly from
+ * the trie and the spans, so neither source, nor resulting document is materialized as DOM.
+ */
+class projector
+{
+  public:
+    projector(const std::vector<std::string>& paths, bool preserve_array_indexes)
+      : preserve_array_indexes_(preserve_array_indexes)
+    {
+        nodes_.emplace_back();
+        for (std::size_t path_index = 0; path_index < paths.size(); ++path_index) {
+            terminals_.push_back(compile(paths[path_index]));
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return terminals_.size();
+    }
+
+    /**
+     * Assigns value of the path directly, when it is known from sub-document response.
+     */
+    void assign(std::size_t path_index, std::string_view raw_value)
+    {
+        nodes_[terminals_[path_index]].value = raw_value;
+    }
+
+    /**
+     * Scans the full document, and remembers values of all paths found in it.
+     *
+     * @return common_errc::parsing_failure if the document is not valid JSON
+     */
+    [[nodiscard]] std::error_code extract(std::string_view document)
+    {
+        input_ = document;
+        pos_ = 0;
+        if (!scan(0) || (skip_whitespace(), pos_ != input_.size())) {
+            return error::common_errc::parsing_failure;
+        }
+        return {};
+    }
+
+    /**
+     * Writes new document, which contains only projected paths.
+     *
+     * @return key_value_errc::path_not_found if some of the paths do not exist
+     */
+    [[nodiscard]] std::error_code write(std::string& output) const
+    {
+        for (auto terminal : terminals_) {
+            if (!nodes_[terminal].value) {
+                return error::key_value_errc::path_not_found;
+            }
+        }
+        std::size_t size = 0;
+        for (auto terminal : terminals_) {
+            size += nodes_[terminal].value->size() + 16;
+        }
+        output.reserve(output.size() + size);
+        write_node(0, output);
+        return {};
+    }
+
+  private:
+    struct node {
+        std::string key{};
+        std::int64_t index{ 0 };
+        bool is_index{ false };
+        bool is_terminal{ false };
+        std::vector<std::size_t> children{};
+        std::optional<std::string_view> value{};
+    };
+
+    std::size_t child(std::size_t parent, std::string_view key, std::optional<std::int64_t> index)
+    {
+        for (auto id : nodes_[parent].children) {
+            const auto& candidate = nodes_[id];
+            if (index ? (candidate.is_index && candidate.index == *index) : (!candidate.is_index && candidate.key == key)) {
+                return id;
+            }
+        }
+        node entry{};
+        entry.key = key;
+        entry.index = index.value_or(0);
+        entry.is_index = index.has_value();
+        nodes_.emplace_back(std::move(entry));
+        nodes_[parent].children.push_back(nodes_.size() - 1);
+        return nodes_.size() - 1;
+    }
+
+    std::size_t compile(std::string_view path)
+    {
+        std::size_t current = 0;
+        std::size_t offset = 0;
+        while (offset < path.size()) {
+            if (path[offset] == '[') {
+                auto close = path.find(']', offset);
+                if (close == std::string_view::npos) {
+                    close = path.size();
+                }
+                std::int64_t index = 0;
+                bool negative = false;
+                for (auto i = offset + 1; i < close; ++i) {
+                    if (path[i] == '-') {
+                        negative = true;
+                    } else {
+                        index = index * 10 + (path[i] - '0');
+                    }
+                }
+                current = child(current, {}, negative ? -index : index);
+                offset = close + 1;
+            } else {
+                auto end = path.find_first_of(".[", offset);
+                if (end == std::string_view::npos) {
+                    end = path.size();
+                }
+                current = child(current, path.substr(offset, end - offset), std::nullopt);
+                offset = end;
+            }
+            if (offset < path.size() && path[offset] == '.') {
+                ++offset;
+            }
+        }
+        nodes_[current].is_terminal = true;
+        return current;
+    }
+
+    void skip_whitespace()
+    {
+        while (pos_ < input_.size() && (input_[pos_] == ' ' || input_[pos_] == '\t' || input_[pos_] == '\n' || input_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    /**
+     * Moves position after the closing quote of the string, position must point to the opening quote.
+     */
+    bool skip_string()
+    {
+        for (++pos_; pos_ < input_.size(); ++pos_) {
+            if (input_[pos_] == '\\') {
+                ++pos_;
+            } else if (input_[pos_] == '"') {
+                ++pos_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool skip_value()
+    {
+        skip_whitespace();
+        if (pos_ >= input_.size()) {
+            return false;
+        }
+        switch (input_[pos_]) {
+            case '"':
+                return skip_string();
+            case '{':
+            case '[': {
+                std::size_t depth = 0;
+                while (pos_ < input_.size()) {
+                    switch (input_[pos_]) {
+                        case '"':
+                            if (!skip_string()) {
+                                return false;
+                            }
+                            continue;
+                        case '{':
+                        case '[':
+                            ++depth;
+                            break;
+                        case '}':
+                        case ']':
+                            if (--depth == 0) {
+                                ++pos_;
+                                return true;
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                    ++pos_;
+                }
+                return false;
+            }
+            default: {
+                auto start = pos_;
+                while (pos_ < input_.size() && input_[pos_] != ',' && input_[pos_] != '}' && input_[pos_] != ']' && input_[pos_] != ' ' &&
+                       input_[pos_] != '\t' && input_[pos_] != '\n' && input_[pos_] != '\r') {
+                    ++pos_;
+                }
+                return pos_ > start;
+            }
+        }
+    }
+
+    /**
+     * Compares JSON-encoded key (without quotes) with the path segment, decoding simple escape sequences.
+     */
+    static bool key_equals(std::string_view encoded, std::string_view key)
+    {
+        if (encoded.find('\\') == std::string_view::npos) {
+            return encoded == key;
+        }
+        std::string decoded;
+        decoded.reserve(encoded.size());
+        for (std::size_t i = 0; i < encoded.size(); ++i) {
+            if (encoded[i] != '\\' || i + 1 == encoded.size()) {
+                decoded.push_back(encoded[i]);
+                continue;
+            }
+            switch (encoded[++i]) {
+                case 'b':
+                    decoded.push_back('\b');
+                    break;
+                case 'f':
+                    decoded.push_back('\f');
+                    break;
+                case 'n':
+                    decoded.push_back('\n');
+                    break;
+                case 'r':
+                    decoded.push_back('\r');
+                    break;
+                case 't':
+                    decoded.push_back('\t');
+                    break;
+                case 'u':
+                    /* non-ASCII keys are expected to be stored as UTF-8, compare encoded form */
+                    decoded.append("\\u");
+                    break;
+                default:
+                    decoded.push_back(encoded[i]);
+                    break;
+            }
+        }
+        return decoded == key;
+    }
+
+    /**
+     * Scans the value at the current position for the trie node. Remembers the span, if the node is terminal, and descends into
+     * the children.
+     */
+    bool scan(std::size_t id)
+    {
+        skip_whitespace();
+        auto start = pos_;
+        bool success = true;
+        if (nodes_[id].children.empty()) {
+            success = skip_value();
+        } else if (pos_ < input_.size() && input_[pos_] == '{') {
+            success = scan_object(id);
+        } else if (pos_ < input_.size() && input_[pos_] == '[') {
+            success = scan_array(id);
+        } else {
+            success = skip_value();
+        }
+        if (success && nodes_[id].is_terminal) {
+            nodes_[id].value = input_.substr(start, pos_ - start);
+        }
+        return success;
+    }
+
+    bool scan_object(std::size_t id)
+    {
+        ++pos_;
+        skip_whitespace();
+        if (pos_ < input_.size() && input_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        while (pos_ < input_.size()) {
+            skip_whitespace();
+            if (pos_ >= input_.size() || input_[pos_] != '"') {
+                return false;
+            }
+            auto key_start = pos_ + 1;
+            if (!skip_string()) {
+                return false;
+            }
+            auto key = input_.substr(key_start, pos_ - key_start - 1);
+            skip_whitespace();
+            if (pos_ >= input_.size() || input_[pos_] != ':') {
+                return false;
+            }
+            ++pos_;
+            auto match = std::find_if(nodes_[id].children.begin(), nodes_[id].children.end(), [this, key](std::size_t child_id) {
+                return !nodes_[child_id].is_index && key_equals(key, nodes_[child_id].key);
+            });
+            if (!(match == nodes_[id].children.end() ? skip_value() : scan(*match))) {
+                return false;
+            }
+            skip_whitespace();
+            if (pos_ >= input_.size()) {
+                return false;
+            }
+            if (input_[pos_] == '}') {
+                ++pos_;
+                return true;
+            }
+            if (input_[pos_] != ',') {
+                return false;
+            }
+            ++pos_;
+        }
+        return false;
+    }
+
+    bool scan_array(std::size_t id)
+    {
+        std::optional<std::size_t> last_child{};
+        for (auto child_id : nodes_[id].children) {
+            if (nodes_[child_id].is_index && nodes_[child_id].index < 0) {
+                last_child = child_id;
+            }
+        }
+        ++pos_;
+        skip_whitespace();
+        if (pos_ < input_.size() && input_[pos_] == ']') {
+            ++pos_;
+            return true;
+        }
+        std::int64_t index = 0;
+        std::size_t last_element = 0;
+        while (pos_ < input_.size()) {
+            skip_whitespace();
+            last_element = pos_;
+            auto match = std::find_if(nodes_[id].children.begin(), nodes_[id].children.end(), [this, index](std::size_t child_id) {
+                return nodes_[child_id].is_index && nodes_[child_id].index == index;
+            });
+            if (!(match == nodes_[id].children.end() ? skip_value() : scan(*match))) {
+                return false;
+            }
+            ++index;
+            skip_whitespace();
+            if (pos_ >= input_.size()) {
+                return false;
+            }
+            if (input_[pos_] == ']') {
+                ++pos_;
+                if (last_child) {
+                    /* the last element is known only at the end of the array, scan it once again for negative index */
+                    auto end = pos_;
+                    pos_ = last_element;
+                    if (!scan(*last_child)) {
+                        return false;
+                    }
+                    pos_ = end;
+                }
+                return true;
+            }
+            if (input_[pos_] != ',') {
+                return false;
+            }
+            ++pos_;
+        }
+        return false;
+    }
+
+    static void write_key(std::string_view key, std::string& output)
+    {
+        output.push_back('"');
+        for (auto c : key) {
+            if (c == '"' || c == '\\') {
+                output.push_back('\\');
+            }
+            output.push_back(c);
+        }
+        output.append("\":");
+    }
+
+    void write_node(std::size_t id, std::string& output) const
+    {
+        const auto& entry = nodes_[id];
+        if (entry.is_terminal) {
+            output.append(*entry.value);
+            return;
+        }
+        bool is_array = !entry.children.empty() && nodes_[entry.children.front()].is_index;
+        output.push_back(is_array ? '[' : '{');
+        bool first = true;
+        auto separate = [&first, &output]() {
+            if (!first) {
+                output.push_back(',');
+            }
+            first = false;
+        };
+        if (!is_array) {
+            for (auto child_id : entry.children) {
+                separate();
+                write_key(nodes_[child_id].key, output);
+                write_node(child_id, output);
+            }
+        } else if (preserve_array_indexes_) {
+            std::vector<std::size_t> ordered{};
+            std::vector<std::size_t> negative{};
+            for (auto child_id : entry.children) {
+                (nodes_[child_id].index < 0 ? negative : ordered).push_back(child_id);
+            }
+            std::sort(ordered.begin(), ordered.end(), [this](std::size_t lhs, std::size_t rhs) {
+                return nodes_[lhs].index < nodes_[rhs].index;
+            });
+            std::int64_t next_index = 0;
+            for (auto child_id : ordered) {
+                for (; next_index < nodes_[child_id].index; ++next_index) {
+                    separate();
+                    output.append("null");
+                }
+                separate();
+                write_node(child_id, output);
+                ++next_index;
+            }
+            for (auto child_id : negative) {
+                /* index is negative, just append and let user decide what it means */
+                separate();
+                write_node(child_id, output);
+            }
+        } else {
+            for (auto child_id : entry.children) {
+                separate();
+                write_node(child_id, output);
+            }
+        }
+        output.push_back(is_array ? ']' : '}');
+    }
+
+    bool preserve_array_indexes_;
+    std::vector<node> nodes_{};
+    std::vector<std::size_t> terminals_{};
+    std::string_view input_{};
+    std::size_t pos_{ 0 };
+};
+} // namespace couchbase::utils::json
@@ -0,0 +1,127 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace couchbase::utils
+{
+/**
+ * Bounded lock-free queue for many producers and a single consumer.
+ *
+ * Every cell carries a sequence number, which tells producers whether the cell is free for the given position, and tells the
+ * consumer whether the value has been published. Producers claim positions with CAS on the shared counter, and never wait for
+ * each other: when the queue is full, try_push() fails instead.
+ */
+template<typename T>
+class mpsc_queue
+{
+  public:
+    /**
+     * @param capacity number of cells, rounded up to the power of two
+     */
+    explicit mpsc_queue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1U;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    [[nodiscard]] std::size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    /**
+     * Might be called from any thread.
+     *
+     * @return false if the queue is full, in this case the value is left untouched
+     */
+    [[nodiscard]] bool try_push(T& value)
+    {
+        std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        cell* target = nullptr;
+        for (;;) {
+            target = &cells_[position & mask_];
+            std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (difference == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+        target->value = std::move(value);
+        target->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Must be called from the consumer thread only.
+     *
+     * @return false if there is no published value
+     */
+    [[nodiscard]] bool try_pop(T& value)
+    {
+        cell& target = cells_[dequeue_position_ & mask_];
+        if (target.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1) {
+            return false;
+        }
+        value = std::move(target.value);
+        target.value = T{};
+        target.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_position_;
+        return true;
+    }
+
+    /**
+     * Must be called from the consumer thread only.
+     */
+    [[nodiscard]] bool empty() const
+    {
+        return cells_[dequeue_position_ & mask_].sequence.load(std::memory_order_acquire) != dequeue_position_ + 1;
+    }
+
+  private:
+    struct cell {
+        std::atomic<std::size_t> sequence{ 0 };
+        T value{};
+    };
+
+    std::size_t mask_{ 0 };
+    std::unique_ptr<cell[]> cells_{};
+    alignas(64) std::atomic<std::size_t> enqueue_position_{ 0 };
+    alignas(64) std::size_t dequeue_position_{ 0 };
+};
+} // namespace couchbase::utils
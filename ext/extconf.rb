@@ -42,6 +42,7 @@ cmake_flags = %W[
 cmake_flags << "-DCMAKE_C_COMPILER=#{ENV['CB_CC']}" if ENV["CB_CC"]
 cmake_flags << "-DCMAKE_CXX_COMPILER=#{ENV['CB_CXX']}" if ENV["CB_CXX"]
 cmake_flags << "-DSTATIC_STDLIB=ON" << "-DSTATIC_OPENSSL=ON" if ENV["CB_STATIC"]
+cmake_flags << "-DENABLE_IO_URING=ON" if ENV["CB_IO_URING"]
 cmake_flags << "-DENABLE_SANITIZER_ADDRESS=ON" if ENV["CB_ASAN"]
 cmake_flags << "-DENABLE_SANITIZER_LEAK=ON" if ENV["CB_LSAN"]
 cmake_flags << "-DENABLE_SANITIZER_MEMORY=ON" if ENV["CB_MSAN"]
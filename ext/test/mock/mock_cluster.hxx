@@ -0,0 +1,252 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <thread>
+
+#include <asio.hpp>
+
+#include "mock_http_session.hxx"
+#include "mock_kv_session.hxx"
+#include "mock_state.hxx"
+
+namespace mock
+{
+/**
+ * In-process Couchbase cluster, which speaks enough of MCBP and query HTTP protocols to run the SDK against it.
+ *
+ * Every node listens on 127.0.0.1 with ephemeral KV and HTTP ports. The mock runs its own IO thread, so the tests can use blocking
+ * calls. Latency, error statuses, NOT_MY_VBUCKET responses and topology changes could be injected at any time.
+ */
+class mock_cluster
+{
+  public:
+    explicit mock_cluster(mock_options options = {})
+      : state_(std::make_shared<cluster_state>(std::move(options)))
+    {
+        std::vector<std::pair<std::uint16_t, std::uint16_t>> ports;
+        for (std::size_t index = 0; index < state_->options().number_of_nodes; ++index) {
+            auto& node = nodes_.emplace_back(std::make_unique<node_listeners>(ctx_));
+            ports.emplace_back(node->kv.local_endpoint().port(), node->http.local_endpoint().port());
+            accept_kv(index);
+            accept_http(index);
+        }
+        state_->set_ports(std::move(ports));
+        io_thread_ = std::thread([this]() { ctx_.run(); });
+    }
+
+    mock_cluster(const mock_cluster&) = delete;
+    mock_cluster& operator=(const mock_cluster&) = delete;
+
+    ~mock_cluster()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        if (!io_thread_.joinable()) {
+            return;
+        }
+        asio::post(ctx_, [this]() {
+            for (auto& node : nodes_) {
+                std::error_code ignored;
+                node->kv.close(ignored);
+                node->http.close(ignored);
+            }
+            for (auto& session : kv_sessions_) {
+                if (auto s = session.lock(); s) {
+                    s->stop();
+                }
+            }
+            for (auto& session : http_sessions_) {
+                if (auto s = session.lock(); s) {
+                    s->stop();
+                }
+            }
+            ctx_.stop();
+        });
+        io_thread_.join();
+    }
+
+    /**
+     * @return connection string, which lists KV endpoints of all nodes
+     */
+    [[nodiscard]] std::string connection_string() const
+    {
+        std::vector<std::string> hosts;
+        for (const auto& node : nodes_) {
+            hosts.emplace_back(fmt::format("127.0.0.1:{}=mcd", node->kv.local_endpoint().port()));
+        }
+        return fmt::format("couchbase://{}", fmt::join(hosts, ","));
+    }
+
+    [[nodiscard]] std::uint16_t kv_port(std::size_t index) const
+    {
+        return nodes_.at(index)->kv.local_endpoint().port();
+    }
+
+    [[nodiscard]] const mock_options& options() const
+    {
+        return state_->options();
+    }
+
+    /**
+     * Delays every KV response.
+     */
+    void set_latency(std::chrono::milliseconds latency)
+    {
+        state_->set_latency(latency);
+    }
+
+    /**
+     * Delays KV responses for the given opcode, overrides global latency.
+     */
+    void set_latency(couchbase::protocol::client_opcode opcode, std::chrono::milliseconds latency)
+    {
+        state_->set_latency(opcode, latency);
+    }
+
+    /**
+     * Next count requests with given opcode will fail with the status.
+     */
+    void inject_status(couchbase::protocol::client_opcode opcode, couchbase::protocol::status code, std::size_t count = 1)
+    {
+        state_->inject_status(opcode, code, count);
+    }
+
+    /**
+     * Next count data requests will receive NOT_MY_VBUCKET with the current configuration in the payload.
+     */
+    void inject_not_my_vbucket(std::size_t count = 1)
+    {
+        state_->inject_not_my_vbucket(count);
+    }
+
+    /**
+     * Moves every vBucket to the next node, and notifies connected clients about new configuration.
+     */
+    void rebalance()
+    {
+        state_->rebalance();
+        notify_configuration();
+    }
+
+    /**
+     * Bumps configuration revision without changing topology, and notifies connected clients.
+     */
+    void bump_configuration()
+    {
+        state_->bump_revision();
+        notify_configuration();
+    }
+
+    void set_query_handler(query_handler handler)
+    {
+        state_->set_query_handler(std::move(handler));
+    }
+
+    void set_query_latency(std::chrono::milliseconds latency)
+    {
+        state_->set_query_latency(latency);
+    }
+
+    /**
+     * @return number of requests with given opcode received by all nodes
+     */
+    [[nodiscard]] std::size_t requests(couchbase::protocol::client_opcode opcode) const
+    {
+        return state_->requests(opcode);
+    }
+
+    /**
+     * Stores document directly, bypassing the protocol.
+     */
+    void store(const std::string& key, const std::string& value, std::uint32_t flags = 0)
+    {
+        state_->with_documents([&](std::map<std::string, document>& documents) {
+            auto& doc = documents[key];
+            doc.value = value;
+            doc.flags = flags;
+            doc.datatype = static_cast<std::uint8_t>(couchbase::protocol::datatype::json);
+            doc.cas = state_->next_cas();
+        });
+    }
+
+  private:
+    struct node_listeners {
+        asio::ip::tcp::acceptor kv;
+        asio::ip::tcp::acceptor http;
+
+        explicit node_listeners(asio::io_context& ctx)
+          : kv(ctx, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0))
+          , http(ctx, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0))
+        {
+        }
+    };
+
+    void accept_kv(std::size_t index)
+    {
+        nodes_[index]->kv.async_accept([this, index](std::error_code ec, asio::ip::tcp::socket socket) {
+            if (ec) {
+                return;
+            }
+            socket.set_option(asio::ip::tcp::no_delay{ true });
+            auto session = std::make_shared<kv_session>(std::move(socket), state_, index);
+            kv_sessions_.erase(std::remove_if(kv_sessions_.begin(), kv_sessions_.end(), [](const auto& s) { return s.expired(); }),
+                               kv_sessions_.end());
+            kv_sessions_.emplace_back(session);
+            session->start();
+            accept_kv(index);
+        });
+    }
+
+    void accept_http(std::size_t index)
+    {
+        nodes_[index]->http.async_accept([this, index](std::error_code ec, asio::ip::tcp::socket socket) {
+            if (ec) {
+                return;
+            }
+            auto session = std::make_shared<http_session>(std::move(socket), state_);
+            http_sessions_.erase(std::remove_if(http_sessions_.begin(), http_sessions_.end(), [](const auto& s) { return s.expired(); }),
+                                 http_sessions_.end());
+            http_sessions_.emplace_back(session);
+            session->start();
+            accept_http(index);
+        });
+    }
+
+    void notify_configuration()
+    {
+        asio::post(ctx_, [this]() {
+            for (auto& session : kv_sessions_) {
+                if (auto s = session.lock(); s) {
+                    s->notify_configuration();
+                }
+            }
+        });
+    }
+
+    asio::io_context ctx_{};
+    std::shared_ptr<cluster_state> state_;
+    std::vector<std::unique_ptr<node_listeners>> nodes_{};
+    std::vector<std::weak_ptr<kv_session>> kv_sessions_{};
+    std::vector<std::weak_ptr<http_session>> http_sessions_{};
+    std::thread io_thread_{};
+};
+} // namespace mock
@@ -0,0 +1,182 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+
+#include <io/dns_codec.hxx>
+
+namespace mock
+{
+struct srv_target {
+    std::string hostname{};
+    std::uint16_t port{ 0 };
+    std::uint16_t priority{ 0 };
+    std::uint16_t weight{ 0 };
+    std::uint32_t ttl{ 60 };
+};
+
+/**
+ * In-process DNS server, which answers SRV queries over UDP on 127.0.0.1 with the configured records, and counts the queries.
+ *
+ * Unknown names are answered with empty answer section.
+ */
+class mock_dns_server
+{
+  public:
+    mock_dns_server()
+      : socket_(ctx_, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0))
+    {
+        do_receive();
+        io_thread_ = std::thread([this]() { ctx_.run(); });
+    }
+
+    mock_dns_server(const mock_dns_server&) = delete;
+    mock_dns_server& operator=(const mock_dns_server&) = delete;
+
+    ~mock_dns_server()
+    {
+        asio::post(ctx_, [this]() {
+            std::error_code ignored;
+            socket_.close(ignored);
+        });
+        io_thread_.join();
+    }
+
+    [[nodiscard]] asio::ip::address address() const
+    {
+        return socket_.local_endpoint().address();
+    }
+
+    [[nodiscard]] std::uint16_t port() const
+    {
+        return socket_.local_endpoint().port();
+    }
+
+    /**
+     * @param name fully qualified record name, e.g. "_couchbase._tcp.example.com"
+     */
+    void set_records(const std::string& name, std::vector<srv_target> targets)
+    {
+        std::scoped_lock lock(mutex_);
+        records_[name] = std::move(targets);
+    }
+
+    [[nodiscard]] std::size_t queries(const std::string& name) const
+    {
+        std::scoped_lock lock(mutex_);
+        if (auto it = queries_.find(name); it != queries_.end()) {
+            return it->second;
+        }
+        return 0;
+    }
+
+  private:
+    void do_receive()
+    {
+        socket_.async_receive_from(asio::buffer(buffer_), sender_, [this](std::error_code ec, std::size_t bytes_transferred) {
+            if (ec) {
+                return;
+            }
+            std::vector<std::uint8_t> request(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(bytes_transferred));
+            auto reply = std::make_shared<std::vector<std::uint8_t>>(answer(request));
+            socket_.async_send_to(asio::buffer(*reply), sender_, [reply](std::error_code /* ec */, std::size_t /* bytes_transferred */) {});
+            do_receive();
+        });
+    }
+
+    static void put_u16(std::vector<std::uint8_t>& payload, std::uint16_t val)
+    {
+        payload.push_back(static_cast<std::uint8_t>(val >> 8U));
+        payload.push_back(static_cast<std::uint8_t>(val & 0xffU));
+    }
+
+    static void put_u32(std::vector<std::uint8_t>& payload, std::uint32_t val)
+    {
+        put_u16(payload, static_cast<std::uint16_t>(val >> 16U));
+        put_u16(payload, static_cast<std::uint16_t>(val & 0xffffU));
+    }
+
+    std::vector<std::uint8_t> answer(const std::vector<std::uint8_t>& request)
+    {
+        auto message = couchbase::io::dns::dns_codec::decode(request);
+        message.header.flags.qr = couchbase::io::dns::message_type::response;
+        std::vector<srv_target> targets;
+        if (!message.questions.empty()) {
+            std::string name;
+            for (const auto& label : message.questions[0].name.labels) {
+                if (!name.empty()) {
+                    name += ".";
+                }
+                name += label;
+            }
+            std::scoped_lock lock(mutex_);
+            ++queries_[name];
+            if (auto it = records_.find(name); it != records_.end()) {
+                targets = it->second;
+            }
+        }
+        auto payload = couchbase::io::dns::dns_codec::encode(message);
+        payload[6] = static_cast<std::uint8_t>(targets.size() >> 8U);
+        payload[7] = static_cast<std::uint8_t>(targets.size() & 0xffU);
+        for (const auto& target : targets) {
+            put_u16(payload, 0xc00c); /* pointer to the name of the first question */
+            put_u16(payload, static_cast<std::uint16_t>(couchbase::io::dns::resource_type::srv));
+            put_u16(payload, static_cast<std::uint16_t>(couchbase::io::dns::resource_class::in));
+            put_u32(payload, target.ttl);
+            std::vector<std::uint8_t> rdata;
+            put_u16(rdata, target.priority);
+            put_u16(rdata, target.weight);
+            put_u16(rdata, target.port);
+            std::size_t label_start = 0;
+            while (label_start < target.hostname.size()) {
+                auto label_end = target.hostname.find('.', label_start);
+                if (label_end == std::string::npos) {
+                    label_end = target.hostname.size();
+                }
+                rdata.push_back(static_cast<std::uint8_t>(label_end - label_start));
+                rdata.insert(rdata.end(), target.hostname.begin() + static_cast<std::ptrdiff_t>(label_start),
+                             target.hostname.begin() + static_cast<std::ptrdiff_t>(label_end));
+                label_start = label_end + 1;
+            }
+            rdata.push_back(0);
+            put_u16(payload, static_cast<std::uint16_t>(rdata.size()));
+            payload.insert(payload.end(), rdata.begin(), rdata.end());
+        }
+        return payload;
+    }
+
+    asio::io_context ctx_{};
+    asio::ip::udp::socket socket_;
+    asio::ip::udp::endpoint sender_{};
+    std::array<std::uint8_t, 512> buffer_{};
+    std::thread io_thread_{};
+
+    mutable std::mutex mutex_{};
+    std::map<std::string, std::vector<srv_target>> records_{};
+    std::map<std::string, std::size_t> queries_{};
+};
+} // namespace mock
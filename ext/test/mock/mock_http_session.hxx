@@ -0,0 +1,226 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <asio.hpp>
+
+#include <http_parser.h>
+
+#include <platform/base64.h>
+
+#include "mock_state.hxx"
+
+namespace mock
+{
+struct http_request {
+    std::string method{};
+    std::string path{};
+    std::map<std::string, std::string> headers{};
+    std::string body{};
+};
+
+/**
+ * Single HTTP connection of the mock node. Serves the query service and ping endpoints.
+ */
+class http_session : public std::enable_shared_from_this<http_session>
+{
+  public:
+    http_session(asio::ip::tcp::socket socket, std::shared_ptr<cluster_state> state)
+      : socket_(std::move(socket))
+      , state_(std::move(state))
+    {
+        ::http_parser_init(&parser_, HTTP_REQUEST);
+        parser_.data = this;
+        settings_.on_url = [](::http_parser* parser, const char* at, std::size_t length) -> int {
+            static_cast<http_session*>(parser->data)->request_.path.append(at, length);
+            return 0;
+        };
+        settings_.on_header_field = [](::http_parser* parser, const char* at, std::size_t length) -> int {
+            auto* self = static_cast<http_session*>(parser->data);
+            self->header_field_.assign(at, length);
+            std::transform(self->header_field_.begin(), self->header_field_.end(), self->header_field_.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            return 0;
+        };
+        settings_.on_header_value = [](::http_parser* parser, const char* at, std::size_t length) -> int {
+            auto* self = static_cast<http_session*>(parser->data);
+            self->request_.headers[self->header_field_].append(at, length);
+            return 0;
+        };
+        settings_.on_body = [](::http_parser* parser, const char* at, std::size_t length) -> int {
+            static_cast<http_session*>(parser->data)->request_.body.append(at, length);
+            return 0;
+        };
+        settings_.on_message_complete = [](::http_parser* parser) -> int {
+            auto* self = static_cast<http_session*>(parser->data);
+            self->request_.method = ::http_method_str(static_cast<::http_method>(parser->method));
+            self->completed_.emplace_back(std::move(self->request_));
+            self->request_ = {};
+            return 0;
+        };
+    }
+
+    void start()
+    {
+        do_read();
+    }
+
+    void stop()
+    {
+        asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            std::error_code ignored;
+            self->socket_.shutdown(asio::socket_base::shutdown_both, ignored);
+            self->socket_.close(ignored);
+        });
+    }
+
+  private:
+    void do_read()
+    {
+        socket_.async_read_some(asio::buffer(input_), [self = shared_from_this()](std::error_code ec, std::size_t bytes_transferred) {
+            if (ec) {
+                return;
+            }
+            auto parsed = ::http_parser_execute(&self->parser_, &self->settings_, self->input_.data(), bytes_transferred);
+            if (parsed != bytes_transferred) {
+                std::error_code ignored;
+                self->socket_.close(ignored);
+                return;
+            }
+            auto requests = std::move(self->completed_);
+            self->completed_.clear();
+            for (auto& request : requests) {
+                self->handle(request);
+            }
+            self->do_read();
+        });
+    }
+
+    [[nodiscard]] bool authorized(const http_request& request) const
+    {
+        auto header = request.headers.find("authorization");
+        if (header == request.headers.end() || header->second.rfind("Basic ", 0) != 0) {
+            return false;
+        }
+        return couchbase::base64::decode(header->second.substr(6)) == state_->options().username + ":" + state_->options().password;
+    }
+
+    void handle(const http_request& request)
+    {
+        if (request.path == "/admin/ping") {
+            return respond(200, "OK", "text/plain", {});
+        }
+        if (!authorized(request)) {
+            return respond(401, "Unauthorized", "text/plain", {});
+        }
+        if (request.method == "POST" && request.path == "/query/service") {
+            return handle_query(request);
+        }
+        respond(404, "Not Found", "text/plain", {});
+    }
+
+    void handle_query(const http_request& request)
+    {
+        tao::json::value payload{};
+        try {
+            payload = tao::json::from_string(request.body);
+        } catch (const std::exception&) {
+            return respond(400, "Bad Request", "text/plain", {});
+        }
+        auto result = state_->execute_query(payload);
+        tao::json::value rows = tao::json::empty_array;
+        rows.get_array() = result.rows;
+        tao::json::value body{
+            { "requestID", fmt::format("mock-{}", ++request_counter_) },
+            { "signature", { { "*", "*" } } },
+            { "results", std::move(rows) },
+            { "status", result.error ? "errors" : "success" },
+            { "metrics",
+              {
+                { "elapsedTime", "1ms" },
+                { "executionTime", "1ms" },
+                { "resultCount", result.rows.size() },
+                { "resultSize", 0 },
+              } },
+        };
+        if (const auto* id = payload.find("client_context_id"); id != nullptr && id->is_string()) {
+            body["clientContextID"] = id->get_string();
+        }
+        if (result.error) {
+            tao::json::value error{
+                { "code", result.error->first },
+                { "msg", result.error->second },
+            };
+            body["errors"] = tao::json::value::array({ std::move(error) });
+        }
+        auto latency = state_->query_latency();
+        auto content = tao::json::to_string(body);
+        if (latency.count() == 0) {
+            return respond(200, "OK", "application/json", content);
+        }
+        auto timer = std::make_shared<asio::steady_timer>(socket_.get_executor(), latency);
+        timer->async_wait([self = shared_from_this(), timer, content = std::move(content)](std::error_code ec) {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            self->respond(200, "OK", "application/json", content);
+        });
+    }
+
+    void respond(int code, const std::string& reason, const std::string& content_type, const std::string& content)
+    {
+        output_ += fmt::format("HTTP/1.1 {} {}\r\nContent-Type: {}\r\nContent-Length: {}\r\n\r\n{}",
+                               code,
+                               reason,
+                               content_type,
+                               content.size(),
+                               content);
+        if (!writing_.empty()) {
+            return;
+        }
+        do_write();
+    }
+
+    void do_write()
+    {
+        std::swap(writing_, output_);
+        asio::async_write(socket_, asio::buffer(writing_), [self = shared_from_this()](std::error_code ec, std::size_t /* bytes */) {
+            self->writing_.clear();
+            if (ec) {
+                return;
+            }
+            if (!self->output_.empty()) {
+                self->do_write();
+            }
+        });
+    }
+
+    asio::ip::tcp::socket socket_;
+    std::shared_ptr<cluster_state> state_;
+    ::http_parser parser_{};
+    http_parser_settings settings_{};
+    std::array<char, 16384> input_{};
+    std::string header_field_{};
+    http_request request_{};
+    std::vector<http_request> completed_{};
+    std::string output_{};
+    std::string writing_{};
+    std::uint64_t request_counter_{ 0 };
+};
+} // namespace mock
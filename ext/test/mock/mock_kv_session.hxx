@@ -0,0 +1,952 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+#include <asio.hpp>
+
+#include <protocol/client_opcode.hxx>
+#include <protocol/datatype.hxx>
+#include <protocol/hello_feature.hxx>
+#include <protocol/magic.hxx>
+#include <protocol/server_opcode.hxx>
+#include <protocol/status.hxx>
+#include <utils/byteswap.hxx>
+#include <utils/crc32.hxx>
+
+#include "mock_sasl.hxx"
+#include "mock_state.hxx"
+#include "mock_subdoc.hxx"
+
+namespace mock
+{
+using couchbase::protocol::client_opcode;
+using couchbase::protocol::hello_feature;
+using couchbase::protocol::status;
+
+struct kv_request {
+    std::uint8_t magic{};
+    client_opcode opcode{};
+    std::uint8_t datatype{};
+    std::uint16_t vbucket{};
+    std::array<std::uint8_t, 4> opaque{};
+    std::uint64_t cas{};
+    std::string extras{};
+    std::string key{};
+    std::string value{};
+};
+
+struct kv_response {
+    status code{ status::success };
+    std::string extras{};
+    std::string key{};
+    std::string value{};
+    std::uint64_t cas{ 0 };
+    std::uint8_t datatype{ 0 };
+};
+
+/**
+ * Single KV connection of the mock node.
+ */
+class kv_session : public std::enable_shared_from_this<kv_session>
+{
+  public:
+    kv_session(asio::ip::tcp::socket socket, std::shared_ptr<cluster_state> state, std::size_t node_index)
+      : socket_(std::move(socket))
+      , state_(std::move(state))
+      , node_index_(node_index)
+      , sasl_(state_->options().username, state_->options().password)
+    {
+    }
+
+    void start()
+    {
+        read_header();
+    }
+
+    void stop()
+    {
+        asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            std::error_code ignored;
+            self->socket_.shutdown(asio::socket_base::shutdown_both, ignored);
+            self->socket_.close(ignored);
+        });
+    }
+
+    /**
+     * Pushes current configuration to the client, if it has negotiated clustermap change notifications.
+     */
+    void notify_configuration()
+    {
+        asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            if (!self->supports(hello_feature::clustermap_change_notification) || !self->supports(hello_feature::duplex) ||
+                !self->bucket_selected_) {
+                return;
+            }
+            std::string extras(4, '\0');
+            std::uint32_t revision = htonl(static_cast<std::uint32_t>(self->state_->revision()));
+            std::memcpy(extras.data(), &revision, sizeof(revision));
+            auto packet = encode(static_cast<std::uint8_t>(couchbase::protocol::magic::server_request),
+                                 static_cast<std::uint8_t>(couchbase::protocol::server_opcode::cluster_map_change_notification),
+                                 0,
+                                 {},
+                                 { status::success,
+                                   extras,
+                                   self->state_->options().bucket,
+                                   self->state_->configuration(self->node_index_, true),
+                                   0,
+                                   static_cast<std::uint8_t>(couchbase::protocol::datatype::json) });
+            self->enqueue(std::move(packet));
+        });
+    }
+
+  private:
+    static std::vector<std::uint8_t> encode(std::uint8_t magic,
+                                            std::uint8_t opcode,
+                                            std::uint16_t status_code,
+                                            const std::array<std::uint8_t, 4>& opaque,
+                                            const kv_response& response)
+    {
+        std::size_t body_size = response.extras.size() + response.key.size() + response.value.size();
+        std::vector<std::uint8_t> packet(24 + body_size);
+        packet[0] = magic;
+        packet[1] = opcode;
+        std::uint16_t key_size = htons(static_cast<std::uint16_t>(response.key.size()));
+        std::memcpy(packet.data() + 2, &key_size, sizeof(key_size));
+        packet[4] = static_cast<std::uint8_t>(response.extras.size());
+        packet[5] = response.datatype;
+        std::uint16_t status_field = htons(status_code);
+        std::memcpy(packet.data() + 6, &status_field, sizeof(status_field));
+        std::uint32_t body_field = htonl(static_cast<std::uint32_t>(body_size));
+        std::memcpy(packet.data() + 8, &body_field, sizeof(body_field));
+        std::memcpy(packet.data() + 12, opaque.data(), opaque.size());
+        std::uint64_t cas = couchbase::utils::byte_swap_64(response.cas);
+        std::memcpy(packet.data() + 16, &cas, sizeof(cas));
+        auto* out = packet.data() + 24;
+        std::memcpy(out, response.extras.data(), response.extras.size());
+        out += response.extras.size();
+        std::memcpy(out, response.key.data(), response.key.size());
+        out += response.key.size();
+        std::memcpy(out, response.value.data(), response.value.size());
+        return packet;
+    }
+
+    [[nodiscard]] bool supports(hello_feature feature) const
+    {
+        return std::find(features_.begin(), features_.end(), feature) != features_.end();
+    }
+
+    void read_header()
+    {
+        asio::async_read(socket_, asio::buffer(header_), [self = shared_from_this()](std::error_code ec, std::size_t /* bytes */) {
+            if (ec) {
+                return;
+            }
+            std::uint32_t body_size = 0;
+            std::memcpy(&body_size, self->header_.data() + 8, sizeof(body_size));
+            self->body_.resize(ntohl(body_size));
+            self->read_body();
+        });
+    }
+
+    void read_body()
+    {
+        asio::async_read(socket_, asio::buffer(body_), [self = shared_from_this()](std::error_code ec, std::size_t /* bytes */) {
+            if (ec) {
+                return;
+            }
+            self->dispatch(self->parse());
+            self->read_header();
+        });
+    }
+
+    [[nodiscard]] kv_request parse() const
+    {
+        kv_request req{};
+        req.magic = header_[0];
+        req.opcode = static_cast<client_opcode>(header_[1]);
+        std::size_t framing_extras_size = 0;
+        std::size_t key_size = 0;
+        if (req.magic == static_cast<std::uint8_t>(couchbase::protocol::magic::alt_client_request)) {
+            framing_extras_size = header_[2];
+            key_size = header_[3];
+        } else {
+            std::uint16_t field = 0;
+            std::memcpy(&field, header_.data() + 2, sizeof(field));
+            key_size = ntohs(field);
+        }
+        std::size_t extras_size = header_[4];
+        req.datatype = header_[5];
+        std::uint16_t vbucket = 0;
+        std::memcpy(&vbucket, header_.data() + 6, sizeof(vbucket));
+        req.vbucket = ntohs(vbucket);
+        std::memcpy(req.opaque.data(), header_.data() + 12, req.opaque.size());
+        std::uint64_t cas = 0;
+        std::memcpy(&cas, header_.data() + 16, sizeof(cas));
+        req.cas = couchbase::utils::byte_swap_64(cas);
+        auto* data = reinterpret_cast<const char*>(body_.data()) + framing_extras_size;
+        req.extras.assign(data, extras_size);
+        req.key.assign(data + extras_size, key_size);
+        req.value.assign(data + extras_size + key_size, body_.size() - framing_extras_size - extras_size - key_size);
+        return req;
+    }
+
+    void dispatch(kv_request&& req)
+    {
+        state_->record_request(req.opcode);
+        if (req.opcode == client_opcode::dcp_buffer_acknowledgement) {
+            return; /* flow control messages do not have responses */
+        }
+        kv_response response = handle(req);
+        auto packet = encode(static_cast<std::uint8_t>(couchbase::protocol::magic::client_response),
+                             static_cast<std::uint8_t>(req.opcode),
+                             static_cast<std::uint16_t>(response.code),
+                             req.opaque,
+                             response);
+        if (req.opcode == client_opcode::dcp_stream_request && response.code == status::success) {
+            enqueue(std::move(packet));
+            return stream_partition(req);
+        }
+        auto latency = state_->latency(req.opcode);
+        if (latency.count() == 0) {
+            return enqueue(std::move(packet));
+        }
+        auto timer = std::make_shared<asio::steady_timer>(socket_.get_executor(), latency);
+        timer->async_wait([self = shared_from_this(), timer, packet = std::move(packet)](std::error_code ec) mutable {
+            if (ec == asio::error::operation_aborted) {
+                return;
+            }
+            self->enqueue(std::move(packet));
+        });
+    }
+
+    void enqueue(std::vector<std::uint8_t>&& packet)
+    {
+        output_.insert(output_.end(), packet.begin(), packet.end());
+        if (!writing_.empty()) {
+            return;
+        }
+        do_write();
+    }
+
+    void do_write()
+    {
+        std::swap(writing_, output_);
+        asio::async_write(socket_, asio::buffer(writing_), [self = shared_from_this()](std::error_code ec, std::size_t /* bytes */) {
+            self->writing_.clear();
+            if (ec) {
+                return;
+            }
+            if (!self->output_.empty()) {
+                self->do_write();
+            }
+        });
+    }
+
+    [[nodiscard]] std::string mutation_extras(std::uint16_t vbucket) const
+    {
+        if (!supports(hello_feature::mutation_seqno)) {
+            return {};
+        }
+        auto [partition_uuid, seqno] = state_->next_seqno(vbucket);
+        std::string extras(16, '\0');
+        std::uint64_t field = couchbase::utils::byte_swap_64(partition_uuid);
+        std::memcpy(extras.data(), &field, sizeof(field));
+        field = couchbase::utils::byte_swap_64(seqno);
+        std::memcpy(extras.data() + 8, &field, sizeof(field));
+        return extras;
+    }
+
+    static std::uint32_t read_uint32(const std::string& data, std::size_t offset)
+    {
+        std::uint32_t value = 0;
+        if (data.size() >= offset + sizeof(value)) {
+            std::memcpy(&value, data.data() + offset, sizeof(value));
+        }
+        return ntohl(value);
+    }
+
+    static std::uint64_t read_uint64(const std::string& data, std::size_t offset)
+    {
+        std::uint64_t value = 0;
+        if (data.size() >= offset + sizeof(value)) {
+            std::memcpy(&value, data.data() + offset, sizeof(value));
+        }
+        return couchbase::utils::byte_swap_64(value);
+    }
+
+    static std::optional<std::chrono::steady_clock::time_point> expiry_to_time_point(std::uint32_t expiry)
+    {
+        if (expiry == 0) {
+            return {};
+        }
+        static constexpr std::uint32_t relative_expiry_limit = 30 * 24 * 60 * 60;
+        if (expiry <= relative_expiry_limit) {
+            return std::chrono::steady_clock::now() + std::chrono::seconds(expiry);
+        }
+        auto now = std::chrono::system_clock::now();
+        auto absolute = std::chrono::system_clock::time_point(std::chrono::seconds(expiry));
+        return std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(absolute - now);
+    }
+
+    static std::string flags_extras(std::uint32_t flags)
+    {
+        std::string extras(4, '\0');
+        std::uint32_t field = htonl(flags);
+        std::memcpy(extras.data(), &field, sizeof(field));
+        return extras;
+    }
+
+    /**
+     * Expired documents are removed lazily, when they are accessed.
+     */
+    static std::map<std::string, document>::iterator find_document(std::map<std::string, document>& documents, const std::string& key)
+    {
+        auto it = documents.find(key);
+        if (it != documents.end() && it->second.expires_at && *it->second.expires_at <= std::chrono::steady_clock::now()) {
+            documents.erase(it);
+            return documents.end();
+        }
+        return it;
+    }
+
+    static bool is_locked(const document& doc, std::uint64_t cas)
+    {
+        return doc.locked_until && *doc.locked_until > std::chrono::steady_clock::now() && doc.cas != cas;
+    }
+
+    kv_response handle(const kv_request& req)
+    {
+        switch (req.opcode) {
+            case client_opcode::hello:
+                return handle_hello(req);
+            case client_opcode::sasl_list_mechs:
+                return { status::success, {}, {}, sasl_server::mechanisms() };
+            case client_opcode::sasl_auth:
+            case client_opcode::sasl_step:
+                return handle_sasl(req);
+            case client_opcode::noop:
+                return {};
+            default:
+                break;
+        }
+        if (!authenticated_) {
+            return { status::auth_error };
+        }
+        if (auto injected = state_->take_injected_status(req.opcode); injected) {
+            return { *injected };
+        }
+        switch (req.opcode) {
+            case client_opcode::select_bucket:
+                if (req.key != state_->options().bucket) {
+                    return { status::no_access };
+                }
+                bucket_selected_ = true;
+                return {};
+            case client_opcode::get_cluster_config:
+                return { status::success,
+                         {},
+                         {},
+                         state_->configuration(node_index_, bucket_selected_),
+                         0,
+                         static_cast<std::uint8_t>(couchbase::protocol::datatype::json) };
+            default:
+                break;
+        }
+        if (!bucket_selected_) {
+            return { status::no_bucket };
+        }
+        switch (req.opcode) {
+            case client_opcode::dcp_open:
+            case client_opcode::dcp_control:
+                return {};
+            default:
+                break;
+        }
+        if (req.opcode != client_opcode::observe && (state_->take_not_my_vbucket() || !state_->owns_vbucket(node_index_, req.vbucket))) {
+            return { status::not_my_vbucket,
+                     {},
+                     {},
+                     state_->configuration(node_index_, true),
+                     0,
+                     static_cast<std::uint8_t>(couchbase::protocol::datatype::json) };
+        }
+        switch (req.opcode) {
+            case client_opcode::get:
+            case client_opcode::get_and_touch:
+            case client_opcode::get_and_lock:
+                return handle_get(req);
+            case client_opcode::upsert:
+            case client_opcode::insert:
+            case client_opcode::replace:
+            case client_opcode::append:
+            case client_opcode::prepend:
+                return handle_store(req);
+            case client_opcode::remove:
+                return handle_remove(req);
+            case client_opcode::touch:
+                return handle_touch(req);
+            case client_opcode::unlock:
+                return handle_unlock(req);
+            case client_opcode::increment:
+            case client_opcode::decrement:
+                return handle_arithmetic(req);
+            case client_opcode::observe:
+                return handle_observe(req);
+            case client_opcode::subdoc_multi_lookup:
+                return handle_lookup_in(req);
+            case client_opcode::subdoc_multi_mutation:
+                return handle_mutate_in(req);
+            case client_opcode::dcp_stream_request:
+                return handle_stream_request(req);
+            default:
+                break;
+        }
+        return { status::unknown_command };
+    }
+
+    kv_response handle_hello(const kv_request& req)
+    {
+        static const std::vector<hello_feature> known_features{
+            hello_feature::tcp_nodelay,
+            hello_feature::mutation_seqno,
+            hello_feature::xattr,
+            hello_feature::select_bucket,
+            hello_feature::json,
+            hello_feature::duplex,
+            hello_feature::unordered_execution,
+            hello_feature::alt_request_support,
+            hello_feature::sync_replication,
+            hello_feature::clustermap_change_notification,
+        };
+        features_.clear();
+        kv_response response{};
+        for (std::size_t offset = 0; offset + 1 < req.value.size(); offset += 2) {
+            auto feature = static_cast<hello_feature>((static_cast<std::uint8_t>(req.value[offset]) << 8U) |
+                                                      static_cast<std::uint8_t>(req.value[offset + 1]));
+            if (std::find(known_features.begin(), known_features.end(), feature) != known_features.end() ||
+                (feature == hello_feature::collections && state_->options().collections)) {
+                features_.emplace_back(feature);
+                response.value.push_back(req.value[offset]);
+                response.value.push_back(req.value[offset + 1]);
+            }
+        }
+        return response;
+    }
+
+    kv_response handle_sasl(const kv_request& req)
+    {
+        std::string output{};
+        auto result = req.opcode == client_opcode::sasl_auth ? sasl_.start(req.key, req.value, output) : sasl_.step(req.value, output);
+        switch (result) {
+            case sasl_server::state::success:
+                authenticated_ = true;
+                return { status::success, {}, {}, output };
+            case sasl_server::state::in_progress:
+                return { status::auth_continue, {}, {}, output };
+            case sasl_server::state::failure:
+                break;
+        }
+        return { status::auth_error };
+    }
+
+    kv_response handle_get(const kv_request& req)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it == documents.end()) {
+                return { status::not_found };
+            }
+            auto& doc = it->second;
+            if (req.opcode == client_opcode::get_and_touch) {
+                doc.expires_at = expiry_to_time_point(read_uint32(req.extras, 0));
+            } else if (req.opcode == client_opcode::get_and_lock) {
+                if (is_locked(doc, 0)) {
+                    return { status::locked };
+                }
+                auto lock_time = read_uint32(req.extras, 0);
+                doc.locked_until = std::chrono::steady_clock::now() + std::chrono::seconds(lock_time == 0 ? 15 : lock_time);
+                doc.cas = state_->next_cas();
+            }
+            return { status::success, flags_extras(doc.flags), {}, doc.value, doc.cas, doc.datatype };
+        });
+    }
+
+    kv_response handle_store(const kv_request& req)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it != documents.end() && is_locked(it->second, req.cas)) {
+                return { status::locked };
+            }
+            switch (req.opcode) {
+                case client_opcode::insert:
+                    if (it != documents.end()) {
+                        return { status::exists };
+                    }
+                    break;
+                case client_opcode::replace:
+                case client_opcode::append:
+                case client_opcode::prepend:
+                    if (it == documents.end()) {
+                        return { req.opcode == client_opcode::replace ? status::not_found : status::not_stored };
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (req.cas != 0) {
+                if (it == documents.end()) {
+                    return { status::not_found };
+                }
+                if (it->second.cas != req.cas) {
+                    return { status::exists };
+                }
+            }
+            auto& doc = documents[req.key];
+            if (req.opcode == client_opcode::append) {
+                doc.value += req.value;
+            } else if (req.opcode == client_opcode::prepend) {
+                doc.value.insert(0, req.value);
+            } else {
+                doc.value = req.value;
+                doc.flags = read_uint32(req.extras, 0);
+                doc.datatype = req.datatype;
+                doc.expires_at = expiry_to_time_point(read_uint32(req.extras, 4));
+            }
+            doc.locked_until.reset();
+            doc.cas = state_->next_cas();
+            return { status::success, mutation_extras(req.vbucket), {}, {}, doc.cas };
+        });
+    }
+
+    kv_response handle_remove(const kv_request& req)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it == documents.end()) {
+                return { status::not_found };
+            }
+            if (is_locked(it->second, req.cas)) {
+                return { status::locked };
+            }
+            if (req.cas != 0 && it->second.cas != req.cas) {
+                return { status::exists };
+            }
+            documents.erase(it);
+            return { status::success, mutation_extras(req.vbucket), {}, {}, state_->next_cas() };
+        });
+    }
+
+    kv_response handle_touch(const kv_request& req)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it == documents.end()) {
+                return { status::not_found };
+            }
+            if (is_locked(it->second, 0)) {
+                return { status::locked };
+            }
+            it->second.expires_at = expiry_to_time_point(read_uint32(req.extras, 0));
+            it->second.cas = state_->next_cas();
+            return { status::success, {}, {}, {}, it->second.cas };
+        });
+    }
+
+    kv_response handle_unlock(const kv_request& req)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it == documents.end()) {
+                return { status::not_found };
+            }
+            auto& doc = it->second;
+            if (!doc.locked_until || *doc.locked_until <= std::chrono::steady_clock::now()) {
+                return { status::temporary_failure };
+            }
+            if (doc.cas != req.cas) {
+                return { status::locked };
+            }
+            doc.locked_until.reset();
+            return { status::success, {}, {}, {}, doc.cas };
+        });
+    }
+
+    kv_response handle_arithmetic(const kv_request& req)
+    {
+        auto delta = read_uint64(req.extras, 0);
+        auto initial = read_uint64(req.extras, 8);
+        auto expiry = read_uint32(req.extras, 16);
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            std::uint64_t counter = initial;
+            if (it == documents.end()) {
+                if (expiry == 0xffff'ffffU) {
+                    return { status::not_found };
+                }
+                it = documents.emplace(req.key, document{}).first;
+                it->second.expires_at = expiry_to_time_point(expiry);
+            } else {
+                if (is_locked(it->second, req.cas)) {
+                    return { status::locked };
+                }
+                try {
+                    std::size_t parsed = 0;
+                    counter = std::stoull(it->second.value, &parsed);
+                    if (parsed != it->second.value.size()) {
+                        return { status::delta_bad_value };
+                    }
+                } catch (const std::exception&) {
+                    return { status::delta_bad_value };
+                }
+                if (req.opcode == client_opcode::increment) {
+                    counter += delta;
+                } else {
+                    counter = counter > delta ? counter - delta : 0;
+                }
+            }
+            auto& doc = it->second;
+            doc.value = std::to_string(counter);
+            doc.datatype = static_cast<std::uint8_t>(couchbase::protocol::datatype::json);
+            doc.cas = state_->next_cas();
+            std::string value(8, '\0');
+            std::uint64_t field = couchbase::utils::byte_swap_64(counter);
+            std::memcpy(value.data(), &field, sizeof(field));
+            return { status::success, mutation_extras(req.vbucket), {}, value, doc.cas };
+        });
+    }
+
+    kv_response handle_observe(const kv_request& req)
+    {
+        // vbucket (2 bytes), key length (2 bytes), key
+        if (req.value.size() < 4) {
+            return { status::invalid };
+        }
+        std::uint16_t key_size = 0;
+        std::memcpy(&key_size, req.value.data() + 2, sizeof(key_size));
+        auto key = req.value.substr(4, ntohs(key_size));
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            kv_response response{};
+            response.value = req.value.substr(0, 4 + key.size());
+            auto it = find_document(documents, key);
+            std::uint64_t cas = 0;
+            if (it == documents.end()) {
+                response.value.push_back(static_cast<char>(0x80)); // not found
+            } else {
+                response.value.push_back(static_cast<char>(0x01)); // found, persisted
+                cas = it->second.cas;
+            }
+            std::string cas_field(8, '\0');
+            std::uint64_t field = couchbase::utils::byte_swap_64(cas);
+            std::memcpy(cas_field.data(), &field, sizeof(field));
+            response.value += cas_field;
+            return response;
+        });
+    }
+
+    static tao::json::value virtual_document(const document& doc)
+    {
+        tao::json::value vattr{
+            { "CAS", fmt::format("0x{:016x}", doc.cas) },
+            { "exptime", 0 },
+            { "value_bytes", doc.value.size() },
+            { "flags", doc.flags },
+            { "deleted", false },
+            { "datatype", tao::json::value::array({ couchbase::protocol::has_json_datatype(doc.datatype) ? "json" : "raw" }) },
+        };
+        return { { "$document", std::move(vattr) } };
+    }
+
+    static void append_lookup_entry(std::string& out, status code, const std::string& value)
+    {
+        std::uint16_t status_field = htons(static_cast<std::uint16_t>(code));
+        std::uint32_t size_field = htonl(static_cast<std::uint32_t>(value.size()));
+        out.append(reinterpret_cast<const char*>(&status_field), sizeof(status_field));
+        out.append(reinterpret_cast<const char*>(&size_field), sizeof(size_field));
+        out.append(value);
+    }
+
+    kv_response handle_lookup_in(const kv_request& req)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it == documents.end()) {
+                return { status::not_found };
+            }
+            const auto& doc = it->second;
+            std::optional<tao::json::value> body{};
+            try {
+                body = tao::json::from_string(doc.value);
+            } catch (const std::exception&) {
+                body.reset();
+            }
+            kv_response response{};
+            response.cas = doc.cas;
+            bool failed = false;
+            std::size_t offset = 0;
+            std::size_t num_of_specs = 0;
+            // opcode (1 byte), flags (1 byte), path length (2 bytes), path
+            while (offset + 4 <= req.value.size()) {
+                auto opcode = static_cast<std::uint8_t>(req.value[offset]);
+                auto flags = static_cast<std::uint8_t>(req.value[offset + 1]);
+                std::uint16_t path_size = 0;
+                std::memcpy(&path_size, req.value.data() + offset + 2, sizeof(path_size));
+                auto path = req.value.substr(offset + 4, ntohs(path_size));
+                offset += 4 + path.size();
+
+                subdoc::lookup_result result{};
+                if ((flags & 0b0000'0100U) != 0) {
+                    auto root = path.rfind("$document", 0) == 0 ? virtual_document(doc) : doc.xattrs;
+                    result = subdoc::lookup(opcode, path, root);
+                } else if (!body) {
+                    result = { status::subdoc_doc_not_json };
+                } else if (static_cast<subdoc::subdoc_opcode>(opcode) == subdoc::subdoc_opcode::get_doc) {
+                    result = { status::success, doc.value };
+                } else {
+                    result = subdoc::lookup(opcode, path, *body);
+                }
+                failed = failed || result.code != status::success;
+                append_lookup_entry(response.value, result.code, result.value);
+                ++num_of_specs;
+            }
+            if (num_of_specs > 16) {
+                return { status::subdoc_invalid_combo };
+            }
+            if (failed) {
+                response.code = status::subdoc_multi_path_failure;
+            }
+            return response;
+        });
+    }
+
+    kv_response handle_mutate_in(const kv_request& req)
+    {
+        std::uint32_t expiry = 0;
+        std::uint8_t doc_flags = 0;
+        if (req.extras.size() == 1) {
+            doc_flags = static_cast<std::uint8_t>(req.extras[0]);
+        } else if (req.extras.size() >= 4) {
+            expiry = read_uint32(req.extras, 0);
+            if (req.extras.size() == 5) {
+                doc_flags = static_cast<std::uint8_t>(req.extras[4]);
+            }
+        }
+        bool mkdoc = (doc_flags & 0b0000'0001U) != 0;
+        bool add = (doc_flags & 0b0000'0010U) != 0;
+        return state_->with_documents([&](std::map<std::string, document>& documents) -> kv_response {
+            auto it = find_document(documents, req.key);
+            if (it == documents.end()) {
+                if (!mkdoc && !add) {
+                    return { status::not_found };
+                }
+                if (req.cas != 0) {
+                    return { status::not_found };
+                }
+            } else {
+                if (add) {
+                    return { status::exists };
+                }
+                if (is_locked(it->second, req.cas)) {
+                    return { status::locked };
+                }
+                if (req.cas != 0 && it->second.cas != req.cas) {
+                    return { status::exists };
+                }
+            }
+            document doc = it == documents.end() ? document{ "{}" } : it->second;
+            tao::json::value body{};
+            try {
+                body = tao::json::from_string(doc.value);
+            } catch (const std::exception&) {
+                return { status::subdoc_doc_not_json };
+            }
+            auto new_cas = state_->next_cas();
+            bool remove_document = false;
+            kv_response response{};
+            std::size_t offset = 0;
+            std::uint8_t index = 0;
+            // opcode (1 byte), flags (1 byte), path length (2 bytes), value length (4 bytes), path, value
+            while (offset + 8 <= req.value.size()) {
+                auto opcode = static_cast<std::uint8_t>(req.value[offset]);
+                auto flags = static_cast<std::uint8_t>(req.value[offset + 1]);
+                std::uint16_t path_size = 0;
+                std::memcpy(&path_size, req.value.data() + offset + 2, sizeof(path_size));
+                path_size = ntohs(path_size);
+                auto param_size = read_uint32(req.value, offset + 4);
+                auto path = req.value.substr(offset + 8, path_size);
+                auto param = req.value.substr(offset + 8 + path_size, param_size);
+                offset += 8 + path_size + param_size;
+
+                bool create_parents = (flags & 0b0000'0001U) != 0 || mkdoc || add;
+                subdoc::mutation_result result{};
+                switch (static_cast<subdoc::subdoc_opcode>(opcode)) {
+                    case subdoc::subdoc_opcode::set_doc:
+                        try {
+                            body = tao::json::from_string(param);
+                        } catch (const std::exception&) {
+                            result = { status::subdoc_value_cannot_insert };
+                        }
+                        break;
+                    case subdoc::subdoc_opcode::remove_doc:
+                        remove_document = true;
+                        break;
+                    default:
+                        if ((flags & 0b0000'0100U) != 0) {
+                            if ((flags & 0b0001'0000U) != 0) {
+                                if (param == R"("${Mutation.CAS}")") {
+                                    param = fmt::format(R"("0x{:016x}")", new_cas);
+                                } else if (param == R"("${Mutation.value_crc32c}")") {
+                                    param = R"("0x00000000")";
+                                }
+                            }
+                            result = subdoc::mutate(opcode, create_parents, path, param, doc.xattrs);
+                        } else {
+                            result = subdoc::mutate(opcode, create_parents, path, param, body);
+                        }
+                        break;
+                }
+                if (result.code != status::success) {
+                    response.code = status::subdoc_multi_path_failure;
+                    response.value.push_back(static_cast<char>(index));
+                    std::uint16_t status_field = htons(static_cast<std::uint16_t>(result.code));
+                    response.value.append(reinterpret_cast<const char*>(&status_field), sizeof(status_field));
+                    return response;
+                }
+                if (result.value) {
+                    response.value.push_back(static_cast<char>(index));
+                    append_lookup_entry(response.value, status::success, *result.value);
+                }
+                ++index;
+            }
+            if (remove_document) {
+                documents.erase(req.key);
+            } else {
+                doc.value = tao::json::to_string(body);
+                doc.datatype = static_cast<std::uint8_t>(couchbase::protocol::datatype::json);
+                doc.cas = new_cas;
+                doc.locked_until.reset();
+                if (expiry != 0) {
+                    doc.expires_at = expiry_to_time_point(expiry);
+                }
+                documents[req.key] = std::move(doc);
+            }
+            response.cas = new_cas;
+            response.extras = mutation_extras(req.vbucket);
+            return response;
+        });
+    }
+
+    [[nodiscard]] static std::uint64_t partition_uuid(std::uint16_t vbucket)
+    {
+        return 0xcafe'0000ULL + vbucket;
+    }
+
+    /**
+     * Documents of the vBucket ordered by CAS, the position in this list is used as the sequence number.
+     */
+    [[nodiscard]] std::vector<std::pair<std::string, document>> partition_documents(std::uint16_t vbucket)
+    {
+        return state_->with_documents([&](std::map<std::string, document>& documents) {
+            std::vector<std::pair<std::string, document>> res;
+            for (const auto& [key, doc] : documents) {
+                if (couchbase::utils::hash_crc32(key.data(), key.size()) % state_->options().number_of_vbuckets == vbucket) {
+                    res.emplace_back(key, doc);
+                }
+            }
+            std::sort(res.begin(), res.end(), [](const auto& a, const auto& b) { return a.second.cas < b.second.cas; });
+            return res;
+        });
+    }
+
+    /**
+     * The history of every vBucket has single partition UUID, the stream with unknown UUID is rolled back to zero.
+     */
+    kv_response handle_stream_request(const kv_request& req)
+    {
+        auto start_seqno = read_uint64(req.extras, 8);
+        auto uuid = read_uint64(req.extras, 24);
+        if (start_seqno > 0 && uuid != partition_uuid(req.vbucket)) {
+            return { status::rollback, {}, {}, std::string(sizeof(std::uint64_t), '\0') };
+        }
+        std::string failover_log(2 * sizeof(std::uint64_t), '\0');
+        std::uint64_t field = couchbase::utils::byte_swap_64(partition_uuid(req.vbucket));
+        std::memcpy(failover_log.data(), &field, sizeof(field));
+        return { status::success, {}, {}, failover_log };
+    }
+
+    /**
+     * Sends the documents of the vBucket between start and end seqno in one snapshot. Unlike the server, ends the stream right away
+     * if the end seqno is not infinite, even if the vBucket does not have that many mutations yet.
+     */
+    void stream_partition(const kv_request& req)
+    {
+        auto start_seqno = read_uint64(req.extras, 8);
+        auto end_seqno = read_uint64(req.extras, 16);
+        auto documents = partition_documents(req.vbucket);
+        auto last_seqno = std::min<std::uint64_t>(documents.size(), end_seqno);
+        auto send = [this, &req](client_opcode opcode, kv_response message) {
+            enqueue(encode(static_cast<std::uint8_t>(couchbase::protocol::magic::client_request),
+                           static_cast<std::uint8_t>(opcode),
+                           req.vbucket,
+                           req.opaque,
+                           message));
+        };
+        if (start_seqno < last_seqno) {
+            std::string extras(2 * sizeof(std::uint64_t) + sizeof(std::uint32_t), '\0');
+            std::uint64_t field = couchbase::utils::byte_swap_64(start_seqno + 1);
+            std::memcpy(extras.data(), &field, sizeof(field));
+            field = couchbase::utils::byte_swap_64(last_seqno);
+            std::memcpy(extras.data() + 8, &field, sizeof(field));
+            send(client_opcode::dcp_snapshot_marker, { status::success, extras });
+        }
+        for (std::uint64_t seqno = start_seqno + 1; seqno <= last_seqno; ++seqno) {
+            const auto& [key, doc] = documents[seqno - 1];
+            /* by_seqno, rev_seqno, flags, expiry, lock time, extended metadata size and NRU */
+            std::string extras(2 * sizeof(std::uint64_t) + 3 * sizeof(std::uint32_t) + sizeof(std::uint16_t) + 1, '\0');
+            std::uint64_t field = couchbase::utils::byte_swap_64(seqno);
+            std::memcpy(extras.data(), &field, sizeof(field));
+            field = couchbase::utils::byte_swap_64(1);
+            std::memcpy(extras.data() + 8, &field, sizeof(field));
+            std::uint32_t flags = htonl(doc.flags);
+            std::memcpy(extras.data() + 16, &flags, sizeof(flags));
+            std::string encoded_key = supports(hello_feature::collections) ? std::string(1, '\0') + key : key;
+            send(client_opcode::dcp_mutation, { status::success, extras, encoded_key, doc.value, doc.cas, doc.datatype });
+        }
+        if (end_seqno != std::numeric_limits<std::uint64_t>::max()) {
+            send(client_opcode::dcp_stream_end, { status::success, std::string(sizeof(std::uint32_t), '\0') });
+        }
+    }
+
+    asio::ip::tcp::socket socket_;
+    std::shared_ptr<cluster_state> state_;
+    const std::size_t node_index_;
+    sasl_server sasl_;
+    std::array<std::uint8_t, 24> header_{};
+    std::vector<std::uint8_t> body_{};
+    std::vector<std::uint8_t> output_{};
+    std::vector<std::uint8_t> writing_{};
+    std::vector<hello_feature> features_{};
+    bool authenticated_{ false };
+    bool bucket_selected_{ false };
+};
+} // namespace mock
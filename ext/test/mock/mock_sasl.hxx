@@ -0,0 +1,152 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <cbcrypto/cbcrypto.h>
+#include <platform/base64.h>
+
+namespace mock
+{
+/**
+ * Server side of SASL authentication. Supports PLAIN and SCRAM-SHA{1,256,512}.
+ */
+class sasl_server
+{
+  public:
+    enum class state { in_progress, success, failure };
+
+    sasl_server(std::string username, std::string password)
+      : username_(std::move(username))
+      , password_(std::move(password))
+    {
+    }
+
+    static std::string mechanisms()
+    {
+        return "SCRAM-SHA512 SCRAM-SHA256 SCRAM-SHA1 PLAIN";
+    }
+
+    /**
+     * Handles SASL_AUTH payload. On in_progress the challenge is stored into the output.
+     */
+    state start(std::string_view mechanism, std::string_view payload, std::string& output)
+    {
+        if (mechanism == "PLAIN") {
+            // [authzid] NUL authcid NUL passwd
+            auto first = payload.find('\0');
+            if (first == std::string_view::npos) {
+                return state::failure;
+            }
+            auto second = payload.find('\0', first + 1);
+            if (second == std::string_view::npos) {
+                return state::failure;
+            }
+            if (payload.substr(first + 1, second - first - 1) == username_ && payload.substr(second + 1) == password_) {
+                return state::success;
+            }
+            return state::failure;
+        }
+        if (mechanism == "SCRAM-SHA512") {
+            algorithm_ = couchbase::crypto::Algorithm::SHA512;
+        } else if (mechanism == "SCRAM-SHA256") {
+            algorithm_ = couchbase::crypto::Algorithm::SHA256;
+        } else if (mechanism == "SCRAM-SHA1") {
+            algorithm_ = couchbase::crypto::Algorithm::SHA1;
+        } else {
+            return state::failure;
+        }
+        // n,,n=user,r=nonce
+        if (payload.substr(0, 3) != "n,,") {
+            return state::failure;
+        }
+        client_first_bare_ = std::string(payload.substr(3));
+        auto user = attribute(client_first_bare_, 'n');
+        auto nonce = attribute(client_first_bare_, 'r');
+        if (user != username_ || nonce.empty()) {
+            return state::failure;
+        }
+        nonce_ = nonce + "6d6f636b";
+        salted_password_ = couchbase::crypto::PBKDF2_HMAC(algorithm_, password_, salt, iterations);
+        server_first_ = fmt::format("r={},s={},i={}", nonce_, couchbase::base64::encode(salt), iterations);
+        output = server_first_;
+        return state::in_progress;
+    }
+
+    /**
+     * Handles SASL_STEP payload (client-final-message) and verifies the proof.
+     */
+    state step(std::string_view payload, std::string& output)
+    {
+        std::string client_final(payload);
+        auto proof_pos = client_final.find(",p=");
+        if (server_first_.empty() || proof_pos == std::string::npos || attribute(client_final, 'r') != nonce_) {
+            return state::failure;
+        }
+        auto proof = couchbase::base64::decode(client_final.substr(proof_pos + 3));
+        auto auth_message = client_first_bare_ + "," + server_first_ + "," + client_final.substr(0, proof_pos);
+
+        auto client_key = couchbase::crypto::HMAC(algorithm_, salted_password_, "Client Key");
+        auto stored_key = couchbase::crypto::digest(algorithm_, client_key);
+        auto client_signature = couchbase::crypto::HMAC(algorithm_, stored_key, auth_message);
+        if (proof.size() != client_signature.size()) {
+            return state::failure;
+        }
+        std::string recovered_key(proof.size(), '\0');
+        for (std::size_t i = 0; i < proof.size(); ++i) {
+            recovered_key[i] = static_cast<char>(proof[i] ^ client_signature[i]);
+        }
+        if (couchbase::crypto::digest(algorithm_, recovered_key) != stored_key) {
+            return state::failure;
+        }
+        auto server_key = couchbase::crypto::HMAC(algorithm_, salted_password_, "Server Key");
+        output = "v=" + couchbase::base64::encode(couchbase::crypto::HMAC(algorithm_, server_key, auth_message));
+        return state::success;
+    }
+
+  private:
+    static constexpr const char* salt = "mock-salt";
+    static constexpr unsigned int iterations = 4096;
+
+    static std::string attribute(const std::string& message, char key)
+    {
+        std::size_t pos = 0;
+        while (pos < message.size()) {
+            auto end = message.find(',', pos);
+            if (end == std::string::npos) {
+                end = message.size();
+            }
+            if (end - pos >= 2 && message[pos] == key && message[pos + 1] == '=') {
+                return message.substr(pos + 2, end - pos - 2);
+            }
+            pos = end + 1;
+        }
+        return {};
+    }
+
+    std::string username_;
+    std::string password_;
+    couchbase::crypto::Algorithm algorithm_{ couchbase::crypto::Algorithm::SHA512 };
+    std::string client_first_bare_{};
+    std::string server_first_{};
+    std::string nonce_{};
+    std::string salted_password_{};
+};
+} // namespace mock
@@ -0,0 +1,321 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <tao/json.hpp>
+
+#include <protocol/client_opcode.hxx>
+#include <protocol/status.hxx>
+
+namespace mock
+{
+struct mock_options {
+    std::size_t number_of_nodes{ 1 };
+    std::size_t number_of_vbuckets{ 64 };
+    std::string bucket{ "default" };
+    std::string username{ "Administrator" };
+    std::string password{ "password" };
+
+    /**
+     * Negotiate collections in HELLO. The mock does not resolve collection IDs of KV requests, only DCP keys get the prefix of the
+     * default collection.
+     */
+    bool collections{ false };
+};
+
+struct document {
+    std::string value{};
+    std::uint32_t flags{ 0 };
+    std::uint8_t datatype{ 0 };
+    std::uint64_t cas{ 0 };
+    std::optional<std::chrono::steady_clock::time_point> expires_at{};
+    std::optional<std::chrono::steady_clock::time_point> locked_until{};
+    tao::json::value xattrs{ tao::json::empty_object };
+};
+
+struct query_result {
+    std::vector<tao::json::value> rows{};
+    std::optional<std::pair<std::uint64_t, std::string>> error{};
+};
+
+using query_handler = std::function<query_result(const tao::json::value& request)>;
+
+/**
+ * Shared state of the mock cluster: documents, vBucket map and injected faults.
+ *
+ * Accessed from the mock IO thread and from the test thread, so every method takes the lock. The lock is recursive, because
+ * document handlers allocate CAS and sequence numbers while holding it.
+ */
+class cluster_state
+{
+  public:
+    explicit cluster_state(mock_options options)
+      : options_(std::move(options))
+      , seqnos_(options_.number_of_vbuckets, 0)
+    {
+        vbmap_.resize(options_.number_of_vbuckets);
+        for (std::size_t vbid = 0; vbid < vbmap_.size(); ++vbid) {
+            vbmap_[vbid] = vbid % options_.number_of_nodes;
+        }
+    }
+
+    [[nodiscard]] const mock_options& options() const
+    {
+        return options_;
+    }
+
+    void set_ports(std::vector<std::pair<std::uint16_t, std::uint16_t>> ports)
+    {
+        std::scoped_lock lock(mutex_);
+        ports_ = std::move(ports);
+    }
+
+    [[nodiscard]] std::uint64_t revision() const
+    {
+        std::scoped_lock lock(mutex_);
+        return revision_;
+    }
+
+    [[nodiscard]] bool owns_vbucket(std::size_t node_index, std::uint16_t vbid) const
+    {
+        std::scoped_lock lock(mutex_);
+        return vbid < vbmap_.size() && vbmap_[vbid] == node_index;
+    }
+
+    /**
+     * Moves every vBucket to the next node and bumps configuration revision.
+     */
+    void rebalance()
+    {
+        std::scoped_lock lock(mutex_);
+        for (auto& owner : vbmap_) {
+            owner = (owner + 1) % options_.number_of_nodes;
+        }
+        ++revision_;
+    }
+
+    void bump_revision()
+    {
+        std::scoped_lock lock(mutex_);
+        ++revision_;
+    }
+
+    [[nodiscard]] std::string configuration(std::size_t node_index, bool with_bucket) const
+    {
+        std::scoped_lock lock(mutex_);
+        tao::json::value nodes_ext = tao::json::empty_array;
+        tao::json::value server_list = tao::json::empty_array;
+        for (std::size_t idx = 0; idx < ports_.size(); ++idx) {
+            tao::json::value node{
+                { "hostname", "127.0.0.1" },
+                { "services",
+                  {
+                    { "kv", ports_[idx].first },
+                    { "mgmt", ports_[idx].second },
+                    { "n1ql", ports_[idx].second },
+                  } },
+            };
+            if (idx == node_index) {
+                node["thisNode"] = true;
+            }
+            nodes_ext.get_array().emplace_back(std::move(node));
+            server_list.get_array().emplace_back(fmt::format("127.0.0.1:{}", ports_[idx].first));
+        }
+        tao::json::value config{
+            { "rev", revision_ },
+            { "nodesExt", std::move(nodes_ext) },
+            { "clusterCapabilitiesVer", tao::json::value::array({ 1, 0 }) },
+            { "clusterCapabilities", { { "n1ql", tao::json::value::array({ "enhancedPreparedStatements" }) } } },
+        };
+        if (with_bucket) {
+            tao::json::value map = tao::json::empty_array;
+            for (auto owner : vbmap_) {
+                map.get_array().emplace_back(tao::json::value::array({ static_cast<std::int64_t>(owner) }));
+            }
+            config["name"] = options_.bucket;
+            config["uuid"] = "6c6f3b6e2bd25a8f5c1f2a6a3e1b5d9c";
+            config["nodeLocator"] = "vbucket";
+            config["bucketCapabilitiesVer"] = "";
+            config["bucketCapabilities"] = tao::json::value::array({ "couchapi", "dcp", "cbhello", "touch", "cccp", "xattr", "nodesExt" });
+            config["vBucketServerMap"] = tao::json::value{
+                { "hashAlgorithm", "CRC" },
+                { "numReplicas", 0 },
+                { "serverList", std::move(server_list) },
+                { "vBucketMap", std::move(map) },
+            };
+        }
+        return tao::json::to_string(config);
+    }
+
+    [[nodiscard]] std::uint64_t next_cas()
+    {
+        std::scoped_lock lock(mutex_);
+        return ++cas_;
+    }
+
+    /**
+     * @return partition UUID and sequence number for the next mutation in the vBucket
+     */
+    [[nodiscard]] std::pair<std::uint64_t, std::uint64_t> next_seqno(std::uint16_t vbid)
+    {
+        std::scoped_lock lock(mutex_);
+        return { 0xcafe'0000ULL + vbid, ++seqnos_[vbid % seqnos_.size()] };
+    }
+
+    /**
+     * Runs the function with the document map under the lock.
+     */
+    template<typename Function>
+    auto with_documents(Function&& fun)
+    {
+        std::scoped_lock lock(mutex_);
+        return fun(documents_);
+    }
+
+    void set_latency(std::chrono::milliseconds latency)
+    {
+        std::scoped_lock lock(mutex_);
+        latency_ = latency;
+    }
+
+    void set_latency(couchbase::protocol::client_opcode opcode, std::chrono::milliseconds latency)
+    {
+        std::scoped_lock lock(mutex_);
+        opcode_latency_[opcode] = latency;
+    }
+
+    [[nodiscard]] std::chrono::milliseconds latency(couchbase::protocol::client_opcode opcode) const
+    {
+        std::scoped_lock lock(mutex_);
+        if (auto it = opcode_latency_.find(opcode); it != opcode_latency_.end()) {
+            return it->second;
+        }
+        return latency_;
+    }
+
+    void inject_status(couchbase::protocol::client_opcode opcode, couchbase::protocol::status code, std::size_t count)
+    {
+        std::scoped_lock lock(mutex_);
+        injected_statuses_[opcode].emplace_back(code, count);
+    }
+
+    [[nodiscard]] std::optional<couchbase::protocol::status> take_injected_status(couchbase::protocol::client_opcode opcode)
+    {
+        std::scoped_lock lock(mutex_);
+        auto it = injected_statuses_.find(opcode);
+        if (it == injected_statuses_.end() || it->second.empty()) {
+            return {};
+        }
+        auto& [code, count] = it->second.front();
+        auto result = code;
+        if (--count == 0) {
+            it->second.erase(it->second.begin());
+        }
+        return result;
+    }
+
+    void inject_not_my_vbucket(std::size_t count)
+    {
+        std::scoped_lock lock(mutex_);
+        not_my_vbucket_ += count;
+    }
+
+    [[nodiscard]] bool take_not_my_vbucket()
+    {
+        std::scoped_lock lock(mutex_);
+        if (not_my_vbucket_ == 0) {
+            return false;
+        }
+        --not_my_vbucket_;
+        return true;
+    }
+
+    void record_request(couchbase::protocol::client_opcode opcode)
+    {
+        std::scoped_lock lock(mutex_);
+        ++requests_[opcode];
+    }
+
+    [[nodiscard]] std::size_t requests(couchbase::protocol::client_opcode opcode) const
+    {
+        std::scoped_lock lock(mutex_);
+        if (auto it = requests_.find(opcode); it != requests_.end()) {
+            return it->second;
+        }
+        return 0;
+    }
+
+    void set_query_handler(query_handler handler)
+    {
+        std::scoped_lock lock(mutex_);
+        query_handler_ = std::move(handler);
+    }
+
+    void set_query_latency(std::chrono::milliseconds latency)
+    {
+        std::scoped_lock lock(mutex_);
+        query_latency_ = latency;
+    }
+
+    [[nodiscard]] std::chrono::milliseconds query_latency() const
+    {
+        std::scoped_lock lock(mutex_);
+        return query_latency_;
+    }
+
+    [[nodiscard]] query_result execute_query(const tao::json::value& request) const
+    {
+        query_handler handler;
+        {
+            std::scoped_lock lock(mutex_);
+            handler = query_handler_;
+        }
+        if (handler) {
+            return handler(request);
+        }
+        return {};
+    }
+
+  private:
+    const mock_options options_;
+    mutable std::recursive_mutex mutex_{};
+    std::vector<std::pair<std::uint16_t, std::uint16_t>> ports_{};
+    std::vector<std::size_t> vbmap_{};
+    std::vector<std::uint64_t> seqnos_{};
+    std::uint64_t revision_{ 1 };
+    std::uint64_t cas_{ 0x1600'0000'0000'0000ULL };
+    std::map<std::string, document> documents_{};
+    std::chrono::milliseconds latency_{ 0 };
+    std::map<couchbase::protocol::client_opcode, std::chrono::milliseconds> opcode_latency_{};
+    std::map<couchbase::protocol::client_opcode, std::vector<std::pair<couchbase::protocol::status, std::size_t>>> injected_statuses_{};
+    std::size_t not_my_vbucket_{ 0 };
+    std::map<couchbase::protocol::client_opcode, std::size_t> requests_{};
+    query_handler query_handler_{};
+    std::chrono::milliseconds query_latency_{ 0 };
+};
+} // namespace mock
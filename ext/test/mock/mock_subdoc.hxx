@@ -0,0 +1,346 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <tao/json.hpp>
+
+#include <protocol/client_opcode.hxx>
+#include <protocol/status.hxx>
+
+namespace mock::subdoc
+{
+using couchbase::protocol::status;
+using couchbase::protocol::subdoc_opcode;
+
+struct path_token {
+    bool is_index{ false };
+    std::string key{};
+    std::int64_t index{ 0 };
+};
+
+/**
+ * Splits path like `a.b[2].c` or `` `dotted.key`.x `` into tokens.
+ */
+inline std::optional<std::vector<path_token>>
+parse_path(const std::string& path)
+{
+    std::vector<path_token> tokens;
+    std::size_t pos = 0;
+    while (pos < path.size()) {
+        if (path[pos] == '[') {
+            auto end = path.find(']', pos);
+            if (end == std::string::npos || end == pos + 1) {
+                return {};
+            }
+            path_token token{ true };
+            try {
+                token.index = std::stoll(path.substr(pos + 1, end - pos - 1));
+            } catch (const std::exception&) {
+                return {};
+            }
+            tokens.emplace_back(token);
+            pos = end + 1;
+            if (pos < path.size() && path[pos] == '.') {
+                ++pos;
+            }
+            continue;
+        }
+        path_token token{};
+        if (path[pos] == '`') {
+            auto end = path.find('`', pos + 1);
+            if (end == std::string::npos) {
+                return {};
+            }
+            token.key = path.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+        } else {
+            auto end = path.find_first_of(".[", pos);
+            if (end == std::string::npos) {
+                end = path.size();
+            }
+            token.key = path.substr(pos, end - pos);
+            pos = end;
+        }
+        if (token.key.empty()) {
+            return {};
+        }
+        tokens.emplace_back(token);
+        if (pos < path.size() && path[pos] == '.') {
+            ++pos;
+        }
+    }
+    return tokens;
+}
+
+/**
+ * Walks the tokens, optionally creating missing objects on the way.
+ */
+inline tao::json::value*
+resolve(tao::json::value& root, const std::vector<path_token>& tokens, std::size_t count, bool create_parents, status& error)
+{
+    tao::json::value* current = &root;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& token = tokens[i];
+        if (token.is_index) {
+            if (!current->is_array()) {
+                error = status::subdoc_path_mismatch;
+                return nullptr;
+            }
+            auto& array = current->get_array();
+            auto index = token.index < 0 ? static_cast<std::int64_t>(array.size()) + token.index : token.index;
+            if (index < 0 || static_cast<std::size_t>(index) >= array.size()) {
+                error = status::subdoc_path_not_found;
+                return nullptr;
+            }
+            current = &array[static_cast<std::size_t>(index)];
+        } else {
+            if (!current->is_object()) {
+                error = status::subdoc_path_mismatch;
+                return nullptr;
+            }
+            auto* next = current->find(token.key);
+            if (next == nullptr) {
+                if (!create_parents) {
+                    error = status::subdoc_path_not_found;
+                    return nullptr;
+                }
+                next = &current->get_object().emplace(token.key, tao::json::empty_object).first->second;
+            }
+            current = next;
+        }
+    }
+    return current;
+}
+
+struct lookup_result {
+    status code{ status::success };
+    std::string value{};
+};
+
+inline lookup_result
+lookup(std::uint8_t opcode, const std::string& path, tao::json::value& root)
+{
+    if (static_cast<subdoc_opcode>(opcode) == subdoc_opcode::get_doc) {
+        return { status::success, tao::json::to_string(root) };
+    }
+    auto tokens = parse_path(path);
+    if (!tokens) {
+        return { status::subdoc_path_invalid };
+    }
+    status error{ status::success };
+    auto* value = resolve(root, *tokens, tokens->size(), false, error);
+    if (value == nullptr) {
+        return { error };
+    }
+    switch (static_cast<subdoc_opcode>(opcode)) {
+        case subdoc_opcode::get:
+            return { status::success, tao::json::to_string(*value) };
+        case subdoc_opcode::exists:
+            return { status::success };
+        case subdoc_opcode::get_count:
+            if (value->is_array()) {
+                return { status::success, std::to_string(value->get_array().size()) };
+            }
+            if (value->is_object()) {
+                return { status::success, std::to_string(value->get_object().size()) };
+            }
+            return { status::subdoc_path_mismatch };
+        default:
+            break;
+    }
+    return { status::invalid };
+}
+
+struct mutation_result {
+    status code{ status::success };
+    std::optional<std::string> value{};
+};
+
+inline std::optional<tao::json::value>
+parse_values(const std::string& param, bool multi)
+{
+    try {
+        return tao::json::from_string(multi ? "[" + param + "]" : param);
+    } catch (const std::exception&) {
+        return {};
+    }
+}
+
+/**
+ * Applies single path mutation to the JSON document.
+ */
+inline mutation_result
+mutate(std::uint8_t opcode, bool create_parents, const std::string& path, const std::string& param, tao::json::value& root)
+{
+    auto op = static_cast<subdoc_opcode>(opcode);
+    auto tokens = parse_path(path);
+    if (!tokens || tokens->empty()) {
+        return { status::subdoc_path_invalid };
+    }
+    bool multi_value = op == subdoc_opcode::array_push_last || op == subdoc_opcode::array_push_first || op == subdoc_opcode::array_insert;
+    std::optional<tao::json::value> param_value{};
+    if (op != subdoc_opcode::remove) {
+        param_value = parse_values(param, multi_value);
+        if (!param_value) {
+            return { op == subdoc_opcode::counter ? status::subdoc_delta_invalid : status::subdoc_value_cannot_insert };
+        }
+    }
+    status error{ status::success };
+    const auto& last = tokens->back();
+
+    switch (op) {
+        case subdoc_opcode::dict_add:
+        case subdoc_opcode::dict_upsert:
+        case subdoc_opcode::replace:
+        case subdoc_opcode::remove: {
+            auto* parent = resolve(root, *tokens, tokens->size() - 1, create_parents, error);
+            if (parent == nullptr) {
+                return { error };
+            }
+            if (last.is_index) {
+                if (!parent->is_array() || op == subdoc_opcode::dict_add || op == subdoc_opcode::dict_upsert) {
+                    return { status::subdoc_path_mismatch };
+                }
+                auto& array = parent->get_array();
+                auto index = last.index < 0 ? static_cast<std::int64_t>(array.size()) + last.index : last.index;
+                if (index < 0 || static_cast<std::size_t>(index) >= array.size()) {
+                    return { status::subdoc_path_not_found };
+                }
+                if (op == subdoc_opcode::remove) {
+                    array.erase(array.begin() + index);
+                } else {
+                    array[static_cast<std::size_t>(index)] = std::move(*param_value);
+                }
+                return {};
+            }
+            if (!parent->is_object()) {
+                return { status::subdoc_path_mismatch };
+            }
+            auto& object = parent->get_object();
+            auto existing = object.find(last.key);
+            if (op == subdoc_opcode::dict_add && existing != object.end()) {
+                return { status::subdoc_path_exists };
+            }
+            if ((op == subdoc_opcode::replace || op == subdoc_opcode::remove) && existing == object.end()) {
+                return { status::subdoc_path_not_found };
+            }
+            if (op == subdoc_opcode::remove) {
+                object.erase(existing);
+            } else {
+                object[last.key] = std::move(*param_value);
+            }
+            return {};
+        }
+
+        case subdoc_opcode::array_push_last:
+        case subdoc_opcode::array_push_first:
+        case subdoc_opcode::array_add_unique: {
+            auto* parent = resolve(root, *tokens, tokens->size() - 1, create_parents, error);
+            if (parent == nullptr) {
+                return { error };
+            }
+            tao::json::value* target = nullptr;
+            if (last.is_index) {
+                target = resolve(root, *tokens, tokens->size(), false, error);
+            } else if (parent->is_object()) {
+                target = parent->find(last.key);
+                if (target == nullptr && create_parents) {
+                    target = &parent->get_object().emplace(last.key, tao::json::empty_array).first->second;
+                }
+            }
+            if (target == nullptr) {
+                return { error == status::success ? status::subdoc_path_not_found : error };
+            }
+            if (!target->is_array()) {
+                return { status::subdoc_path_mismatch };
+            }
+            auto& array = target->get_array();
+            if (op == subdoc_opcode::array_add_unique) {
+                if (param_value->is_array() || param_value->is_object()) {
+                    return { status::subdoc_value_cannot_insert };
+                }
+                if (std::find(array.begin(), array.end(), *param_value) != array.end()) {
+                    return { status::subdoc_path_exists };
+                }
+                array.emplace_back(std::move(*param_value));
+            } else {
+                auto& values = param_value->get_array();
+                array.insert(op == subdoc_opcode::array_push_last ? array.end() : array.begin(), values.begin(), values.end());
+            }
+            return {};
+        }
+
+        case subdoc_opcode::array_insert: {
+            if (!last.is_index) {
+                return { status::subdoc_path_invalid };
+            }
+            auto* parent = resolve(root, *tokens, tokens->size() - 1, false, error);
+            if (parent == nullptr) {
+                return { error };
+            }
+            if (!parent->is_array()) {
+                return { status::subdoc_path_mismatch };
+            }
+            auto& array = parent->get_array();
+            if (last.index < 0 || static_cast<std::size_t>(last.index) > array.size()) {
+                return { status::subdoc_path_not_found };
+            }
+            auto& values = param_value->get_array();
+            array.insert(array.begin() + last.index, values.begin(), values.end());
+            return {};
+        }
+
+        case subdoc_opcode::counter: {
+            if (!param_value->is_integer()) {
+                return { status::subdoc_delta_invalid };
+            }
+            auto* parent = resolve(root, *tokens, tokens->size() - 1, create_parents, error);
+            if (parent == nullptr) {
+                return { error };
+            }
+            tao::json::value* target = nullptr;
+            if (last.is_index) {
+                target = resolve(root, *tokens, tokens->size(), false, error);
+            } else if (parent->is_object()) {
+                target = parent->find(last.key);
+                if (target == nullptr) {
+                    target = &parent->get_object().emplace(last.key, 0).first->second;
+                }
+            }
+            if (target == nullptr) {
+                return { error == status::success ? status::subdoc_path_mismatch : error };
+            }
+            if (!target->is_integer()) {
+                return { status::subdoc_path_mismatch };
+            }
+            auto result = target->as<std::int64_t>() + param_value->as<std::int64_t>();
+            *target = result;
+            return { status::success, std::to_string(result) };
+        }
+
+        default:
+            break;
+    }
+    return { status::invalid };
+}
+} // namespace mock::subdoc
@@ -100,6 +100,7 @@ struct test_context {
     std::string password{ "password" };
     std::string bucket{ "default" };
     test_server_version version{ 6, 6, 0 };
+    bool use_mock{ false };
 
     static test_context load_from_environment()
     {
@@ -127,6 +128,14 @@ struct test_context {
         if (var != nullptr) {
             ctx.bucket = var;
         }
+        var = getenv("TEST_USE_MOCK");
+        if (var != nullptr) {
+            if (strcmp(var, "true") == 0 || strcmp(var, "yes") == 0 || strcmp(var, "1") == 0) {
+                ctx.use_mock = true;
+            } else if (strcmp(var, "false") == 0 || strcmp(var, "no") == 0 || strcmp(var, "0") == 0) {
+                ctx.use_mock = false;
+            }
+        }
         var = getenv("TEST_DEVELOPER_PREVIEW");
         if (var != nullptr) {
             if (strcmp(var, "true") == 0 || strcmp(var, "yes") == 0 || strcmp(var, "1") == 0) {
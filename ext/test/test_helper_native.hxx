@@ -36,6 +36,8 @@
 #include <io/dns_client.hxx>
 #include <utils/connection_string.hxx>
 
+#include "mock/mock_cluster.hxx"
+
 void
 native_init_logger()
 {
@@ -54,3 +56,32 @@ native_init_logger()
         initialized = true;
     }
 }
+
+/**
+ * Builds credentials for native tests. The core leaves the SASL mechanisms to the caller, so list the SCRAM ones here, like the Ruby
+ * authenticator does.
+ */
+couchbase::cluster_credentials
+native_test_credentials(const std::string& username, const std::string& password)
+{
+    couchbase::cluster_credentials auth{};
+    auth.username = username;
+    auth.password = password;
+    auth.allowed_sasl_mechanisms = { "SCRAM-SHA512", "SCRAM-SHA256", "SCRAM-SHA1" };
+    return auth;
+}
+
+/**
+ * Loads test context from the environment. When TEST_USE_MOCK is set, starts in-process mock cluster (once per test executable)
+ * and points the context to it.
+ */
+test_context
+native_test_context()
+{
+    auto ctx = test_context::load_from_environment();
+    if (ctx.use_mock) {
+        static mock::mock_cluster cluster(mock::mock_options{ 1, 64, ctx.bucket, ctx.username, ctx.password });
+        ctx.connection_string = cluster.connection_string();
+    }
+    return ctx;
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <io/adaptive_limiter.hxx>
+
+using namespace std::chrono_literals;
+
+static void
+fill(couchbase::io::adaptive_limiter& limiter, std::size_t number_of_requests)
+{
+    for (std::size_t i = 0; i < number_of_requests; ++i) {
+        REQUIRE(limiter.try_acquire(0));
+    }
+}
+
+TEST_CASE("native: adaptive limiter rejects requests over the limit", "[native]")
+{
+    couchbase::io::adaptive_limiter limiter(256, 1024);
+    REQUIRE(limiter.stats().limit == 64);
+
+    fill(limiter, 64);
+    REQUIRE_FALSE(limiter.try_acquire(0));
+    REQUIRE(limiter.stats().rejected == 1);
+
+    limiter.release();
+    REQUIRE(limiter.try_acquire(1000));
+    limiter.on_queued(1000);
+    limiter.release();
+    REQUIRE_FALSE(limiter.try_acquire(100));
+    limiter.on_written(1000);
+    REQUIRE(limiter.try_acquire(100));
+    REQUIRE(limiter.stats().rejected == 2);
+}
+
+TEST_CASE("native: adaptive limiter grows additively while the limit is utilized", "[native]")
+{
+    couchbase::io::adaptive_limiter limiter(256, 0);
+    auto now = std::chrono::steady_clock::time_point{} + 1h;
+    fill(limiter, 64);
+
+    // every response adds 1/limit, so the limit grows by one per window of responses
+    for (int i = 0; i < 60; ++i) {
+        limiter.release(1ms, false, now);
+        REQUIRE(limiter.try_acquire(0));
+    }
+    REQUIRE(limiter.stats().limit == 64);
+    for (int i = 0; i < 10; ++i) {
+        limiter.release(1ms, false, now);
+        REQUIRE(limiter.try_acquire(0));
+    }
+    REQUIRE(limiter.stats().limit == 65);
+
+    // the limit does not grow, when less than half of it is in use
+    for (int i = 0; i < 64; ++i) {
+        limiter.release(1ms, false, now);
+    }
+    auto limit = limiter.stats().limit;
+    REQUIRE(limiter.stats().in_flight == 0);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(limiter.try_acquire(0));
+        limiter.release(1ms, false, now);
+    }
+    REQUIRE(limiter.stats().limit == limit);
+}
+
+TEST_CASE("native: adaptive limiter backs off multiplicatively at most once per round trip", "[native]")
+{
+    couchbase::io::adaptive_limiter limiter(256, 0);
+    auto now = std::chrono::steady_clock::time_point{} + 1h;
+    fill(limiter, 64);
+    limiter.release(1ms, false, now);
+    REQUIRE(limiter.stats().limit == 64);
+
+    // timed out request
+    limiter.release(1ms, true, now);
+    REQUIRE(limiter.stats().limit == 57); // 64 * 0.9
+
+    // the rest of the same burst is ignored
+    limiter.release(1ms, true, now + 500us);
+    REQUIRE(limiter.stats().limit == 57);
+
+    // degraded latency is treated as congestion in the next round trip
+    limiter.release(5ms, false, now + 10ms);
+    REQUIRE(limiter.stats().limit == 51); // 57.6 * 0.9
+
+    for (int i = 0; i < 100; ++i) {
+        now += 1s;
+        limiter.release(1ms, true, now);
+    }
+    REQUIRE(limiter.stats().limit == 16);
+}
+
+TEST_CASE("native: adaptive limiter does not grow over the maximum", "[native]")
+{
+    couchbase::io::adaptive_limiter limiter(20, 0);
+    auto now = std::chrono::steady_clock::time_point{} + 1h;
+    REQUIRE(limiter.stats().limit == 16);
+    fill(limiter, 16);
+    for (int i = 0; i < 1000; ++i) {
+        limiter.release(1ms, false, now);
+        REQUIRE(limiter.try_acquire(0));
+    }
+    REQUIRE(limiter.stats().limit == 20);
+}
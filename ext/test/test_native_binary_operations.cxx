@@ -25,13 +25,11 @@ uniq_id(const std::string& prefix)
 
 TEST_CASE("native: append", "[native]")
 {
-    auto ctx = test_context::load_from_environment();
+    auto ctx = native_test_context();
     native_init_logger();
 
     auto connstr = couchbase::utils::parse_connection_string(ctx.connection_string);
-    couchbase::cluster_credentials auth{};
-    auth.username = ctx.username;
-    auth.password = ctx.password;
+    auto auth = native_test_credentials(ctx.username, ctx.password);
 
     asio::io_context io;
 
@@ -106,13 +104,11 @@ TEST_CASE("native: append", "[native]")
 
 TEST_CASE("native: prepend", "[native]")
 {
-    auto ctx = test_context::load_from_environment();
+    auto ctx = native_test_context();
     native_init_logger();
 
     auto connstr = couchbase::utils::parse_connection_string(ctx.connection_string);
-    couchbase::cluster_credentials auth{};
-    auth.username = ctx.username;
-    auth.password = ctx.password;
+    auto auth = native_test_credentials(ctx.username, ctx.password);
 
     asio::io_context io;
 
@@ -0,0 +1,108 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <utils/md5.hxx>
+
+static std::string
+md5_hex(std::string_view data)
+{
+    std::string hex{};
+    for (auto byte : couchbase::utils::md5(data)) {
+        hex += fmt::format("{:02x}", byte);
+    }
+    return hex;
+}
+
+TEST_CASE("native: md5 matches test suite of RFC 1321", "[native]")
+{
+    REQUIRE(md5_hex("") == "d41d8cd98f00b204e9800998ecf8427e");
+    REQUIRE(md5_hex("a") == "0cc175b9c0f1b6a831c399e269772661");
+    REQUIRE(md5_hex("abc") == "900150983cd24fb0d6963f7d28e17f72");
+    REQUIRE(md5_hex("message digest") == "f96b697d7cb7938d525a2f31aaf161d0");
+    REQUIRE(md5_hex("abcdefghijklmnopqrstuvwxyz") == "c3fcd3d76192e4007dfb496cca67e13b");
+    REQUIRE(md5_hex("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789") == "d174ab98d277d9f5a5611c2c9f419d9f");
+    REQUIRE(md5_hex("12345678901234567890123456789012345678901234567890123456789012345678901234567890") ==
+            "57edf4a22be3c955ac49da2e2107b67a");
+}
+
+static couchbase::configuration
+make_memcached_configuration(std::size_t number_of_nodes)
+{
+    couchbase::configuration config{};
+    config.node_locator = couchbase::configuration::node_locator_type::ketama;
+    for (std::size_t i = 0; i < number_of_nodes; ++i) {
+        couchbase::configuration::node n{};
+        n.index = i;
+        n.hostname = fmt::format("192.168.1.{}", i + 1);
+        n.services_plain.key_value = 11210;
+        config.nodes.emplace_back(n);
+    }
+    config.build_ketama_continuum();
+    return config;
+}
+
+TEST_CASE("native: memcached bucket keys are mapped with ketama", "[native]")
+{
+    auto config = make_memcached_configuration(4);
+    REQUIRE(config.ketama_continuum.size() == 4 * 160);
+
+    constexpr std::size_t number_of_keys = 1000;
+    std::vector<std::int16_t> owners(number_of_keys);
+    std::map<std::int16_t, std::size_t> keys_per_node{};
+    for (std::size_t i = 0; i < number_of_keys; ++i) {
+        auto [partition, index] = config.map_key(fmt::format("key_{}", i));
+        REQUIRE(partition == 0);
+        REQUIRE(index >= 0);
+        REQUIRE(index < 4);
+        owners[i] = index;
+        ++keys_per_node[index];
+    }
+    REQUIRE(keys_per_node.size() == 4);
+
+    /* removing the node moves only the keys it owned */
+    auto smaller = make_memcached_configuration(3);
+    for (std::size_t i = 0; i < number_of_keys; ++i) {
+        auto index = smaller.map_key(fmt::format("key_{}", i)).second;
+        if (owners[i] != 3) {
+            REQUIRE(index == owners[i]);
+        }
+    }
+}
+
+TEST_CASE("native: memcached bucket keys are placed on the same nodes as libcouchbase places them", "[native]")
+{
+    /* expectations of lcbvb_map_key() for the same four nodes ("192.168.1.N:11210") */
+    auto config = make_memcached_configuration(4);
+    REQUIRE(config.ketama_continuum.front() == std::make_pair(std::uint32_t{ 0x004398a4 }, std::int16_t{ 1 }));
+    REQUIRE(config.ketama_continuum.back().first == 0xffec6323);
+
+    std::vector<std::pair<std::string, std::int16_t>> expected{
+        { "foo", 0 },   { "bar", 0 },   { "baz", 0 },   { "hello", 2 }, { "couchbase", 1 }, { "key_0", 1 }, { "key_1", 2 },
+        { "key_2", 1 }, { "key_3", 3 }, { "key_4", 1 }, { "key_5", 3 }, { "key_6", 1 },     { "key_7", 2 }, { "key_8", 3 },
+        { "key_9", 1 },
+        /* hashes above the last point of the continuum wrap around to the first one */
+        { "key_323", 1 },
+        /* hashes below the first point */
+        { "key_2514", 1 },
+    };
+    for (const auto& [key, index] : expected) {
+        INFO(key);
+        REQUIRE(config.map_key(key) == std::make_pair(std::uint16_t{ 0 }, index));
+    }
+}
@@ -0,0 +1,228 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <dcp/message_decoder.hxx>
+#include <protocol/client_request.hxx>
+#include <protocol/client_response.hxx>
+#include <protocol/cmd_dcp_stream_request.hxx>
+
+static couchbase::io::mcbp_message
+make_message(couchbase::protocol::magic magic,
+             couchbase::protocol::client_opcode opcode,
+             std::uint16_t specific,
+             const std::string& extras,
+             const std::string& key,
+             const std::string& value)
+{
+    couchbase::io::mcbp_message msg{};
+    msg.header.magic = static_cast<std::uint8_t>(magic);
+    msg.header.opcode = static_cast<std::uint8_t>(opcode);
+    msg.header.keylen = htons(static_cast<std::uint16_t>(key.size()));
+    msg.header.extlen = static_cast<std::uint8_t>(extras.size());
+    msg.header.datatype = 0;
+    msg.header.specific = htons(specific);
+    msg.header.bodylen = htonl(static_cast<std::uint32_t>(extras.size() + key.size() + value.size()));
+    msg.header.opaque = 42;
+    msg.header.cas = couchbase::utils::byte_swap_64(0xdead'beefULL);
+    std::string body = extras + key + value;
+    msg.body.assign(body.begin(), body.end());
+    return msg;
+}
+
+static std::string
+encode_uint64(std::uint64_t value)
+{
+    std::string res(sizeof(value), '\0');
+    value = couchbase::utils::byte_swap_64(value);
+    std::memcpy(res.data(), &value, sizeof(value));
+    return res;
+}
+
+static std::string
+encode_uint32(std::uint32_t value)
+{
+    std::string res(sizeof(value), '\0');
+    value = htonl(value);
+    std::memcpy(res.data(), &value, sizeof(value));
+    return res;
+}
+
+static std::uint64_t
+decode_uint64(const std::vector<std::uint8_t>& data, std::size_t offset)
+{
+    std::uint64_t value = 0;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return couchbase::utils::byte_swap_64(value);
+}
+
+TEST_CASE("native: DCP stream request encodes flags, positions and collections filter", "[native]")
+{
+    couchbase::protocol::client_request<couchbase::protocol::dcp_stream_request_request_body> req;
+    req.opaque(7);
+    req.partition(513);
+    req.body().flags(couchbase::protocol::dcp_stream_request_request_body::flag_active_vb_only);
+    req.body().start_seqno(100);
+    req.body().end_seqno(200);
+    req.body().partition_uuid(0x1122'3344'5566'7788ULL);
+    req.body().snapshot(90, 110);
+    req.body().filter(R"({"collections":["8"]})");
+    const auto& data = req.data();
+
+    constexpr std::size_t extras_size = 2 * sizeof(std::uint32_t) + 5 * sizeof(std::uint64_t);
+    const std::string filter = R"({"collections":["8"]})";
+    REQUIRE(data.size() == couchbase::protocol::header_size + extras_size + filter.size());
+    REQUIRE(data[1] == static_cast<std::uint8_t>(couchbase::protocol::client_opcode::dcp_stream_request));
+    REQUIRE(data[4] == extras_size);
+    REQUIRE(data[6] == 0x02);
+    REQUIRE(data[7] == 0x01);
+
+    const auto offset = couchbase::protocol::header_size;
+    std::uint32_t flags = 0;
+    std::memcpy(&flags, data.data() + offset, sizeof(flags));
+    REQUIRE(ntohl(flags) == 0x10);
+    std::uint32_t reserved = 0;
+    std::memcpy(&reserved, data.data() + offset + 4, sizeof(reserved));
+    REQUIRE(reserved == 0);
+    REQUIRE(decode_uint64(data, offset + 8) == 100);
+    REQUIRE(decode_uint64(data, offset + 16) == 200);
+    REQUIRE(decode_uint64(data, offset + 24) == 0x1122'3344'5566'7788ULL);
+    REQUIRE(decode_uint64(data, offset + 32) == 90);
+    REQUIRE(decode_uint64(data, offset + 40) == 110);
+    REQUIRE(std::string(data.begin() + static_cast<std::ptrdiff_t>(offset + extras_size), data.end()) == filter);
+}
+
+TEST_CASE("native: DCP stream response carries failover log or rollback seqno", "[native]")
+{
+    using couchbase::protocol::client_opcode;
+    using couchbase::protocol::magic;
+    using response_type = couchbase::protocol::client_response<couchbase::protocol::dcp_stream_request_response_body>;
+    {
+        auto msg = make_message(magic::client_response,
+                                client_opcode::dcp_stream_request,
+                                static_cast<std::uint16_t>(couchbase::protocol::status::success),
+                                {},
+                                {},
+                                encode_uint64(0xaaaa) + encode_uint64(1500) + encode_uint64(0xbbbb) + encode_uint64(0));
+        response_type resp(std::move(msg));
+        REQUIRE(resp.status() == couchbase::protocol::status::success);
+        const auto& log = resp.body().failover_log_entries();
+        REQUIRE(log.size() == 2);
+        REQUIRE(log[0].first == 0xaaaa);
+        REQUIRE(log[0].second == 1500);
+        REQUIRE(log[1].first == 0xbbbb);
+        REQUIRE(log[1].second == 0);
+    }
+    {
+        auto msg = make_message(magic::client_response,
+                                client_opcode::dcp_stream_request,
+                                static_cast<std::uint16_t>(couchbase::protocol::status::rollback),
+                                {},
+                                {},
+                                encode_uint64(1234));
+        response_type resp(std::move(msg));
+        REQUIRE(resp.status() == couchbase::protocol::status::rollback);
+        REQUIRE(resp.body().rollback_seqno() == 1234);
+        REQUIRE(resp.body().failover_log_entries().empty());
+    }
+}
+
+TEST_CASE("native: DCP decoder strips collection ID from the document keys", "[native]")
+{
+    using couchbase::protocol::client_opcode;
+    using couchbase::protocol::magic;
+    /* by_seqno, rev_seqno, flags, expiry, lock time, extended metadata size, NRU */
+    std::string extras = encode_uint64(17) + encode_uint64(3) + encode_uint32(0x0200'0006) + encode_uint32(3600) + encode_uint32(0) +
+                         std::string(3, '\0');
+    {
+        /* collection 0x88 is encoded in two bytes */
+        auto msg = make_message(magic::client_request, client_opcode::dcp_mutation, 42, extras, std::string("\x88\x01", 2) + "foo", "{}");
+        auto e = couchbase::dcp::message_decoder::document(msg, true);
+        REQUIRE(e.has_value());
+        REQUIRE(e->type == couchbase::dcp::event_type::mutation);
+        REQUIRE(e->partition == 42);
+        REQUIRE(e->collection_id == 0x88);
+        REQUIRE(e->key == "foo");
+        REQUIRE(e->value == "{}");
+        REQUIRE(e->by_seqno == 17);
+        REQUIRE(e->rev_seqno == 3);
+        REQUIRE(e->flags == 0x0200'0006);
+        REQUIRE(e->expiry == 3600);
+        REQUIRE(e->cas == 0xdead'beefULL);
+    }
+    {
+        auto msg = make_message(magic::client_request, client_opcode::dcp_mutation, 42, extras, std::string(1, '\0') + "foo", "{}");
+        auto e = couchbase::dcp::message_decoder::document(msg, true);
+        REQUIRE(e.has_value());
+        REQUIRE(e->collection_id == 0);
+        REQUIRE(e->key == "foo");
+    }
+    {
+        auto msg = make_message(magic::client_request, client_opcode::dcp_mutation, 42, extras, "foo", "{}");
+        auto e = couchbase::dcp::message_decoder::document(msg, false);
+        REQUIRE(e.has_value());
+        REQUIRE(e->collection_id == 0);
+        REQUIRE(e->key == "foo");
+    }
+    {
+        /* the prefix without stop byte */
+        auto msg = make_message(magic::client_request, client_opcode::dcp_mutation, 42, extras, std::string("\x88\x81", 2), "{}");
+        REQUIRE_FALSE(couchbase::dcp::message_decoder::document(msg, true).has_value());
+    }
+    {
+        auto msg = make_message(magic::client_request, client_opcode::dcp_mutation, 42, extras, "foo", "{}");
+        msg.header.keylen = htons(100);
+        REQUIRE_FALSE(couchbase::dcp::message_decoder::document(msg, false).has_value());
+    }
+}
+
+TEST_CASE("native: DCP decoder reads deletions, snapshot markers and stream ends", "[native]")
+{
+    using couchbase::protocol::client_opcode;
+    using couchbase::protocol::magic;
+    {
+        /* by_seqno, rev_seqno, delete time */
+        std::string extras = encode_uint64(18) + encode_uint64(4) + encode_uint32(1'600'000'000);
+        auto msg = make_message(magic::client_request, client_opcode::dcp_deletion, 7, extras, std::string("\x09", 1) + "bar", {});
+        auto e = couchbase::dcp::message_decoder::document(msg, true);
+        REQUIRE(e.has_value());
+        REQUIRE(e->type == couchbase::dcp::event_type::deletion);
+        REQUIRE(e->partition == 7);
+        REQUIRE(e->collection_id == 9);
+        REQUIRE(e->key == "bar");
+        REQUIRE(e->value.empty());
+        REQUIRE(e->by_seqno == 18);
+        REQUIRE(e->rev_seqno == 4);
+        REQUIRE(e->flags == 0);
+    }
+    {
+        std::string extras = encode_uint64(10) + encode_uint64(20) + encode_uint32(0x02);
+        auto msg = make_message(magic::client_request, client_opcode::dcp_snapshot_marker, 7, extras, {}, {});
+        auto marker = couchbase::dcp::message_decoder::snapshot(msg);
+        REQUIRE(marker.has_value());
+        REQUIRE(marker->start == 10);
+        REQUIRE(marker->end == 20);
+
+        auto truncated = make_message(magic::client_request, client_opcode::dcp_snapshot_marker, 7, encode_uint64(10), {}, {});
+        REQUIRE_FALSE(couchbase::dcp::message_decoder::snapshot(truncated).has_value());
+    }
+    {
+        auto msg = make_message(magic::client_request, client_opcode::dcp_stream_end, 7, encode_uint32(0x04), {}, {});
+        REQUIRE(couchbase::dcp::message_decoder::stream_end(msg) == couchbase::dcp::stream_end_reason::too_slow);
+    }
+}
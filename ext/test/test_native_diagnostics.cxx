@@ -177,7 +177,7 @@ TEST_CASE("native: serializing diagnostics report", "[native]")
 
 TEST_CASE("native: serializing ping report", "[native]")
 {
-    auto ctx = test_context::load_from_environment();
+    auto ctx = native_test_context();
     native_init_logger();
 
     couchbase::diag::ping_result res{
@@ -320,13 +320,11 @@ TEST_CASE("native: serializing ping report", "[native]")
 
 TEST_CASE("native: fetch diagnostics after N1QL query", "[native]")
 {
-    auto ctx = test_context::load_from_environment();
+    auto ctx = native_test_context();
     native_init_logger();
 
     auto connstr = couchbase::utils::parse_connection_string(ctx.connection_string);
-    couchbase::cluster_credentials auth{};
-    auth.username = ctx.username;
-    auth.password = ctx.password;
+    auto auth = native_test_credentials(ctx.username, ctx.password);
 
     asio::io_context io;
 
@@ -385,13 +383,11 @@ TEST_CASE("native: fetch diagnostics after N1QL query", "[native]")
 
 TEST_CASE("native: ping", "[native]")
 {
-    auto ctx = test_context::load_from_environment();
+    auto ctx = native_test_context();
     native_init_logger();
 
     auto connstr = couchbase::utils::parse_connection_string(ctx.connection_string);
-    couchbase::cluster_credentials auth{};
-    auth.username = ctx.username;
-    auth.password = ctx.password;
+    auto auth = native_test_credentials(ctx.username, ctx.password);
 
     asio::io_context io;
 
@@ -0,0 +1,59 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <utils/json_projector.hxx>
+
+static std::pair<std::error_code, std::string>
+project(const std::string& document, const std::vector<std::string>& paths, bool preserve_array_indexes = false)
+{
+    couchbase::utils::json::projector projector(paths, preserve_array_indexes);
+    std::string output;
+    if (auto ec = projector.extract(document); ec) {
+        return { ec, output };
+    }
+    auto ec = projector.write(output);
+    return { ec, output };
+}
+
+TEST_CASE("native: json projector extracts nested paths", "[native]")
+{
+    std::string document = R"({"name": "Emma", "skipped": {"deep": [1, {"x": "}]"}]}, "address": {"city": "Paris", "zip": "75001"},)"
+                           R"( "tags": ["a", "b", "c"], "k\"ey": 42})";
+
+    auto [ec, output] = project(document, { "address.city", "name", "tags[1]", "tags[-1]", "k\"ey" });
+    REQUIRE_FALSE(ec);
+    REQUIRE(output == R"({"address":{"city":"Paris"},"name":"Emma","tags":["b","c"],"k\"ey":42})");
+
+    std::tie(ec, output) = project(document, { "tags[2]", "tags[0]" }, true);
+    REQUIRE_FALSE(ec);
+    REQUIRE(output == R"({"tags":["a",null,"c"]})");
+
+    std::tie(ec, output) = project(document, { "address", "address.city" });
+    REQUIRE_FALSE(ec);
+    REQUIRE(output == R"({"address":{"city": "Paris", "zip": "75001"}})");
+}
+
+TEST_CASE("native: json projector reports errors", "[native]")
+{
+    auto [ec, output] = project(R"({"name": "Emma"})", { "name", "age" });
+    REQUIRE(ec == couchbase::error::key_value_errc::path_not_found);
+
+    std::tie(ec, output) = project(R"({"name": "Emma")", { "name" });
+    REQUIRE(ec == couchbase::error::common_errc::parsing_failure);
+}
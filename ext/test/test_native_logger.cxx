@@ -0,0 +1,300 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <future>
+#include <sstream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/ostream_sink.h>
+
+#include <logger.hxx>
+#include <utils/mpsc_queue.hxx>
+
+TEST_CASE("native: mpsc queue rejects values when full", "[native]")
+{
+    couchbase::utils::mpsc_queue<int> queue(3);
+    REQUIRE(queue.capacity() == 4);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.try_push(i));
+    }
+    int value = 42;
+    REQUIRE_FALSE(queue.try_push(value));
+    REQUIRE(value == 42);
+
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.try_pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("native: mpsc queue keeps order of every producer", "[native]")
+{
+    constexpr int number_of_producers = 4;
+    constexpr int values_per_producer = 100'000;
+    couchbase::utils::mpsc_queue<int> queue(1024);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < number_of_producers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < values_per_producer; ++i) {
+                int value = p * values_per_producer + i;
+                while (!queue.try_push(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> last(number_of_producers, -1);
+    int received = 0;
+    while (received < number_of_producers * values_per_producer) {
+        int value = 0;
+        if (!queue.try_pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int producer = value / values_per_producer;
+        REQUIRE(value % values_per_producer == last[static_cast<std::size_t>(producer)] + 1);
+        last[static_cast<std::size_t>(producer)] = value % values_per_producer;
+        ++received;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+}
+
+TEST_CASE("native: async sink writes messages from the background thread", "[native]")
+{
+    std::ostringstream output;
+    auto inner = std::make_shared<spdlog::sinks::ostream_sink_mt>(output);
+    inner->set_pattern("[%l] %v");
+    auto sink = std::make_shared<couchbase::logger::async_sink>(std::vector<spdlog::sink_ptr>{ inner }, 1024);
+    spdlog::logger logger("test", sink);
+    logger.set_level(spdlog::level::trace);
+
+    logger.info("first message");
+    sink->push_deferred(spdlog::level::debug,
+                        "test",
+                        std::make_unique<couchbase::logger::priv::deferred_message_with_args<std::string, couchbase::logger::hex_dump>>(
+                          "second message {}{:n}", "with payload", couchbase::logger::hex(std::string("\x01\xfe"))));
+    logger.warn("third message");
+    sink->shutdown();
+
+    REQUIRE(output.str() == "[info] first message\n[debug] second message with payload 01 fe\n[warning] third message\n");
+
+    logger.info("written synchronously");
+    REQUIRE(output.str().find("[info] written synchronously\n") != std::string::npos);
+}
+
+namespace
+{
+class gated_sink : public spdlog::sinks::base_sink<std::mutex>
+{
+  public:
+    std::promise<void> entered{};
+    std::shared_future<void> gate{};
+    std::vector<std::string> messages{};
+
+  protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override
+    {
+        if (messages.empty()) {
+            entered.set_value();
+            gate.wait();
+        }
+        messages.emplace_back(msg.payload.data(), msg.payload.size());
+    }
+
+    void flush_() override
+    {
+    }
+};
+} // namespace
+
+TEST_CASE("native: async sink drops and counts messages when the queue is full", "[native]")
+{
+    std::promise<void> open_gate;
+    auto inner = std::make_shared<gated_sink>();
+    inner->gate = open_gate.get_future().share();
+    auto entered = inner->entered.get_future();
+    auto sink = std::make_shared<couchbase::logger::async_sink>(std::vector<spdlog::sink_ptr>{ inner }, 4);
+    spdlog::logger logger("test", sink);
+
+    auto dropped_before = couchbase::logger::dropped_messages();
+    logger.info("blocks the background thread");
+    entered.wait();
+    for (int i = 0; i < 10; ++i) {
+        logger.info("message {}", i);
+    }
+    REQUIRE(couchbase::logger::dropped_messages() - dropped_before == 6);
+
+    open_gate.set_value();
+    sink->shutdown();
+    REQUIRE(inner->messages.size() == 6);
+    REQUIRE(inner->messages[1] == "message 0");
+    REQUIRE(inner->messages[4] == "message 3");
+    REQUIRE(inner->messages[5].find("6 log messages have been dropped") == 0);
+}
+
+namespace
+{
+struct broken_message : couchbase::logger::priv::deferred_message {
+    [[nodiscard]] std::string render() const override
+    {
+        throw std::runtime_error("broken argument");
+    }
+};
+
+class broken_sink : public spdlog::sinks::base_sink<std::mutex>
+{
+  protected:
+    void sink_it_(const spdlog::details::log_msg& /* msg */) override
+    {
+        throw std::runtime_error("broken sink");
+    }
+
+    void flush_() override
+    {
+    }
+};
+
+class counting_sink : public spdlog::sinks::base_sink<std::mutex>
+{
+  public:
+    std::size_t messages{ 0 };
+
+  protected:
+    void sink_it_(const spdlog::details::log_msg& /* msg */) override
+    {
+        ++messages;
+    }
+
+    void flush_() override
+    {
+    }
+};
+} // namespace
+
+TEST_CASE("native: async sink survives exceptions of formatting and sinks", "[native]")
+{
+    std::ostringstream output;
+    auto inner = std::make_shared<spdlog::sinks::ostream_sink_mt>(output);
+    inner->set_pattern("[%l] %v");
+    std::vector<spdlog::sink_ptr> sinks{ std::make_shared<broken_sink>(), inner };
+    auto sink = std::make_shared<couchbase::logger::async_sink>(std::move(sinks), 16);
+    spdlog::logger logger("test", sink);
+
+    sink->push_deferred(spdlog::level::info, "test", std::make_unique<broken_message>());
+    logger.info("next message");
+    sink->shutdown();
+
+    REQUIRE(output.str() == "[info] unable to format log message: broken argument\n[info] next message\n");
+}
+
+TEST_CASE("native: stopped async sink is not used for deferred messages", "[native]")
+{
+    auto& active = couchbase::logger::priv::active_sink();
+    auto* previous = active.load();
+    {
+        auto sink = std::make_shared<couchbase::logger::async_sink>(std::vector<spdlog::sink_ptr>{}, 16);
+        active.store(sink.get());
+        sink->shutdown();
+        REQUIRE(active.load() == nullptr);
+    }
+    {
+        auto sink = std::make_shared<couchbase::logger::async_sink>(std::vector<spdlog::sink_ptr>{}, 16);
+        active.store(sink.get());
+    }
+    REQUIRE(active.load() == nullptr);
+    active.store(previous);
+}
+
+TEST_CASE("native: async sink does not lose messages logged during shutdown", "[native]")
+{
+    constexpr std::size_t number_of_threads = 4;
+    constexpr std::size_t messages_per_thread = 2'000;
+    auto inner = std::make_shared<counting_sink>();
+    auto sink = std::make_shared<couchbase::logger::async_sink>(std::vector<spdlog::sink_ptr>{ inner },
+                                                                number_of_threads * messages_per_thread);
+    spdlog::logger logger("test", sink);
+
+    auto dropped_before = couchbase::logger::dropped_messages();
+    std::promise<void> start;
+    auto started = start.get_future().share();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < number_of_threads; ++t) {
+        threads.emplace_back([&logger, started]() {
+            started.wait();
+            for (std::size_t i = 0; i < messages_per_thread; ++i) {
+                logger.info("message {}", i);
+            }
+        });
+    }
+    start.set_value();
+    sink->shutdown();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(couchbase::logger::dropped_messages() == dropped_before);
+    REQUIRE(inner->messages == number_of_threads * messages_per_thread);
+}
+
+TEST_CASE("native: async sink writes synchronously in the child process after fork", "[native]")
+{
+    std::ostringstream output;
+    auto inner = std::make_shared<spdlog::sinks::ostream_sink_mt>(output);
+    inner->set_pattern("[%l] %v");
+    auto sink = std::make_shared<couchbase::logger::async_sink>(std::vector<spdlog::sink_ptr>{ inner }, 1024);
+    spdlog::logger logger("test", sink);
+    auto& active = couchbase::logger::priv::active_sink();
+    auto* previous = active.exchange(sink.get());
+
+    for (int i = 0; i < 100; ++i) {
+        logger.info("parent message {}", i);
+    }
+    auto pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        /* the background thread does not exist here, so the messages must be written before the calls return */
+        logger.info("child message");
+        sink->push_deferred(spdlog::level::warn,
+                            "test",
+                            std::make_unique<couchbase::logger::priv::deferred_message_with_args<int>>("deferred child message {}", 42));
+        bool written = output.str().find("[info] child message\n[warning] deferred child message 42\n") != std::string::npos;
+        sink->shutdown();
+        _exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == EXIT_SUCCESS);
+
+    logger.info("parent message after fork");
+    sink->shutdown();
+    active.store(previous);
+    REQUIRE(output.str().find("child message") == std::string::npos);
+    REQUIRE(output.str().find("[info] parent message 99\n") != std::string::npos);
+    REQUIRE(output.str().find("[info] parent message after fork\n") != std::string::npos);
+}
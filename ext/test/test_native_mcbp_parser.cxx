@@ -0,0 +1,129 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <io/mcbp_parser.hxx>
+
+static std::vector<std::uint8_t>
+make_get_response_frame(std::uint32_t opaque, const std::string& value)
+{
+    const std::string extras(4, '\0');
+    std::vector<std::uint8_t> frame(couchbase::protocol::header_size + extras.size() + value.size());
+    frame[0] = static_cast<std::uint8_t>(couchbase::protocol::magic::client_response);
+    frame[1] = static_cast<std::uint8_t>(couchbase::protocol::client_opcode::get);
+    frame[4] = static_cast<std::uint8_t>(extras.size());
+    std::uint32_t body_size = htonl(static_cast<std::uint32_t>(extras.size() + value.size()));
+    std::memcpy(frame.data() + 8, &body_size, sizeof(body_size));
+    std::memcpy(frame.data() + 12, &opaque, sizeof(opaque));
+    std::copy(value.begin(), value.end(), frame.begin() + static_cast<std::ptrdiff_t>(couchbase::protocol::header_size + extras.size()));
+    return frame;
+}
+
+/**
+ * Emulates the session: copies at most read_size bytes into the space returned by prepare() and parses what has been received.
+ */
+static std::vector<couchbase::io::mcbp_message>
+receive(couchbase::io::mcbp_parser& parser, const std::vector<std::uint8_t>& stream, std::size_t read_size, std::size_t& reads)
+{
+    std::vector<couchbase::io::mcbp_message> messages;
+    std::size_t offset = 0;
+    while (offset < stream.size()) {
+        auto [data, size] = parser.prepare();
+        std::size_t chunk = std::min({ size, read_size, stream.size() - offset });
+        std::memcpy(data, stream.data() + offset, chunk);
+        parser.commit(chunk);
+        offset += chunk;
+        ++reads;
+        for (;;) {
+            couchbase::io::mcbp_message msg{};
+            if (parser.next(msg) != couchbase::io::mcbp_parser::result::ok) {
+                break;
+            }
+            messages.emplace_back(std::move(msg));
+        }
+    }
+    return messages;
+}
+
+TEST_CASE("native: mcbp parser splits pipelined responses received in arbitrary chunks", "[native]")
+{
+    std::vector<std::uint8_t> stream;
+    for (std::uint32_t i = 0; i < 100; ++i) {
+        auto frame = make_get_response_frame(i, fmt::format(R"({{"id":{},"padding":"{}"}})", i, std::string(i * 7, 'x')));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    for (std::size_t read_size : { std::size_t{ 1 }, std::size_t{ 13 }, std::size_t{ 1000 }, stream.size() }) {
+        couchbase::io::mcbp_parser parser;
+        std::size_t reads = 0;
+        auto messages = receive(parser, stream, read_size, reads);
+        REQUIRE(messages.size() == 100);
+        for (std::uint32_t i = 0; i < 100; ++i) {
+            REQUIRE(messages[i].header.opaque == i);
+            std::string value(messages[i].body.begin() + 4, messages[i].body.end());
+            REQUIRE(value == fmt::format(R"({{"id":{},"padding":"{}"}})", i, std::string(i * 7, 'x')));
+        }
+        REQUIRE(parser.buffered() == 0);
+        REQUIRE(parser.capacity() == couchbase::io::mcbp_parser::default_read_size);
+    }
+}
+
+TEST_CASE("native: mcbp parser receives large bodies directly into the body storage", "[native]")
+{
+    std::string value(5 * 1024 * 1024, '\0');
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        value[i] = static_cast<char>('a' + i % 26);
+    }
+    auto stream = make_get_response_frame(1, value);
+    auto small = make_get_response_frame(2, "{}");
+    stream.insert(stream.end(), small.begin(), small.end());
+
+    couchbase::io::mcbp_parser parser;
+    std::size_t reads = 0;
+    auto messages = receive(parser, stream, std::numeric_limits<std::size_t>::max(), reads);
+    REQUIRE(messages.size() == 2);
+    REQUIRE(messages[0].header.opaque == 1);
+    REQUIRE(messages[0].body.size() == value.size() + 4);
+    REQUIRE(std::equal(value.begin(), value.end(), messages[0].body.begin() + 4));
+    REQUIRE(messages[1].header.opaque == 2);
+
+    // the first read receives the header, the second one the rest of the large body, the third one the small frame
+    REQUIRE(reads == 3);
+    REQUIRE(parser.buffered() == 0);
+    REQUIRE(parser.capacity() == couchbase::io::mcbp_parser::default_read_size);
+}
+
+TEST_CASE("native: mcbp parser decompresses large bodies", "[native]")
+{
+    std::string value;
+    while (value.size() < 1024 * 1024) {
+        value += fmt::format(R"({{"counter":{}}})", value.size());
+    }
+    std::string compressed;
+    snappy::Compress(value.data(), value.size(), &compressed);
+    REQUIRE(compressed.size() > couchbase::io::mcbp_parser::default_read_size);
+    auto stream = make_get_response_frame(1, compressed);
+    stream[5] = static_cast<std::uint8_t>(couchbase::protocol::datatype::snappy);
+
+    couchbase::io::mcbp_parser parser;
+    std::size_t reads = 0;
+    auto messages = receive(parser, stream, 64 * 1024, reads);
+    REQUIRE(messages.size() == 1);
+    REQUIRE(ntohl(messages[0].header.bodylen) == value.size() + 4);
+    REQUIRE(std::string(messages[0].body.begin() + 4, messages[0].body.end()) == value);
+}
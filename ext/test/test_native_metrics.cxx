@@ -0,0 +1,192 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <metrics/registry.hxx>
+#include <metrics/threshold_reporter.hxx>
+#include <tracing/chrome_trace_exporter.hxx>
+#include <tracing/ring_buffer_tracer.hxx>
+
+TEST_CASE("native: latency histogram keeps relative error within bucket precision", "[native]")
+{
+    couchbase::metrics::latency_histogram histogram{};
+    for (std::uint64_t value = 1; value <= 100'000; ++value) {
+        histogram.record(value);
+    }
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == 100'000);
+    REQUIRE(snapshot.max == 100'000);
+    REQUIRE(snapshot.mean() == Approx(50'000.5));
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9 }) {
+        auto expected = static_cast<double>(percentile * 1'000);
+        INFO("percentile=" << percentile);
+        REQUIRE(static_cast<double>(snapshot.value_at_percentile(percentile)) >= expected);
+        REQUIRE(static_cast<double>(snapshot.value_at_percentile(percentile)) <= expected * 1.04);
+    }
+    REQUIRE(snapshot.value_at_percentile(100) == 100'000);
+}
+
+TEST_CASE("native: latency histogram bucket boundaries", "[native]")
+{
+    using couchbase::metrics::latency_histogram;
+    for (std::uint64_t value = 0; value < (1ULL << 24); value += 97) {
+        auto index = latency_histogram::bucket_index(value);
+        REQUIRE(latency_histogram::bucket_upper_bound(index) >= value);
+        if (index > 0) {
+            REQUIRE(latency_histogram::bucket_upper_bound(index - 1) < value);
+        }
+    }
+    REQUIRE(latency_histogram::bucket_index(std::numeric_limits<std::uint64_t>::max()) == latency_histogram::bucket_count - 1);
+}
+
+TEST_CASE("native: metrics registry returns stable entries per opcode and node", "[native]")
+{
+    couchbase::metrics::registry registry{};
+    registry.enabled(true);
+    auto* get_metrics = registry.kv(couchbase::protocol::client_opcode::get, "test-node-1:11210");
+    REQUIRE(get_metrics != nullptr);
+    REQUIRE(get_metrics == registry.kv(couchbase::protocol::client_opcode::get, "test-node-1:11210"));
+    REQUIRE(get_metrics != registry.kv(couchbase::protocol::client_opcode::get, "test-node-2:11210"));
+    REQUIRE(get_metrics != registry.kv(couchbase::protocol::client_opcode::upsert, "test-node-1:11210"));
+    get_metrics->latency.record(std::chrono::microseconds(250));
+    ++get_metrics->operations;
+
+    auto snapshot = registry.snapshot();
+    auto entry = std::find_if(snapshot.kv.begin(), snapshot.kv.end(), [](const auto& e) {
+        return e.opcode == couchbase::protocol::client_opcode::get && e.node == "test-node-1:11210";
+    });
+    REQUIRE(entry != snapshot.kv.end());
+    REQUIRE(entry->operations == 1);
+    REQUIRE(entry->latency.count == 1);
+
+    registry.enabled(false);
+    REQUIRE(registry.kv(couchbase::protocol::client_opcode::get, "test-node-1:11210") == nullptr);
+    registry.enabled(true);
+}
+
+TEST_CASE("native: threshold report keeps only the slowest operations", "[native]")
+{
+    couchbase::metrics::sampled_queue queue(3);
+    for (std::uint64_t duration : { 700, 100, 900, 300, 800, 200 }) {
+        couchbase::metrics::report_entry entry{};
+        entry.operation_name = "get";
+        entry.total_duration_us = duration;
+        queue.add(std::move(entry));
+    }
+    auto report = queue.to_json();
+    REQUIRE(report["total_count"].as<std::uint64_t>() == 6);
+    const auto& top = report["top_requests"].get_array();
+    REQUIRE(top.size() == 3);
+    REQUIRE(top[0]["total_duration_us"].as<std::uint64_t>() == 900);
+    REQUIRE(top[1]["total_duration_us"].as<std::uint64_t>() == 800);
+    REQUIRE(top[2]["total_duration_us"].as<std::uint64_t>() == 700);
+}
+
+TEST_CASE("native: ring buffer tracer keeps the most recent sampled spans", "[native]")
+{
+    couchbase::tracing::ring_buffer_tracer tracer(3, 2);
+    for (int i = 0; i < 10; ++i) {
+        auto span = tracer.start_span("get", std::to_string(i));
+        if (span) {
+            span->mark(couchbase::tracing::span_phase::dispatched);
+            tracer.end_span(span);
+        }
+    }
+    auto spans = tracer.snapshot();
+    REQUIRE(spans.size() == 3);
+    REQUIRE(spans[0]->id() == "4");
+    REQUIRE(spans[1]->id() == "6");
+    REQUIRE(spans[2]->id() == "8");
+    REQUIRE(spans[2]->has(couchbase::tracing::span_phase::dispatched));
+    REQUIRE_FALSE(spans[2]->has(couchbase::tracing::span_phase::received));
+}
+
+TEST_CASE("native: chrome trace exporter emits request and phase events relative to the first span", "[native]")
+{
+    using couchbase::tracing::span_phase;
+    auto origin = std::chrono::steady_clock::now();
+    auto at = [origin](int us) { return origin + std::chrono::microseconds(us); };
+
+    auto first = std::make_shared<couchbase::tracing::request_span>("get", "0x1");
+    first->set_remote("127.0.0.1:11210");
+    first->mark(span_phase::queued, at(0));
+    first->mark(span_phase::encode_start, at(10));
+    first->mark(span_phase::encode_end, at(20));
+    first->mark(span_phase::dispatched, at(30));
+    first->mark(span_phase::written, at(40));
+    first->mark(span_phase::received, at(140));
+    first->mark(span_phase::decoded, at(150));
+
+    auto second = std::make_shared<couchbase::tracing::request_span>("upsert");
+    second->mark(span_phase::queued, at(100));
+    second->mark(span_phase::dispatched, at(110));
+    second->mark(span_phase::received, at(300));
+
+    auto never_queued = std::make_shared<couchbase::tracing::request_span>("remove");
+
+    auto trace = couchbase::tracing::chrome_trace_exporter::to_json({ first, nullptr, never_queued, second });
+    const auto& events = trace["traceEvents"].get_array();
+    /* first: request, queue, encode, write, wire, decode; second: request and wire */
+    REQUIRE(events.size() == 8);
+
+    REQUIRE(events[0]["name"].get_string() == "get");
+    REQUIRE(events[0]["ph"].get_string() == "X");
+    REQUIRE(events[0]["tid"].as<std::size_t>() == 1);
+    REQUIRE(events[0]["ts"].as<double>() == Approx(0.0));
+    REQUIRE(events[0]["dur"].as<double>() == Approx(150.0));
+    REQUIRE(events[0]["args"]["id"].get_string() == "0x1");
+    REQUIRE(events[0]["args"]["remote"].get_string() == "127.0.0.1:11210");
+    REQUIRE(events[0]["args"]["retries"].as<std::size_t>() == 0);
+
+    REQUIRE(events[1]["name"].get_string() == "queue");
+    REQUIRE(events[2]["name"].get_string() == "encode");
+    REQUIRE(events[3]["name"].get_string() == "write");
+    REQUIRE(events[4]["name"].get_string() == "wire");
+    REQUIRE(events[4]["ts"].as<double>() == Approx(40.0));
+    REQUIRE(events[4]["dur"].as<double>() == Approx(100.0));
+    REQUIRE(events[5]["name"].get_string() == "decode");
+
+    REQUIRE(events[6]["name"].get_string() == "upsert");
+    REQUIRE(events[6]["tid"].as<std::size_t>() == 2);
+    REQUIRE(events[6]["ts"].as<double>() == Approx(100.0));
+    REQUIRE(events[6]["args"].find("id") == nullptr);
+    /* without written timestamp the wire interval starts at dispatch */
+    REQUIRE(events[7]["name"].get_string() == "wire");
+    REQUIRE(events[7]["ts"].as<double>() == Approx(110.0));
+    REQUIRE(events[7]["dur"].as<double>() == Approx(190.0));
+}
+
+TEST_CASE("native: tracer holder stops sampling once the tracer is removed", "[native]")
+{
+    couchbase::tracing::tracer_holder holder{};
+    REQUIRE_FALSE(holder.enabled());
+    REQUIRE(holder.start_span("get") == nullptr);
+
+    auto tracer = std::make_shared<couchbase::tracing::ring_buffer_tracer>(4);
+    holder.set(tracer);
+    REQUIRE(holder.enabled());
+    auto span = holder.start_span("get", "0x1");
+    REQUIRE(span != nullptr);
+    REQUIRE(span->has(couchbase::tracing::span_phase::queued));
+
+    holder.set(nullptr);
+    REQUIRE_FALSE(holder.enabled());
+    REQUIRE(holder.start_span("get") == nullptr);
+    holder.end_span(span);
+    REQUIRE(tracer->snapshot().empty());
+}
@@ -0,0 +1,694 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <cbsasl/scram-sha/salted_password_cache.h>
+#include <io/dns_cache.hxx>
+
+#include <gsl/gsl_util>
+
+#include "mock/mock_dns_server.hxx"
+
+template<typename Request>
+typename Request::response_type
+execute(couchbase::cluster& cluster, Request request)
+{
+    auto barrier = std::make_shared<std::promise<typename Request::response_type>>();
+    auto f = barrier->get_future();
+    cluster.execute(request, [barrier](typename Request::response_type resp) mutable { barrier->set_value(resp); });
+    return f.get();
+}
+
+void
+open_cluster(couchbase::cluster& cluster, const mock::mock_cluster& mock, const std::string& parameters = "")
+{
+    auto auth = native_test_credentials(mock.options().username, mock.options().password);
+    {
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        cluster.open(couchbase::origin(auth, couchbase::utils::parse_connection_string(mock.connection_string() + parameters)),
+                     [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        auto rc = f.get();
+        INFO(rc.message());
+        REQUIRE_FALSE(rc);
+    }
+    {
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        cluster.open_bucket(mock.options().bucket, [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        auto rc = f.get();
+        INFO(rc.message());
+        REQUIRE_FALSE(rc);
+    }
+}
+
+void
+close_cluster(couchbase::cluster& cluster)
+{
+    auto barrier = std::make_shared<std::promise<void>>();
+    auto f = barrier->get_future();
+    cluster.close([barrier]() { barrier->set_value(); });
+    f.get();
+}
+
+TEST_CASE("native: mock cluster serves basic KV operations", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    couchbase::document_id id{ mock.options().bucket, "_default._default", "foo" };
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"a":1})" });
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(resp.cas != 0);
+        REQUIRE(resp.token.sequence_number != 0);
+    }
+    {
+        auto resp = execute(cluster, couchbase::operations::get_request{ id });
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(resp.value == R"({"a":1})");
+    }
+    {
+        mock.inject_status(couchbase::protocol::client_opcode::get, couchbase::protocol::status::not_found);
+        auto resp = execute(cluster, couchbase::operations::get_request{ id });
+        REQUIRE(resp.ctx.ec == couchbase::error::key_value_errc::document_not_found);
+    }
+    {
+        auto resp = execute(cluster, couchbase::operations::get_request{ id });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: mock cluster redirects requests after rebalance", "[native]")
+{
+    native_init_logger();
+    mock::mock_options options{};
+    options.number_of_nodes = 2;
+    mock::mock_cluster mock(options);
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    std::vector<couchbase::document_id> ids{};
+    for (int i = 0; i < 16; ++i) {
+        ids.emplace_back(couchbase::document_id{ mock.options().bucket, "_default._default", fmt::format("key_{}", i) });
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ ids.back(), fmt::format(R"({{"index":{}}})", i) });
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+
+    mock.inject_not_my_vbucket(3);
+    mock.rebalance();
+    for (const auto& id : ids) {
+        auto resp = execute(cluster, couchbase::operations::get_request{ id });
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) >= ids.size() + 3);
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: parallel bootstrap candidates start from different seed nodes and keep the full list", "[native]")
+{
+    couchbase::cluster_credentials auth{};
+    couchbase::origin origin(auth, couchbase::utils::parse_connection_string("couchbase://n0,n1,n2,n3,n4"));
+
+    auto walk = [](couchbase::origin candidate) {
+        std::vector<std::string> hostnames;
+        while (!candidate.exhausted()) {
+            hostnames.emplace_back(candidate.next_address().first);
+        }
+        return hostnames;
+    };
+
+    auto candidates = origin.split(3);
+    REQUIRE(candidates.size() == 3);
+    REQUIRE(walk(candidates[0]) == std::vector<std::string>{ "n0", "n3", "n1", "n4", "n2" });
+    REQUIRE(walk(candidates[1]) == std::vector<std::string>{ "n1", "n4", "n2", "n0", "n3" });
+    REQUIRE(walk(candidates[2]) == std::vector<std::string>{ "n2", "n0", "n3", "n1", "n4" });
+
+    candidates = origin.split(1);
+    REQUIRE(candidates.size() == 1);
+    REQUIRE(walk(candidates[0]) == std::vector<std::string>{ "n0", "n1", "n2", "n3", "n4" });
+
+    REQUIRE(origin.split(10).size() == 5);
+    REQUIRE(origin.split(0).size() == 1);
+    REQUIRE(couchbase::cluster_options{}.max_parallel_bootstrap_nodes == 1);
+}
+
+TEST_CASE("native: pipelined bootstrap with PLAIN authentication", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+
+    couchbase::cluster_credentials auth{};
+    auth.username = mock.options().username;
+    auth.allowed_sasl_mechanisms = { "PLAIN" };
+
+    SECTION("valid credentials")
+    {
+        asio::io_context io;
+        couchbase::cluster cluster(io);
+        auto io_thread = std::thread([&io]() { io.run(); });
+
+        auth.password = mock.options().password;
+        for (const auto& bucket : { std::optional<std::string>{}, std::make_optional(mock.options().bucket) }) {
+            auto barrier = std::make_shared<std::promise<std::error_code>>();
+            auto f = barrier->get_future();
+            if (bucket) {
+                cluster.open_bucket(*bucket, [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+            } else {
+                cluster.open(couchbase::origin(auth, couchbase::utils::parse_connection_string(mock.connection_string())),
+                             [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+            }
+            auto rc = f.get();
+            INFO(rc.message());
+            REQUIRE_FALSE(rc);
+        }
+
+        couchbase::document_id id{ mock.options().bucket, "_default._default", "foo" };
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"a":1})" });
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+
+        close_cluster(cluster);
+        io_thread.join();
+    }
+
+    SECTION("invalid credentials")
+    {
+        asio::io_context io;
+        couchbase::cluster cluster(io);
+        auto io_thread = std::thread([&io]() { io.run(); });
+
+        auth.password = "wrong password";
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        cluster.open(couchbase::origin(auth, couchbase::utils::parse_connection_string(mock.connection_string())),
+                     [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        REQUIRE(f.get() == couchbase::error::common_errc::authentication_failure);
+
+        close_cluster(cluster);
+        io_thread.join();
+    }
+}
+
+TEST_CASE("native: SCRAM salted password is computed once per process", "[native]")
+{
+    native_init_logger();
+    mock::mock_options options{};
+    options.number_of_nodes = 3;
+    mock::mock_cluster mock(options);
+
+    auto& cache = couchbase::sasl::mechanism::scram::SaltedPasswordCache::instance();
+    cache.clear();
+    auto before = cache.stats();
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+    close_cluster(cluster);
+    io_thread.join();
+
+    auto after = cache.stats();
+    REQUIRE(after.misses - before.misses == 1);
+    REQUIRE(after.hits - before.hits >= options.number_of_nodes);
+    REQUIRE(after.size == 1);
+}
+
+TEST_CASE("native: DNS SRV answers are cached between clusters", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+    mock::mock_dns_server dns{};
+    dns.set_records("_couchbase._tcp.cluster.mock.test", { { "127.0.0.1", mock.kv_port(0), 0, 0, 60 } });
+    auto& dns_config = couchbase::io::dns::dns_config::get();
+    /* the nameserver and the cache are process-wide, so the following tests must not see the mock */
+    auto restore_dns = gsl::finally([&dns_config, address = dns_config.address(), port = dns_config.port()]() {
+        dns_config.set_nameserver(address, port);
+        couchbase::io::dns::dns_cache::instance().clear();
+    });
+    dns_config.set_nameserver(dns.address(), dns.port());
+    couchbase::io::dns::dns_cache::instance().clear();
+
+    auto auth = native_test_credentials(mock.options().username, mock.options().password);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        asio::io_context io;
+        couchbase::cluster cluster(io);
+        auto io_thread = std::thread([&io]() { io.run(); });
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        cluster.open(couchbase::origin(auth, couchbase::utils::parse_connection_string("couchbase://cluster.mock.test")),
+                     [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        auto rc = f.get();
+        INFO(rc.message());
+        REQUIRE_FALSE(rc);
+        close_cluster(cluster);
+        io_thread.join();
+    }
+    REQUIRE(dns.queries("_couchbase._tcp.cluster.mock.test") == 1);
+    REQUIRE(couchbase::io::dns::dns_cache::instance().get_stats().hits >= 1);
+}
+
+TEST_CASE("native: DNS SRV targets are ordered by priority and weight", "[native]")
+{
+    using address = couchbase::io::dns::dns_client::dns_srv_response::address;
+    std::vector<address> targets{
+        { "c.mock.test", 11210, 20, 0, 60 },
+        { "b.mock.test", 11210, 10, 0, 60 },
+        { "a.mock.test", 11210, 10, 100, 60 },
+    };
+    for (int attempt = 0; attempt < 10; ++attempt) {
+        auto ordered = couchbase::io::dns::order_srv_targets(targets);
+        REQUIRE(ordered.size() == 3);
+        REQUIRE(ordered[0].priority == 10);
+        REQUIRE(ordered[1].priority == 10);
+        REQUIRE(ordered[2].hostname == "c.mock.test");
+    }
+}
+
+TEST_CASE("native: mock cluster answers queries", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+    mock.set_query_handler([](const tao::json::value& request) {
+        mock::query_result result{};
+        if (request.at("statement").get_string() == "SELECT 1 AS one") {
+            result.rows.emplace_back(tao::json::value{ { "one", 1 } });
+        } else {
+            result.error = { 3000, "syntax error" };
+        }
+        return result;
+    });
+    mock.set_query_latency(std::chrono::milliseconds(10));
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    {
+        couchbase::operations::query_request req{ "SELECT 1 AS one" };
+        auto resp = execute(cluster, req);
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(resp.payload.rows.size() == 1);
+        REQUIRE(resp.payload.rows[0] == R"({"one":1})");
+    }
+    {
+        couchbase::operations::query_request req{ "SELEKT" };
+        auto resp = execute(cluster, req);
+        REQUIRE(resp.ctx.ec == couchbase::error::common_errc::parsing_failure);
+    }
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: lookup_in with more than 16 specs is split", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    constexpr std::size_t num_of_fields = 20;
+    tao::json::value body = tao::json::empty_object;
+    for (std::size_t i = 0; i < num_of_fields; ++i) {
+        body[fmt::format("f{}", i)] = i;
+    }
+    couchbase::document_id id{ mock.options().bucket, "_default._default", "foo" };
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, tao::json::to_string(body) });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+    {
+        couchbase::operations::lookup_in_request req{ id };
+        for (std::size_t i = num_of_fields; i > 0; --i) {
+            req.specs.add_spec(couchbase::protocol::subdoc_opcode::get, false, fmt::format("f{}", i - 1));
+        }
+        auto requests_before = mock.requests(couchbase::protocol::client_opcode::subdoc_multi_lookup);
+        auto resp = execute(cluster, req);
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(mock.requests(couchbase::protocol::client_opcode::subdoc_multi_lookup) == requests_before + 2);
+        REQUIRE(resp.fields.size() == num_of_fields);
+        for (std::size_t i = 0; i < num_of_fields; ++i) {
+            REQUIRE(resp.fields[i].original_index == i);
+            REQUIRE(resp.fields[i].path == fmt::format("f{}", num_of_fields - i - 1));
+            REQUIRE(resp.fields[i].value == std::to_string(num_of_fields - i - 1));
+        }
+    }
+    {
+        couchbase::operations::get_projected_request req{ id };
+        for (std::size_t i = 0; i < num_of_fields; ++i) {
+            req.projections.emplace_back(fmt::format("f{}", i));
+        }
+        req.with_expiry = true;
+        auto resp = execute(cluster, req);
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(tao::json::from_string(resp.value) == body);
+    }
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: concurrent identical reads are coalesced", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock, "?enable_read_coalescing=true");
+
+    couchbase::document_id id{ mock.options().bucket, "_default._default", "hot" };
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"hot":true})" });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+
+    mock.set_latency(couchbase::protocol::client_opcode::get, std::chrono::milliseconds(100));
+    auto requests_before = mock.requests(couchbase::protocol::client_opcode::get);
+    auto coalesced_before = cluster.telemetry().registry.snapshot().coalescing.coalesced;
+
+    constexpr std::size_t number_of_reads = 50;
+    std::vector<std::future<couchbase::operations::get_response>> futures{};
+    for (std::size_t i = 0; i < number_of_reads; ++i) {
+        auto barrier = std::make_shared<std::promise<couchbase::operations::get_response>>();
+        futures.emplace_back(barrier->get_future());
+        cluster.execute(couchbase::operations::get_request{ id },
+                        [barrier](couchbase::operations::get_response&& resp) mutable { barrier->set_value(std::move(resp)); });
+    }
+    for (auto& f : futures) {
+        auto resp = f.get();
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(resp.value == R"({"hot":true})");
+    }
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) == requests_before + 1);
+    REQUIRE(cluster.telemetry().registry.snapshot().coalescing.coalesced == coalesced_before + number_of_reads - 1);
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: near cache serves repeated reads and is invalidated by mutations", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock, "?near_cache_capacity=100&near_cache_max_staleness=60000");
+
+    couchbase::document_id id{ mock.options().bucket, "_default._default", "config" };
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"version":1})" });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+    auto requests_before = mock.requests(couchbase::protocol::client_opcode::get);
+    for (int i = 0; i < 10; ++i) {
+        auto resp = execute(cluster, couchbase::operations::get_request{ id });
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(resp.value == R"({"version":1})");
+    }
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) == requests_before + 1);
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"version":2})" });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+    {
+        auto resp = execute(cluster, couchbase::operations::get_request{ id });
+        REQUIRE_FALSE(resp.ctx.ec);
+        REQUIRE(resp.value == R"({"version":2})");
+    }
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) == requests_before + 2);
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: DCP consumer streams documents and advances state only after acknowledgement", "[native]")
+{
+    native_init_logger();
+    mock::mock_options options{};
+    options.number_of_vbuckets = 4;
+    options.collections = true;
+    mock::mock_cluster mock(options);
+    constexpr std::size_t number_of_documents = 20;
+    for (std::size_t i = 0; i < number_of_documents; ++i) {
+        mock.store(fmt::format("doc-{}", i), fmt::format(R"({{"id":{},"payload":"{}"}})", i, std::string(100, 'x')));
+    }
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    couchbase::dcp::consumer_options consumer_options{};
+    consumer_options.end_seqno = 1'000;
+    /* the threshold is larger than the snapshot markers, so only the acknowledged documents can trigger buffer acknowledgement */
+    consumer_options.buffer_size = 2'048;
+    /* unknown partition UUID makes the mock roll the partition back to zero */
+    auto& resume = consumer_options.start_state[0];
+    resume.partition_uuid = 42;
+    resume.seqno = 1;
+    resume.snapshot_end = 1;
+    auto consumer = cluster.dcp_consumer(mock.options().bucket, consumer_options);
+
+    std::mutex batches_mutex{};
+    std::vector<couchbase::dcp::batch> batches{};
+    auto barrier = std::make_shared<std::promise<std::error_code>>();
+    auto f = barrier->get_future();
+    consumer->start(
+      [&batches_mutex, &batches](couchbase::dcp::batch&& batch) {
+          std::scoped_lock lock(batches_mutex);
+          batches.emplace_back(std::move(batch));
+      },
+      [barrier](std::error_code ec) { barrier->set_value(ec); });
+    REQUIRE_FALSE(f.get());
+
+    std::set<std::string> keys{};
+    std::size_t rollbacks = 0;
+    std::size_t stream_ends = 0;
+    {
+        std::scoped_lock lock(batches_mutex);
+        for (const auto& batch : batches) {
+            for (const auto& e : batch.events) {
+                switch (e.type) {
+                    case couchbase::dcp::event_type::mutation:
+                        REQUIRE(e.collection_id == 0);
+                        keys.insert(e.key);
+                        break;
+                    case couchbase::dcp::event_type::rollback:
+                        REQUIRE(e.partition == 0);
+                        REQUIRE(e.by_seqno == 0);
+                        ++rollbacks;
+                        break;
+                    case couchbase::dcp::event_type::stream_end:
+                        REQUIRE(e.reason == couchbase::dcp::stream_end_reason::ok);
+                        ++stream_ends;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+    REQUIRE(keys.size() == number_of_documents);
+    REQUIRE(keys.count("doc-0") == 1);
+    REQUIRE(rollbacks == 1);
+    REQUIRE(stream_ends == options.number_of_vbuckets);
+
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::dcp_buffer_acknowledgement) == 0);
+    for (const auto& [partition, state] : consumer->state()) {
+        REQUIRE(state.seqno == (partition == 0 ? 1 : 0));
+    }
+
+    {
+        std::scoped_lock lock(batches_mutex);
+        for (auto& batch : batches) {
+            consumer->acknowledge(std::move(batch));
+        }
+        batches.clear();
+    }
+    std::uint64_t acknowledged_documents = 0;
+    for (const auto& [partition, state] : consumer->state()) {
+        acknowledged_documents += state.seqno;
+    }
+    REQUIRE(acknowledged_documents == number_of_documents);
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: reads after mutation are not attached to the read in flight", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock, "?enable_read_coalescing=true");
+
+    couchbase::document_id id{ mock.options().bucket, "_default._default", "counter" };
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"version":1})" });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+
+    mock.set_latency(couchbase::protocol::client_opcode::get, std::chrono::milliseconds(200));
+    auto requests_before = mock.requests(couchbase::protocol::client_opcode::get);
+
+    auto get = [&cluster, &id]() {
+        auto barrier = std::make_shared<std::promise<couchbase::operations::get_response>>();
+        auto f = barrier->get_future();
+        cluster.execute(couchbase::operations::get_request{ id },
+                        [barrier](couchbase::operations::get_response&& resp) mutable { barrier->set_value(std::move(resp)); });
+        return f;
+    };
+    auto leader = get();
+    auto attached = get();
+    {
+        auto resp = execute(cluster, couchbase::operations::upsert_request{ id, R"({"version":2})" });
+        REQUIRE_FALSE(resp.ctx.ec);
+    }
+    auto after_mutation = get();
+
+    REQUIRE(leader.get().value == R"({"version":1})");
+    REQUIRE(attached.get().value == R"({"version":1})");
+    REQUIRE(after_mutation.get().value == R"({"version":2})");
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) == requests_before + 2);
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+static couchbase::operations::get_multi_response
+execute_get_multi(couchbase::cluster& cluster, couchbase::operations::get_multi_request request)
+{
+    auto barrier = std::make_shared<std::promise<couchbase::operations::get_multi_response>>();
+    auto f = barrier->get_future();
+    cluster.execute(std::move(request), [barrier](couchbase::operations::get_multi_response&& resp) mutable {
+        barrier->set_value(std::move(resp));
+    });
+    return f.get();
+}
+
+TEST_CASE("native: get_multi keeps order of the entries and limits requests in flight per node", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+    constexpr std::size_t number_of_documents = 10;
+    couchbase::operations::get_multi_request request{};
+    for (std::size_t i = 0; i < number_of_documents; ++i) {
+        mock.store(fmt::format("doc-{}", i), fmt::format(R"({{"id":{}}})", i));
+        request.ids.emplace_back(couchbase::document_id{ mock.options().bucket, "_default._default", fmt::format("doc-{}", i) });
+    }
+    request.ids.emplace_back(couchbase::document_id{ mock.options().bucket, "_default._default", "missing" });
+    request.max_in_flight_per_node = 2;
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    mock.set_latency(couchbase::protocol::client_opcode::get, std::chrono::milliseconds(300));
+    auto requests_before = mock.requests(couchbase::protocol::client_opcode::get);
+    auto barrier = std::make_shared<std::promise<couchbase::operations::get_multi_response>>();
+    auto f = barrier->get_future();
+    cluster.execute(request, [barrier](couchbase::operations::get_multi_response&& resp) mutable { barrier->set_value(std::move(resp)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    /* the mock has a single node, so only the window is in flight until the first responses arrive */
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) == requests_before + 2);
+
+    auto resp = f.get();
+    REQUIRE(resp.entries.size() == number_of_documents + 1);
+    for (std::size_t i = 0; i < number_of_documents; ++i) {
+        INFO(i);
+        REQUIRE_FALSE(resp.entries[i].ctx.ec);
+        REQUIRE(resp.entries[i].ctx.id.key == fmt::format("doc-{}", i));
+        REQUIRE(resp.entries[i].value == fmt::format(R"({{"id":{}}})", i));
+    }
+    REQUIRE(resp.entries[number_of_documents].ctx.ec == couchbase::error::key_value_errc::document_not_found);
+    REQUIRE(mock.requests(couchbase::protocol::client_opcode::get) == requests_before + number_of_documents + 1);
+
+    close_cluster(cluster);
+    io_thread.join();
+}
+
+TEST_CASE("native: get_multi completes every entry when the bucket is closed", "[native]")
+{
+    native_init_logger();
+    mock::mock_cluster mock{};
+    couchbase::operations::get_multi_request request{};
+    for (std::size_t i = 0; i < 10; ++i) {
+        mock.store(fmt::format("doc-{}", i), "{}");
+        request.ids.emplace_back(couchbase::document_id{ mock.options().bucket, "_default._default", fmt::format("doc-{}", i) });
+    }
+    request.max_in_flight_per_node = 1;
+
+    asio::io_context io;
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+    open_cluster(cluster, mock);
+
+    /* the bucket is closed while the batch is in flight */
+    mock.set_latency(couchbase::protocol::client_opcode::get, std::chrono::milliseconds(200));
+    auto barrier = std::make_shared<std::promise<couchbase::operations::get_multi_response>>();
+    auto f = barrier->get_future();
+    cluster.execute(request, [barrier](couchbase::operations::get_multi_response&& resp) mutable { barrier->set_value(std::move(resp)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    close_cluster(cluster);
+    REQUIRE(f.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    auto resp = f.get();
+    REQUIRE(resp.entries.size() == request.ids.size());
+    REQUIRE(resp.entries.back().ctx.ec == couchbase::error::common_errc::request_canceled);
+
+    /* and the batch is requested after the bucket has been closed */
+    resp = execute_get_multi(cluster, request);
+    REQUIRE(resp.entries.size() == request.ids.size());
+    for (const auto& entry : resp.entries) {
+        REQUIRE(entry.ctx.ec == couchbase::error::common_errc::request_canceled);
+    }
+
+    io_thread.join();
+}
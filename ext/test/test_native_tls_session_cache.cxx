@@ -0,0 +1,186 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *   Copyright 2020-2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "test_helper_native.hxx"
+
+#include <io/tls_session_cache.hxx>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+/**
+ * Server context with self-signed certificate, generated for every test.
+ */
+static void
+configure_server(asio::ssl::context& server)
+{
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    REQUIRE(EVP_PKEY_keygen_init(key_ctx) == 1);
+    REQUIRE(EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx, NID_X9_62_prime256v1) == 1);
+    REQUIRE(EVP_PKEY_keygen(key_ctx, &key) == 1);
+    EVP_PKEY_CTX_free(key_ctx);
+
+    X509* cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    REQUIRE(X509_sign(cert, key, EVP_sha256()) > 0);
+
+    REQUIRE(SSL_CTX_use_certificate(server.native_handle(), cert) == 1);
+    REQUIRE(SSL_CTX_use_PrivateKey(server.native_handle(), key) == 1);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+/**
+ * Runs the handshake between client and server over in-memory BIO pair.
+ *
+ * @return true if the client has resumed the session
+ */
+static bool
+handshake(asio::ssl::context& client, asio::ssl::context& server, const asio::ip::tcp::endpoint& endpoint)
+{
+    auto& cache = couchbase::io::tls_session_cache::instance();
+    std::string key{};
+    SSL* client_ssl = SSL_new(client.native_handle());
+    SSL* server_ssl = SSL_new(server.native_handle());
+    BIO* client_bio = nullptr;
+    BIO* server_bio = nullptr;
+    REQUIRE(BIO_new_bio_pair(&client_bio, 0, &server_bio, 0) == 1);
+    SSL_set_bio(client_ssl, client_bio, client_bio);
+    SSL_set_bio(server_ssl, server_bio, server_bio);
+    SSL_set_connect_state(client_ssl);
+    SSL_set_accept_state(server_ssl);
+
+    cache.prepare(client_ssl, key, endpoint);
+    bool client_done = false;
+    bool server_done = false;
+    for (int round = 0; round < 100 && !(client_done && server_done); ++round) {
+        client_done = client_done || SSL_do_handshake(client_ssl) == 1;
+        server_done = server_done || SSL_do_handshake(server_ssl) == 1;
+    }
+    REQUIRE(client_done);
+    REQUIRE(server_done);
+    /* TLS 1.3 tickets arrive after the handshake, and the client processes them on read */
+    char byte = 0;
+    REQUIRE(SSL_read(client_ssl, &byte, sizeof(byte)) <= 0);
+
+    bool resumed = cache.record_handshake(client_ssl, key, {}, std::chrono::microseconds(10));
+    SSL_free(client_ssl);
+    SSL_free(server_ssl);
+    return resumed;
+}
+
+/**
+ * Records failed handshake for the endpoint, as the stream does when the server rejects the connection.
+ */
+static void
+fail_handshake(asio::ssl::context& client, const asio::ip::tcp::endpoint& endpoint)
+{
+    auto& cache = couchbase::io::tls_session_cache::instance();
+    std::string key{};
+    SSL* client_ssl = SSL_new(client.native_handle());
+    cache.prepare(client_ssl, key, endpoint);
+    auto ec = std::make_error_code(std::errc::connection_reset);
+    REQUIRE_FALSE(cache.record_handshake(client_ssl, key, ec, std::chrono::microseconds(10)));
+    SSL_free(client_ssl);
+}
+
+TEST_CASE("native: TLS sessions are cached and resumed per endpoint", "[native]")
+{
+    asio::ssl::context server(asio::ssl::context::tls_server);
+    configure_server(server);
+    asio::ssl::context client(asio::ssl::context::tls_client);
+    couchbase::io::tls_session_cache::enable(client);
+    auto& cache = couchbase::io::tls_session_cache::instance();
+
+    asio::ip::tcp::endpoint first(asio::ip::make_address("192.0.2.1"), 11207);
+    asio::ip::tcp::endpoint second(asio::ip::make_address("192.0.2.2"), 11207);
+
+    REQUIRE_FALSE(handshake(client, server, first));
+    REQUIRE(handshake(client, server, first));
+    REQUIRE_FALSE(handshake(client, server, second));
+    REQUIRE(handshake(client, server, second));
+
+    auto stats = cache.stats(client);
+    REQUIRE(stats.has_value());
+    REQUIRE(stats->full_handshakes == 2);
+    REQUIRE(stats->resumed_handshakes == 2);
+    REQUIRE(stats->failed_handshakes == 0);
+    REQUIRE(stats->total_handshake_us == 40);
+    REQUIRE(stats->max_handshake_us == 10);
+
+    cache.forget(client);
+}
+
+TEST_CASE("native: TLS session is evicted after failed handshake", "[native]")
+{
+    asio::ssl::context server(asio::ssl::context::tls_server);
+    configure_server(server);
+    asio::ssl::context client(asio::ssl::context::tls_client);
+    couchbase::io::tls_session_cache::enable(client);
+    auto& cache = couchbase::io::tls_session_cache::instance();
+
+    asio::ip::tcp::endpoint failed(asio::ip::make_address("192.0.2.1"), 11207);
+    asio::ip::tcp::endpoint healthy(asio::ip::make_address("192.0.2.2"), 11207);
+
+    REQUIRE_FALSE(handshake(client, server, failed));
+    REQUIRE_FALSE(handshake(client, server, healthy));
+    fail_handshake(client, failed);
+
+    REQUIRE_FALSE(handshake(client, server, failed));
+    REQUIRE(handshake(client, server, healthy));
+
+    auto stats = cache.stats(client);
+    REQUIRE(stats.has_value());
+    REQUIRE(stats->full_handshakes == 3);
+    REQUIRE(stats->resumed_handshakes == 1);
+    REQUIRE(stats->failed_handshakes == 1);
+
+    cache.forget(client);
+}
+
+TEST_CASE("native: forgetting TLS context drops its sessions and statistics", "[native]")
+{
+    asio::ssl::context server(asio::ssl::context::tls_server);
+    configure_server(server);
+    asio::ssl::context client(asio::ssl::context::tls_client);
+    couchbase::io::tls_session_cache::enable(client);
+    asio::ssl::context other_client(asio::ssl::context::tls_client);
+    couchbase::io::tls_session_cache::enable(other_client);
+    auto& cache = couchbase::io::tls_session_cache::instance();
+
+    asio::ip::tcp::endpoint endpoint(asio::ip::make_address("192.0.2.1"), 11207);
+
+    REQUIRE_FALSE(handshake(client, server, endpoint));
+    REQUIRE_FALSE(handshake(other_client, server, endpoint));
+
+    cache.forget(client);
+    REQUIRE_FALSE(cache.stats(client).has_value());
+    REQUIRE_FALSE(handshake(client, server, endpoint));
+
+    /* sessions of the other context are not affected */
+    REQUIRE(handshake(other_client, server, endpoint));
+
+    cache.forget(client);
+    cache.forget(other_client);
+}
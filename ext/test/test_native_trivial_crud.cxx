@@ -25,13 +25,11 @@ uniq_id(const std::string& prefix)
 
 TEST_CASE("native: upsert document into default collection", "[native]")
 {
-    auto ctx = test_context::load_from_environment();
+    auto ctx = native_test_context();
     native_init_logger();
 
     auto connstr = couchbase::utils::parse_connection_string(ctx.connection_string);
-    couchbase::cluster_credentials auth{};
-    auth.username = ctx.username;
-    auth.password = ctx.password;
+    auto auth = native_test_credentials(ctx.username, ctx.password);
 
     asio::io_context io;
 
@@ -81,3 +79,72 @@ TEST_CASE("native: upsert document into default collection", "[native]")
 
     io_thread.join();
 }
+
+TEST_CASE("native: fetch multiple documents preserving order of the keys", "[native]")
+{
+    auto ctx = native_test_context();
+    native_init_logger();
+
+    auto connstr = couchbase::utils::parse_connection_string(ctx.connection_string);
+    auto auth = native_test_credentials(ctx.username, ctx.password);
+
+    asio::io_context io;
+
+    couchbase::cluster cluster(io);
+    auto io_thread = std::thread([&io]() { io.run(); });
+
+    {
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        cluster.open(couchbase::origin(auth, connstr), [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        auto rc = f.get();
+        INFO(rc.message());
+        REQUIRE_FALSE(rc);
+    }
+    {
+        auto barrier = std::make_shared<std::promise<std::error_code>>();
+        auto f = barrier->get_future();
+        cluster.open_bucket(ctx.bucket, [barrier](std::error_code ec) mutable { barrier->set_value(ec); });
+        auto rc = f.get();
+        INFO(rc.message());
+        REQUIRE_FALSE(rc);
+    }
+    std::vector<couchbase::document_id> ids{};
+    for (int i = 0; i < 100; ++i) {
+        couchbase::document_id id{ ctx.bucket, "_default._default", uniq_id(fmt::format("multi_{}", i)) };
+        couchbase::operations::upsert_request req{ id, fmt::format(R"({{"index":{}}})", i) };
+        auto barrier = std::make_shared<std::promise<couchbase::operations::upsert_response>>();
+        auto f = barrier->get_future();
+        cluster.execute(req, [barrier](couchbase::operations::upsert_response resp) mutable { barrier->set_value(resp); });
+        auto resp = f.get();
+        INFO(resp.ctx.ec.message());
+        REQUIRE_FALSE(resp.ctx.ec);
+        ids.emplace_back(id);
+    }
+    ids.emplace_back(couchbase::document_id{ ctx.bucket, "_default._default", uniq_id("missing") });
+    ids.emplace_back(couchbase::document_id{ "this_bucket_does_not_exist", "_default._default", uniq_id("foo") });
+    {
+        couchbase::operations::get_multi_request req{ ids };
+        req.max_in_flight_per_node = 4;
+        auto barrier = std::make_shared<std::promise<couchbase::operations::get_multi_response>>();
+        auto f = barrier->get_future();
+        cluster.execute(req, [barrier](couchbase::operations::get_multi_response resp) mutable { barrier->set_value(resp); });
+        auto resp = f.get();
+        REQUIRE(resp.entries.size() == ids.size());
+        for (std::size_t i = 0; i < 100; ++i) {
+            INFO(resp.entries[i].ctx.ec.message());
+            REQUIRE_FALSE(resp.entries[i].ctx.ec);
+            REQUIRE(resp.entries[i].value == fmt::format(R"({{"index":{}}})", i));
+        }
+        REQUIRE(resp.entries[100].ctx.ec == couchbase::error::key_value_errc::document_not_found);
+        REQUIRE(resp.entries[101].ctx.ec == couchbase::error::common_errc::bucket_not_found);
+    }
+    {
+        auto barrier = std::make_shared<std::promise<void>>();
+        auto f = barrier->get_future();
+        cluster.close([barrier]() { barrier->set_value(); });
+        f.get();
+    }
+
+    io_thread.join();
+}
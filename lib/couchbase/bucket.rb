@@ -18,6 +18,7 @@ require "couchbase/management/view_index_manager"
 require "couchbase/options"
 require "couchbase/view_options"
 require "couchbase/diagnostics"
+require "couchbase/dcp"
 
 module Couchbase
   # Provides access to a Couchbase bucket APIs
@@ -107,6 +108,15 @@ module Couchbase
       Management::ViewIndexManager.new(@backend, @name)
     end
 
+    # Opens a stream of changes of the bucket
+    #
+    # @param [Hash] options see {DCP::Consumer#initialize}
+    #
+    # @return [DCP::Consumer]
+    def dcp_consumer(options = {})
+      DCP::Consumer.new(@backend, @name, options)
+    end
+
     # Performs application-level ping requests against services in the couchbase cluster
     #
     # @param [Options::Ping] options
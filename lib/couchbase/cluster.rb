@@ -23,6 +23,7 @@ require "couchbase/search_options"
 require "couchbase/query_options"
 require "couchbase/analytics_options"
 require "couchbase/diagnostics"
+require "couchbase/future"
 
 module Couchbase
   # The main entry point when connecting to a Couchbase cluster.
@@ -93,31 +94,24 @@ module Couchbase
     #
     # @return [QueryResult]
     def query(statement, options = Options::Query.new)
-      resp = @backend.document_query(statement, options.to_backend)
+      build_query_result(@backend.document_query(statement, options.to_backend))
+    end
 
-      QueryResult.new do |res|
-        res.meta_data = QueryMetaData.new do |meta|
-          meta.status = resp[:meta][:status]
-          meta.request_id = resp[:meta][:request_id]
-          meta.client_context_id = resp[:meta][:client_context_id]
-          meta.signature = JSON.parse(resp[:meta][:signature]) if resp[:meta][:signature]
-          meta.profile = JSON.parse(resp[:meta][:profile]) if resp[:meta][:profile]
-          meta.metrics = QueryMetrics.new do |metrics|
-            if resp[:meta][:metrics]
-              metrics.elapsed_time = resp[:meta][:metrics][:elapsed_time]
-              metrics.execution_time = resp[:meta][:metrics][:execution_time]
-              metrics.sort_count = resp[:meta][:metrics][:sort_count]
-              metrics.result_count = resp[:meta][:metrics][:result_count]
-              metrics.result_size = resp[:meta][:metrics][:result_size]
-              metrics.mutation_count = resp[:meta][:metrics][:mutation_count]
-              metrics.error_count = resp[:meta][:metrics][:error_count]
-              metrics.warning_count = resp[:meta][:metrics][:warning_count]
-            end
-          end
-          res[:warnings] = resp[:warnings].map { |warn| QueryWarning.new(warn[:code], warn[:message]) } if resp[:warnings]
-        end
-        res.instance_variable_set("@rows", resp[:rows])
-      end
+    # Performs a query against the query (N1QL) services without blocking the caller
+    #
+    # @param [String] statement the N1QL query statement
+    # @param [Options::Query] options the custom options for this query
+    #
+    # @example Run several queries concurrently
+    #   futures = ["airline", "airport"].map do |type|
+    #     cluster.query_async("SELECT COUNT(*) AS cnt FROM `travel-sample` WHERE type = $1",
+    #                         Options::Query(positional_parameters: [type]))
+    #   end
+    #   futures.map { |future| future.value.rows.first["cnt"] }
+    #
+    # @return [Future<QueryResult>]
+    def query_async(statement, options = Options::Query.new)
+      Future.new(@backend.document_query_async(statement, options.to_backend)) { |resp| build_query_result(resp) }
     end
 
     # Performs an analytics query
@@ -304,6 +298,7 @@ module Couchbase
         res.version = resp[:version]
         res.id = resp[:id]
         res.sdk = resp[:sdk]
+        res.tls = resp[:tls]
         resp[:services].each do |type, svcs|
           res.services[type] = svcs.map do |svc|
             DiagnosticsResult::ServiceInfo.new do |info|
@@ -347,6 +342,32 @@ module Couchbase
 
     private
 
+    def build_query_result(resp)
+      QueryResult.new do |res|
+        res.meta_data = QueryMetaData.new do |meta|
+          meta.status = resp[:meta][:status]
+          meta.request_id = resp[:meta][:request_id]
+          meta.client_context_id = resp[:meta][:client_context_id]
+          meta.signature = JSON.parse(resp[:meta][:signature]) if resp[:meta][:signature]
+          meta.profile = JSON.parse(resp[:meta][:profile]) if resp[:meta][:profile]
+          meta.metrics = QueryMetrics.new do |metrics|
+            if resp[:meta][:metrics]
+              metrics.elapsed_time = resp[:meta][:metrics][:elapsed_time]
+              metrics.execution_time = resp[:meta][:metrics][:execution_time]
+              metrics.sort_count = resp[:meta][:metrics][:sort_count]
+              metrics.result_count = resp[:meta][:metrics][:result_count]
+              metrics.result_size = resp[:meta][:metrics][:result_size]
+              metrics.mutation_count = resp[:meta][:metrics][:mutation_count]
+              metrics.error_count = resp[:meta][:metrics][:error_count]
+              metrics.warning_count = resp[:meta][:metrics][:warning_count]
+            end
+          end
+          res[:warnings] = resp[:warnings].map { |warn| QueryWarning.new(warn[:code], warn[:message]) } if resp[:warnings]
+        end
+        res.instance_variable_set("@rows", resp[:rows])
+      end
+    end
+
     # Initialize {Cluster} object
     #
     # @overload new(connection_string, options)
@@ -15,6 +15,7 @@
 require "couchbase/errors"
 require "couchbase/collection_options"
 require "couchbase/binary_collection"
+require "couchbase/future"
 
 module Couchbase
   # Provides access to all collection APIs
@@ -84,6 +85,30 @@ module Couchbase
       end
     end
 
+    # Fetches the full document from the collection without blocking the caller
+    #
+    # @param [String] id the document id which is used to uniquely identify it
+    # @param [Options::Get] options request customization, projections are not supported
+    #
+    # @example Fetch several documents concurrently
+    #   futures = ["foo", "bar"].map { |id| collection.get_async(id) }
+    #   futures.map { |future| future.value.content }
+    #
+    # @return [Future<GetResult>]
+    def get_async(id, options = Options::Get.new)
+      raise ArgumentError, "projections are not supported by #get_async" if options.need_projected_get?
+
+      future = @backend.document_get_async(bucket_name, "#{@scope_name}.#{@name}", id, options.to_backend)
+      Future.new(future) do |resp|
+        GetResult.new do |res|
+          res.transcoder = options.transcoder
+          res.cas = resp[:cas]
+          res.flags = resp[:flags]
+          res.encoded = resp[:content]
+        end
+      end
+    end
+
     # Fetches multiple documents from the collection.
     #
     # @note that it will not generate {Error::DocumentNotFound} exceptions in this case. The caller should check
@@ -225,6 +250,17 @@ module Couchbase
       end
     end
 
+    # Removes a document from the collection without blocking the caller
+    #
+    # @param [String] id the document id which is used to uniquely identify it.
+    # @param [Options::Remove] options request customization
+    #
+    # @return [Future<MutationResult>]
+    def remove_async(id, options = Options::Remove.new)
+      future = @backend.document_remove_async(bucket_name, "#{@scope_name}.#{@name}", id, options.to_backend)
+      Future.new(future) { |resp| build_mutation_result(resp) }
+    end
+
     # Removes a list of the documents from the collection
     #
     # @note that it will not generate {Error::DocumentNotFound} or {Error::CasMismatch} exceptions in this case.
@@ -292,6 +328,19 @@ module Couchbase
       end
     end
 
+    # Inserts a full document without blocking the caller
+    #
+    # @param [String] id the document id which is used to uniquely identify it.
+    # @param [Object] content the document content
+    # @param [Options::Insert] options request customization
+    #
+    # @return [Future<MutationResult>]
+    def insert_async(id, content, options = Options::Insert.new)
+      blob, flags = options.transcoder ? options.transcoder.encode(content) : [content, 0]
+      future = @backend.document_insert_async(bucket_name, "#{@scope_name}.#{@name}", id, blob, flags, options.to_backend)
+      Future.new(future) { |resp| build_mutation_result(resp) }
+    end
+
     # Upserts (inserts or updates) a full document which might or might not exist yet
     #
     # @param [String] id the document id which is used to uniquely identify it.
@@ -312,6 +361,19 @@ module Couchbase
       end
     end
 
+    # Upserts a full document without blocking the caller
+    #
+    # @param [String] id the document id which is used to uniquely identify it.
+    # @param [Object] content the document content
+    # @param [Options::Upsert] options request customization
+    #
+    # @return [Future<MutationResult>]
+    def upsert_async(id, content, options = Options::Upsert.new)
+      blob, flags = options.transcoder ? options.transcoder.encode(content) : [content, 0]
+      future = @backend.document_upsert_async(bucket_name, "#{@scope_name}.#{@name}", id, blob, flags, options.to_backend)
+      Future.new(future) { |resp| build_mutation_result(resp) }
+    end
+
     # Upserts (inserts or updates) a list of documents which might or might not exist yet
     #
     # @note that it will not generate exceptions in this case. The caller should check {MutationResult#error} property of the
@@ -366,6 +428,19 @@ module Couchbase
       end
     end
 
+    # Replaces a full document without blocking the caller
+    #
+    # @param [String] id the document id which is used to uniquely identify it.
+    # @param [Object] content the document content
+    # @param [Options::Replace] options request customization
+    #
+    # @return [Future<MutationResult>]
+    def replace_async(id, content, options = Options::Replace.new)
+      blob, flags = options.transcoder ? options.transcoder.encode(content) : [content, 0]
+      future = @backend.document_replace_async(bucket_name, "#{@scope_name}.#{@name}", id, blob, flags, options.to_backend)
+      Future.new(future) { |resp| build_mutation_result(resp) }
+    end
+
     # Update the expiration of the document with the given id
     #
     # @param [String] id the document id which is used to uniquely identify it.
@@ -507,6 +582,13 @@ module Couchbase
 
     private
 
+    def build_mutation_result(resp)
+      MutationResult.new do |res|
+        res.cas = resp[:cas]
+        res.mutation_token = extract_mutation_token(resp)
+      end
+    end
+
     def extract_mutation_token(resp)
       MutationToken.new do |token|
         token.partition_id = resp[:mutation_token][:partition_id]
@@ -0,0 +1,81 @@
+#  Copyright 2020-2021 Couchbase, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+
+module Couchbase
+  module DCP
+    # Streams changes of the bucket using Database Change Protocol.
+    #
+    # Events are delivered in batches. The next batch is requested only after the previous one has been processed, so a slow
+    # consumer never lets the server queue more than +buffer_size+ bytes per node.
+    class Consumer
+      # @param [Couchbase::Backend] backend
+      # @param [String] bucket_name
+      # @param [Hash] options
+      # @option options [String] :connection_name name of the DCP connection, visible in server stats
+      # @option options [Array<Integer>] :partitions partitions to stream (all partitions by default)
+      # @option options [Hash<Integer, Hash>] :start_state state returned by {#state} to resume from
+      # @option options [Integer] :end_seqno sequence number where the streams stop (infinite by default)
+      # @option options [Boolean] :include_xattrs
+      # @option options [Boolean] :no_value stream keys and metadata only
+      # @option options [Array<Integer>] :collections IDs of the collections to stream (all collections by default)
+      # @option options [Integer] :stream_flags flags of the DCP stream requests (e.g. +0x10+ to stream active partitions only)
+      # @option options [Integer] :buffer_size flow control window in bytes
+      # @option options [Integer] :batch_size maximum number of events in a batch
+      # @option options [Integer] :flush_interval maximum delay of a partial batch in milliseconds
+      #
+      # @api private
+      def initialize(backend, bucket_name, options = {})
+        @backend = backend
+        @id = @backend.dcp_open(bucket_name, options)
+      end
+
+      # Yields batches of events until all streams have ended or the consumer is closed
+      #
+      # Each event is a Hash with +:type+ (+:mutation+, +:deletion+, +:expiration+, +:stream_end+ or +:rollback+), +:partition+
+      # and +:seqno+. Document events also carry +:id+, +:collection_id+, +:cas+ and (for mutations) +:content+, +:flags+ and
+      # +:expiry+.
+      #
+      # The batch is acknowledged only when the block returns. If the block raises, the batch will be yielded again by the next
+      # call.
+      #
+      # @param [Integer] timeout how long to wait for the next batch in milliseconds
+      #
+      # @yieldparam [Array<Hash>] events
+      def each_batch(timeout: 1_000)
+        return enum_for(:each_batch, timeout: timeout) unless block_given?
+
+        loop do
+          events = @backend.dcp_poll(@id, timeout)
+          break if events.nil?
+
+          next if events.empty?
+
+          yield events
+          @backend.dcp_ack(@id)
+        end
+      end
+
+      # @return [Hash<Integer, Hash>] position of every partition after the last processed batch, suitable for +:start_state+
+      def state
+        @backend.dcp_state(@id)
+      end
+
+      # Closes the streams and the DCP connections
+      def close
+        @backend.dcp_close(@id)
+      end
+    end
+  end
+end
@@ -76,6 +76,17 @@ module Couchbase
     # @return [Hash<Symbol, ServiceInfo>] map service types to info
     attr_accessor :services
 
+    # Statistics of TLS handshakes since the cluster has been opened (+nil+ for plain connections)
+    #
+    # :full_handshakes:: handshakes that performed key exchange and certificate verification
+    # :resumed_handshakes:: handshakes that resumed cached TLS session
+    # :failed_handshakes:: handshakes that have failed
+    # :total_handshake_us:: total time spent in handshakes (in microseconds)
+    # :max_handshake_us:: the longest handshake (in microseconds)
+    #
+    # @return [Hash<Symbol, Integer>, nil]
+    attr_accessor :tls
+
     # @yieldparam [DiagnosticsResult] self
     def initialize
       @services = {}
@@ -92,6 +103,7 @@ module Couchbase
         id: @id,
         sdk: @sdk,
         services: @services,
+        tls: @tls,
       }.to_json(*args)
     end
   end
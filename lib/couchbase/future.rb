@@ -0,0 +1,128 @@
+#  Copyright 2020-2021 Couchbase, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+require "io/wait"
+
+module Couchbase
+  # The result of an operation that runs in the background, returned by the +*_async+ methods.
+  #
+  # Asynchronous variants exist only for {Collection#get_async}, {Collection#insert_async}, {Collection#upsert_async},
+  # {Collection#replace_async}, {Collection#remove_async} and {Cluster#query_async}.
+  #
+  # Without +Fiber.scheduler+ {#value} waits without holding the GVL. Under +Fiber.scheduler+ (Ruby 3.0+) it waits with
+  # +IO#wait_readable+ on the descriptor, that the backend shares between all its futures, so only the calling fiber is suspended.
+  #
+  # @example Fetch several documents concurrently
+  #   futures = ["foo", "bar", "baz"].map { |id| collection.get_async(id) }
+  #   futures.map(&:value).map(&:content)
+  class Future
+    # @api private
+    #
+    # @param [Couchbase::Backend::Future] backend_future
+    # @yieldparam [Hash] resp the response of the backend, converted to the public result
+    def initialize(backend_future, &block)
+      @future = backend_future
+      @transform = block
+    end
+
+    # @return [Boolean] true if the operation has completed, and {#value} will not wait
+    def completed?
+      @future.nil? || @future.completed?
+    end
+
+    # Waits for the operation to complete
+    #
+    # @raise [Error::CouchbaseError] if the operation has failed
+    # @return [Object] the result of the operation
+    def value
+      resolve unless @future.nil?
+      raise @error if @error
+
+      @value
+    end
+
+    private
+
+    def resolve
+      if Fiber.respond_to?(:scheduler) && Fiber.scheduler
+        CompletionQueue.for(@future.fileno).wait_for(@future)
+      else
+        @future.wait until @future.completed?
+      end
+      begin
+        resp = @future.result
+        @value = @transform ? @transform.call(resp) : resp
+      rescue StandardError => e
+        @error = e
+      ensure
+        @future = nil
+      end
+    end
+
+    # Lets fibers share the wakeup descriptor of the backend. One waiter at a time waits for the descriptor and drains it, the
+    # others wait on the condition variable, and check their futures every time the descriptor has been drained.
+    #
+    # @api private
+    class CompletionQueue
+      QUEUES = {} # rubocop:disable Style/MutableConstant guarded by QUEUES_MUTEX
+      QUEUES_MUTEX = Mutex.new
+
+      # @param [Integer] fileno descriptor of the backend, the queue exists until the end of the process
+      # @return [CompletionQueue]
+      def self.for(fileno)
+        QUEUES_MUTEX.synchronize { QUEUES[fileno] ||= new(fileno) }
+      end
+
+      def initialize(fileno)
+        @io = IO.for_fd(fileno, autoclose: false)
+        @mutex = Mutex.new
+        @drained = ConditionVariable.new
+        @draining = false
+      end
+
+      # @param [Couchbase::Backend::Future] future
+      def wait_for(future)
+        until future.completed?
+          next unless become_drainer(future)
+
+          begin
+            @io.wait_readable
+            future.drain
+          ensure
+            @mutex.synchronize do
+              @draining = false
+              @drained.broadcast
+            end
+          end
+        end
+      end
+
+      private
+
+      # @return [Boolean] true if the caller has to wait for the descriptor, false if it has to check its future again
+      def become_drainer(future)
+        @mutex.synchronize do
+          # the previous drainer might have consumed the wakeup of this future, after it has been checked last time
+          return false if future.completed?
+
+          if @draining
+            @drained.wait(@mutex)
+            return false
+          end
+          @draining = true
+        end
+      end
+    end
+  end
+end
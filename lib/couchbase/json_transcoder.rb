@@ -29,4 +29,29 @@ module Couchbase
       JSON.parse(blob) unless blob&.empty?
     end
   end
+
+  # Transcoder, that converts documents to JSON and back in the native extension.
+  #
+  # Supports String, Symbol, Integer, Float, +true+, +false+, +nil+, Array and Hash with String or Symbol keys, and raises
+  # {Error::EncodingFailure} for other types. Large documents are parsed without holding the GVL.
+  #
+  # @example Use the native transcoder for the single operation
+  #   collection.get("mydoc", Options::Get(transcoder: NativeJsonTranscoder.new))
+  #
+  # @example Decode query rows with the native transcoder
+  #   cluster.query("SELECT * FROM `travel-sample` LIMIT 10").rows(NativeJsonTranscoder.new)
+  class NativeJsonTranscoder
+    # @param [Object] document
+    # @return [Array<String, Integer>] pair of encoded document and flags
+    def encode(document)
+      [Backend.json_generate(document), (0x02 << 24) | 0x06]
+    end
+
+    # @param [String, nil] blob string of bytes, containing encoded representation of the document
+    # @param [Integer, :json] _flags bit field, describing how the data encoded
+    # @return Object decoded document
+    def decode(blob, _flags)
+      Backend.json_parse(blob) unless blob.nil? || blob.empty?
+    end
+  end
 end
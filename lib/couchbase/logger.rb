@@ -33,6 +33,23 @@ module Couchbase
     Backend.set_log_level(level)
   end
 
+  # Set log level and choose how the messages are written
+  #
+  # @example Log debug messages from the background thread, so that IO threads never wait for the output
+  #   Couchbase.set_log_level(:debug, async: true)
+  #
+  # @param [Symbol] level new log level (see {log_level=})
+  # @param [Boolean, nil] async if +true+, IO threads only put messages into the queue, and they are formatted and written by the
+  #   background thread. Messages that do not fit into the queue are dropped and counted. If +nil+, the current mode is kept.
+  # @param [Integer, nil] queue_size capacity of the queue of the asynchronous logger (8192 by default)
+  #
+  # @note The background thread does not survive +fork+, so the child process has to enable asynchronous mode again.
+  #
+  # @return [void]
+  def self.set_log_level(level, async: nil, queue_size: nil)
+    Backend.set_log_level(level, {async: async, queue_size: queue_size})
+  end
+
   # Get current log level
   #
   # @return [Symbol] current log level
@@ -24,11 +24,15 @@ module Couchbase
 
       # Returns all rows converted using a transcoder
       #
+      # @param [:json, JsonTranscoder, NativeJsonTranscoder, #call(String)] transcoder
+      #
       # @return [Array]
       def rows(transcoder = self.transcoder)
         @rows.lazy.map do |row|
           if transcoder == :json
             JSON.parse(row)
+          elsif transcoder.respond_to?(:decode)
+            transcoder.decode(row, 0)
           else
             transcoder.call(row)
           end
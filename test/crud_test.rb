@@ -36,6 +36,38 @@ module Couchbase
       assert_equal document, res.content
     end
 
+    def test_async_operations
+      ids = Array.new(10) { uniq_id(:foo) }
+      ids.map { |id| @collection.upsert_async(id, {"value" => id}) }.each { |future| assert future.value.cas }
+
+      futures = ids.map { |id| @collection.get_async(id) }
+      ids.zip(futures).each do |id, future|
+        assert_equal({"value" => id}, future.value.content)
+        assert_predicate future, :completed?
+      end
+
+      @collection.remove_async(ids.first).value
+      future = @collection.get_async(ids.first)
+      assert_raises(Couchbase::Error::DocumentNotFound) do
+        future.value
+      end
+    end
+
+    def test_native_json_transcoder
+      doc_id = uniq_id(:foo)
+      document = {"value" => 42, "list" => [1, 2.5, nil, true, "ü"], "nested" => {"empty" => {}}}
+      @collection.upsert(doc_id, document, Options::Upsert(transcoder: NativeJsonTranscoder.new))
+
+      res = @collection.get(doc_id)
+      assert_equal document, res.content
+      res = @collection.get(doc_id, Options::Get(transcoder: NativeJsonTranscoder.new))
+      assert_equal document, res.content
+
+      assert_raises(Couchbase::Error::EncodingFailure) do
+        @collection.upsert(doc_id, {"time" => Object.new}, Options::Upsert(transcoder: NativeJsonTranscoder.new))
+      end
+    end
+
     def test_removes_documents
       doc_id = uniq_id(:foo)
       document = {"value" => 42}
@@ -0,0 +1,55 @@
+#  Copyright 2020-2021 Couchbase, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+require_relative "test_helper"
+
+module Couchbase
+  class JsonTranscoderTest < Minitest::Test
+    def test_native_json_transcoder_round_trip
+      transcoder = NativeJsonTranscoder.new
+      document = {"value" => 42, "list" => [1, 2.5, nil, true, "ü"], "nested" => {"empty" => {}}}
+      blob, flags = transcoder.encode(document)
+      assert_equal document, transcoder.decode(blob, flags)
+    end
+
+    def test_native_json_transcoder_accepts_nesting_up_to_the_limit
+      transcoder = NativeJsonTranscoder.new
+      document = "#{'[' * 100}#{']' * 100}"
+      assert_equal 100, depth_of(transcoder.decode(document, 0))
+    end
+
+    def test_native_json_transcoder_rejects_deeply_nested_documents
+      transcoder = NativeJsonTranscoder.new
+      [101, 100_000].each do |depth|
+        assert_raises(Couchbase::Error::DecodingFailure) do
+          transcoder.decode("#{'[' * depth}#{']' * depth}", 0)
+        end
+        assert_raises(Couchbase::Error::DecodingFailure) do
+          transcoder.decode("#{'{"a":' * depth}null#{'}' * depth}", 0)
+        end
+      end
+    end
+
+    private
+
+    def depth_of(value)
+      depth = 0
+      while value.is_a?(Array)
+        depth += 1
+        value = value.first
+      end
+      depth
+    end
+  end
+end